@@ -0,0 +1,312 @@
+/* Edge Impulse inferencing library
+ * Copyright (c) 2021 EdgeImpulse Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _EDGE_IMPULSE_CLASSIFIER_ASYNC_H_
+#define _EDGE_IMPULSE_CLASSIFIER_ASYNC_H_
+
+#include "ei_run_classifier.h"
+
+#if EI_PORTING_POSIX == 1
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Outcome of an asynchronous classification
+ */
+typedef struct {
+    EI_IMPULSE_ERROR status;
+    ei_impulse_result_t result;
+} ei_classifier_async_result_t;
+
+/**
+ * Completion callback, called on the worker thread before the future becomes ready.
+ * If it throws, the future rethrows the exception from get().
+ */
+typedef std::function<void(const ei_classifier_async_result_t &res)> ei_classifier_async_callback_t;
+
+class ei_classifier_pool;
+
+/**
+ * A signal that was submitted to an ei_classifier_pool
+ */
+class ei_classifier_request {
+public:
+    /**
+     * @brief Cancel the request. A queued request completes with EI_IMPULSE_CANCELED
+     *        without running, a running one stops at its next cancellation check.
+     */
+    void cancel() {
+        canceled.store(true);
+    }
+
+    bool is_canceled() const {
+        return canceled.load();
+    }
+
+    /**
+     * @brief Future that becomes ready when the request completes, also when it
+     *        was canceled or failed (see status). An exception thrown while running
+     *        the request (by get_data or the callback) is rethrown by get().
+     */
+    std::shared_future<ei_classifier_async_result_t> get_future() const {
+        return future;
+    }
+
+private:
+    friend class ei_classifier_pool;
+
+    ei_classifier_request(const signal_t &signal, ei_classifier_async_callback_t callback, bool debug)
+        : signal(signal), callback(callback), debug(debug), canceled(false)
+    {
+        future = promise.get_future().share();
+    }
+
+    signal_t signal;
+    ei_classifier_async_callback_t callback;
+    bool debug;
+    std::atomic<bool> canceled;
+    std::promise<ei_classifier_async_result_t> promise;
+    std::shared_future<ei_classifier_async_result_t> future;
+};
+
+/**
+ * Fixed pool of worker threads that run run_classifier() on submitted signals.
+ * Every worker keeps its own classifier context (the model it pinned and the
+ * cancel flag of the request it runs), so workers never share inference state.
+ * The number of requests that are queued or running is bounded, submit() blocks
+ * when the bound is reached.
+ *
+ * The data behind a signal's get_data callback has to stay valid until the
+ * request completes.
+ */
+class ei_classifier_pool {
+public:
+    /**
+     * @param worker_count   Number of worker threads (0 = one per core)
+     * @param max_in_flight  Maximum number of queued + running requests (0 = two per worker)
+     */
+    ei_classifier_pool(size_t worker_count = 0, size_t max_in_flight = 0)
+        : in_flight_count(0), stopping(false)
+    {
+        if (worker_count == 0) {
+            worker_count = std::thread::hardware_concurrency();
+            if (worker_count == 0) {
+                worker_count = 1;
+            }
+        }
+        this->max_in_flight = max_in_flight > 0 ? max_in_flight : worker_count * 2;
+
+        running.resize(worker_count);
+        for (size_t ix = 0; ix < worker_count; ix++) {
+            workers.emplace_back(&ei_classifier_pool::worker_loop, this, ix);
+        }
+    }
+
+    /**
+     * @brief Cancels every request that is still in flight and joins the workers.
+     *        All futures are completed before this returns.
+     */
+    ~ei_classifier_pool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            cancel_all_locked();
+        }
+        work_cv.notify_all();
+        space_cv.notify_all();
+        for (std::thread &t : workers) {
+            t.join();
+        }
+    }
+
+    ei_classifier_pool(const ei_classifier_pool&) = delete;
+    ei_classifier_pool& operator=(const ei_classifier_pool&) = delete;
+
+    /**
+     * @brief Queue a signal for classification, blocks while the pool is full
+     *
+     * @param signal    Signal with a full model window
+     * @param callback  Optional completion callback
+     * @param debug     Whether to show debug messages
+     *
+     * @return Request handle, or nullptr if the pool is shutting down
+     */
+    std::shared_ptr<ei_classifier_request> submit(const signal_t &signal,
+        ei_classifier_async_callback_t callback = nullptr, bool debug = false)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        space_cv.wait(lock, [this] { return stopping || in_flight_count < max_in_flight; });
+        if (stopping) {
+            return nullptr;
+        }
+        return enqueue_locked(signal, callback, debug);
+    }
+
+    /**
+     * @brief Same as submit(), but returns nullptr instead of blocking when the pool is full
+     */
+    std::shared_ptr<ei_classifier_request> try_submit(const signal_t &signal,
+        ei_classifier_async_callback_t callback = nullptr, bool debug = false)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping || in_flight_count >= max_in_flight) {
+            return nullptr;
+        }
+        return enqueue_locked(signal, callback, debug);
+    }
+
+    /**
+     * @brief Cancel every queued and running request
+     */
+    void cancel_all() {
+        std::lock_guard<std::mutex> lock(mutex);
+        cancel_all_locked();
+    }
+
+    /**
+     * @brief Number of requests that are queued or running
+     */
+    size_t in_flight() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return in_flight_count;
+    }
+
+private:
+    std::shared_ptr<ei_classifier_request> enqueue_locked(const signal_t &signal,
+        ei_classifier_async_callback_t callback, bool debug)
+    {
+        std::shared_ptr<ei_classifier_request> request(new ei_classifier_request(signal, callback, debug));
+        queue.push_back(request);
+        in_flight_count++;
+        work_cv.notify_one();
+        return request;
+    }
+
+    void cancel_all_locked() {
+        for (std::shared_ptr<ei_classifier_request> &request : queue) {
+            request->cancel();
+        }
+        for (std::shared_ptr<ei_classifier_request> &request : running) {
+            if (request) {
+                request->cancel();
+            }
+        }
+    }
+
+    void worker_loop(size_t worker_ix) {
+        while (true) {
+            std::shared_ptr<ei_classifier_request> request;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                work_cv.wait(lock, [this] { return stopping || !queue.empty(); });
+                if (queue.empty()) {
+                    return;
+                }
+                request = queue.front();
+                queue.pop_front();
+                running[worker_ix] = request;
+            }
+
+            // whatever happens below, the slot is given back when this iteration ends
+            running_slot_guard slot(this, worker_ix);
+
+            ei_classifier_async_result_t res;
+            memset(&res, 0, sizeof(res));
+            std::exception_ptr error;
+
+            try {
+                if (request->is_canceled()) {
+                    res.status = EI_IMPULSE_CANCELED;
+                }
+                else {
+                    impulse_cancel_flag = &request->canceled;
+                    res.status = run_classifier(&request->signal, &res.result, request->debug);
+                    impulse_cancel_flag = nullptr;
+                }
+            }
+            catch (...) {
+                // e.g. from the signal's get_data callback
+                impulse_cancel_flag = nullptr;
+                error = std::current_exception();
+            }
+
+            if (!error && request->callback) {
+                try {
+                    request->callback(res);
+                }
+                catch (...) {
+                    error = std::current_exception();
+                }
+            }
+
+            if (error) {
+                request->promise.set_exception(error);
+            }
+            else {
+                request->promise.set_value(res);
+            }
+        }
+    }
+
+    /**
+     * Clears the running slot of a worker and frees its place in the pool
+     * when it goes out of scope
+     */
+    struct running_slot_guard {
+        running_slot_guard(ei_classifier_pool *pool, size_t worker_ix) : pool(pool), worker_ix(worker_ix) { }
+
+        ~running_slot_guard() {
+            {
+                std::lock_guard<std::mutex> lock(pool->mutex);
+                pool->running[worker_ix] = nullptr;
+                pool->in_flight_count--;
+            }
+            pool->space_cv.notify_one();
+        }
+
+        ei_classifier_pool *pool;
+        size_t worker_ix;
+    };
+
+    std::mutex mutex;
+    std::condition_variable work_cv;
+    std::condition_variable space_cv;
+    std::deque<std::shared_ptr<ei_classifier_request>> queue;
+    std::vector<std::shared_ptr<ei_classifier_request>> running;
+    std::vector<std::thread> workers;
+    size_t in_flight_count;
+    size_t max_in_flight;
+    bool stopping;
+};
+
+#endif // EI_PORTING_POSIX == 1
+
+#endif // _EDGE_IMPULSE_CLASSIFIER_ASYNC_H_
@@ -62,5 +62,21 @@
 #endif // CPU_ARC
 #endif // EI_CLASSIFIER_TFLITE_ENABLE_ARC
 
+// Run the DSP blocks of an impulse concurrently on a thread pool (POSIX targets only)
+#ifndef EI_CLASSIFIER_PARALLEL_DSP_BLOCKS
+#define EI_CLASSIFIER_PARALLEL_DSP_BLOCKS           0
+#endif // EI_CLASSIFIER_PARALLEL_DSP_BLOCKS
+
+// Number of threads that run DSP blocks, including the calling thread (0 = one per core)
+#ifndef EI_CLASSIFIER_DSP_BLOCK_THREADS
+#define EI_CLASSIFIER_DSP_BLOCK_THREADS             0
+#endif // EI_CLASSIFIER_DSP_BLOCK_THREADS
+
+// Use an MFCC pipeline specialized on the model's MFCC block, when the model metadata
+// exposes that block as a compile-time constant (EI_DSP_MFCC_STATIC_CONFIG)
+#ifndef EI_CLASSIFIER_STATIC_MFCC
+#define EI_CLASSIFIER_STATIC_MFCC                   1
+#endif // EI_CLASSIFIER_STATIC_MFCC
+
 // clang-format on
 #endif // _EI_CLASSIFIER_CONFIG_H_
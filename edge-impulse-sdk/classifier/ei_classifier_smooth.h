@@ -26,6 +26,7 @@
 #if EI_CLASSIFIER_OBJECT_DETECTION != 1
 
 #include <stdint.h>
+#include <string.h>
 
 typedef struct ei_classifier_smooth {
     int *last_readings;
@@ -35,13 +36,49 @@ typedef struct ei_classifier_smooth {
     float anomaly_confidence;
     uint8_t count[EI_CLASSIFIER_LABEL_COUNT + 2] = { 0 };
     size_t count_size = EI_CLASSIFIER_LABEL_COUNT + 2;
+    size_t last_readings_head = 0; // oldest reading, the next one to be replaced
 } ei_classifier_smooth_t;
 
+/**
+ * Turn a classifier result into a single reading
+ * @returns Index of the (last) label with at least classifier_confidence, -1 (uncertain) or -2 (anomaly)
+ */
+static int ei_classifier_smooth_reading(ei_impulse_result_t *result, float classifier_confidence,
+                                        float anomaly_confidence) {
+    int reading = -1; // uncertain
+
+    for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
+        if (result->classification[ix].value >= classifier_confidence) {
+            reading = (int)ix;
+        }
+    }
+#if EI_CLASSIFIER_HAS_ANOMALY == 1
+    if (result->anomaly >= anomaly_confidence) {
+        reading = -2; // anomaly
+    }
+#else
+    (void)anomaly_confidence;
+#endif
+
+    return reading;
+}
+
+/**
+ * Index in the count array for a reading: the labels, then uncertain, then anomaly
+ */
+static size_t ei_classifier_smooth_slot(int reading) {
+    if (reading >= 0) {
+        return (size_t)reading;
+    }
+    return reading == -2 ? EI_CLASSIFIER_LABEL_COUNT + 1 : EI_CLASSIFIER_LABEL_COUNT;
+}
+
 /**
  * Initialize a smooth structure. This is useful if you don't want to trust
  * single readings, but rather want consensus
  * (e.g. 7 / 10 readings should be the same before I draw any ML conclusions).
- * This allocates memory on the heap!
+ * This allocates memory on the heap! If the number of readings is known at compile
+ * time, ei_classifier_smoother (below) doesn't.
  * @param smooth Pointer to an uninitialized ei_classifier_smooth_t struct
  * @param n_readings Number of readings you want to store
  * @param min_readings_same Minimum readings that need to be the same before concluding (needs to be lower than n_readings)
@@ -56,53 +93,37 @@ void ei_classifier_smooth_init(ei_classifier_smooth_t *smooth, size_t n_readings
         smooth->last_readings[ix] = -1; // -1 == uncertain
     }
     smooth->last_readings_size = n_readings;
+    smooth->last_readings_head = 0;
     smooth->min_readings_same = min_readings_same;
     smooth->classifier_confidence = classifier_confidence;
     smooth->anomaly_confidence = anomaly_confidence;
     smooth->count_size = EI_CLASSIFIER_LABEL_COUNT + 2;
+
+    // the counts are kept up to date on every update, all readings start out uncertain
+    memset(smooth->count, 0, EI_CLASSIFIER_LABEL_COUNT + 2);
+    smooth->count[EI_CLASSIFIER_LABEL_COUNT] = (uint8_t)n_readings;
 }
 
 /**
- * Call when a new reading comes in.
+ * Call when a new reading comes in. The new reading replaces the oldest one in
+ * the ring buffer and only the counts of those two change, so this doesn't
+ * depend on the number of readings.
  * @param smooth Pointer to an initialized ei_classifier_smooth_t struct
  * @param result Pointer to a result structure (after calling ei_run_classifier)
  * @returns Label, either 'uncertain', 'anomaly', or a label from the result struct
  */
 const char* ei_classifier_smooth_update(ei_classifier_smooth_t *smooth, ei_impulse_result_t *result) {
-    // clear out the count array
-    memset(smooth->count, 0, EI_CLASSIFIER_LABEL_COUNT + 2);
+    int reading = ei_classifier_smooth_reading(result, smooth->classifier_confidence,
+        smooth->anomaly_confidence);
 
-    // roll through the last_readings buffer
-    numpy::roll(smooth->last_readings, smooth->last_readings_size, -1);
+    int *oldest = &smooth->last_readings[smooth->last_readings_head];
+    smooth->count[ei_classifier_smooth_slot(*oldest)]--;
+    smooth->count[ei_classifier_smooth_slot(reading)]++;
+    *oldest = reading;
 
-    int reading = -1; // uncertain
-
-    // print the predictions
-    // printf("[");
-    for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
-        if (result->classification[ix].value >= smooth->classifier_confidence) {
-            reading = (int)ix;
-        }
-    }
-#if EI_CLASSIFIER_HAS_ANOMALY == 1
-    if (result->anomaly >= smooth->anomaly_confidence) {
-        reading = -2; // anomaly
-    }
-#endif
-
-    smooth->last_readings[smooth->last_readings_size - 1] = reading;
-
-    // now count last 10 readings and see what we actually see...
-    for (size_t ix = 0; ix < smooth->last_readings_size; ix++) {
-        if (smooth->last_readings[ix] >= 0) {
-            smooth->count[smooth->last_readings[ix]]++;
-        }
-        else if (smooth->last_readings[ix] == -1) { // uncertain
-            smooth->count[EI_CLASSIFIER_LABEL_COUNT]++;
-        }
-        else if (smooth->last_readings[ix] == -2) { // anomaly
-            smooth->count[EI_CLASSIFIER_LABEL_COUNT + 1]++;
-        }
+    smooth->last_readings_head++;
+    if (smooth->last_readings_head == smooth->last_readings_size) {
+        smooth->last_readings_head = 0;
     }
 
     // then loop over the count and see which is highest
@@ -141,6 +162,142 @@ void ei_classifier_smooth_free(ei_classifier_smooth_t *smooth) {
     free(smooth->last_readings);
 }
 
+/**
+ * Smoother for a fixed number of readings, without heap allocations: the readings
+ * are kept in a ring buffer inside the object and the vote counts are updated
+ * incrementally, so every update costs the same whatever N is.
+ *
+ * The decision has hysteresis: a label (or anomaly) is reported once at least
+ * min_readings_same of the last N readings agree on it, and it keeps being
+ * reported until fewer than min_readings_keep of them do. With min_readings_keep
+ * lower than min_readings_same a decision doesn't flicker on a single missed reading.
+ *
+ * @tparam N Number of readings to keep
+ */
+template <size_t N>
+class ei_classifier_smoother {
+public:
+    /**
+     * @param min_readings_same Readings that need to be the same before reporting them (1..N)
+     * @param min_readings_keep Readings that need to stay the same to keep reporting them
+     *     (1..min_readings_same)
+     * @param classifier_confidence Minimum confidence in a class (default 0.8)
+     * @param anomaly_confidence Maximum error for anomalies (default 0.3)
+     */
+    ei_classifier_smoother(size_t min_readings_same, size_t min_readings_keep,
+                           float classifier_confidence = 0.8, float anomaly_confidence = 0.3)
+        : min_readings_same(clamp(min_readings_same, 1, N)),
+          min_readings_keep(clamp(min_readings_keep, 1, this->min_readings_same)),
+          classifier_confidence(classifier_confidence),
+          anomaly_confidence(anomaly_confidence)
+    {
+        reset();
+    }
+
+    /**
+     * Forget all readings, they're all uncertain again
+     */
+    void reset() {
+        for (size_t ix = 0; ix < N; ix++) {
+            readings[ix] = UNCERTAIN;
+        }
+        memset(count, 0, sizeof(count));
+        count[UNCERTAIN] = N;
+        head = 0;
+        current = UNCERTAIN;
+    }
+
+    /**
+     * Add a reading
+     * @param reading Index of a label, -1 (uncertain) or -2 (anomaly)
+     * @returns The decision: index of a label, -1 (uncertain) or -2 (anomaly)
+     */
+    int update(int reading) {
+        uint8_t slot = (uint8_t)ei_classifier_smooth_slot(reading);
+
+        count[readings[head]]--;
+        count[slot]++;
+        readings[head] = slot;
+        head = head + 1 == N ? 0 : head + 1;
+
+        if (current != UNCERTAIN && count[current] < min_readings_keep) {
+            current = UNCERTAIN;
+
+            // another label may have reached min_readings_same while this one was kept
+            size_t top_count = 0;
+            for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT + 2; ix++) {
+                if (ix != UNCERTAIN && count[ix] >= min_readings_same && count[ix] > top_count) {
+                    current = (uint8_t)ix;
+                    top_count = count[ix];
+                }
+            }
+        }
+        // otherwise only the label we just counted can have reached it
+        if (current == UNCERTAIN && slot != UNCERTAIN && count[slot] >= min_readings_same) {
+            current = slot;
+        }
+
+        return decision();
+    }
+
+    /**
+     * Add the reading of a classifier result (see ei_classifier_smooth_update)
+     * @param result Pointer to a result structure (after calling ei_run_classifier)
+     * @returns Label, either 'uncertain', 'anomaly', or a label from the result struct
+     */
+    const char *update(ei_impulse_result_t *result) {
+        int d = update(ei_classifier_smooth_reading(result, classifier_confidence, anomaly_confidence));
+        if (d == -1) {
+            return "uncertain";
+        }
+        else if (d == -2) {
+            return "anomaly";
+        }
+        return result->classification[d].label;
+    }
+
+    /**
+     * @returns The current decision: index of a label, -1 (uncertain) or -2 (anomaly)
+     */
+    int decision() const {
+        if (current == UNCERTAIN) {
+            return -1;
+        }
+        if (current == ANOMALY) {
+            return -2;
+        }
+        return (int)current;
+    }
+
+    /**
+     * @returns How many of the last N readings were this reading (label index, -1 or -2)
+     */
+    size_t readings_of(int reading) const {
+        return count[ei_classifier_smooth_slot(reading)];
+    }
+
+private:
+    static_assert(N > 0, "ei_classifier_smoother needs at least one reading");
+    static_assert(EI_CLASSIFIER_LABEL_COUNT + 2 <= 256, "readings are stored as uint8_t");
+
+    static const uint8_t UNCERTAIN = EI_CLASSIFIER_LABEL_COUNT;
+    static const uint8_t ANOMALY = EI_CLASSIFIER_LABEL_COUNT + 1;
+
+    static size_t clamp(size_t value, size_t min, size_t max) {
+        return value < min ? min : (value > max ? max : value);
+    }
+
+    const size_t min_readings_same;
+    const size_t min_readings_keep;
+    const float classifier_confidence;
+    const float anomaly_confidence;
+
+    uint8_t readings[N];
+    size_t count[EI_CLASSIFIER_LABEL_COUNT + 2];
+    size_t head;
+    uint8_t current;
+};
+
 #endif // #if EI_CLASSIFIER_OBJECT_DETECTION != 1
 
 #endif // _EI_CLASSIFIER_SMOOTH_H_
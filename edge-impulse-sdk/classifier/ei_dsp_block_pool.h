@@ -0,0 +1,180 @@
+/* Edge Impulse inferencing library
+ * Copyright (c) 2021 EdgeImpulse Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef _EDGE_IMPULSE_DSP_BLOCK_POOL_H_
+#define _EDGE_IMPULSE_DSP_BLOCK_POOL_H_
+
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+
+#if EI_PORTING_POSIX == 1
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Persistent pool of worker threads that the DSP blocks of an impulse run on.
+ * run() hands out the tasks of one call to the workers and to the calling thread,
+ * and returns when all of them are done. Several threads can call run() at the
+ * same time (e.g. the workers of an ei_classifier_pool), the caller keeps working
+ * on its own tasks so a busy pool never blocks it.
+ *
+ * A task that throws does not take down the worker it runs on: the tasks of
+ * the batch that did not start yet are dropped, and run() rethrows the
+ * exception on the calling thread once the tasks that did start are done.
+ */
+class ei_dsp_block_pool {
+public:
+    /**
+     * @param worker_count Number of worker threads besides the calling thread
+     */
+    explicit ei_dsp_block_pool(size_t worker_count)
+        : stopping(false)
+    {
+        for (size_t ix = 0; ix < worker_count; ix++) {
+            workers.emplace_back(&ei_dsp_block_pool::worker_loop, this);
+        }
+    }
+
+    ~ei_dsp_block_pool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        work_cv.notify_all();
+        for (std::thread &t : workers) {
+            t.join();
+        }
+    }
+
+    ei_dsp_block_pool(const ei_dsp_block_pool&) = delete;
+    ei_dsp_block_pool& operator=(const ei_dsp_block_pool&) = delete;
+
+    /**
+     * @brief Run task(0) ... task(task_count - 1) concurrently and wait for all of them.
+     *        Rethrows the first exception thrown by a task.
+     */
+    void run(size_t task_count, const std::function<void(size_t task_ix)> &task) {
+        batch_t batch;
+        batch.task = &task;
+        batch.task_count = task_count;
+        batch.next_task = 0;
+        batch.done_count = 0;
+        batch.error = nullptr;
+
+        std::unique_lock<std::mutex> lock(mutex);
+        batches.push_back(&batch);
+        work_cv.notify_all();
+
+        while (batch.next_task < batch.task_count) {
+            run_next_locked(&batch, lock);
+        }
+        // the batch lives on this stack, so wait for every task that started
+        batch.done_cv.wait(lock, [&batch] { return batch.done_count == batch.task_count; });
+
+        if (batch.error) {
+            std::rethrow_exception(batch.error);
+        }
+    }
+
+private:
+    typedef struct {
+        const std::function<void(size_t)> *task;
+        size_t task_count;
+        size_t next_task;
+        size_t done_count;
+        std::condition_variable done_cv;
+        std::exception_ptr error;
+    } batch_t;
+
+    /**
+     * Take the next task of a batch and run it with the lock released.
+     * If the task throws, the exception is kept for run() and the tasks
+     * that did not start yet are dropped.
+     */
+    void run_next_locked(batch_t *batch, std::unique_lock<std::mutex> &lock) {
+        size_t task_ix = batch->next_task++;
+        if (batch->next_task == batch->task_count) {
+            remove_locked(batch);
+        }
+
+        lock.unlock();
+        std::exception_ptr error;
+        try {
+            (*batch->task)(task_ix);
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+        lock.lock();
+
+        if (error) {
+            if (!batch->error) {
+                batch->error = error;
+            }
+            if (batch->next_task < batch->task_count) {
+                batch->task_count = batch->next_task;
+                remove_locked(batch);
+            }
+        }
+
+        batch->done_count++;
+        if (batch->done_count == batch->task_count) {
+            batch->done_cv.notify_all();
+        }
+    }
+
+    void remove_locked(batch_t *batch) {
+        for (auto it = batches.begin(); it != batches.end(); ++it) {
+            if (*it == batch) {
+                batches.erase(it);
+                break;
+            }
+        }
+    }
+
+    void worker_loop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            work_cv.wait(lock, [this] { return stopping || !batches.empty(); });
+            if (stopping) {
+                return;
+            }
+            run_next_locked(batches.front(), lock);
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable work_cv;
+    std::deque<batch_t*> batches;
+    std::vector<std::thread> workers;
+    bool stopping;
+};
+
+#endif // EI_PORTING_POSIX == 1
+
+#endif // _EDGE_IMPULSE_DSP_BLOCK_POOL_H_
@@ -0,0 +1,106 @@
+/* Edge Impulse inferencing library
+ * Copyright (c) 2021 EdgeImpulse Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _EDGE_IMPULSE_MODEL_FILE_H_
+#define _EDGE_IMPULSE_MODEL_FILE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "../porting/ei_classifier_porting.h"
+
+#if EI_PORTING_POSIX == 1
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * A model file (e.g. a .tflite file) that is mapped into memory
+ */
+typedef struct {
+    const uint8_t *buffer;
+    size_t length;
+} ei_model_file_t;
+
+#ifdef __cplusplus
+namespace {
+#endif // __cplusplus
+
+/**
+ * Map a model file read-only into memory. The mapping is backed by the page cache,
+ * so every process (and every stream) that maps the same file shares the same pages.
+ *
+ * @param path  Path to the model file
+ * @param file  Out parameter, receives the mapping
+ *
+ * @return EI_IMPULSE_OK if successful
+ */
+__attribute__((unused)) EI_IMPULSE_ERROR ei_model_file_map(const char *path, ei_model_file_t *file)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        ei_printf("ERR: Failed to open model file '%s'\n", path);
+        return EI_IMPULSE_MODEL_LOAD_FAILED;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ei_printf("ERR: Failed to stat model file '%s' (or file is empty)\n", path);
+        close(fd);
+        return EI_IMPULSE_MODEL_LOAD_FAILED;
+    }
+
+    void *ptr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    // the mapping stays valid after closing the descriptor
+    close(fd);
+    if (ptr == MAP_FAILED) {
+        ei_printf("ERR: Failed to mmap model file '%s'\n", path);
+        return EI_IMPULSE_MODEL_LOAD_FAILED;
+    }
+
+    file->buffer = (const uint8_t *)ptr;
+    file->length = (size_t)st.st_size;
+    return EI_IMPULSE_OK;
+}
+
+/**
+ * Unmap a model file that was mapped through ei_model_file_map
+ *
+ * @param file  Mapping, will be reset
+ */
+__attribute__((unused)) void ei_model_file_unmap(ei_model_file_t *file)
+{
+    if (file->buffer) {
+        munmap((void *)file->buffer, file->length);
+    }
+    file->buffer = NULL;
+    file->length = 0;
+}
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // EI_PORTING_POSIX == 1
+
+#endif // _EDGE_IMPULSE_MODEL_FILE_H_
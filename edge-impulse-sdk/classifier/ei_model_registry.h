@@ -0,0 +1,383 @@
+/* Edge Impulse inferencing library
+ * Copyright (c) 2021 EdgeImpulse Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef _EDGE_IMPULSE_MODEL_REGISTRY_H_
+#define _EDGE_IMPULSE_MODEL_REGISTRY_H_
+
+#include "ei_run_classifier.h"
+
+#if (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE) && (EI_CLASSIFIER_COMPILED != 1)
+
+#ifndef EI_CLASSIFIER_REGISTRY_MAX_MODELS
+#define EI_CLASSIFIER_REGISTRY_MAX_MODELS       4
+#endif
+
+#ifndef EI_CLASSIFIER_REGISTRY_MAX_LABELS
+#define EI_CLASSIFIER_REGISTRY_MAX_LABELS       16
+#endif
+
+/**
+ * DSP configuration of registered models, the features of all blocks form the
+ * model input. Models that point to the same configuration share one feature
+ * extraction per signal.
+ */
+typedef struct {
+    const ei_model_dsp_t *blocks;
+    size_t blocks_size;
+} ei_registry_dsp_config_t;
+
+/**
+ * A model in the registry, either compiled in or memory mapped from a file
+ */
+typedef struct {
+    const char *name;
+    const ei_registry_dsp_config_t *dsp_config;
+    const char * const *labels;
+    size_t label_count;
+    size_t arena_size;
+    const tflite::Model *model;
+#if EI_PORTING_POSIX == 1
+    ei_model_file_t file;
+#endif
+} ei_registry_model_t;
+
+/**
+ * Result of one registered model. For a model with a single output (e.g. an
+ * anomaly score) classification[0].value holds that output.
+ */
+typedef struct {
+    const char *model_name;
+    EI_IMPULSE_ERROR status;
+    size_t label_count;
+    ei_impulse_result_classification_t classification[EI_CLASSIFIER_REGISTRY_MAX_LABELS];
+    ei_impulse_result_timing_t timing;
+} ei_registry_result_t;
+
+#ifdef __cplusplus
+namespace {
+#endif // __cplusplus
+
+/* DSP configuration of the impulse that was compiled in */
+const ei_registry_dsp_config_t ei_registry_impulse_dsp_config = { ei_dsp_blocks, ei_dsp_blocks_size };
+
+static ei_registry_model_t registry_models[EI_CLASSIFIER_REGISTRY_MAX_MODELS];
+static size_t registry_model_count = 0;
+
+/**
+ * Number of features (the model input size) of a DSP configuration
+ */
+static size_t registry_feature_count(const ei_registry_dsp_config_t *dsp_config) {
+    size_t count = 0;
+    for (size_t ix = 0; ix < dsp_config->blocks_size; ix++) {
+        count += dsp_config->blocks[ix].n_output_features;
+    }
+    return count;
+}
+
+/**
+ * Validate a model against its DSP configuration and labels, warm it up and
+ * add it to the registry
+ */
+static EI_IMPULSE_ERROR registry_add(const char *name, const uint8_t *buffer, size_t length,
+    const ei_registry_dsp_config_t *dsp_config, const char * const *labels, size_t label_count,
+    size_t arena_size, ei_registry_model_t **added)
+{
+    if (registry_model_count == EI_CLASSIFIER_REGISTRY_MAX_MODELS) {
+        ei_printf("ERR: Model registry is full (EI_CLASSIFIER_REGISTRY_MAX_MODELS = %d)\n",
+            EI_CLASSIFIER_REGISTRY_MAX_MODELS);
+        return EI_IMPULSE_OUT_OF_MEMORY;
+    }
+    if (label_count == 0 || label_count > EI_CLASSIFIER_REGISTRY_MAX_LABELS) {
+        ei_printf("ERR: Model '%s' has %d outputs, between 1 and %d are supported\n",
+            name, (int)label_count, EI_CLASSIFIER_REGISTRY_MAX_LABELS);
+        return EI_IMPULSE_ERROR_SHAPES_DONT_MATCH;
+    }
+
+    const tflite::Model *model;
+    EI_IMPULSE_ERROR res = inference_tflite_verify_model(buffer, length, &model,
+        registry_feature_count(dsp_config), kTfLiteNoType, label_count, kTfLiteNoType);
+    if (res != EI_IMPULSE_OK) {
+        return res;
+    }
+
+    res = inference_tflite_warm_up(model, arena_size);
+    if (res != EI_IMPULSE_OK) {
+        return res;
+    }
+
+    ei_registry_model_t *entry = &registry_models[registry_model_count++];
+    memset(entry, 0, sizeof(ei_registry_model_t));
+    entry->name = name;
+    entry->dsp_config = dsp_config;
+    entry->labels = labels;
+    entry->label_count = label_count;
+    entry->arena_size = arena_size;
+    entry->model = model;
+    if (added) {
+        *added = entry;
+    }
+    return EI_IMPULSE_OK;
+}
+
+/**
+ * Run one registered model on the features of its DSP configuration
+ */
+static EI_IMPULSE_ERROR registry_run_model(const ei_registry_model_t *entry, ei::matrix_t *features_matrix,
+    ei_registry_result_t *result, bool debug)
+{
+    uint8_t *tensor_arena = (uint8_t*)ei_aligned_malloc(16, entry->arena_size);
+    if (tensor_arena == NULL) {
+        ei_printf("Failed to allocate TFLite arena (%d bytes)\n", (int)entry->arena_size);
+        return EI_IMPULSE_TFLITE_ARENA_ALLOC_FAILED;
+    }
+
+    uint64_t ctx_start_ms = ei_read_timer_ms();
+
+    EI_IMPULSE_ERROR res = EI_IMPULSE_OK;
+    {
+        tflite::MicroInterpreter interpreter(entry->model, *inference_tflite_resolver(),
+            tensor_arena, entry->arena_size, error_reporter);
+
+        if (interpreter.AllocateTensors() != kTfLiteOk) {
+            error_reporter->Report("AllocateTensors() failed");
+            res = EI_IMPULSE_TFLITE_ERROR;
+        }
+        else {
+            TfLiteTensor *input = interpreter.input(0);
+            TfLiteTensor *output = interpreter.output(0);
+
+            bool int8_input = input->type == TfLiteType::kTfLiteInt8;
+            for (size_t ix = 0; ix < features_matrix->rows * features_matrix->cols; ix++) {
+                if (int8_input) {
+                    input->data.int8[ix] = static_cast<int8_t>(round(features_matrix->buffer[ix] / input->params.scale) + input->params.zero_point);
+                }
+                else {
+                    input->data.f[ix] = features_matrix->buffer[ix];
+                }
+            }
+
+            TfLiteStatus invoke_status = interpreter.Invoke();
+            if (invoke_status != kTfLiteOk) {
+                error_reporter->Report("Invoke failed (%d)\n", invoke_status);
+                res = EI_IMPULSE_TFLITE_ERROR;
+            }
+            else {
+                result->timing.classification = ei_read_timer_ms() - ctx_start_ms;
+
+                if (debug) {
+                    ei_printf("Predictions for '%s' (time: %d ms.):\n", entry->name, result->timing.classification);
+                }
+
+                bool int8_output = output->type == TfLiteType::kTfLiteInt8;
+                result->label_count = entry->label_count;
+                for (size_t ix = 0; ix < entry->label_count; ix++) {
+                    float value = int8_output ?
+                        static_cast<float>(output->data.int8[ix] - output->params.zero_point) * output->params.scale :
+                        output->data.f[ix];
+
+                    result->classification[ix].label = entry->labels ? entry->labels[ix] : "";
+                    result->classification[ix].value = value;
+
+                    if (debug) {
+                        ei_printf("%s:\t", result->classification[ix].label);
+                        ei_printf_float(value);
+                        ei_printf("\n");
+                    }
+                }
+            }
+        }
+    }
+
+    ei_aligned_free(tensor_arena);
+    return res;
+}
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+/**
+ * @brief      Register a compiled-in model, e.g. a second trained_tflite array.
+ *             Registration is not thread safe, register all models before
+ *             run_classifier_models is called.
+ *
+ * @param      name          Name of the model, reported in its results
+ * @param      tflite_model  TFLite flatbuffer, has to stay valid while registered
+ * @param      length        Length of the flatbuffer
+ * @param      dsp_config    DSP configuration that produces the model input
+ * @param      labels        Label per model output (or NULL)
+ * @param      label_count   Number of model outputs
+ * @param      arena_size    Size of the TFLite arena needed by the model
+ *
+ * @return     The ei impulse error.
+ */
+extern "C" EI_IMPULSE_ERROR ei_registry_add_model(const char *name,
+    const uint8_t *tflite_model, size_t length,
+    const ei_registry_dsp_config_t *dsp_config,
+    const char * const *labels, size_t label_count,
+    size_t arena_size)
+{
+    return registry_add(name, tflite_model, length, dsp_config, labels, label_count, arena_size, NULL);
+}
+
+/**
+ * @brief      Register the model of the impulse that was compiled in (trained_tflite)
+ *
+ * @param      name  Name of the model, reported in its results
+ *
+ * @return     The ei impulse error.
+ */
+extern "C" EI_IMPULSE_ERROR ei_registry_add_impulse(const char *name = "impulse")
+{
+    return registry_add(name, trained_tflite, trained_tflite_len, &ei_registry_impulse_dsp_config,
+        ei_classifier_inferencing_categories, EI_CLASSIFIER_LABEL_COUNT, EI_CLASSIFIER_TFLITE_ARENA_SIZE, NULL);
+}
+
+#if EI_PORTING_POSIX == 1
+/**
+ * @brief      Register a .tflite file. The file is memory mapped read-only and
+ *             stays mapped until ei_registry_clear is called.
+ *
+ * @param      name          Name of the model, reported in its results
+ * @param      path          Path to the .tflite file
+ * @param      dsp_config    DSP configuration that produces the model input
+ * @param      labels        Label per model output (or NULL)
+ * @param      label_count   Number of model outputs
+ * @param      arena_size    Size of the TFLite arena needed by the model
+ *
+ * @return     The ei impulse error.
+ */
+extern "C" EI_IMPULSE_ERROR ei_registry_add_model_file(const char *name, const char *path,
+    const ei_registry_dsp_config_t *dsp_config,
+    const char * const *labels, size_t label_count,
+    size_t arena_size)
+{
+    ei_model_file_t file;
+    EI_IMPULSE_ERROR res = ei_model_file_map(path, &file);
+    if (res != EI_IMPULSE_OK) {
+        return res;
+    }
+
+    ei_registry_model_t *entry;
+    res = registry_add(name, file.buffer, file.length, dsp_config, labels, label_count, arena_size, &entry);
+    if (res != EI_IMPULSE_OK) {
+        ei_model_file_unmap(&file);
+        return res;
+    }
+    entry->file = file;
+    return EI_IMPULSE_OK;
+}
+#endif // EI_PORTING_POSIX == 1
+
+/**
+ * @brief      Remove all models from the registry (and unmap the model files)
+ */
+extern "C" void ei_registry_clear(void)
+{
+    for (size_t ix = 0; ix < registry_model_count; ix++) {
+#if EI_PORTING_POSIX == 1
+        ei_model_file_unmap(&registry_models[ix].file);
+#endif
+    }
+    registry_model_count = 0;
+}
+
+/**
+ * @brief      Number of registered models, run_classifier_models fills one result per model
+ */
+extern "C" size_t ei_registry_model_count(void)
+{
+    return registry_model_count;
+}
+
+/**
+ * @brief      Run every registered model over a signal. The features of every
+ *             DSP configuration are computed once and fanned out to all models
+ *             that use that configuration.
+ *
+ * @param      signal        Signal with a full model window
+ * @param      results       Results, one per model in registration order
+ * @param      results_size  Number of results, at least ei_registry_model_count()
+ * @param      debug         Whether to show debug messages
+ *
+ * @return     EI_IMPULSE_OK when the features could be computed, the outcome of
+ *             every model is in the status of its result
+ */
+extern "C" EI_IMPULSE_ERROR run_classifier_models(signal_t *signal,
+    ei_registry_result_t results[], size_t results_size, bool debug = false)
+{
+    if (results_size < registry_model_count) {
+        ei_printf("ERR: Need room for %d results, got %d\n", (int)registry_model_count, (int)results_size);
+        return EI_IMPULSE_OUT_OF_MEMORY;
+    }
+
+    memset(results, 0, sizeof(ei_registry_result_t) * registry_model_count);
+    bool model_done[EI_CLASSIFIER_REGISTRY_MAX_MODELS] = { false };
+
+    for (size_t ix = 0; ix < registry_model_count; ix++) {
+        if (model_done[ix]) {
+            continue;
+        }
+
+        const ei_registry_dsp_config_t *dsp_config = registry_models[ix].dsp_config;
+
+        ei::matrix_t features_matrix(1, registry_feature_count(dsp_config));
+        if (!features_matrix.buffer) {
+            return EI_IMPULSE_ALLOC_FAILED;
+        }
+
+        uint64_t dsp_start_ms = ei_read_timer_ms();
+
+        // framing shortens the signal, so every configuration starts from the full window
+        signal_t config_signal = *signal;
+        EI_IMPULSE_ERROR res = extract_features(&config_signal, &features_matrix,
+            dsp_config->blocks, dsp_config->blocks_size);
+        if (res != EI_IMPULSE_OK) {
+            return res;
+        }
+
+        int dsp_ms = (int)(ei_read_timer_ms() - dsp_start_ms);
+
+        for (size_t jx = ix; jx < registry_model_count; jx++) {
+            if (registry_models[jx].dsp_config != dsp_config) {
+                continue;
+            }
+            model_done[jx] = true;
+
+            ei_registry_result_t *result = &results[jx];
+            result->model_name = registry_models[jx].name;
+            result->timing.dsp = dsp_ms;
+            result->status = registry_run_model(&registry_models[jx], &features_matrix, result, debug);
+
+            if (impulse_check_canceled() == EI_IMPULSE_CANCELED) {
+                return EI_IMPULSE_CANCELED;
+            }
+        }
+    }
+
+    return EI_IMPULSE_OK;
+}
+
+#endif // (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE) && (EI_CLASSIFIER_COMPILED != 1)
+
+#endif // _EDGE_IMPULSE_MODEL_REGISTRY_H_
@@ -29,6 +29,7 @@
 #include "model-parameters/anomaly_clusters.h"
 #endif
 #include "ei_run_dsp.h"
+#include "ei_classifier_config.h"
 #include "ei_classifier_types.h"
 #include "ei_classifier_smooth.h"
 #if defined(EI_CLASSIFIER_HAS_SAMPLER) && EI_CLASSIFIER_HAS_SAMPLER == 1
@@ -36,6 +37,13 @@
 #endif
 #include "edge-impulse-sdk/porting/ei_classifier_porting.h"
 #include "model-parameters/dsp_blocks.h"
+#if EI_PORTING_POSIX == 1
+#include <atomic>
+#endif
+#if EI_CLASSIFIER_PARALLEL_DSP_BLOCKS == 1 && EI_PORTING_POSIX == 1
+#include <vector>
+#include "ei_dsp_block_pool.h"
+#endif
 
 #if (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE) && (EI_CLASSIFIER_COMPILED != 1)
 #include <cmath>
@@ -43,8 +51,14 @@
 #include "edge-impulse-sdk/tensorflow/lite/micro/micro_error_reporter.h"
 #include "edge-impulse-sdk/tensorflow/lite/micro/micro_interpreter.h"
 #include "edge-impulse-sdk/tensorflow/lite/schema/schema_generated.h"
+#include "edge-impulse-sdk/tensorflow/lite/core/api/flatbuffer_conversions.h"
+#include "edge-impulse-sdk/tensorflow/lite/core/api/op_resolver.h"
 #include "edge-impulse-sdk/tensorflow/lite/version.h"
 #include "edge-impulse-sdk/classifier/ei_aligned_malloc.h"
+#include "edge-impulse-sdk/classifier/ei_model_file.h"
+#if EI_PORTING_POSIX == 1
+#include <memory>
+#endif
 
 #include "tflite-model/tflite-trained.h"
 #if defined(EI_CLASSIFIER_HAS_TFLITE_OPS_RESOLVER) && EI_CLASSIFIER_HAS_TFLITE_OPS_RESOLVER == 1
@@ -113,9 +127,12 @@ namespace {
 extern "C" EI_IMPULSE_ERROR run_inference(ei::matrix_t *fmatrix, ei_impulse_result_t *result, bool debug);
 extern "C" EI_IMPULSE_ERROR run_classifier_image_quantized(signal_t *signal, ei_impulse_result_t *result, bool debug);
 static EI_IMPULSE_ERROR can_run_classifier_image_quantized();
-static void calc_cepstral_mean_and_var_normalization_mfcc(ei_matrix *matrix, void *config_ptr);
-static void calc_cepstral_mean_and_var_normalization_mfe(ei_matrix *matrix, void *config_ptr);
-static void calc_cepstral_mean_and_var_normalization_spectrogram(ei_matrix *matrix, void *config_ptr);
+static void calc_cepstral_mean_and_var_normalization_mfcc(ei_matrix *matrix, size_t first_feature, ei_matrix *out_matrix, void *config_ptr);
+static void calc_cepstral_mean_and_var_normalization_mfe(ei_matrix *matrix, size_t first_feature, ei_matrix *out_matrix, void *config_ptr);
+static void calc_cepstral_mean_and_var_normalization_spectrogram(ei_matrix *matrix, size_t first_feature, ei_matrix *out_matrix, void *config_ptr);
+static EI_IMPULSE_ERROR run_inference_continuous(ei::matrix_t *features_matrix, size_t first_feature,
+    void (*normalize_fn)(ei_matrix *matrix, size_t first_feature, ei_matrix *out_matrix, void *config_ptr),
+    void *config_ptr, ei_impulse_result_t *result, bool debug);
 
 /* Private variables ------------------------------------------------------- */
 #if EI_CLASSIFIER_LABEL_COUNT > 0
@@ -123,11 +140,29 @@ ei_impulse_maf classifier_maf[EI_CLASSIFIER_LABEL_COUNT] = {{0}};
 #else
 ei_impulse_maf classifier_maf[0];
 #endif
-static size_t slice_offset = 0;
-static bool feature_buffer_full = false;
+static size_t feature_window_head = 0;
+static bool feature_window_full = false;
+#if EI_PORTING_POSIX == 1
+/* Cancel flag of the request that is running on this thread (see ei_classifier_pool) */
+static thread_local const std::atomic<bool> *impulse_cancel_flag = nullptr;
+#endif
 
 /* Private functions ------------------------------------------------------- */
 
+/**
+ * Check whether the running impulse was canceled, either through the
+ * ei_run_impulse_check_canceled porting hook or through the cancel flag
+ * of the request that is running on this thread
+ */
+static EI_IMPULSE_ERROR impulse_check_canceled() {
+#if EI_PORTING_POSIX == 1
+    if (impulse_cancel_flag && impulse_cancel_flag->load(std::memory_order_relaxed)) {
+        return EI_IMPULSE_CANCELED;
+    }
+#endif
+    return ei_run_impulse_check_canceled();
+}
+
 /**
  * @brief      Run a moving average filter over the classification result.
  *             The size of the filter determines the response of the filter.
@@ -173,8 +208,8 @@ static void clear_moving_average_filter(ei_impulse_maf *maf)
  */
 extern "C" void run_classifier_init(void)
 {
-    slice_offset = 0;
-    feature_buffer_full = false;
+    feature_window_head = 0;
+    feature_window_full = false;
 
     for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
         clear_moving_average_filter(&classifier_maf[ix]);
@@ -195,7 +230,9 @@ extern "C" void run_classifier_init(void)
 extern "C" EI_IMPULSE_ERROR run_classifier_continuous(signal_t *signal, ei_impulse_result_t *result,
                                                       bool debug = false, bool enable_maf = true)
 {
-    static ei::matrix_t static_features_matrix(1, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE);
+    /* Ring buffer holding the feature window. A slice is always written contiguously at the
+       head, the extra space at the end catches the part that is wrapped to the start afterwards. */
+    static ei::matrix_t static_features_matrix(1, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE * 2);
     if (!static_features_matrix.buffer) {
         return EI_IMPULSE_ALLOC_FAILED;
     }
@@ -205,10 +242,8 @@ extern "C" EI_IMPULSE_ERROR run_classifier_continuous(signal_t *signal, ei_impul
     uint64_t dsp_start_ms = ei_read_timer_ms();
 
     size_t out_features_index = 0;
-    size_t feature_size;
-    bool is_mfcc = false;
-    bool is_mfe = false;
-    bool is_spectrogram = false;
+    size_t slice_size = 0;
+    void (*normalize_fn)(ei_matrix *matrix, size_t first_feature, ei_matrix *out_matrix, void *config_ptr) = NULL;
 
     for (size_t ix = 0; ix < ei_dsp_blocks_size; ix++) {
         ei_model_dsp_t block = ei_dsp_blocks[ix];
@@ -219,20 +254,20 @@ extern "C" EI_IMPULSE_ERROR run_classifier_continuous(signal_t *signal, ei_impul
         }
 
         ei::matrix_t fm(1, block.n_output_features,
-                        static_features_matrix.buffer + out_features_index + slice_offset);
+                        static_features_matrix.buffer + feature_window_head + slice_size);
 
         /* Switch to the slice version of the mfcc feature extract function */
-        if (block.extract_fn == extract_mfcc_features) {
+        if (block.extract_fn == static_cast<decltype(block.extract_fn)>(&extract_mfcc_features)) {
             block.extract_fn = &extract_mfcc_per_slice_features;
-            is_mfcc = true;
+            normalize_fn = &calc_cepstral_mean_and_var_normalization_mfcc;
         }
         else if (block.extract_fn == extract_spectrogram_features) {
             block.extract_fn = &extract_spectrogram_per_slice_features;
-            is_spectrogram = true;
+            normalize_fn = &calc_cepstral_mean_and_var_normalization_spectrogram;
         }
         else if (block.extract_fn == extract_mfe_features) {
             block.extract_fn = &extract_mfe_per_slice_features;
-            is_mfe = true;
+            normalize_fn = &calc_cepstral_mean_and_var_normalization_mfe;
         }
         else {
             ei_printf("ERR: Unknown extract function, only MFCC, MFE and spectrogram supported\n");
@@ -245,31 +280,31 @@ extern "C" EI_IMPULSE_ERROR run_classifier_continuous(signal_t *signal, ei_impul
             return EI_IMPULSE_DSP_ERROR;
         }
 
-        if (ei_run_impulse_check_canceled() == EI_IMPULSE_CANCELED) {
+        if (impulse_check_canceled() == EI_IMPULSE_CANCELED) {
             return EI_IMPULSE_CANCELED;
         }
 
         out_features_index += block.n_output_features;
 
-        feature_size = (fm.rows * fm.cols);
+        slice_size += (fm.rows * fm.cols);
     }
 
-    /* For as long as the feature buffer isn't completely full, keep moving the slice offset */
-    if (feature_buffer_full == false) {
-        slice_offset += feature_size;
-
-        if (slice_offset > (EI_CLASSIFIER_NN_INPUT_FRAME_SIZE - feature_size)) {
-            feature_buffer_full = true;
-            slice_offset -= feature_size;
-        }
+    /* Move the head, wrapping whatever was written past the end of the window */
+    feature_window_head += slice_size;
+    if (feature_window_head >= EI_CLASSIFIER_NN_INPUT_FRAME_SIZE) {
+        feature_window_head -= EI_CLASSIFIER_NN_INPUT_FRAME_SIZE;
+        memcpy(static_features_matrix.buffer, static_features_matrix.buffer + EI_CLASSIFIER_NN_INPUT_FRAME_SIZE,
+            feature_window_head * sizeof(float));
+        feature_window_full = true;
     }
 
     result->timing.dsp = ei_read_timer_ms() - dsp_start_ms;
 
     if (debug) {
         ei_printf("\r\nFeatures (%d ms.): ", result->timing.dsp);
-        for (size_t ix = 0; ix < static_features_matrix.cols; ix++) {
-            ei_printf_float(static_features_matrix.buffer[ix]);
+        size_t first_feature = feature_window_full ? feature_window_head : 0;
+        for (size_t ix = 0; ix < EI_CLASSIFIER_NN_INPUT_FRAME_SIZE; ix++) {
+            ei_printf_float(static_features_matrix.buffer[(first_feature + ix) % EI_CLASSIFIER_NN_INPUT_FRAME_SIZE]);
             ei_printf(" ");
         }
         ei_printf("\n");
@@ -281,27 +316,9 @@ extern "C" EI_IMPULSE_ERROR run_classifier_continuous(signal_t *signal, ei_impul
     }
 #endif
 
-    if (feature_buffer_full == true) {
-        dsp_start_ms = ei_read_timer_ms();
-        ei::matrix_t classify_matrix(1, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE);
-
-        /* Create a copy of the matrix for normalization */
-        for (size_t m_ix = 0; m_ix < EI_CLASSIFIER_NN_INPUT_FRAME_SIZE; m_ix++) {
-            classify_matrix.buffer[m_ix] = static_features_matrix.buffer[m_ix];
-        }
-
-        if (is_mfcc) {
-            calc_cepstral_mean_and_var_normalization_mfcc(&classify_matrix, ei_dsp_blocks[0].config);
-        }
-        else if (is_spectrogram) {
-            calc_cepstral_mean_and_var_normalization_spectrogram(&classify_matrix, ei_dsp_blocks[0].config);
-        }
-        else if (is_mfe) {
-            calc_cepstral_mean_and_var_normalization_mfe(&classify_matrix, ei_dsp_blocks[0].config);
-        }
-        result->timing.dsp += ei_read_timer_ms() - dsp_start_ms;
-
-        ei_impulse_error = run_inference(&classify_matrix, result, debug);
+    if (feature_window_full == true) {
+        ei_impulse_error = run_inference_continuous(&static_features_matrix, feature_window_head,
+            normalize_fn, ei_dsp_blocks[0].config, result, debug);
 
         if (enable_maf) {
             for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
@@ -311,11 +328,6 @@ extern "C" EI_IMPULSE_ERROR run_classifier_continuous(signal_t *signal, ei_impul
     #endif
             }
         }
-
-        /* Shift the feature buffer for new data */
-        for (size_t i = 0; i < (EI_CLASSIFIER_NN_INPUT_FRAME_SIZE - feature_size); i++) {
-            static_features_matrix.buffer[i] = static_features_matrix.buffer[i + feature_size];
-        }
     }
     return ei_impulse_error;
 }
@@ -413,6 +425,52 @@ __attribute__((unused)) static void fill_result_struct_f32(ei_impulse_result_t *
 
 #if (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE)
 
+#if (EI_CLASSIFIER_COMPILED != 1)
+#if EI_PORTING_POSIX == 1
+/**
+ * A model loaded at runtime. Inferences hold a reference while they use the model,
+ * so a replaced model is only unmapped after the last inference on it has finished.
+ */
+typedef struct ei_tflite_loaded_model {
+    const tflite::Model* model;
+    size_t arena_size;
+    ei_model_file_t file;
+
+    ~ei_tflite_loaded_model() {
+        ei_model_file_unmap(&file);
+    }
+} ei_tflite_loaded_model_t;
+
+/* Published model, only accessed through std::atomic_load / std::atomic_store */
+static std::shared_ptr<ei_tflite_loaded_model_t> tflite_loaded_model;
+/* Model used by the inference that is running on this thread */
+static thread_local std::shared_ptr<ei_tflite_loaded_model_t> tflite_loaded_model_in_use;
+#endif // EI_PORTING_POSIX == 1
+
+/**
+ * Build the op resolver
+ */
+static tflite::MicroOpResolver* inference_tflite_resolver_init() {
+#ifdef EI_TFLITE_RESOLVER
+    EI_TFLITE_RESOLVER
+#else
+    static tflite::AllOpsResolver resolver;
+#endif
+#if defined(EI_CLASSIFIER_ENABLE_DETECTION_POSTPROCESS_OP)
+    resolver.AddCustom("TFLite_Detection_PostProcess", tflite::ops::micro::Register_TFLite_Detection_PostProcess());
+#endif
+    return &resolver;
+}
+
+/**
+ * Get the op resolver, this is only constructed once
+ */
+static tflite::MicroOpResolver* inference_tflite_resolver() {
+    static tflite::MicroOpResolver *op_resolver = inference_tflite_resolver_init();
+    return op_resolver;
+}
+#endif // EI_CLASSIFIER_COMPILED != 1
+
 /**
  * Setup the TFLite runtime
  *
@@ -440,10 +498,47 @@ static EI_IMPULSE_ERROR inference_tflite_setup(uint64_t *ctx_start_ms, TfLiteTen
         return EI_IMPULSE_TFLITE_ARENA_ALLOC_FAILED;
     }
 #else
+    // ======
+    // Initialization code start
+    // This part can be run once, but that would require the TFLite arena
+    // to be allocated at all times, which is not ideal (e.g. when doing MFCC)
+    // ======
+    // Map the model into a usable data structure. This doesn't involve any
+    // copying or parsing, it's a very lightweight operation.
+    const tflite::Model* model = tflite::GetModel(trained_tflite);
+    if (model->version() != TFLITE_SCHEMA_VERSION) {
+        error_reporter->Report(
+            "Model provided is schema version %d not equal "
+            "to supported version %d.",
+            model->version(), TFLITE_SCHEMA_VERSION);
+        return EI_IMPULSE_TFLITE_ERROR;
+    }
+
+    size_t arena_size = EI_CLASSIFIER_TFLITE_ARENA_SIZE;
+
+#if EI_PORTING_POSIX == 1
+    // pick up a model that was loaded at runtime, this reference is dropped in inference_tflite_teardown
+    tflite_loaded_model_in_use = std::atomic_load(&tflite_loaded_model);
+    if (tflite_loaded_model_in_use) {
+        model = tflite_loaded_model_in_use->model;
+        arena_size = tflite_loaded_model_in_use->arena_size;
+    }
+
+    // if the setup fails there's no teardown, so drop the reference on every error return
+    struct loaded_model_pin_guard {
+        bool keep = false;
+        ~loaded_model_pin_guard() {
+            if (!keep) {
+                tflite_loaded_model_in_use.reset();
+            }
+        }
+    } pin_guard;
+#endif
+
     // Create an area of memory to use for input, output, and intermediate arrays.
-    uint8_t *tensor_arena = (uint8_t*)ei_aligned_malloc(16, EI_CLASSIFIER_TFLITE_ARENA_SIZE);
+    uint8_t *tensor_arena = (uint8_t*)ei_aligned_malloc(16, arena_size);
     if (tensor_arena == NULL) {
-        ei_printf("Failed to allocate TFLite arena (%d bytes)\n", EI_CLASSIFIER_TFLITE_ARENA_SIZE);
+        ei_printf("Failed to allocate TFLite arena (%d bytes)\n", (int)arena_size);
         return EI_IMPULSE_TFLITE_ARENA_ALLOC_FAILED;
     }
     *micro_tensor_arena = tensor_arena;
@@ -453,42 +548,6 @@ static EI_IMPULSE_ERROR inference_tflite_setup(uint64_t *ctx_start_ms, TfLiteTen
 
     static bool tflite_first_run = true;
 
-#if (EI_CLASSIFIER_COMPILED != 1)
-        static const tflite::Model* model = nullptr;
-#endif
-
-#if (EI_CLASSIFIER_COMPILED != 1)
-    // ======
-    // Initialization code start
-    // This part can be run once, but that would require the TFLite arena
-    // to be allocated at all times, which is not ideal (e.g. when doing MFCC)
-    // ======
-    if (tflite_first_run) {
-        // Map the model into a usable data structure. This doesn't involve any
-        // copying or parsing, it's a very lightweight operation.
-        model = tflite::GetModel(trained_tflite);
-        if (model->version() != TFLITE_SCHEMA_VERSION) {
-            error_reporter->Report(
-                "Model provided is schema version %d not equal "
-                "to supported version %d.",
-                model->version(), TFLITE_SCHEMA_VERSION);
-            ei_aligned_free(tensor_arena);
-            return EI_IMPULSE_TFLITE_ERROR;
-        }
-    }
-#endif
-
-#if (EI_CLASSIFIER_COMPILED != 1)
-#ifdef EI_TFLITE_RESOLVER
-    EI_TFLITE_RESOLVER
-#else
-    tflite::AllOpsResolver resolver;
-#endif
-#if defined(EI_CLASSIFIER_ENABLE_DETECTION_POSTPROCESS_OP)
-    resolver.AddCustom("TFLite_Detection_PostProcess", tflite::ops::micro::Register_TFLite_Detection_PostProcess());
-#endif
-#endif // EI_CLASSIFIER_COMPILED != 1
-
 #if (EI_CLASSIFIER_COMPILED == 1)
     *input = trained_model_input(0);
     *output = trained_model_output(0);
@@ -499,7 +558,7 @@ static EI_IMPULSE_ERROR inference_tflite_setup(uint64_t *ctx_start_ms, TfLiteTen
 #else
     // Build an interpreter to run the model with.
     tflite::MicroInterpreter *interpreter = new tflite::MicroInterpreter(
-        model, resolver, tensor_arena, EI_CLASSIFIER_TFLITE_ARENA_SIZE, error_reporter);
+        model, *inference_tflite_resolver(), tensor_arena, arena_size, error_reporter);
 
     *micro_interpreter = interpreter;
 
@@ -507,6 +566,8 @@ static EI_IMPULSE_ERROR inference_tflite_setup(uint64_t *ctx_start_ms, TfLiteTen
     TfLiteStatus allocate_status = interpreter->AllocateTensors();
     if (allocate_status != kTfLiteOk) {
         error_reporter->Report("AllocateTensors() failed");
+        delete interpreter;
+        *micro_interpreter = NULL;
         ei_aligned_free(tensor_arena);
         return EI_IMPULSE_TFLITE_ERROR;
     }
@@ -540,22 +601,26 @@ static EI_IMPULSE_ERROR inference_tflite_setup(uint64_t *ctx_start_ms, TfLiteTen
 #endif
         tflite_first_run = false;
     }
+
+#if (EI_CLASSIFIER_COMPILED != 1) && EI_PORTING_POSIX == 1
+    pin_guard.keep = true;
+#endif
     return EI_IMPULSE_OK;
 }
 
 /**
- * Run TFLite model
+ * Invoke the TFLite model and read the results, the interpreter stays alive
+ * so this can be called again with new input data
  *
  * @param   ctx_start_ms    Start time of the setup function (see above)
  * @param   output          Output tensor
  * @param   interpreter     TFLite interpreter (non-compiled models)
- * @param   tensor_arena    Allocated arena (will be freed)
  * @param   result          Struct for results
  * @param   debug           Whether to print debug info
  *
  * @return  EI_IMPULSE_OK if successful
  */
-static EI_IMPULSE_ERROR inference_tflite_run(uint64_t ctx_start_ms,
+static EI_IMPULSE_ERROR inference_tflite_invoke(uint64_t ctx_start_ms,
     TfLiteTensor* output,
 #if EI_CLASSIFIER_OBJECT_DETECTION
     TfLiteTensor* labels_tensor,
@@ -564,20 +629,21 @@ static EI_IMPULSE_ERROR inference_tflite_run(uint64_t ctx_start_ms,
 #if (EI_CLASSIFIER_COMPILED != 1)
     tflite::MicroInterpreter* interpreter,
 #endif
-    uint8_t* tensor_arena,
     ei_impulse_result_t *result,
     bool debug) {
 #if (EI_CLASSIFIER_COMPILED == 1)
-    trained_model_invoke();
+    TfLiteStatus invoke_status = trained_model_invoke();
+    if (invoke_status != kTfLiteOk) {
+        ei_printf("ERR: Invoke failed (%d)\n", invoke_status);
+        return EI_IMPULSE_TFLITE_ERROR;
+    }
 #else
     // Run inference, and report any error
     TfLiteStatus invoke_status = interpreter->Invoke();
     if (invoke_status != kTfLiteOk) {
         error_reporter->Report("Invoke failed (%d)\n", invoke_status);
-        ei_aligned_free(tensor_arena);
         return EI_IMPULSE_TFLITE_ERROR;
     }
-    delete interpreter;
 #endif
 
     uint64_t ctx_end_ms = ei_read_timer_ms();
@@ -600,19 +666,299 @@ static EI_IMPULSE_ERROR inference_tflite_run(uint64_t ctx_start_ms,
         fill_result_struct_f32(result, output->data.f, debug);
     }
 #endif
+    return EI_IMPULSE_OK;
+}
 
+/**
+ * Release the interpreter and arena from inference_tflite_setup
+ *
+ * @param   interpreter     TFLite interpreter (non-compiled models)
+ * @param   tensor_arena    Allocated arena (will be freed)
+ */
+static void inference_tflite_teardown(
+#if (EI_CLASSIFIER_COMPILED != 1)
+    tflite::MicroInterpreter* interpreter,
+#endif
+    uint8_t* tensor_arena) {
 #if (EI_CLASSIFIER_COMPILED == 1)
     trained_model_reset(ei_aligned_free);
 #else
+    delete interpreter;
     ei_aligned_free(tensor_arena);
+#if EI_PORTING_POSIX == 1
+    tflite_loaded_model_in_use.reset();
+#endif
+#endif
+}
+
+/**
+ * Run TFLite model
+ *
+ * @param   ctx_start_ms    Start time of the setup function (see above)
+ * @param   output          Output tensor
+ * @param   interpreter     TFLite interpreter (non-compiled models)
+ * @param   tensor_arena    Allocated arena (will be freed)
+ * @param   result          Struct for results
+ * @param   debug           Whether to print debug info
+ *
+ * @return  EI_IMPULSE_OK if successful
+ */
+static EI_IMPULSE_ERROR inference_tflite_run(uint64_t ctx_start_ms,
+    TfLiteTensor* output,
+#if EI_CLASSIFIER_OBJECT_DETECTION
+    TfLiteTensor* labels_tensor,
+    TfLiteTensor* scores_tensor,
+#endif
+#if (EI_CLASSIFIER_COMPILED != 1)
+    tflite::MicroInterpreter* interpreter,
+#endif
+    uint8_t* tensor_arena,
+    ei_impulse_result_t *result,
+    bool debug) {
+    EI_IMPULSE_ERROR res = inference_tflite_invoke(ctx_start_ms, output,
+#if EI_CLASSIFIER_OBJECT_DETECTION
+        labels_tensor,
+        scores_tensor,
+#endif
+#if (EI_CLASSIFIER_COMPILED != 1)
+        interpreter,
+#endif
+        result, debug);
+
+#if (EI_CLASSIFIER_COMPILED == 1)
+    inference_tflite_teardown(tensor_arena);
+#else
+    inference_tflite_teardown(interpreter, tensor_arena);
 #endif
 
-    if (ei_run_impulse_check_canceled() == EI_IMPULSE_CANCELED) {
+    if (res != EI_IMPULSE_OK) {
+        return res;
+    }
+
+    if (impulse_check_canceled() == EI_IMPULSE_CANCELED) {
         return EI_IMPULSE_CANCELED;
     }
 
     return EI_IMPULSE_OK;
 }
+
+#if (EI_CLASSIFIER_COMPILED != 1)
+/**
+ * Check that a tensor in a model has the number of elements and type that the impulse expects,
+ * an expected type of kTfLiteNoType accepts both float32 and int8 tensors.
+ * The tensor index and the shape come from the model file, the flatbuffers verifier
+ * does not check them.
+ *
+ * @return  EI_IMPULSE_OK if the tensor matches, EI_IMPULSE_MODEL_LOAD_FAILED if the
+ *          tensor index or the shape is invalid, EI_IMPULSE_ERROR_SHAPES_DONT_MATCH otherwise
+ */
+static EI_IMPULSE_ERROR inference_tflite_check_tensor(const tflite::Model* model, int32_t tensor_ix,
+    size_t expected_size, TfLiteType expected_type, const char *name) {
+    const flatbuffers::Vector<flatbuffers::Offset<tflite::Tensor>> *tensors = model->subgraphs()->Get(0)->tensors();
+    if (tensor_ix < 0 || static_cast<uint32_t>(tensor_ix) >= tensors->size()) {
+        ei_printf("ERR: %s tensor index of the model is out of range (%d, %d tensors)\n",
+            name, (int)tensor_ix, (int)tensors->size());
+        return EI_IMPULSE_MODEL_LOAD_FAILED;
+    }
+    const tflite::Tensor *tensor = tensors->Get(tensor_ix);
+
+    size_t size = 1;
+    if (tensor->shape()) {
+        for (size_t ix = 0; ix < tensor->shape()->size(); ix++) {
+            int32_t dim = tensor->shape()->Get(ix);
+            if (dim < 0) {
+                ei_printf("ERR: %s tensor of the model has a negative dimension (%d)\n", name, (int)dim);
+                return EI_IMPULSE_MODEL_LOAD_FAILED;
+            }
+            size *= static_cast<size_t>(dim);
+        }
+    }
+
+    TfLiteType type;
+    if (tflite::ConvertTensorType(tensor->type(), &type, error_reporter) != kTfLiteOk) {
+        return EI_IMPULSE_ERROR_SHAPES_DONT_MATCH;
+    }
+
+    bool type_ok = expected_type == kTfLiteNoType ?
+        (type == kTfLiteFloat32 || type == kTfLiteInt8) : type == expected_type;
+    if (size != expected_size || !type_ok) {
+        ei_printf("ERR: %s tensor of the model does not match the impulse (%d elements, type %d, expected %d elements, type %d)\n",
+            name, (int)size, (int)type, (int)expected_size, (int)expected_type);
+        return EI_IMPULSE_ERROR_SHAPES_DONT_MATCH;
+    }
+    return EI_IMPULSE_OK;
+}
+
+/**
+ * Validate a TFLite model buffer before it's used in place of trained_tflite.
+ * Runs the flatbuffers verifier, checks that every operator is available in
+ * the op resolver and that the input / output tensors match the impulse.
+ *
+ * @param   buffer       Model buffer
+ * @param   length       Length of the model buffer
+ * @param   model        Out parameter, receives the model
+ * @param   input_size   Expected number of input elements (default: the impulse)
+ * @param   input_type   Expected input type (kTfLiteNoType: float32 or int8)
+ * @param   output_size  Expected number of output elements (default: the impulse)
+ * @param   output_type  Expected output type (kTfLiteNoType: float32 or int8)
+ *
+ * @return  EI_IMPULSE_OK if successful
+ */
+static EI_IMPULSE_ERROR inference_tflite_verify_model(const uint8_t *buffer, size_t length,
+    const tflite::Model** model,
+    size_t input_size = EI_CLASSIFIER_NN_INPUT_FRAME_SIZE,
+    TfLiteType input_type = (TfLiteType)EI_CLASSIFIER_TFLITE_INPUT_DATATYPE,
+    size_t output_size = EI_CLASSIFIER_LABEL_COUNT,
+    TfLiteType output_type = (TfLiteType)EI_CLASSIFIER_TFLITE_OUTPUT_DATATYPE) {
+    flatbuffers::Verifier verifier(buffer, length);
+    if (!tflite::VerifyModelBuffer(verifier)) {
+        ei_printf("ERR: Model is not a valid TFLite flatbuffer\n");
+        return EI_IMPULSE_MODEL_LOAD_FAILED;
+    }
+
+    const tflite::Model* m = tflite::GetModel(buffer);
+    if (m->version() != TFLITE_SCHEMA_VERSION) {
+        ei_printf("ERR: Model provided is schema version %d not equal to supported version %d\n",
+            (int)m->version(), TFLITE_SCHEMA_VERSION);
+        return EI_IMPULSE_MODEL_LOAD_FAILED;
+    }
+
+    if (!m->subgraphs() || m->subgraphs()->size() != 1 || !m->operator_codes()) {
+        ei_printf("ERR: Model should have exactly one subgraph\n");
+        return EI_IMPULSE_MODEL_LOAD_FAILED;
+    }
+
+    const tflite::SubGraph *subgraph = m->subgraphs()->Get(0);
+    if (!subgraph->tensors() || !subgraph->inputs() || !subgraph->outputs() ||
+            subgraph->inputs()->size() < 1 || subgraph->outputs()->size() < 1) {
+        ei_printf("ERR: Model has no input or output tensors\n");
+        return EI_IMPULSE_MODEL_LOAD_FAILED;
+    }
+
+    // every operator needs to be in the resolver, otherwise AllocateTensors fails later on
+    for (size_t ix = 0; ix < m->operator_codes()->size(); ix++) {
+        const tflite::OperatorCode *opcode = m->operator_codes()->Get(ix);
+        const TfLiteRegistration *registration = nullptr;
+        if (tflite::GetRegistrationFromOpCode(opcode, *inference_tflite_resolver(), error_reporter, &registration) != kTfLiteOk) {
+            ei_printf("ERR: Model uses operator %s, which is not in the op resolver\n",
+                opcode->custom_code() ? opcode->custom_code()->c_str() : tflite::EnumNameBuiltinOperator(opcode->builtin_code()));
+            return EI_IMPULSE_TFLITE_ERROR;
+        }
+    }
+
+    EI_IMPULSE_ERROR res = inference_tflite_check_tensor(m, subgraph->inputs()->Get(0), input_size, input_type, "Input");
+    if (res != EI_IMPULSE_OK) {
+        return res;
+    }
+#if EI_CLASSIFIER_OBJECT_DETECTION != 1
+    res = inference_tflite_check_tensor(m, subgraph->outputs()->Get(0), output_size, output_type, "Output");
+    if (res != EI_IMPULSE_OK) {
+        return res;
+    }
+#endif
+
+    *model = m;
+    return EI_IMPULSE_OK;
+}
+
+/**
+ * Build an interpreter for a model on its own arena and invoke it once on an
+ * all-zero input. This checks that the arena is large enough and initializes the
+ * kernels and model pages before the model is used for real inferences.
+ *
+ * @param   model       Model to warm up
+ * @param   arena_size  Size of the TFLite arena needed by the model
+ *
+ * @return  EI_IMPULSE_OK if successful
+ */
+static EI_IMPULSE_ERROR inference_tflite_warm_up(const tflite::Model* model, size_t arena_size) {
+    uint8_t *tensor_arena = (uint8_t*)ei_aligned_malloc(16, arena_size);
+    if (tensor_arena == NULL) {
+        ei_printf("Failed to allocate TFLite arena (%d bytes)\n", (int)arena_size);
+        return EI_IMPULSE_TFLITE_ARENA_ALLOC_FAILED;
+    }
+
+    EI_IMPULSE_ERROR res = EI_IMPULSE_OK;
+    {
+        tflite::MicroInterpreter interpreter(model, *inference_tflite_resolver(), tensor_arena, arena_size, error_reporter);
+
+        if (interpreter.AllocateTensors() != kTfLiteOk) {
+            ei_printf("ERR: AllocateTensors() failed, is the arena (%d bytes) large enough?\n", (int)arena_size);
+            res = EI_IMPULSE_TFLITE_ARENA_ALLOC_FAILED;
+        }
+        else {
+            TfLiteTensor *input = interpreter.input(0);
+            memset(input->data.raw, 0, input->bytes);
+
+            if (interpreter.Invoke() != kTfLiteOk) {
+                ei_printf("ERR: Invoke failed on the new model\n");
+                res = EI_IMPULSE_TFLITE_ERROR;
+            }
+        }
+    }
+
+    ei_aligned_free(tensor_arena);
+    return res;
+}
+
+#if EI_PORTING_POSIX == 1
+/**
+ * @brief      Use a .tflite file in place of the model that was compiled in (trained_tflite).
+ *             The file is memory mapped read-only, so its pages are shared between
+ *             all processes that load the same file. It is validated and warmed up
+ *             (one invoke on its own arena) before it replaces the current model.
+ *             The model needs the same input and output shape as the impulse.
+ *
+ *             This can be called from a background thread while another thread keeps
+ *             running the classifier (e.g. run_classifier_continuous). The swap is a
+ *             single pointer store, so the next inference uses the new model and no
+ *             slice is skipped. The old model is released once the last inference
+ *             that uses it has finished.
+ *
+ * @param      path        Path to the .tflite file
+ * @param[in]  arena_size  Size of the TFLite arena needed by the model
+ *
+ * @return     The ei impulse error.
+ */
+extern "C" EI_IMPULSE_ERROR run_classifier_load_model_file(const char *path,
+                                                           size_t arena_size = EI_CLASSIFIER_TFLITE_ARENA_SIZE)
+{
+    std::shared_ptr<ei_tflite_loaded_model_t> loaded_model = std::make_shared<ei_tflite_loaded_model_t>();
+    loaded_model->file.buffer = NULL;
+    loaded_model->file.length = 0;
+    loaded_model->arena_size = arena_size;
+
+    EI_IMPULSE_ERROR res = ei_model_file_map(path, &loaded_model->file);
+    if (res != EI_IMPULSE_OK) {
+        return res;
+    }
+
+    res = inference_tflite_verify_model(loaded_model->file.buffer, loaded_model->file.length, &loaded_model->model);
+    if (res != EI_IMPULSE_OK) {
+        return res;
+    }
+
+    res = inference_tflite_warm_up(loaded_model->model, arena_size);
+    if (res != EI_IMPULSE_OK) {
+        return res;
+    }
+
+    std::atomic_store(&tflite_loaded_model, loaded_model);
+
+    return EI_IMPULSE_OK;
+}
+
+/**
+ * @brief      Release a model loaded through run_classifier_load_model_file
+ *             and go back to the model that was compiled in. Like loading,
+ *             this is safe to call while the classifier runs on another thread.
+ */
+extern "C" void run_classifier_unload_model_file(void)
+{
+    std::atomic_store(&tflite_loaded_model, std::shared_ptr<ei_tflite_loaded_model_t>());
+}
+#endif // EI_PORTING_POSIX == 1
+#endif // EI_CLASSIFIER_COMPILED != 1
 #endif // (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE)
 
 /**
@@ -928,13 +1274,93 @@ extern "C" EI_IMPULSE_ERROR run_inference(
 
 #endif
 
-    if (ei_run_impulse_check_canceled() == EI_IMPULSE_CANCELED) {
+    if (impulse_check_canceled() == EI_IMPULSE_CANCELED) {
         return EI_IMPULSE_CANCELED;
     }
 
     return EI_IMPULSE_OK;
 }
 
+/**
+ * @brief      Normalize the continuous feature window and do inferencing over it.
+ *             For float TFLite models the window is normalized straight into the input
+ *             tensor, so no intermediate matrix is allocated.
+ *
+ * @param      features_matrix  Feature window ring buffer (not modified)
+ * @param      first_feature    Index of the oldest feature in the ring buffer
+ * @param      normalize_fn     Normalization function for the DSP block
+ * @param      config_ptr       DSP block config passed to normalize_fn
+ * @param      result           Output classifier results
+ * @param[in]  debug            Debug output enable
+ *
+ * @return     The ei impulse error.
+ */
+static EI_IMPULSE_ERROR run_inference_continuous(ei::matrix_t *features_matrix, size_t first_feature,
+    void (*normalize_fn)(ei_matrix *matrix, size_t first_feature, ei_matrix *out_matrix, void *config_ptr),
+    void *config_ptr, ei_impulse_result_t *result, bool debug)
+{
+#if (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE) && (EI_CLASSIFIER_OBJECT_DETECTION != 1) && (EI_CLASSIFIER_HAS_ANOMALY != 1)
+    uint64_t ctx_start_ms;
+    TfLiteTensor* input;
+    TfLiteTensor* output;
+    uint8_t* tensor_arena;
+
+#if (EI_CLASSIFIER_COMPILED == 1)
+    EI_IMPULSE_ERROR init_res = inference_tflite_setup(&ctx_start_ms, &input, &output, &tensor_arena);
+#else
+    tflite::MicroInterpreter* interpreter;
+    EI_IMPULSE_ERROR init_res = inference_tflite_setup(&ctx_start_ms, &input, &output, &interpreter, &tensor_arena);
+#endif
+    if (init_res != EI_IMPULSE_OK) {
+        return init_res;
+    }
+
+    uint64_t dsp_start_ms = ei_read_timer_ms();
+
+    if (input->type == TfLiteType::kTfLiteFloat32) {
+        // normalize into the input tensor itself
+        ei::matrix_t classify_matrix(1, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE, input->data.f);
+        normalize_fn(features_matrix, first_feature, &classify_matrix, config_ptr);
+    }
+    else {
+        ei::matrix_t classify_matrix(1, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE);
+        if (!classify_matrix.buffer) {
+#if (EI_CLASSIFIER_COMPILED == 1)
+            inference_tflite_teardown(tensor_arena);
+#else
+            inference_tflite_teardown(interpreter, tensor_arena);
+#endif
+            return EI_IMPULSE_ALLOC_FAILED;
+        }
+        normalize_fn(features_matrix, first_feature, &classify_matrix, config_ptr);
+        for (size_t ix = 0; ix < EI_CLASSIFIER_NN_INPUT_FRAME_SIZE; ix++) {
+            input->data.int8[ix] = static_cast<int8_t>(round(classify_matrix.buffer[ix] / input->params.scale) + input->params.zero_point);
+        }
+    }
+
+    result->timing.dsp += ei_read_timer_ms() - dsp_start_ms;
+
+    ctx_start_ms = ei_read_timer_ms();
+
+#if (EI_CLASSIFIER_COMPILED == 1)
+    return inference_tflite_run(ctx_start_ms, output, tensor_arena, result, debug);
+#else
+    return inference_tflite_run(ctx_start_ms, output, interpreter, tensor_arena, result, debug);
+#endif
+#else
+    uint64_t dsp_start_ms = ei_read_timer_ms();
+    ei::matrix_t classify_matrix(1, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE);
+    if (!classify_matrix.buffer) {
+        return EI_IMPULSE_ALLOC_FAILED;
+    }
+
+    normalize_fn(features_matrix, first_feature, &classify_matrix, config_ptr);
+    result->timing.dsp += ei_read_timer_ms() - dsp_start_ms;
+
+    return run_inference(&classify_matrix, result, debug);
+#endif
+}
+
 extern "C" EI_IMPULSE_ERROR run_inference_i16(
     ei::matrix_i32_t *fmatrix,
     ei_impulse_result_t *result,
@@ -978,7 +1404,8 @@ extern "C" EI_IMPULSE_ERROR run_inference_i16(
                 calc >>= 8; // Shift to int8_t domain
                 input->data.int8[ix] = static_cast<int8_t>(calc + input->params.zero_point);
             } else {
-                numpy::int16_to_float((EIDSP_i16 *)&fmatrix->buffer[ix], &input->data.f[ix], 1);
+                // q15 in 32 bits, features (e.g. MFCC) can be larger than 1
+                input->data.f[ix] = (float)fmatrix->buffer[ix] / 32768.f;
             }
         }
 
@@ -1033,7 +1460,7 @@ extern "C" EI_IMPULSE_ERROR run_inference_i16(
 
 #endif
 
-    if (ei_run_impulse_check_canceled() == EI_IMPULSE_CANCELED) {
+    if (impulse_check_canceled() == EI_IMPULSE_CANCELED) {
         return EI_IMPULSE_CANCELED;
     }
 
@@ -1041,6 +1468,190 @@ extern "C" EI_IMPULSE_ERROR run_inference_i16(
 #endif // OBJECT_DETECTION
 }
 
+/**
+ * Run all DSP blocks of the impulse over a signal
+ * @param signal Signal with a full model window
+ * @param features_matrix Matrix of EI_CLASSIFIER_NN_INPUT_FRAME_SIZE features to write to
+ * @return EI_IMPULSE_OK if successful
+ */
+#if EI_CLASSIFIER_PARALLEL_DSP_BLOCKS == 1 && EI_PORTING_POSIX == 1
+/**
+ * Pool that the DSP blocks run on, started on first use and kept for the
+ * lifetime of the process
+ */
+static ei_dsp_block_pool& dsp_block_pool() {
+    static ei_dsp_block_pool pool([]() -> size_t {
+        size_t threads = EI_CLASSIFIER_DSP_BLOCK_THREADS;
+        if (threads == 0) {
+            threads = std::thread::hardware_concurrency();
+        }
+        // the thread that runs the impulse works on blocks as well
+        return threads > 1 ? threads - 1 : 0;
+    }());
+    return pool;
+}
+
+/**
+ * Run the DSP blocks concurrently. Every block writes to its own slice of the
+ * features matrix, so the layout is the same as when the blocks run one after
+ * another. Blocks that share power spectra (see stft_cache_begin) run in order
+ * on the same thread. Every thread gets its own copy of the signal, as framing
+ * the signal shortens its total_length. After a block fails or the impulse is
+ * canceled the blocks that did not start yet are skipped.
+ */
+static EI_IMPULSE_ERROR extract_features_parallel(signal_t *signal, ei::matrix_t *features_matrix,
+    const ei_model_dsp_t *blocks, size_t blocks_size, ei_dsp_stft_cache_t *block_stft_cache)
+{
+    std::vector<size_t> out_features_index(blocks_size);
+    std::vector<size_t> block_group(blocks_size);
+    size_t group_count = 0;
+    size_t features_count = 0;
+
+    for (size_t ix = 0; ix < blocks_size; ix++) {
+        if (features_count + blocks[ix].n_output_features > features_matrix->rows * features_matrix->cols) {
+            ei_printf("ERR: Would write outside feature buffer\n");
+            return EI_IMPULSE_DSP_ERROR;
+        }
+        out_features_index[ix] = features_count;
+        features_count += blocks[ix].n_output_features;
+
+        block_group[ix] = group_count;
+        ei_dsp_stft_key_t key;
+        if (stft_block_key(&blocks[ix], &key)) {
+            for (size_t prev_ix = 0; prev_ix < ix; prev_ix++) {
+                ei_dsp_stft_key_t prev_key;
+                if (stft_block_key(&blocks[prev_ix], &prev_key) && stft_key_equals(&key, &prev_key)) {
+                    block_group[ix] = block_group[prev_ix];
+                    break;
+                }
+            }
+        }
+        if (block_group[ix] == group_count) {
+            group_count++;
+        }
+    }
+
+    std::vector<int> block_ret(blocks_size, EIDSP_OK);
+    std::vector<char> block_canceled(blocks_size, false);
+    std::atomic<bool> stop(false);
+    const std::atomic<bool> *cancel_flag = impulse_cancel_flag;
+
+    // the worker runs on behalf of this impulse, and goes back to its own
+    // state when the group is done (or a block throws)
+    struct thread_state_scope {
+        thread_state_scope(ei_dsp_stft_cache_t *cache, const std::atomic<bool> *cancel_flag)
+            : prev_stft_cache(stft_cache), prev_cancel_flag(impulse_cancel_flag)
+        {
+            stft_cache = cache;
+            impulse_cancel_flag = cancel_flag;
+        }
+
+        ~thread_state_scope() {
+            stft_cache = prev_stft_cache;
+            impulse_cancel_flag = prev_cancel_flag;
+        }
+
+        ei_dsp_stft_cache_t *prev_stft_cache;
+        const std::atomic<bool> *prev_cancel_flag;
+    };
+
+    dsp_block_pool().run(group_count, [&](size_t group) {
+        thread_state_scope thread_state(block_stft_cache, cancel_flag);
+
+        signal_t group_signal = *signal;
+
+        for (size_t ix = 0; ix < blocks_size; ix++) {
+            if (block_group[ix] != group) {
+                continue;
+            }
+            if (stop.load()) {
+                // another block failed or the impulse was canceled
+                continue;
+            }
+
+            ei_model_dsp_t block = blocks[ix];
+            ei::matrix_t fm(1, block.n_output_features, features_matrix->buffer + out_features_index[ix]);
+
+            block_ret[ix] = block.extract_fn(&group_signal, &fm, block.config, EI_CLASSIFIER_FREQUENCY);
+            if (block_ret[ix] != EIDSP_OK) {
+                stop.store(true);
+            }
+            else if (impulse_check_canceled() == EI_IMPULSE_CANCELED) {
+                block_canceled[ix] = true;
+                stop.store(true);
+            }
+        }
+    });
+
+    EI_IMPULSE_ERROR res = EI_IMPULSE_OK;
+    for (size_t ix = 0; ix < blocks_size; ix++) {
+        if (block_ret[ix] != EIDSP_OK) {
+            ei_printf("ERR: Failed to run DSP process (%d)\n", block_ret[ix]);
+            return EI_IMPULSE_DSP_ERROR;
+        }
+        if (block_canceled[ix]) {
+            res = EI_IMPULSE_CANCELED;
+        }
+    }
+
+    return res;
+}
+#endif // EI_CLASSIFIER_PARALLEL_DSP_BLOCKS == 1 && EI_PORTING_POSIX == 1
+
+/**
+ * Run DSP blocks over a signal and write their features one after another
+ *
+ * @param signal           Signal with a full model window
+ * @param features_matrix  Output, at least as large as the features of all blocks
+ * @param blocks           DSP blocks (default: the blocks of the impulse)
+ * @param blocks_size      Number of DSP blocks
+ *
+ * @return EI_IMPULSE_OK if successful
+ */
+static EI_IMPULSE_ERROR extract_features(signal_t *signal, ei::matrix_t *features_matrix,
+    const ei_model_dsp_t *blocks = ei_dsp_blocks, size_t blocks_size = ei_dsp_blocks_size)
+{
+    EI_IMPULSE_ERROR res = EI_IMPULSE_OK;
+    size_t out_features_index = 0;
+
+    // blocks that frame the signal the same way share their power spectra
+    ei_dsp_stft_cache_scope block_stft_cache(EI_CLASSIFIER_FREQUENCY, blocks, blocks_size);
+
+#if EI_CLASSIFIER_PARALLEL_DSP_BLOCKS == 1 && EI_PORTING_POSIX == 1
+    if (blocks_size > 1) {
+        return extract_features_parallel(signal, features_matrix, blocks, blocks_size, &block_stft_cache.cache);
+    }
+#endif
+
+    for (size_t ix = 0; ix < blocks_size; ix++) {
+        ei_model_dsp_t block = blocks[ix];
+
+        if (out_features_index + block.n_output_features > features_matrix->rows * features_matrix->cols) {
+            ei_printf("ERR: Would write outside feature buffer\n");
+            res = EI_IMPULSE_DSP_ERROR;
+            break;
+        }
+
+        ei::matrix_t fm(1, block.n_output_features, features_matrix->buffer + out_features_index);
+
+        int ret = block.extract_fn(signal, &fm, block.config, EI_CLASSIFIER_FREQUENCY);
+        if (ret != EIDSP_OK) {
+            ei_printf("ERR: Failed to run DSP process (%d)\n", ret);
+            res = EI_IMPULSE_DSP_ERROR;
+            break;
+        }
+
+        if (impulse_check_canceled() == EI_IMPULSE_CANCELED) {
+            res = EI_IMPULSE_CANCELED;
+            break;
+        }
+
+        out_features_index += block.n_output_features;
+    }
+
+    return res;
+}
+
 /**
  * Run the classifier over a raw features array
  * @param raw_features Raw features array
@@ -1078,29 +1689,9 @@ extern "C" EI_IMPULSE_ERROR run_classifier(
 
     uint64_t dsp_start_ms = ei_read_timer_ms();
 
-    size_t out_features_index = 0;
-
-    for (size_t ix = 0; ix < ei_dsp_blocks_size; ix++) {
-        ei_model_dsp_t block = ei_dsp_blocks[ix];
-
-        if (out_features_index + block.n_output_features > EI_CLASSIFIER_NN_INPUT_FRAME_SIZE) {
-            ei_printf("ERR: Would write outside feature buffer\n");
-            return EI_IMPULSE_DSP_ERROR;
-        }
-
-        ei::matrix_t fm(1, block.n_output_features, features_matrix.buffer + out_features_index);
-
-        int ret = block.extract_fn(signal, &fm, block.config, EI_CLASSIFIER_FREQUENCY);
-        if (ret != EIDSP_OK) {
-            ei_printf("ERR: Failed to run DSP process (%d)\n", ret);
-            return EI_IMPULSE_DSP_ERROR;
-        }
-
-        if (ei_run_impulse_check_canceled() == EI_IMPULSE_CANCELED) {
-            return EI_IMPULSE_CANCELED;
-        }
-
-        out_features_index += block.n_output_features;
+    EI_IMPULSE_ERROR dsp_res = extract_features(signal, &features_matrix);
+    if (dsp_res != EI_IMPULSE_OK) {
+        return dsp_res;
     }
 
     result->timing.dsp = ei_read_timer_ms() - dsp_start_ms;
@@ -1123,6 +1714,98 @@ extern "C" EI_IMPULSE_ERROR run_classifier(
     return run_inference(&features_matrix, result, debug);
 }
 
+/**
+ * Run the classifier over a batch of signals, e.g. when re-processing recorded data.
+ * The interpreter is set up once for the whole batch, and for float models the
+ * features are extracted straight into the input tensor.
+ * @param signals Array of signals, each with a full model window
+ * @param signals_count Number of signals
+ * @param results Array of signals_count objects to store the results in
+ * @param debug Whether to show debug messages (default: false)
+ */
+extern "C" EI_IMPULSE_ERROR run_classifier_batch(
+    signal_t *signals[],
+    size_t signals_count,
+    ei_impulse_result_t results[],
+    bool debug = false)
+{
+#if (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE) && (EI_CLASSIFIER_OBJECT_DETECTION != 1) && (EI_CLASSIFIER_HAS_ANOMALY != 1)
+    if (signals_count == 0) {
+        return EI_IMPULSE_OK;
+    }
+
+    uint64_t ctx_start_ms;
+    TfLiteTensor* input;
+    TfLiteTensor* output;
+    uint8_t* tensor_arena;
+
+#if (EI_CLASSIFIER_COMPILED == 1)
+    EI_IMPULSE_ERROR res = inference_tflite_setup(&ctx_start_ms, &input, &output, &tensor_arena);
+#else
+    tflite::MicroInterpreter* interpreter;
+    EI_IMPULSE_ERROR res = inference_tflite_setup(&ctx_start_ms, &input, &output, &interpreter, &tensor_arena);
+#endif
+    if (res != EI_IMPULSE_OK) {
+        return res;
+    }
+
+    // float models get their features written into the input tensor, int8 models
+    // go through a scratch matrix that's quantized into the tensor
+    bool float_input = input->type == TfLiteType::kTfLiteFloat32;
+    ei::matrix_t features_matrix(1, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE, float_input ? input->data.f : NULL);
+    if (!features_matrix.buffer) {
+        res = EI_IMPULSE_ALLOC_FAILED;
+    }
+
+    for (size_t ix = 0; ix < signals_count && res == EI_IMPULSE_OK; ix++) {
+        ei_impulse_result_t *result = &results[ix];
+        memset(result, 0, sizeof(ei_impulse_result_t));
+
+        uint64_t dsp_start_ms = ei_read_timer_ms();
+
+        res = extract_features(signals[ix], &features_matrix);
+        if (res != EI_IMPULSE_OK) {
+            break;
+        }
+
+        if (!float_input) {
+            for (size_t fx = 0; fx < EI_CLASSIFIER_NN_INPUT_FRAME_SIZE; fx++) {
+                input->data.int8[fx] = static_cast<int8_t>(round(features_matrix.buffer[fx] / input->params.scale) + input->params.zero_point);
+            }
+        }
+
+        ctx_start_ms = ei_read_timer_ms();
+        result->timing.dsp = ctx_start_ms - dsp_start_ms;
+
+#if (EI_CLASSIFIER_COMPILED == 1)
+        res = inference_tflite_invoke(ctx_start_ms, output, result, debug);
+#else
+        res = inference_tflite_invoke(ctx_start_ms, output, interpreter, result, debug);
+#endif
+
+        if (res == EI_IMPULSE_OK && impulse_check_canceled() == EI_IMPULSE_CANCELED) {
+            res = EI_IMPULSE_CANCELED;
+        }
+    }
+
+#if (EI_CLASSIFIER_COMPILED == 1)
+    inference_tflite_teardown(tensor_arena);
+#else
+    inference_tflite_teardown(interpreter, tensor_arena);
+#endif
+
+    return res;
+#else
+    for (size_t ix = 0; ix < signals_count; ix++) {
+        EI_IMPULSE_ERROR res = run_classifier(signals[ix], &results[ix], debug);
+        if (res != EI_IMPULSE_OK) {
+            return res;
+        }
+    }
+    return EI_IMPULSE_OK;
+#endif
+}
+
 #if defined(EI_CLASSIFIER_USE_QUANTIZED_DSP_BLOCK) && EI_CLASSIFIER_USE_QUANTIZED_DSP_BLOCK == 1
 
 extern "C" EI_IMPULSE_ERROR run_classifier_i16(
@@ -1139,7 +1822,7 @@ extern "C" EI_IMPULSE_ERROR run_classifier_i16(
 
     size_t out_features_index = 0;
 
-    for (size_t ix = 0; ix < ei_dsp_blocks_size; ix++) {
+    for (size_t ix = 0; ix < ei_dsp_blocks_i16_size; ix++) {
         ei_model_dsp_i16_t block = ei_dsp_blocks_i16[ix];
 
         if (out_features_index + block.n_output_features > EI_CLASSIFIER_NN_INPUT_FRAME_SIZE) {
@@ -1156,7 +1839,7 @@ extern "C" EI_IMPULSE_ERROR run_classifier_i16(
             return EI_IMPULSE_DSP_ERROR;
         }
 
-        if (ei_run_impulse_check_canceled() == EI_IMPULSE_CANCELED) {
+        if (impulse_check_canceled() == EI_IMPULSE_CANCELED) {
             return EI_IMPULSE_CANCELED;
         }
 
@@ -1187,78 +1870,75 @@ extern "C" EI_IMPULSE_ERROR run_classifier_i16(
 /**
  * @brief      Calculates the cepstral mean and variable normalization.
  *
- * @param      matrix      Source and destination matrix
- * @param      config_ptr  ei_dsp_config_mfcc_t struct pointer
+ * @param      matrix         Source matrix (ring buffer of the feature window)
+ * @param      first_feature  Index of the oldest feature in the source matrix
+ * @param      out_matrix     Destination matrix (window in order)
+ * @param      config_ptr     ei_dsp_config_mfcc_t struct pointer
  */
-static void calc_cepstral_mean_and_var_normalization_mfcc(ei_matrix *matrix, void *config_ptr)
+static void calc_cepstral_mean_and_var_normalization_mfcc(ei_matrix *matrix, size_t first_feature, ei_matrix *out_matrix, void *config_ptr)
 {
     ei_dsp_config_mfcc_t *config = (ei_dsp_config_mfcc_t *)config_ptr;
 
     /* Modify rows and colums ration for matrix normalization */
-    matrix->rows = EI_CLASSIFIER_NN_INPUT_FRAME_SIZE / config->num_cepstral;
-    matrix->cols = config->num_cepstral;
+    ei::matrix_t window(EI_CLASSIFIER_NN_INPUT_FRAME_SIZE / config->num_cepstral, config->num_cepstral, matrix->buffer);
+    ei::matrix_t out(window.rows, window.cols, out_matrix->buffer);
 
     // cepstral mean and variance normalization
-    int ret = speechpy::processing::cmvnw(matrix, config->win_size, true, false);
+    int ret = speechpy::processing::cmvnw(&window, first_feature / window.cols, &out, config->win_size, true, false);
     if (ret != EIDSP_OK) {
         ei_printf("ERR: cmvnw failed (%d)\n", ret);
         return;
     }
-
-    /* Reset rows and columns ratio */
-    matrix->rows = 1;
-    matrix->cols = EI_CLASSIFIER_NN_INPUT_FRAME_SIZE;
 }
 
 /**
  * @brief      Calculates the cepstral mean and variable normalization.
  *
- * @param      matrix      Source and destination matrix
- * @param      config_ptr  ei_dsp_config_mfe_t struct pointer
+ * @param      matrix         Source matrix (ring buffer of the feature window)
+ * @param      first_feature  Index of the oldest feature in the source matrix
+ * @param      out_matrix     Destination matrix (window in order)
+ * @param      config_ptr     ei_dsp_config_mfe_t struct pointer
  */
-static void calc_cepstral_mean_and_var_normalization_mfe(ei_matrix *matrix, void *config_ptr)
+static void calc_cepstral_mean_and_var_normalization_mfe(ei_matrix *matrix, size_t first_feature, ei_matrix *out_matrix, void *config_ptr)
 {
     ei_dsp_config_mfe_t *config = (ei_dsp_config_mfe_t *)config_ptr;
 
     /* Modify rows and colums ration for matrix normalization */
-    matrix->rows = EI_CLASSIFIER_NN_INPUT_FRAME_SIZE / config->num_filters;
-    matrix->cols = config->num_filters;
+    ei::matrix_t window(EI_CLASSIFIER_NN_INPUT_FRAME_SIZE / config->num_filters, config->num_filters, matrix->buffer);
+    ei::matrix_t out(window.rows, window.cols, out_matrix->buffer);
 
     // cepstral mean and variance normalization
-    int ret = speechpy::processing::cmvnw(matrix, config->win_size, false, true);
+    int ret = speechpy::processing::cmvnw(&window, first_feature / window.cols, &out, config->win_size, false, true);
     if (ret != EIDSP_OK) {
         ei_printf("ERR: cmvnw failed (%d)\n", ret);
         return;
     }
-
-    /* Reset rows and columns ratio */
-    matrix->rows = 1;
-    matrix->cols = EI_CLASSIFIER_NN_INPUT_FRAME_SIZE;
 }
 
 /**
  * @brief      Calculates the cepstral mean and variable normalization.
  *
- * @param      matrix      Source and destination matrix
- * @param      config_ptr  ei_dsp_config_spectrogram_t struct pointer
+ * @param      matrix         Source matrix (ring buffer of the feature window)
+ * @param      first_feature  Index of the oldest feature in the source matrix
+ * @param      out_matrix     Destination matrix (window in order)
+ * @param      config_ptr     ei_dsp_config_spectrogram_t struct pointer
  */
-static void calc_cepstral_mean_and_var_normalization_spectrogram(ei_matrix *matrix, void *config_ptr)
+static void calc_cepstral_mean_and_var_normalization_spectrogram(ei_matrix *matrix, size_t first_feature, ei_matrix *out_matrix, void *config_ptr)
 {
-    ei_dsp_config_spectrogram_t *config = (ei_dsp_config_spectrogram_t *)config_ptr;
+    (void)config_ptr;
 
-    /* Modify rows and colums ration for matrix normalization */
-    matrix->cols = config->fft_length / 2 + 1;
-    matrix->rows = EI_CLASSIFIER_NN_INPUT_FRAME_SIZE / matrix->cols;
+    /* Linearize the ring buffer, normalization is over the whole window */
+    memcpy(out_matrix->buffer, matrix->buffer + first_feature,
+        (EI_CLASSIFIER_NN_INPUT_FRAME_SIZE - first_feature) * sizeof(float));
+    memcpy(out_matrix->buffer + (EI_CLASSIFIER_NN_INPUT_FRAME_SIZE - first_feature), matrix->buffer,
+        first_feature * sizeof(float));
 
-    int ret = numpy::normalize(matrix);
+    ei::matrix_t out(1, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE, out_matrix->buffer);
+    int ret = numpy::normalize(&out);
     if (ret != EIDSP_OK) {
         ei_printf("ERR: normalization failed (%d)\n", ret);
         return;
     }
-
-    /* Reset rows and columns ratio */
-    matrix->rows = 1;
-    matrix->cols = EI_CLASSIFIER_NN_INPUT_FRAME_SIZE;
 }
 
 /**
@@ -1353,7 +2033,7 @@ extern "C" EI_IMPULSE_ERROR run_classifier_image_quantized(
         return EI_IMPULSE_DSP_ERROR;
     }
 
-    if (ei_run_impulse_check_canceled() == EI_IMPULSE_CANCELED) {
+    if (impulse_check_canceled() == EI_IMPULSE_CANCELED) {
         return EI_IMPULSE_CANCELED;
     }
 
@@ -1438,7 +2118,7 @@ __attribute__((unused)) EI_IMPULSE_ERROR run_impulse(
         }
 #endif
 
-        if (ei_run_impulse_check_canceled() == EI_IMPULSE_CANCELED) {
+        if (impulse_check_canceled() == EI_IMPULSE_CANCELED) {
             free(x);
             return EI_IMPULSE_CANCELED;
         }
@@ -1494,7 +2174,7 @@ __attribute__((unused)) EI_IMPULSE_ERROR run_impulse_i16(
         }
 #endif
 
-        if (ei_run_impulse_check_canceled() == EI_IMPULSE_CANCELED) {
+        if (impulse_check_canceled() == EI_IMPULSE_CANCELED) {
             return EI_IMPULSE_CANCELED;
         }
 
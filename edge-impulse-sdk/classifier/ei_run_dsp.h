@@ -26,6 +26,9 @@
 #include "model-parameters/model_metadata.h"
 #include "edge-impulse-sdk/dsp/spectral/spectral.hpp"
 #include "edge-impulse-sdk/dsp/speechpy/speechpy.hpp"
+#include "edge-impulse-sdk/classifier/ei_model_types.h"
+#include "edge-impulse-sdk/classifier/ei_classifier_config.h"
+#include <memory>
 
 #if defined(__cplusplus) && EI_C_LINKAGE == 1
 extern "C" {
@@ -50,15 +53,141 @@ static uint32_t cache_sample_size = 0;
 float ei_dsp_image_buffer[EI_DSP_IMAGE_BUFFER_STATIC_SIZE];
 #endif
 
+#ifndef EI_DSP_SPECTRAL_PLAN_MAX_ENTRIES
+#define EI_DSP_SPECTRAL_PLAN_MAX_ENTRIES     4
+#endif
+
+#ifndef EI_DSP_MFCC_I16_PLAN_MAX_ENTRIES
+#define EI_DSP_MFCC_I16_PLAN_MAX_ENTRIES     4
+#endif
+
+/* the parts of a block configuration that a plan depends on, and how to build the plan */
+static bool ei_dsp_plan_config_equals(const ei_dsp_config_spectral_analysis_t *a,
+    const ei_dsp_config_spectral_analysis_t *b)
+{
+    return a->axes == b->axes && a->filter_type == b->filter_type &&
+        a->filter_cutoff == b->filter_cutoff && a->filter_order == b->filter_order &&
+        a->fft_length == b->fft_length && a->spectral_peaks_count == b->spectral_peaks_count &&
+        a->spectral_peaks_threshold == b->spectral_peaks_threshold &&
+        a->spectral_power_edges == b->spectral_power_edges;
+}
+
+static int ei_dsp_plan_init(spectral::spectral_analysis_plan *plan,
+    const ei_dsp_config_spectral_analysis_t *config, float frequency)
+{
+    return plan->init(config->axes, frequency, config->filter_type,
+        config->filter_cutoff, config->filter_order, config->fft_length,
+        config->spectral_peaks_count, config->spectral_peaks_threshold,
+        config->spectral_power_edges);
+}
+
+static bool ei_dsp_plan_config_equals(const ei_dsp_config_mfcc_t *a, const ei_dsp_config_mfcc_t *b) {
+    return a->num_cepstral == b->num_cepstral && a->num_filters == b->num_filters &&
+        a->fft_length == b->fft_length && a->low_frequency == b->low_frequency &&
+        a->high_frequency == b->high_frequency;
+}
+
+static int ei_dsp_plan_init(speechpy::mfcc_i16_plan *plan, const ei_dsp_config_mfcc_t *config, float frequency) {
+    return plan->init(static_cast<uint32_t>(frequency), config->num_cepstral, config->num_filters,
+        config->fft_length, config->low_frequency, config->high_frequency);
+}
+
+/**
+ * Plans of a DSP block (everything that only depends on the block configuration),
+ * built on the first window of a configuration and sampling frequency and reused for
+ * every window after that. The plans hold scratch buffers, so every thread that runs
+ * DSP blocks keeps its own.
+ */
+template<typename Config, typename Plan, size_t MaxEntries>
+class ei_dsp_plan_cache {
+public:
+    ei_dsp_plan_cache() : entry_count(0), next_evict(0) { }
+
+    ~ei_dsp_plan_cache() {
+        for (size_t ix = 0; ix < entry_count; ix++) {
+            delete entries[ix].plan;
+        }
+    }
+
+    /**
+     * @brief Get the plan for a block configuration, building it when needed
+     * @param config Block configuration
+     * @param frequency Sampling frequency
+     * @param plan Set to the plan, owned by the cache
+     * @returns EIDSP_OK, or the error from building the plan
+     */
+    int get(const Config *config, float frequency, Plan **plan)
+    {
+        for (size_t ix = 0; ix < entry_count; ix++) {
+            if (entries[ix].config_ptr == config && entries[ix].frequency == frequency &&
+                ei_dsp_plan_config_equals(&entries[ix].config, config))
+            {
+                *plan = entries[ix].plan;
+                return EIDSP_OK;
+            }
+        }
+
+        // replace the oldest plan when the cache is full
+        size_t slot = entry_count < MaxEntries ? entry_count : (next_evict++ % MaxEntries);
+        entry_t *entry = &entries[slot];
+        if (slot == entry_count) {
+            entry->plan = new Plan();
+            entry_count++;
+        }
+        entry->config_ptr = NULL;
+
+        int ret = ei_dsp_plan_init(entry->plan, config, frequency);
+        if (ret != EIDSP_OK) {
+            return ret;
+        }
+
+        entry->config_ptr = config;
+        entry->config = *config;
+        entry->frequency = frequency;
+        *plan = entry->plan;
+        return EIDSP_OK;
+    }
+
+private:
+    typedef struct {
+        const Config *config_ptr;
+        Config config;
+        float frequency;
+        Plan *plan;
+    } entry_t;
+
+    entry_t entries[MaxEntries];
+    size_t entry_count;
+    size_t next_evict;
+};
+
+typedef ei_dsp_plan_cache<ei_dsp_config_spectral_analysis_t, spectral::spectral_analysis_plan,
+    EI_DSP_SPECTRAL_PLAN_MAX_ENTRIES> ei_dsp_spectral_plan_cache;
+typedef ei_dsp_plan_cache<ei_dsp_config_mfcc_t, speechpy::mfcc_i16_plan,
+    EI_DSP_MFCC_I16_PLAN_MAX_ENTRIES> ei_dsp_mfcc_i16_plan_cache;
+
+#if EI_PORTING_POSIX == 1
+static thread_local ei_dsp_spectral_plan_cache spectral_plan_cache;
+static thread_local ei_dsp_mfcc_i16_plan_cache mfcc_i16_plan_cache;
+#else
+static ei_dsp_spectral_plan_cache spectral_plan_cache;
+static ei_dsp_mfcc_i16_plan_cache mfcc_i16_plan_cache;
+#endif
+
 __attribute__((unused)) int extract_spectral_analysis_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float frequency) {
-    ei_dsp_config_spectral_analysis_t config = *((ei_dsp_config_spectral_analysis_t*)config_ptr);
+    ei_dsp_config_spectral_analysis_t *config = (ei_dsp_config_spectral_analysis_t*)config_ptr;
 
     int ret;
 
-    const float sampling_freq = frequency;
+    spectral::spectral_analysis_plan *plan;
+    ret = spectral_plan_cache.get(config, frequency, &plan);
+    if (ret != EIDSP_OK) {
+        ei_printf("ERR: Failed to create spectral analysis plan (%d)\n", ret);
+        EIDSP_ERR(ret);
+    }
 
     // input matrix from the raw signal
-    matrix_t input_matrix(signal->total_length / config.axes, config.axes);
+    matrix_t input_matrix(signal->total_length / config->axes, config->axes);
     if (!input_matrix.buffer) {
         EIDSP_ERR(EIDSP_OUT_OF_MEM);
     }
@@ -66,7 +195,7 @@ __attribute__((unused)) int extract_spectral_analysis_features(signal_t *signal,
     signal->get_data(0, signal->total_length, input_matrix.buffer);
 
     // scale the signal
-    ret = numpy::scale(&input_matrix, config.scale_axes);
+    ret = numpy::scale(&input_matrix, config->scale_axes);
     if (ret != EIDSP_OK) {
         ei_printf("ERR: Failed to scale signal (%d)\n", ret);
         EIDSP_ERR(ret);
@@ -79,69 +208,25 @@ __attribute__((unused)) int extract_spectral_analysis_features(signal_t *signal,
         EIDSP_ERR(ret);
     }
 
-    // the spectral edges that we want to calculate
-    matrix_t edges_matrix_in(64, 1);
-    size_t edge_matrix_ix = 0;
-
-    char spectral_str[128] = { 0 };
-    if (strlen(config.spectral_power_edges) > sizeof(spectral_str) - 1) {
-        EIDSP_ERR(EIDSP_PARAMETER_INVALID);
-    }
-    memcpy(spectral_str, config.spectral_power_edges, strlen(config.spectral_power_edges));
-
-    // convert spectral_power_edges (string) into float array
-    char *spectral_ptr = spectral_str;
-    while (spectral_ptr != NULL) {
-        edges_matrix_in.buffer[edge_matrix_ix++] = atof(spectral_ptr);
-
-        // find next (spectral) delimiter (or '\0' character)
-        while((*spectral_ptr != ',')) {
-            spectral_ptr++;
-            if (*spectral_ptr == '\0') break;
-        }
-
-        if (*spectral_ptr == '\0') {
-            spectral_ptr = NULL;
-        }
-        else  {
-            spectral_ptr++;
-        }
-    }
-    edges_matrix_in.rows = edge_matrix_ix;
-
     // calculate how much room we need for the output matrix
     size_t output_matrix_cols = spectral::feature::calculate_spectral_buffer_size(
-        true, config.spectral_peaks_count, edges_matrix_in.rows
+        true, config->spectral_peaks_count, plan->get_edge_count()
     );
-    // ei_printf("output_matrix_size %hux%zu\n", input_matrix.rows, output_matrix_cols);
-    if (output_matrix->cols * output_matrix->rows != static_cast<uint32_t>(output_matrix_cols * config.axes)) {
+    if (output_matrix->cols * output_matrix->rows != static_cast<uint32_t>(output_matrix_cols * config->axes)) {
         EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
     }
 
     output_matrix->cols = output_matrix_cols;
-    output_matrix->rows = config.axes;
+    output_matrix->rows = config->axes;
 
-    spectral::filter_t filter_type;
-    if (strcmp(config.filter_type, "low") == 0) {
-        filter_type = spectral::filter_lowpass;
-    }
-    else if (strcmp(config.filter_type, "high") == 0) {
-        filter_type = spectral::filter_highpass;
-    }
-    else {
-        filter_type = spectral::filter_none;
-    }
-
-    ret = spectral::feature::spectral_analysis(output_matrix, &input_matrix,
-        sampling_freq, filter_type, config.filter_cutoff, config.filter_order,
-        config.fft_length, config.spectral_peaks_count, config.spectral_peaks_threshold, &edges_matrix_in);
+    ret = spectral::feature::spectral_analysis(output_matrix, &input_matrix, plan);
     if (ret != EIDSP_OK) {
         ei_printf("ERR: Failed to calculate spectral features (%d)\n", ret);
         EIDSP_ERR(ret);
     }
 
     // flatten again
-    output_matrix->cols = config.axes * output_matrix_cols;
+    output_matrix->cols = config->axes * output_matrix_cols;
     output_matrix->rows = 1;
 
     return EIDSP_OK;
@@ -321,58 +406,57 @@ __attribute__((unused)) int extract_flatten_features(signal_t *signal, matrix_t
         EIDSP_ERR(ret);
     }
 
+    // highest central moment that the enabled features need
+    int order = 1;
+    if (config.rms || config.stdev) order = 2;
+    if (config.skewness) order = 3;
+    if (config.kurtosis) order = 4;
+
     size_t out_matrix_ix = 0;
 
     for (size_t row = 0; row < input_matrix.rows; row++) {
-        matrix_t row_matrix(1, input_matrix.cols, input_matrix.buffer + (row * input_matrix.cols));
+        // one pass over the axis for all of the features
+        moments_t moments;
+        ret = numpy::moments(input_matrix.buffer + (row * input_matrix.cols), input_matrix.cols,
+            order, &moments);
+        if (ret != EIDSP_OK) {
+            ei_printf("ERR: Failed to calculate moments (%d)\n", ret);
+            EIDSP_ERR(ret);
+        }
+
+        float variance = moments.m2 / input_matrix.cols;
 
         if (config.average) {
-            float fbuffer;
-            matrix_t out_matrix(1, 1, &fbuffer);
-            numpy::mean(&row_matrix, &out_matrix);
-            output_matrix->buffer[out_matrix_ix++] = out_matrix.buffer[0];
+            output_matrix->buffer[out_matrix_ix++] = moments.mean;
         }
 
         if (config.minimum) {
-            float fbuffer;
-            matrix_t out_matrix(1, 1, &fbuffer);
-            numpy::min(&row_matrix, &out_matrix);
-            output_matrix->buffer[out_matrix_ix++] = out_matrix.buffer[0];
+            output_matrix->buffer[out_matrix_ix++] = moments.min;
         }
 
         if (config.maximum) {
-            float fbuffer;
-            matrix_t out_matrix(1, 1, &fbuffer);
-            numpy::max(&row_matrix, &out_matrix);
-            output_matrix->buffer[out_matrix_ix++] = out_matrix.buffer[0];
+            output_matrix->buffer[out_matrix_ix++] = moments.max;
         }
 
         if (config.rms) {
-            float fbuffer;
-            matrix_t out_matrix(1, 1, &fbuffer);
-            numpy::rms(&row_matrix, &out_matrix);
-            output_matrix->buffer[out_matrix_ix++] = out_matrix.buffer[0];
+            // mean(x^2) = mean^2 + variance
+            output_matrix->buffer[out_matrix_ix++] = sqrt(moments.mean * moments.mean + variance);
         }
 
         if (config.stdev) {
-            float fbuffer;
-            matrix_t out_matrix(1, 1, &fbuffer);
-            numpy::stdev(&row_matrix, &out_matrix);
-            output_matrix->buffer[out_matrix_ix++] = out_matrix.buffer[0];
+            output_matrix->buffer[out_matrix_ix++] = sqrt(variance);
         }
 
         if (config.skewness) {
-            float fbuffer;
-            matrix_t out_matrix(1, 1, &fbuffer);
-            numpy::skew(&row_matrix, &out_matrix);
-            output_matrix->buffer[out_matrix_ix++] = out_matrix.buffer[0];
+            // skew = m_3 / m_2^(3/2)
+            output_matrix->buffer[out_matrix_ix++] = (moments.m3 / input_matrix.cols) /
+                sqrt(variance * variance * variance);
         }
 
         if (config.kurtosis) {
-            float fbuffer;
-            matrix_t out_matrix(1, 1, &fbuffer);
-            numpy::kurtosis(&row_matrix, &out_matrix);
-            output_matrix->buffer[out_matrix_ix++] = out_matrix.buffer[0];
+            // Fisher kurtosis = m_4 / m_2^2 - 3
+            output_matrix->buffer[out_matrix_ix++] = (moments.m4 / input_matrix.cols) /
+                (variance * variance) - 3;
         }
     }
 
@@ -383,11 +467,204 @@ __attribute__((unused)) int extract_flatten_features(signal_t *signal, matrix_t
     return EIDSP_OK;
 }
 
+#if EI_PORTING_POSIX == 1
+// per thread, so impulses can run on several threads at once (see ei_classifier_async.h)
+static thread_local class speechpy::processing::preemphasis *preemphasis;
+#else
 static class speechpy::processing::preemphasis *preemphasis;
+#endif
 static int preemphasized_audio_signal_get_data(size_t offset, size_t length, float *out_ptr) {
     return preemphasis->get_data(offset, length, out_ptr);
 }
 
+/**
+ * Framing of the signal that MFCC, MFE and spectrogram blocks run their filterbanks on.
+ * Blocks with the same key compute the same power spectra.
+ */
+typedef struct {
+    float frame_length;
+    float frame_stride;
+    uint16_t fft_length;
+    uint16_t version;
+    int pre_shift;          // pre-emphasis applied before framing, 0 for none
+    float pre_cof;
+} ei_dsp_stft_key_t;
+
+typedef struct {
+    ei_dsp_stft_key_t key;
+    size_t block_count;     // number of DSP blocks in the impulse with this key
+    matrix_t *power_spectra;
+} ei_dsp_stft_cache_entry_t;
+
+#ifndef EI_DSP_STFT_CACHE_MAX_ENTRIES
+#define EI_DSP_STFT_CACHE_MAX_ENTRIES     4
+#endif
+
+/**
+ * Power spectra shared between the DSP blocks of one inference, so blocks that frame
+ * the signal the same way only frame and FFT it once. Set up by stft_cache_begin()
+ * before the DSP blocks run, and freed by stft_cache_end(). In between, every call
+ * of a DSP block on this thread is for the signal of that inference.
+ */
+typedef struct {
+    uint32_t frequency;
+    size_t entry_count;
+    ei_dsp_stft_cache_entry_t entries[EI_DSP_STFT_CACHE_MAX_ENTRIES];
+} ei_dsp_stft_cache_t;
+
+#if EI_PORTING_POSIX == 1
+static thread_local ei_dsp_stft_cache_t *stft_cache = NULL;
+#else
+static ei_dsp_stft_cache_t *stft_cache = NULL;
+#endif
+
+static ei_dsp_stft_key_t stft_key(float frame_length, float frame_stride, int fft_length,
+    uint16_t version, int pre_shift, float pre_cof)
+{
+    ei_dsp_stft_key_t key;
+    key.frame_length = frame_length;
+    key.frame_stride = frame_stride;
+    key.fft_length = static_cast<uint16_t>(fft_length);
+    key.version = version;
+    // a coefficient of 0 leaves the signal untouched, so it frames the same as no pre-emphasis
+    key.pre_shift = pre_cof == 0.0f ? 0 : pre_shift;
+    key.pre_cof = key.pre_shift == 0 ? 0.0f : pre_cof;
+    return key;
+}
+
+static bool stft_key_equals(const ei_dsp_stft_key_t *a, const ei_dsp_stft_key_t *b) {
+    return a->frame_length == b->frame_length && a->frame_stride == b->frame_stride &&
+        a->fft_length == b->fft_length && a->version == b->version &&
+        a->pre_shift == b->pre_shift && a->pre_cof == b->pre_cof;
+}
+
+/**
+ * @brief Get the power spectra for a block from the STFT cache, calculating them
+ *        for the first block that asks.
+ *
+ * @param frequency      Sampling frequency
+ * @param key            Framing parameters of the block
+ * @param framed_signal  Signal that is framed (e.g. the pre-emphasized signal)
+ * @param power_spectra  Set to the cached power spectra, or NULL when no other block
+ *                       shares them (the block then frames and FFTs the signal itself)
+ *
+ * @return EIDSP_OK if OK
+ */
+static int stft_cache_get(uint32_t frequency, const ei_dsp_stft_key_t *key,
+    signal_t *framed_signal, matrix_t **power_spectra)
+{
+    *power_spectra = NULL;
+
+    if (!stft_cache || stft_cache->frequency != frequency) {
+        return EIDSP_OK;
+    }
+
+    for (size_t ix = 0; ix < stft_cache->entry_count; ix++) {
+        ei_dsp_stft_cache_entry_t *entry = &stft_cache->entries[ix];
+        if (!stft_key_equals(&entry->key, key)) {
+            continue;
+        }
+        if (entry->block_count < 2) {
+            return EIDSP_OK;
+        }
+
+        if (!entry->power_spectra) {
+            matrix_size_t size = speechpy::feature::calculate_mfe_buffer_size(
+                framed_signal->total_length, frequency, key->frame_length, key->frame_stride,
+                key->fft_length / 2 + 1, key->version);
+
+            // owned here until they are complete, the signal can throw
+            std::unique_ptr<matrix_t> spectra(new matrix_t(size.rows, size.cols));
+            if (!spectra->buffer) {
+                EIDSP_ERR(EIDSP_OUT_OF_MEM);
+            }
+
+            int ret = speechpy::feature::power_spectra(spectra.get(), framed_signal, frequency,
+                key->frame_length, key->frame_stride, key->fft_length, key->version);
+            if (ret != EIDSP_OK) {
+                EIDSP_ERR(ret);
+            }
+            entry->power_spectra = spectra.release();
+        }
+
+        *power_spectra = entry->power_spectra;
+        return EIDSP_OK;
+    }
+
+    return EIDSP_OK;
+}
+
+#if defined(EI_DSP_MFCC_STATIC_CONFIG) && EI_CLASSIFIER_STATIC_MFCC == 1 && EIDSP_QUANTIZE_FILTERBANK == 1
+#define EI_DSP_MFCC_STATIC                       1
+
+typedef speechpy::mfcc_static<
+    EI_CLASSIFIER_FREQUENCY,
+    EI_CLASSIFIER_RAW_SAMPLE_COUNT,
+    speechpy::static_framing::frame_length(EI_CLASSIFIER_FREQUENCY,
+        EI_DSP_MFCC_STATIC_CONFIG.frame_length, EI_DSP_MFCC_STATIC_CONFIG.implementation_version),
+    speechpy::static_framing::frame_stride(EI_CLASSIFIER_FREQUENCY,
+        EI_DSP_MFCC_STATIC_CONFIG.frame_stride, EI_DSP_MFCC_STATIC_CONFIG.implementation_version),
+    speechpy::static_framing::frame_count(EI_CLASSIFIER_RAW_SAMPLE_COUNT, EI_CLASSIFIER_FREQUENCY,
+        EI_DSP_MFCC_STATIC_CONFIG.frame_length, EI_DSP_MFCC_STATIC_CONFIG.frame_stride,
+        EI_DSP_MFCC_STATIC_CONFIG.implementation_version),
+    EI_DSP_MFCC_STATIC_CONFIG.fft_length,
+    EI_DSP_MFCC_STATIC_CONFIG.num_filters,
+    EI_DSP_MFCC_STATIC_CONFIG.num_cepstral,
+    EI_DSP_MFCC_STATIC_CONFIG.low_frequency,
+    EI_DSP_MFCC_STATIC_CONFIG.high_frequency> ei_dsp_mfcc_static_t;
+
+/**
+ * Configs the specialized pipeline can't be built for (e.g. an odd number of
+ * filters, or a window shorter than one frame) always run the runtime MFCC
+ */
+typedef std::integral_constant<bool,
+    speechpy::mfcc_static_supported<ei_dsp_mfcc_static_t>::value> ei_dsp_mfcc_static_supported_t;
+
+template<typename Pipeline>
+static bool mfcc_static_matches(const ei_dsp_config_mfcc_t *, const signal_t *, uint32_t, std::false_type)
+{
+    return false;
+}
+
+template<typename Pipeline>
+static int mfcc_static_run(matrix_t *, signal_t *, int, float, std::false_type)
+{
+    EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+}
+
+/**
+ * Whether an MFCC block can run on the specialized pipeline: the config (which may
+ * have been changed at runtime) and the signal have to match what it was built for.
+ */
+template<typename Pipeline>
+static bool mfcc_static_matches(const ei_dsp_config_mfcc_t *config, const signal_t *signal, uint32_t frequency,
+    std::true_type)
+{
+    const ei_dsp_config_mfcc_t *static_config = &EI_DSP_MFCC_STATIC_CONFIG;
+
+    return frequency == EI_CLASSIFIER_FREQUENCY &&
+        signal->total_length == EI_CLASSIFIER_RAW_SAMPLE_COUNT &&
+        config->implementation_version == static_config->implementation_version &&
+        config->num_cepstral == static_config->num_cepstral &&
+        config->frame_length == static_config->frame_length &&
+        config->frame_stride == static_config->frame_stride &&
+        config->num_filters == static_config->num_filters &&
+        config->fft_length == static_config->fft_length &&
+        config->low_frequency == static_config->low_frequency &&
+        config->high_frequency == static_config->high_frequency &&
+        Pipeline::supports_pre_shift(config->pre_shift);
+}
+
+template<typename Pipeline>
+static int mfcc_static_run(matrix_t *output_matrix, signal_t *signal, int pre_shift, float pre_cof,
+    std::true_type)
+{
+    return Pipeline::mfcc(output_matrix, signal, pre_shift, pre_cof);
+}
+#else
+#define EI_DSP_MFCC_STATIC                       0
+#endif // EI_DSP_MFCC_STATIC_CONFIG
+
 __attribute__((unused)) int extract_mfcc_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float sampling_frequency) {
     ei_dsp_config_mfcc_t config = *((ei_dsp_config_mfcc_t*)config_ptr);
 
@@ -423,10 +700,28 @@ __attribute__((unused)) int extract_mfcc_features(signal_t *signal, matrix_t *ou
     output_matrix->rows = out_matrix_size.rows;
     output_matrix->cols = out_matrix_size.cols;
 
+    ei_dsp_stft_key_t key = stft_key(config.frame_length, config.frame_stride, config.fft_length,
+        config.implementation_version, config.pre_shift, config.pre_cof);
+    matrix_t *cached_spectra;
+    int ret = stft_cache_get(frequency, &key, &preemphasized_audio_signal, &cached_spectra);
+    if (ret != EIDSP_OK) {
+        ei_printf("ERR: MFCC failed (%d)\n", ret);
+        EIDSP_ERR(ret);
+    }
+
+#if EI_DSP_MFCC_STATIC == 1
+    // spectra that are shared with other blocks are cheaper than recomputing them
+    if (!cached_spectra && mfcc_static_matches<ei_dsp_mfcc_static_t>(&config, signal, frequency,
+            ei_dsp_mfcc_static_supported_t())) {
+        ret = mfcc_static_run<ei_dsp_mfcc_static_t>(output_matrix, signal, config.pre_shift, config.pre_cof,
+            ei_dsp_mfcc_static_supported_t());
+    }
+    else
+#endif // EI_DSP_MFCC_STATIC == 1
     // and run the MFCC extraction (using 32 rather than 40 filters here to optimize speed on embedded)
-    int ret = speechpy::feature::mfcc(output_matrix, &preemphasized_audio_signal,
+    ret = speechpy::feature::mfcc(output_matrix, &preemphasized_audio_signal,
         frequency, config.frame_length, config.frame_stride, config.num_cepstral, config.num_filters, config.fft_length,
-        config.low_frequency, config.high_frequency, true, config.implementation_version);
+        config.low_frequency, config.high_frequency, true, config.implementation_version, cached_spectra);
     if (ret != EIDSP_OK) {
         ei_printf("ERR: MFCC failed (%d)\n", ret);
         EIDSP_ERR(ret);
@@ -445,6 +740,63 @@ __attribute__((unused)) int extract_mfcc_features(signal_t *signal, matrix_t *ou
     return EIDSP_OK;
 }
 
+__attribute__((unused)) int extract_mfcc_features(signal_i16_t *signal, matrix_i32_t *output_matrix, void *config_ptr, const float sampling_frequency) {
+    ei_dsp_config_mfcc_t config = *((ei_dsp_config_mfcc_t*)config_ptr);
+
+    if (config.axes != 1) {
+        EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+    }
+
+    if(config.implementation_version != 1 && config.implementation_version != 2) {
+        EIDSP_ERR(EIDSP_BLOCK_VERSION_INCORRECT);
+    }
+
+    const uint32_t frequency = static_cast<uint32_t>(sampling_frequency);
+
+    // calculate the size of the MFCC matrix
+    matrix_size_t out_matrix_size =
+        speechpy::feature::calculate_mfcc_buffer_size(
+            signal->total_length, frequency, config.frame_length, config.frame_stride, config.num_cepstral, config.implementation_version);
+    /* Only throw size mismatch error calculated buffer doesn't fit for continuous inferencing */
+    if (out_matrix_size.rows * out_matrix_size.cols > output_matrix->rows * output_matrix->cols) {
+        ei_printf("out_matrix = %hux%hu\n", output_matrix->rows, output_matrix->cols);
+        ei_printf("calculated size = %hux%hu\n", out_matrix_size.rows, out_matrix_size.cols);
+        EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+    }
+
+    output_matrix->rows = out_matrix_size.rows;
+    output_matrix->cols = out_matrix_size.cols;
+
+    // filterbank, DCT table and FFT plan of this block, built on the first window
+    speechpy::mfcc_i16_plan *plan;
+    int ret = mfcc_i16_plan_cache.get((ei_dsp_config_mfcc_t*)config_ptr, sampling_frequency, &plan);
+    if (ret != EIDSP_OK) {
+        ei_printf("ERR: Failed to create MFCC plan (%d)\n", ret);
+        EIDSP_ERR(ret);
+    }
+
+    // preemphasis and MFCC in fixed point, straight from the int16 samples
+    ret = speechpy::feature::mfcc(output_matrix, signal, plan,
+        config.frame_length, config.frame_stride, true, config.implementation_version,
+        config.pre_shift, config.pre_cof);
+    if (ret != EIDSP_OK) {
+        ei_printf("ERR: MFCC failed (%d)\n", ret);
+        EIDSP_ERR(ret);
+    }
+
+    // cepstral mean and variance normalization
+    ret = speechpy::processing::cmvnw(output_matrix, config.win_size, true);
+    if (ret != EIDSP_OK) {
+        ei_printf("ERR: cmvnw failed (%d)\n", ret);
+        EIDSP_ERR(ret);
+    }
+
+    output_matrix->cols = out_matrix_size.rows * out_matrix_size.cols;
+    output_matrix->rows = 1;
+
+    return EIDSP_OK;
+}
+
 /**
  * @brief Preemphasize audio from sample and collect data from cached buffer
  *        Cached buffer data is already preemphasized
@@ -591,8 +943,18 @@ __attribute__((unused)) int extract_spectrogram_features(signal_t *signal, matri
         EIDSP_ERR(EIDSP_OUT_OF_MEM);
     }
 
-    int ret = speechpy::feature::spectrogram(output_matrix, signal,
-        frequency, config.frame_length, config.frame_stride, config.fft_length, config.implementation_version);
+    ei_dsp_stft_key_t key = stft_key(config.frame_length, config.frame_stride, config.fft_length,
+        config.implementation_version, 0, 0.0f);
+    matrix_t *cached_spectra;
+    int ret = stft_cache_get(frequency, &key, signal, &cached_spectra);
+    if (ret != EIDSP_OK) {
+        ei_printf("ERR: Spectrogram failed (%d)\n", ret);
+        EIDSP_ERR(ret);
+    }
+
+    ret = speechpy::feature::spectrogram(output_matrix, signal,
+        frequency, config.frame_length, config.frame_stride, config.fft_length, config.implementation_version,
+        cached_spectra);
     if (ret != EIDSP_OK) {
         ei_printf("ERR: Spectrogram failed (%d)\n", ret);
         EIDSP_ERR(ret);
@@ -702,9 +1064,18 @@ __attribute__((unused)) int extract_mfe_features(signal_t *signal, matrix_t *out
         EIDSP_ERR(EIDSP_OUT_OF_MEM);
     }
 
-    int ret = speechpy::feature::mfe(output_matrix, &energy_matrix, signal,
+    ei_dsp_stft_key_t key = stft_key(config.frame_length, config.frame_stride, config.fft_length,
+        config.implementation_version, 0, 0.0f);
+    matrix_t *cached_spectra;
+    int ret = stft_cache_get(frequency, &key, signal, &cached_spectra);
+    if (ret != EIDSP_OK) {
+        ei_printf("ERR: MFE failed (%d)\n", ret);
+        EIDSP_ERR(ret);
+    }
+
+    ret = speechpy::feature::mfe(output_matrix, &energy_matrix, signal,
         frequency, config.frame_length, config.frame_stride, config.num_filters, config.fft_length,
-        config.low_frequency, config.high_frequency, config.implementation_version);
+        config.low_frequency, config.high_frequency, config.implementation_version, cached_spectra);
     if (ret != EIDSP_OK) {
         ei_printf("ERR: MFE failed (%d)\n", ret);
         EIDSP_ERR(ret);
@@ -787,6 +1158,111 @@ __attribute__((unused)) int extract_mfe_per_slice_features(signal_t *signal, mat
     return EIDSP_OK;
 }
 
+/**
+ * @brief Framing of a DSP block, for the blocks that compute power spectra
+ *
+ * @return false if the block does not use the STFT cache
+ */
+static bool stft_block_key(const ei_model_dsp_t *block, ei_dsp_stft_key_t *key) {
+    // extract_mfcc_features has an int16 overload, pick the float one
+    if (block->extract_fn == static_cast<decltype(block->extract_fn)>(&extract_mfcc_features)) {
+        ei_dsp_config_mfcc_t *config = (ei_dsp_config_mfcc_t*)block->config;
+        *key = stft_key(config->frame_length, config->frame_stride, config->fft_length,
+            config->implementation_version, config->pre_shift, config->pre_cof);
+        return true;
+    }
+    if (block->extract_fn == &extract_mfe_features) {
+        ei_dsp_config_mfe_t *config = (ei_dsp_config_mfe_t*)block->config;
+        *key = stft_key(config->frame_length, config->frame_stride, config->fft_length,
+            config->implementation_version, 0, 0.0f);
+        return true;
+    }
+    if (block->extract_fn == &extract_spectrogram_features) {
+        ei_dsp_config_spectrogram_t *config = (ei_dsp_config_spectrogram_t*)block->config;
+        *key = stft_key(config->frame_length, config->frame_stride, config->fft_length,
+            config->implementation_version, 0, 0.0f);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Set up the STFT cache for one inference. Power spectra are only kept for
+ *        framings that more than one block uses, so an impulse with a single
+ *        audio block uses no extra memory.
+ *
+ * @param cache        Cache to set up, has to stay valid until stft_cache_end()
+ * @param frequency    Sampling frequency
+ * @param blocks       DSP blocks of the impulse
+ * @param blocks_size  Number of DSP blocks
+ */
+static void stft_cache_begin(ei_dsp_stft_cache_t *cache, float frequency,
+    const ei_model_dsp_t *blocks, size_t blocks_size)
+{
+    cache->frequency = static_cast<uint32_t>(frequency);
+    cache->entry_count = 0;
+
+    for (size_t ix = 0; ix < blocks_size; ix++) {
+        ei_dsp_stft_key_t key;
+        if (!stft_block_key(&blocks[ix], &key)) {
+            continue;
+        }
+
+        size_t entry_ix = 0;
+        while (entry_ix < cache->entry_count && !stft_key_equals(&cache->entries[entry_ix].key, &key)) {
+            entry_ix++;
+        }
+        if (entry_ix == EI_DSP_STFT_CACHE_MAX_ENTRIES) {
+            continue;
+        }
+        if (entry_ix == cache->entry_count) {
+            cache->entries[entry_ix].key = key;
+            cache->entries[entry_ix].block_count = 0;
+            cache->entries[entry_ix].power_spectra = NULL;
+            cache->entry_count++;
+        }
+        cache->entries[entry_ix].block_count++;
+    }
+
+    stft_cache = cache;
+}
+
+/**
+ * @brief Free the power spectra of the inference and stop using the STFT cache
+ */
+static void stft_cache_end(ei_dsp_stft_cache_t *cache) {
+    for (size_t ix = 0; ix < cache->entry_count; ix++) {
+        if (cache->entries[ix].power_spectra) {
+            delete cache->entries[ix].power_spectra;
+            cache->entries[ix].power_spectra = NULL;
+        }
+    }
+    cache->entry_count = 0;
+
+    if (stft_cache == cache) {
+        stft_cache = NULL;
+    }
+}
+
+/**
+ * Owns the STFT cache of one inference: stft_cache_begin() when constructed,
+ * stft_cache_end() when it goes out of scope, also when a block throws
+ */
+struct ei_dsp_stft_cache_scope {
+    ei_dsp_stft_cache_scope(float frequency, const ei_model_dsp_t *blocks, size_t blocks_size) {
+        stft_cache_begin(&cache, frequency, blocks, blocks_size);
+    }
+
+    ~ei_dsp_stft_cache_scope() {
+        stft_cache_end(&cache);
+    }
+
+    ei_dsp_stft_cache_scope(const ei_dsp_stft_cache_scope&) = delete;
+    ei_dsp_stft_cache_scope& operator=(const ei_dsp_stft_cache_scope&) = delete;
+
+    ei_dsp_stft_cache_t cache;
+};
+
 __attribute__((unused)) int extract_image_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float frequency) {
     ei_dsp_config_image_t config = *((ei_dsp_config_image_t*)config_ptr);
 
@@ -94,6 +94,33 @@
 #define EIDSP_PRINT_ALLOCATIONS      1
 #endif
 
+// number of frames that MFE / spectrogram read and FFT together (costs a buffer of this many frames)
+#ifndef EIDSP_FFT_BATCH_FRAMES
+#define EIDSP_FFT_BATCH_FRAMES       8
+#endif // EIDSP_FFT_BATCH_FRAMES
+
+// tile size (in elements) of the cache-blocked numpy::transpose, a tile of floats is
+// then 16 cache lines of 64 bytes for both the reads and the writes
+#ifndef EIDSP_TRANSPOSE_BLOCK
+#define EIDSP_TRANSPOSE_BLOCK        16
+#endif // EIDSP_TRANSPOSE_BLOCK
+
+// FFT backend for the software FFTs (see fft/ei_fft.h), on POSIX targets the
+// EI_FFT_BACKEND environment variable can select another one at runtime
+#define EIDSP_FFT_BACKEND_KISSFFT    1
+#define EIDSP_FFT_BACKEND_CMSIS      2
+#define EIDSP_FFT_BACKEND_RADIX4     3
+
+#ifndef EIDSP_FFT_BACKEND
+#define EIDSP_FFT_BACKEND            EIDSP_FFT_BACKEND_KISSFFT
+#endif // EIDSP_FFT_BACKEND
+
+// use the approximations in fast_math.hpp for the log / exp calls of the MFCC and MFE
+// blocks (mel scale conversions, log of the mel energies), see there for the max errors
+#ifndef EIDSP_USE_FAST_MATH
+#define EIDSP_USE_FAST_MATH          0
+#endif // EIDSP_USE_FAST_MATH
+
 #ifndef EIDSP_SIGNAL_C_FN_POINTER
 #define EIDSP_SIGNAL_C_FN_POINTER    0
 #endif // EIDSP_SIGNAL_C_FN_POINTER
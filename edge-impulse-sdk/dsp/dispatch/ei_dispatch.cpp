@@ -0,0 +1,1102 @@
+/* Edge Impulse inferencing library
+ * Copyright (c) 2021 EdgeImpulse Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ei_dispatch.h"
+#include "ei_dispatch_neon.h"
+#include "../numpy.hpp"
+#include "../fast_math.hpp"
+#include "../memory.hpp"
+#include "../../porting/ei_classifier_porting.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define EI_DISPATCH_HAS_AVX2            1
+// fma is only enabled where it's used explicitly, so mul + add never gets contracted
+#define EI_DISPATCH_TARGET_AVX2         __attribute__((target("avx2")))
+#define EI_DISPATCH_TARGET_AVX2_FMA     __attribute__((target("avx2,fma")))
+#else
+#define EI_DISPATCH_HAS_AVX2            0
+#endif
+
+// the NEON vector code is in ei_dispatch_neon.cpp, on 32-bit ARM only that file is
+// built with NEON (neon_vector_kernels() tells whether it was)
+#if defined(__aarch64__) || (defined(__arm__) && defined(__ARM_ARCH_PROFILE) && __ARM_ARCH_PROFILE == 'A')
+#define EI_DISPATCH_HAS_NEON            1
+#else
+#define EI_DISPATCH_HAS_NEON            0
+#endif
+
+#if EI_DISPATCH_HAS_NEON == 1 && defined(__arm__) && defined(__linux__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+namespace ei {
+namespace dispatch {
+
+namespace {
+
+/*
+ * Scalar kernels, these are the reference implementations
+ */
+
+static void int16_to_float_scalar(const int16_t *input, float *output, size_t length) {
+    for (size_t ix = 0; ix < length; ix++) {
+        output[ix] = (float)(input[ix]) / 32768.f;
+    }
+}
+
+static void fft_magnitude_scalar(const fft_complex_t *input, float *output, size_t length) {
+    for (size_t ix = 0; ix < length; ix++) {
+        output[ix] = sqrt(pow(input[ix].r, 2) + pow(input[ix].i, 2));
+    }
+}
+
+static void power_spectrum_scalar(const fft_complex_t *input, float *output, size_t length, uint16_t fft_points) {
+    for (size_t ix = 0; ix < length; ix++) {
+        float magnitude = sqrt(pow(input[ix].r, 2) + pow(input[ix].i, 2));
+        output[ix] = (1.0 / static_cast<float>(fft_points)) * (magnitude * magnitude);
+    }
+}
+
+static void filterbank_dot_u8_filters(const float *row, size_t row_size, const uint8_t *filterbank,
+    size_t filters, const int32_t *bins, const float *dequantize, float *output, size_t first_filter)
+{
+    for (size_t j = first_filter; j < filters; j++) {
+        size_t start, end;
+        filterbank_bins_range(bins, row_size, j, j + 1, &start, &end);
+
+        float tmp = 0.0f;
+        for (size_t k = start; k < end; k++) {
+            uint8_t u8 = filterbank[k * filters + j];
+            if (u8) { // this matrix appears to be very sparsely populated
+                tmp += row[k] * dequantize[u8];
+            }
+        }
+        output[j] = tmp;
+    }
+}
+
+static void filterbank_dot_u8_scalar(const float *row, size_t row_size, const uint8_t *filterbank,
+    size_t filters, const int32_t *bins, const float *dequantize, float *output)
+{
+    filterbank_dot_u8_filters(row, row_size, filterbank, filters, bins, dequantize, output, 0);
+}
+
+static void log_scalar(float *buffer, size_t length) {
+    for (size_t ix = 0; ix < length; ix++) {
+        buffer[ix] = numpy::log(buffer[ix]);
+    }
+}
+
+static void fast_log_scalar(float *buffer, size_t length) {
+    for (size_t ix = 0; ix < length; ix++) {
+        buffer[ix] = fast_math::log(buffer[ix]);
+    }
+}
+
+/**
+ * Axis 0 reductions: four columns at a time walk down the rows with their sums in
+ * registers, every column sums its rows in order, from row 0. Reading four columns per
+ * row is never slower than the column loop this replaced, for any shape.
+ */
+static void mean_std_axis0_strips(const float *input, size_t rows, size_t cols,
+    size_t first_col, float *mean, float *std)
+{
+    size_t col = first_col;
+    for (; col + 4 <= cols; col += 4) {
+        float sum0 = 0.0f, sum1 = 0.0f, sum2 = 0.0f, sum3 = 0.0f;
+        const float *in = input + col;
+        for (size_t row = 0; row < rows; row++, in += cols) {
+            sum0 += in[0];
+            sum1 += in[1];
+            sum2 += in[2];
+            sum3 += in[3];
+        }
+        const float mean0 = sum0 / rows, mean1 = sum1 / rows, mean2 = sum2 / rows, mean3 = sum3 / rows;
+        mean[col] = mean0;
+        mean[col + 1] = mean1;
+        mean[col + 2] = mean2;
+        mean[col + 3] = mean3;
+
+        if (std) {
+            float var0 = 0.0f, var1 = 0.0f, var2 = 0.0f, var3 = 0.0f;
+            in = input + col;
+            for (size_t row = 0; row < rows; row++, in += cols) {
+                float tmp0 = in[0] - mean0;
+                float tmp1 = in[1] - mean1;
+                float tmp2 = in[2] - mean2;
+                float tmp3 = in[3] - mean3;
+                var0 += tmp0 * tmp0;
+                var1 += tmp1 * tmp1;
+                var2 += tmp2 * tmp2;
+                var3 += tmp3 * tmp3;
+            }
+            std[col] = sqrt(var0 / rows);
+            std[col + 1] = sqrt(var1 / rows);
+            std[col + 2] = sqrt(var2 / rows);
+            std[col + 3] = sqrt(var3 / rows);
+        }
+    }
+
+    for (; col < cols; col++) {
+        float sum = 0.0f;
+        for (size_t row = 0; row < rows; row++) {
+            sum += input[(row * cols) + col];
+        }
+        mean[col] = sum / rows;
+
+        if (std) {
+            float var = 0.0f;
+            for (size_t row = 0; row < rows; row++) {
+                float tmp = input[(row * cols) + col] - mean[col];
+                var += tmp * tmp;
+            }
+            std[col] = sqrt(var / rows);
+        }
+    }
+}
+
+static void mean_std_axis0_scalar(const float *input, size_t rows, size_t cols, float *mean, float *std) {
+    mean_std_axis0_strips(input, rows, cols, 0, mean, std);
+}
+
+static void dot_lanes_range(const float *input, size_t length, const float *weights, size_t weights_stride,
+    size_t first_lane, size_t lanes, float *acc)
+{
+    for (size_t lane = first_lane; lane < lanes; lane++) {
+        const float *w = weights + (lane * weights_stride);
+        float total = acc[lane];
+        for (size_t ix = 0; ix < length; ix++) {
+            total += input[ix] * w[ix];
+        }
+        acc[lane] = total;
+    }
+}
+
+static void dot_lanes_scalar(const float *input, size_t length, const float *weights, size_t weights_stride,
+    size_t lanes, float *acc)
+{
+    dot_lanes_range(input, length, weights, weights_stride, 0, lanes, acc);
+}
+
+static int64_t dot_q15_scalar(const int16_t *a, const int16_t *b, size_t length) {
+    int64_t total = 0;
+    for (size_t ix = 0; ix < length; ix++) {
+        total += (int32_t)a[ix] * b[ix];
+    }
+    return total;
+}
+
+static int64_t dot_q31_scalar(const int32_t *a, const int32_t *b, size_t length) {
+    uint64_t total = 0;
+    for (size_t ix = 0; ix < length; ix++) {
+        total += (uint64_t)((int64_t)a[ix] * b[ix]);
+    }
+    return (int64_t)total;
+}
+
+static void butterworth_lanes_range(const float *coefs, size_t sections, bool highpass, float *state,
+    const float *src, float *dest, size_t frames, size_t lanes, size_t frame_stride, size_t lane_stride,
+    size_t first_lane)
+{
+    const float *A = coefs;
+    const float *d1 = coefs + sections;
+    const float *d2 = coefs + (2 * sections);
+
+    for (size_t lane = first_lane; lane < lanes; lane++) {
+        for (size_t f = 0; f < frames; f++) {
+            float v = src[f * frame_stride + lane * lane_stride];
+
+            for (size_t s = 0; s < sections; s++) {
+                float *w1 = &state[(s * 2) * lanes + lane];
+                float *w2 = &state[(s * 2 + 1) * lanes + lane];
+                float w0 = d1[s] * *w1 + d2[s] * *w2 + v;
+                if (highpass) {
+                    v = A[s] * (w0 - (2.0 * *w1) + *w2);
+                }
+                else {
+                    v = A[s] * (w0 + (2.0 * *w1) + *w2);
+                }
+                *w2 = *w1;
+                *w1 = w0;
+            }
+
+            dest[f * frame_stride + lane * lane_stride] = v;
+        }
+    }
+}
+
+static void butterworth_lanes_scalar(const float *coefs, size_t sections, bool highpass, float *state,
+    const float *src, float *dest, size_t frames, size_t lanes, size_t frame_stride, size_t lane_stride)
+{
+    butterworth_lanes_range(coefs, sections, highpass, state, src, dest, frames, lanes,
+        frame_stride, lane_stride, 0);
+}
+
+static void moments_reset(moments_t *m) {
+    m->count = 0;
+    m->mean = 0.0f;
+    m->min = FLT_MAX;
+    m->max = -FLT_MAX;
+    m->m2 = 0.0f;
+    m->m3 = 0.0f;
+    m->m4 = 0.0f;
+}
+
+/**
+ * Welford update with the n-th sample of a stream (n counts from 1), the higher
+ * moments use the old m2 / m3 so they're updated first (Terriberry's extension)
+ */
+static inline void moments_update(moments_t *m, float v, float n, float inv_n, float c4, int order) {
+    float delta = v - m->mean;
+    float delta_n = delta * inv_n;
+    float term1 = delta * delta_n * (n - 1.0f);
+
+    m->mean = m->mean + delta_n;
+    if (order >= 4) {
+        float delta_n2 = delta_n * delta_n;
+        m->m4 = m->m4 + (((term1 * delta_n2) * c4 + (6.0f * delta_n2) * m->m2) - (4.0f * delta_n) * m->m3);
+    }
+    if (order >= 3) {
+        m->m3 = m->m3 + ((term1 * delta_n) * (n - 2.0f) - (3.0f * delta_n) * m->m2);
+    }
+    if (order >= 2) {
+        m->m2 = m->m2 + term1;
+    }
+    if (v < m->min) {
+        m->min = v;
+    }
+    if (v > m->max) {
+        m->max = v;
+    }
+}
+
+/** Combine the accumulators of two parts of a buffer into a (Chan et al. / Pebay) */
+static void moments_merge(moments_t *a, const moments_t *b, int order) {
+    if (b->count == 0) {
+        return;
+    }
+    if (a->count == 0) {
+        *a = *b;
+        return;
+    }
+
+    float na = (float)a->count;
+    float nb = (float)b->count;
+    float n = na + nb;
+    float delta = b->mean - a->mean;
+    float delta_n = delta / n;
+    float delta_n2 = delta_n * delta_n;
+    float term1 = delta * delta_n * na * nb;
+
+    if (order >= 4) {
+        a->m4 = a->m4 + b->m4 + term1 * delta_n2 * (na * na - na * nb + nb * nb)
+            + 6.0f * delta_n2 * (na * na * b->m2 + nb * nb * a->m2)
+            + 4.0f * delta_n * (na * b->m3 - nb * a->m3);
+    }
+    if (order >= 3) {
+        a->m3 = a->m3 + b->m3 + term1 * delta_n * (na - nb)
+            + 3.0f * delta_n * (na * b->m2 - nb * a->m2);
+    }
+    if (order >= 2) {
+        a->m2 = a->m2 + b->m2 + term1;
+    }
+    a->mean = a->mean + delta_n * nb;
+    a->count = a->count + b->count;
+    if (b->min < a->min) {
+        a->min = b->min;
+    }
+    if (b->max > a->max) {
+        a->max = b->max;
+    }
+}
+
+/** Merge the lane accumulators pairwise into lanes[0] and add the samples that are left over */
+static void moments_finish(moments_t *lanes, const float *tail, size_t tail_length, int order,
+    moments_t *output)
+{
+    for (size_t step = 1; step < EI_DISPATCH_MOMENTS_LANES; step *= 2) {
+        for (size_t lane = 0; lane < EI_DISPATCH_MOMENTS_LANES; lane += step * 2) {
+            moments_merge(&lanes[lane], &lanes[lane + step], order);
+        }
+    }
+
+    *output = lanes[0];
+    for (size_t ix = 0; ix < tail_length; ix++) {
+        output->count++;
+        float n = (float)output->count;
+        moments_update(output, tail[ix], n, 1.0f / n, n * n - 3.0f * n + 3.0f, order);
+    }
+}
+
+static void moments_scalar(const float *input, size_t length, int order, moments_t *output) {
+    moments_t lanes[EI_DISPATCH_MOMENTS_LANES];
+    for (size_t lane = 0; lane < EI_DISPATCH_MOMENTS_LANES; lane++) {
+        moments_reset(&lanes[lane]);
+    }
+
+    size_t blocks = length / EI_DISPATCH_MOMENTS_LANES;
+    for (size_t block = 0; block < blocks; block++) {
+        float n = (float)(block + 1);
+        float inv_n = 1.0f / n;
+        float c4 = n * n - 3.0f * n + 3.0f;
+        for (size_t lane = 0; lane < EI_DISPATCH_MOMENTS_LANES; lane++) {
+            lanes[lane].count++;
+            moments_update(&lanes[lane], input[block * EI_DISPATCH_MOMENTS_LANES + lane], n, inv_n, c4, order);
+        }
+    }
+
+    moments_finish(lanes, input + (blocks * EI_DISPATCH_MOMENTS_LANES),
+        length - (blocks * EI_DISPATCH_MOMENTS_LANES), order, output);
+}
+
+static void swap_bytes_range(uint8_t *a, uint8_t *b, size_t start, size_t length) {
+    for (size_t ix = start; ix < length; ix++) {
+        uint8_t tmp = a[ix];
+        a[ix] = b[ix];
+        b[ix] = tmp;
+    }
+}
+
+static void swap_bytes_scalar(uint8_t *a, uint8_t *b, size_t length) {
+    // eight bytes at a time, memcpy keeps the unaligned loads / stores legal
+    size_t words = length / 8;
+    for (size_t ix = 0; ix < words * 8; ix += 8) {
+        uint64_t x, y;
+        memcpy(&x, a + ix, 8);
+        memcpy(&y, b + ix, 8);
+        memcpy(a + ix, &y, 8);
+        memcpy(b + ix, &x, 8);
+    }
+    swap_bytes_range(a, b, words * 8, length);
+}
+
+static const kernels_t scalar_kernels = {
+    "scalar",
+    &int16_to_float_scalar,
+    &fft_magnitude_scalar,
+    &power_spectrum_scalar,
+    &filterbank_dot_u8_scalar,
+    &log_scalar,
+    &fast_log_scalar,
+    &mean_std_axis0_scalar,
+    &dot_lanes_scalar,
+    &dot_q15_scalar,
+    &dot_q31_scalar,
+    &butterworth_lanes_scalar,
+    &moments_scalar,
+    &swap_bytes_scalar
+};
+
+#if EI_DISPATCH_HAS_AVX2 == 1
+/*
+ * AVX2 kernels, 8 output elements per vector. Products and sums are kept
+ * as separate instructions, the scalar code isn't contracted into FMAs either.
+ */
+
+EI_DISPATCH_TARGET_AVX2
+static void int16_to_float_avx2(const int16_t *input, float *output, size_t length) {
+    const __m256 divisor = _mm256_set1_ps(32768.f);
+    size_t ix = 0;
+    for (; ix + 8 <= length; ix += 8) {
+        __m256i v = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(input + ix)));
+        _mm256_storeu_ps(output + ix, _mm256_div_ps(_mm256_cvtepi32_ps(v), divisor));
+    }
+    int16_to_float_scalar(input + ix, output + ix, length - ix);
+}
+
+/**
+ * |c|^2 of 4 complex numbers in double precision, squares of floats are exact in double
+ */
+EI_DISPATCH_TARGET_AVX2
+static inline __m128 magnitude4_avx2(const fft_complex_t *input) {
+    __m256d a = _mm256_cvtps_pd(_mm_loadu_ps(&input[0].r));
+    __m256d b = _mm256_cvtps_pd(_mm_loadu_ps(&input[2].r));
+    __m256d sum = _mm256_hadd_pd(_mm256_mul_pd(a, a), _mm256_mul_pd(b, b));
+    // hadd leaves the bins in 0, 2, 1, 3 order
+    sum = _mm256_permute4x64_pd(sum, 0xd8);
+    return _mm256_cvtpd_ps(_mm256_sqrt_pd(sum));
+}
+
+EI_DISPATCH_TARGET_AVX2
+static void fft_magnitude_avx2(const fft_complex_t *input, float *output, size_t length) {
+    size_t ix = 0;
+    for (; ix + 4 <= length; ix += 4) {
+        _mm_storeu_ps(output + ix, magnitude4_avx2(input + ix));
+    }
+    fft_magnitude_scalar(input + ix, output + ix, length - ix);
+}
+
+EI_DISPATCH_TARGET_AVX2
+static void power_spectrum_avx2(const fft_complex_t *input, float *output, size_t length, uint16_t fft_points) {
+    const __m256d scale = _mm256_set1_pd(1.0 / static_cast<float>(fft_points));
+    size_t ix = 0;
+    for (; ix + 4 <= length; ix += 4) {
+        __m128 magnitude = magnitude4_avx2(input + ix);
+        __m256d power = _mm256_cvtps_pd(_mm_mul_ps(magnitude, magnitude));
+        _mm_storeu_ps(output + ix, _mm256_cvtpd_ps(_mm256_mul_pd(scale, power)));
+    }
+    power_spectrum_scalar(input + ix, output + ix, length - ix, fft_points);
+}
+
+EI_DISPATCH_TARGET_AVX2
+static void filterbank_dot_u8_avx2(const float *row, size_t row_size, const uint8_t *filterbank,
+    size_t filters, const int32_t *bins, const float *dequantize, float *output)
+{
+    size_t j = 0;
+    for (; j + 8 <= filters; j += 8) {
+        // the bins of neighbouring mel filters are next to each other, so 8 filters
+        // together only cover a small part of the row
+        size_t start, end;
+        filterbank_bins_range(bins, row_size, j, j + 8, &start, &end);
+
+        __m256 acc = _mm256_setzero_ps();
+        for (size_t k = start; k < end; k++) {
+            __m128i u8s = _mm_loadl_epi64((const __m128i*)(filterbank + (k * filters) + j));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(u8s, _mm_setzero_si128())) == 0xffff) {
+                continue;
+            }
+            __m256i ix = _mm256_cvtepu8_epi32(u8s);
+            __m256 product = _mm256_mul_ps(_mm256_set1_ps(row[k]), _mm256_i32gather_ps(dequantize, ix, 4));
+            // skip the zero weights like the scalar code (keeps inf / nan rows out)
+            __m256 nonzero = _mm256_castsi256_ps(_mm256_cmpgt_epi32(ix, _mm256_setzero_si256()));
+            acc = _mm256_add_ps(acc, _mm256_and_ps(product, nonzero));
+        }
+        _mm256_storeu_ps(output + j, acc);
+    }
+    // the scalar code is SSE, clear the upper halves first (gcc doesn't always do this before calls)
+    _mm256_zeroupper();
+    filterbank_dot_u8_filters(row, row_size, filterbank, filters, bins, dequantize, output, j);
+}
+
+/**
+ * numpy::log on 8 values, the polynomial uses fused multiply-adds (fmaf) there as well
+ */
+EI_DISPATCH_TARGET_AVX2_FMA
+static void log_avx2(float *buffer, size_t length) {
+    size_t ix = 0;
+    for (; ix + 8 <= length; ix += 8) {
+        __m256i g = _mm256_castps_si256(_mm256_loadu_ps(buffer + ix));
+        __m256i e = _mm256_and_si256(_mm256_sub_epi32(g, _mm256_set1_epi32(0x3f2aaaab)),
+            _mm256_set1_epi32((int32_t)0xff800000));
+        __m256 m = _mm256_castsi256_ps(_mm256_sub_epi32(g, e));
+        __m256 i = _mm256_mul_ps(_mm256_cvtepi32_ps(e), _mm256_set1_ps(1.19209290e-7f));
+        __m256 f = _mm256_sub_ps(m, _mm256_set1_ps(1.0f));
+        __m256 s = _mm256_mul_ps(f, f);
+        __m256 r = _mm256_fmadd_ps(_mm256_set1_ps(0.230836749f), f, _mm256_set1_ps(-0.279208571f));
+        __m256 t = _mm256_fmadd_ps(_mm256_set1_ps(0.331826031f), f, _mm256_set1_ps(-0.498910338f));
+        r = _mm256_fmadd_ps(r, s, t);
+        r = _mm256_fmadd_ps(r, s, f);
+        r = _mm256_fmadd_ps(i, _mm256_set1_ps(0.693147182f), r);
+        _mm256_storeu_ps(buffer + ix, r);
+    }
+    log_scalar(buffer + ix, length - ix);
+}
+
+/**
+ * fast_math::log on 8 values, without FMAs like the scalar code
+ */
+EI_DISPATCH_TARGET_AVX2
+static void fast_log_avx2(float *buffer, size_t length) {
+    size_t ix = 0;
+    for (; ix + 8 <= length; ix += 8) {
+        __m256i g = _mm256_castps_si256(_mm256_loadu_ps(buffer + ix));
+        __m256i e = _mm256_and_si256(_mm256_sub_epi32(g, _mm256_set1_epi32(0x3f3504f3)),
+            _mm256_set1_epi32((int32_t)0xff800000));
+        __m256 f = _mm256_sub_ps(_mm256_castsi256_ps(_mm256_sub_epi32(g, e)), _mm256_set1_ps(1.0f));
+        __m256 p = _mm256_set1_ps(2.556668716e-01f);
+        p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(-3.911231730e-01f));
+        p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(4.852140572e-01f));
+        p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(-7.205412109e-01f));
+        p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(1.442647575e+00f));
+        __m256 r = _mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(e), _mm256_set1_ps(1.19209290e-7f)),
+            _mm256_mul_ps(p, f));
+        _mm256_storeu_ps(buffer + ix, _mm256_mul_ps(r, _mm256_set1_ps(0.693147182f)));
+    }
+    fast_log_scalar(buffer + ix, length - ix);
+}
+
+/**
+ * mean_std_axis0 of the columns [col, col + 16) with the sums in registers, walking down
+ * the rows. Columns from `cols` on are masked off.
+ */
+EI_DISPATCH_TARGET_AVX2
+static void mean_std_axis0_strip_avx2(const float *input, size_t rows, size_t cols, size_t col,
+    float *mean, float *std)
+{
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const int32_t left = (int32_t)(cols - col);
+    const __m256i mask0 = _mm256_cmpgt_epi32(_mm256_set1_epi32(left), lane);
+    const __m256i mask1 = _mm256_cmpgt_epi32(_mm256_set1_epi32(left - 8), lane);
+    const __m256 row_count = _mm256_set1_ps((float)rows);
+
+    __m256 sum0 = _mm256_setzero_ps();
+    __m256 sum1 = _mm256_setzero_ps();
+    const float *in = input + col;
+    for (size_t row = 0; row < rows; row++, in += cols) {
+        sum0 = _mm256_add_ps(sum0, _mm256_maskload_ps(in, mask0));
+        sum1 = _mm256_add_ps(sum1, _mm256_maskload_ps(in + 8, mask1));
+    }
+    const __m256 mean0 = _mm256_div_ps(sum0, row_count);
+    const __m256 mean1 = _mm256_div_ps(sum1, row_count);
+    _mm256_maskstore_ps(mean + col, mask0, mean0);
+    _mm256_maskstore_ps(mean + col + 8, mask1, mean1);
+
+    if (std) {
+        __m256 var0 = _mm256_setzero_ps();
+        __m256 var1 = _mm256_setzero_ps();
+        in = input + col;
+        for (size_t row = 0; row < rows; row++, in += cols) {
+            __m256 tmp0 = _mm256_sub_ps(_mm256_maskload_ps(in, mask0), mean0);
+            __m256 tmp1 = _mm256_sub_ps(_mm256_maskload_ps(in + 8, mask1), mean1);
+            var0 = _mm256_add_ps(var0, _mm256_mul_ps(tmp0, tmp0));
+            var1 = _mm256_add_ps(var1, _mm256_mul_ps(tmp1, tmp1));
+        }
+        _mm256_maskstore_ps(std + col, mask0, _mm256_sqrt_ps(_mm256_div_ps(var0, row_count)));
+        _mm256_maskstore_ps(std + col + 8, mask1, _mm256_sqrt_ps(_mm256_div_ps(var1, row_count)));
+    }
+}
+
+EI_DISPATCH_TARGET_AVX2
+static void mean_std_axis0_avx2(const float *input, size_t rows, size_t cols, float *mean, float *std) {
+    if (cols <= EI_DISPATCH_AXIS0_REGISTER_COLS) {
+        for (size_t col = 0; col < cols; col += 16) {
+            mean_std_axis0_strip_avx2(input, rows, cols, col, mean, std);
+        }
+        return;
+    }
+
+    const size_t vec_cols = cols - (cols % 8);
+    const __m256 row_count = _mm256_set1_ps((float)rows);
+
+    for (size_t col = 0; col < vec_cols; col += 8) {
+        _mm256_storeu_ps(mean + col, _mm256_setzero_ps());
+    }
+    for (size_t row = 0; row < rows; row++) {
+        const float *in = input + (row * cols);
+        for (size_t col = 0; col < vec_cols; col += 8) {
+            _mm256_storeu_ps(mean + col, _mm256_add_ps(_mm256_loadu_ps(mean + col), _mm256_loadu_ps(in + col)));
+        }
+    }
+    for (size_t col = 0; col < vec_cols; col += 8) {
+        _mm256_storeu_ps(mean + col, _mm256_div_ps(_mm256_loadu_ps(mean + col), row_count));
+    }
+
+    if (std) {
+        for (size_t col = 0; col < vec_cols; col += 8) {
+            _mm256_storeu_ps(std + col, _mm256_setzero_ps());
+        }
+        for (size_t row = 0; row < rows; row++) {
+            const float *in = input + (row * cols);
+            for (size_t col = 0; col < vec_cols; col += 8) {
+                __m256 tmp = _mm256_sub_ps(_mm256_loadu_ps(in + col), _mm256_loadu_ps(mean + col));
+                _mm256_storeu_ps(std + col, _mm256_add_ps(_mm256_loadu_ps(std + col), _mm256_mul_ps(tmp, tmp)));
+            }
+        }
+        for (size_t col = 0; col < vec_cols; col += 8) {
+            _mm256_storeu_ps(std + col, _mm256_sqrt_ps(_mm256_div_ps(_mm256_loadu_ps(std + col), row_count)));
+        }
+    }
+
+    if (vec_cols < cols) {
+        mean_std_axis0_strip_avx2(input, rows, cols, vec_cols, mean, std);
+    }
+}
+
+EI_DISPATCH_TARGET_AVX2
+static void dot_lanes_avx2(const float *input, size_t length, const float *weights, size_t weights_stride,
+    size_t lanes, float *acc)
+{
+    const __m256i offsets = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+        _mm256_set1_epi32((int32_t)weights_stride));
+    size_t lane = 0;
+    for (; lane + 8 <= lanes; lane += 8) {
+        const float *w = weights + (lane * weights_stride);
+        __m256 total = _mm256_loadu_ps(acc + lane);
+        for (size_t ix = 0; ix < length; ix++) {
+            __m256 wv = _mm256_i32gather_ps(w + ix, offsets, 4);
+            total = _mm256_add_ps(total, _mm256_mul_ps(_mm256_set1_ps(input[ix]), wv));
+        }
+        _mm256_storeu_ps(acc + lane, total);
+    }
+    dot_lanes_range(input, length, weights, weights_stride, lane, lanes, acc);
+}
+
+/**
+ * madd adds pairs of products in 32 bits, which only overflows when both pairs are
+ * -32768 * -32768. The sum then reads INT32_MIN, which no pair of products can sum
+ * to otherwise, so those lanes get 2^32 added back at the end.
+ */
+EI_DISPATCH_TARGET_AVX2
+static int64_t dot_q15_avx2(const int16_t *a, const int16_t *b, size_t length) {
+    const __m256i int32_min = _mm256_set1_epi32(INT32_MIN);
+    __m256i total = _mm256_setzero_si256();
+    __m256i overflows = _mm256_setzero_si256();
+    size_t ix = 0;
+    for (; ix + 16 <= length; ix += 16) {
+        __m256i m = _mm256_madd_epi16(_mm256_loadu_si256((const __m256i*)(a + ix)),
+            _mm256_loadu_si256((const __m256i*)(b + ix)));
+        total = _mm256_add_epi64(total, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(m)));
+        total = _mm256_add_epi64(total, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(m, 1)));
+        overflows = _mm256_sub_epi32(overflows, _mm256_cmpeq_epi32(m, int32_min));
+    }
+
+    int64_t lanes[4];
+    int32_t overflow_lanes[8];
+    _mm256_storeu_si256((__m256i*)lanes, total);
+    _mm256_storeu_si256((__m256i*)overflow_lanes, overflows);
+    int64_t result = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    for (size_t lane = 0; lane < 8; lane++) {
+        result += (int64_t)overflow_lanes[lane] << 32;
+    }
+    return result + dot_q15_scalar(a + ix, b + ix, length - ix);
+}
+
+EI_DISPATCH_TARGET_AVX2
+static int64_t dot_q31_avx2(const int32_t *a, const int32_t *b, size_t length) {
+    __m256i total = _mm256_setzero_si256();
+    size_t ix = 0;
+    for (; ix + 8 <= length; ix += 8) {
+        __m256i av = _mm256_loadu_si256((const __m256i*)(a + ix));
+        __m256i bv = _mm256_loadu_si256((const __m256i*)(b + ix));
+        // even elements, then the odd ones shifted down
+        total = _mm256_add_epi64(total, _mm256_mul_epi32(av, bv));
+        total = _mm256_add_epi64(total, _mm256_mul_epi32(_mm256_srli_epi64(av, 32), _mm256_srli_epi64(bv, 32)));
+    }
+
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, total);
+    uint64_t result = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    return (int64_t)(result + (uint64_t)dot_q31_scalar(a + ix, b + ix, length - ix));
+}
+
+/**
+ * Four lanes per vector. The frames are filtered in blocks, one section at a time, so
+ * only the w0 recursion of a section is a dependency chain. The output of every section
+ * is calculated in double precision like the scalar code (four floats widened to four doubles).
+ */
+EI_DISPATCH_TARGET_AVX2
+static void butterworth_lanes_avx2(const float *coefs, size_t sections, bool highpass, float *state,
+    const float *src, float *dest, size_t frames, size_t lanes, size_t frame_stride, size_t lane_stride)
+{
+    if (lanes < 2) {
+        butterworth_lanes_scalar(coefs, sections, highpass, state, src, dest, frames, lanes,
+            frame_stride, lane_stride);
+        return;
+    }
+
+    const size_t block_frames = 64;
+    const __m256d two = _mm256_set1_pd(2.0);
+    const __m256d sign = _mm256_set1_pd(highpass ? -1.0 : 1.0);
+    float block[block_frames * 4];
+
+    for (size_t lane = 0; lane < lanes; lane += 4) {
+        const size_t n = lanes - lane < 4 ? lanes - lane : 4;
+
+        for (size_t start = 0; start < frames; start += block_frames) {
+            const size_t count = frames - start < block_frames ? frames - start : block_frames;
+
+            memset(block, 0, sizeof(block));
+            for (size_t f = 0; f < count; f++) {
+                const float *in = src + ((start + f) * frame_stride) + (lane * lane_stride);
+                for (size_t l = 0; l < n; l++) {
+                    block[f * 4 + l] = in[l * lane_stride];
+                }
+            }
+
+            for (size_t s = 0; s < sections; s++) {
+                float tmp[4] = { 0 };
+                float *w1_state = &state[(s * 2) * lanes + lane];
+                float *w2_state = &state[(s * 2 + 1) * lanes + lane];
+                memcpy(tmp, w1_state, n * sizeof(float));
+                __m128 w1 = _mm_loadu_ps(tmp);
+                memcpy(tmp, w2_state, n * sizeof(float));
+                __m128 w2 = _mm_loadu_ps(tmp);
+
+                const __m128 d1 = _mm_set1_ps(coefs[sections + s]);
+                const __m128 d2 = _mm_set1_ps(coefs[2 * sections + s]);
+                const __m256d A = _mm256_set1_pd(coefs[s]);
+
+                for (size_t f = 0; f < count; f++) {
+                    __m128 v = _mm_loadu_ps(block + (f * 4));
+                    __m128 w0 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(d1, w1), _mm_mul_ps(d2, w2)), v);
+                    // (w0 +/- 2 * w1) + w2, negating 2 * w1 is exact
+                    __m256d sum = _mm256_add_pd(_mm256_cvtps_pd(w0),
+                        _mm256_mul_pd(sign, _mm256_mul_pd(two, _mm256_cvtps_pd(w1))));
+                    sum = _mm256_add_pd(sum, _mm256_cvtps_pd(w2));
+                    _mm_storeu_ps(block + (f * 4), _mm256_cvtpd_ps(_mm256_mul_pd(A, sum)));
+                    w2 = w1;
+                    w1 = w0;
+                }
+
+                _mm_storeu_ps(tmp, w1);
+                memcpy(w1_state, tmp, n * sizeof(float));
+                _mm_storeu_ps(tmp, w2);
+                memcpy(w2_state, tmp, n * sizeof(float));
+            }
+
+            for (size_t f = 0; f < count; f++) {
+                float *out = dest + ((start + f) * frame_stride) + (lane * lane_stride);
+                for (size_t l = 0; l < n; l++) {
+                    out[l * lane_stride] = block[f * 4 + l];
+                }
+            }
+        }
+    }
+}
+
+/** One Welford accumulator per vector lane, see moments_update for the order of operations */
+EI_DISPATCH_TARGET_AVX2
+static void moments_avx2(const float *input, size_t length, int order, moments_t *output) {
+    __m256 mean = _mm256_setzero_ps();
+    __m256 m2 = _mm256_setzero_ps();
+    __m256 m3 = _mm256_setzero_ps();
+    __m256 m4 = _mm256_setzero_ps();
+    __m256 min = _mm256_set1_ps(FLT_MAX);
+    __m256 max = _mm256_set1_ps(-FLT_MAX);
+    const __m256 three = _mm256_set1_ps(3.0f);
+    const __m256 four = _mm256_set1_ps(4.0f);
+    const __m256 six = _mm256_set1_ps(6.0f);
+
+    size_t blocks = length / EI_DISPATCH_MOMENTS_LANES;
+    for (size_t block = 0; block < blocks; block++) {
+        float n = (float)(block + 1);
+        const __m256 n1 = _mm256_set1_ps(n - 1.0f);
+        const __m256 n2 = _mm256_set1_ps(n - 2.0f);
+        const __m256 inv_n = _mm256_set1_ps(1.0f / n);
+        const __m256 c4 = _mm256_set1_ps(n * n - 3.0f * n + 3.0f);
+
+        __m256 v = _mm256_loadu_ps(input + (block * EI_DISPATCH_MOMENTS_LANES));
+        __m256 delta = _mm256_sub_ps(v, mean);
+        __m256 delta_n = _mm256_mul_ps(delta, inv_n);
+        __m256 term1 = _mm256_mul_ps(_mm256_mul_ps(delta, delta_n), n1);
+
+        mean = _mm256_add_ps(mean, delta_n);
+        if (order >= 4) {
+            __m256 delta_n2 = _mm256_mul_ps(delta_n, delta_n);
+            __m256 t = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(term1, delta_n2), c4),
+                _mm256_mul_ps(_mm256_mul_ps(six, delta_n2), m2));
+            m4 = _mm256_add_ps(m4, _mm256_sub_ps(t, _mm256_mul_ps(_mm256_mul_ps(four, delta_n), m3)));
+        }
+        if (order >= 3) {
+            m3 = _mm256_add_ps(m3, _mm256_sub_ps(_mm256_mul_ps(_mm256_mul_ps(term1, delta_n), n2),
+                _mm256_mul_ps(_mm256_mul_ps(three, delta_n), m2)));
+        }
+        if (order >= 2) {
+            m2 = _mm256_add_ps(m2, term1);
+        }
+        min = _mm256_min_ps(v, min);
+        max = _mm256_max_ps(v, max);
+    }
+
+    float values[6][EI_DISPATCH_MOMENTS_LANES];
+    _mm256_storeu_ps(values[0], mean);
+    _mm256_storeu_ps(values[1], min);
+    _mm256_storeu_ps(values[2], max);
+    _mm256_storeu_ps(values[3], m2);
+    _mm256_storeu_ps(values[4], m3);
+    _mm256_storeu_ps(values[5], m4);
+
+    moments_t lanes[EI_DISPATCH_MOMENTS_LANES];
+    for (size_t lane = 0; lane < EI_DISPATCH_MOMENTS_LANES; lane++) {
+        lanes[lane].count = blocks;
+        lanes[lane].mean = values[0][lane];
+        lanes[lane].min = values[1][lane];
+        lanes[lane].max = values[2][lane];
+        lanes[lane].m2 = values[3][lane];
+        lanes[lane].m3 = values[4][lane];
+        lanes[lane].m4 = values[5][lane];
+    }
+
+    moments_finish(lanes, input + (blocks * EI_DISPATCH_MOMENTS_LANES),
+        length - (blocks * EI_DISPATCH_MOMENTS_LANES), order, output);
+}
+
+EI_DISPATCH_TARGET_AVX2
+static void swap_bytes_avx2(uint8_t *a, uint8_t *b, size_t length) {
+    size_t blocks = length / 64;
+    for (size_t block = 0; block < blocks; block++) {
+        __m256i *pa = (__m256i *)(a + (block * 64));
+        __m256i *pb = (__m256i *)(b + (block * 64));
+        __m256i a0 = _mm256_loadu_si256(pa);
+        __m256i a1 = _mm256_loadu_si256(pa + 1);
+        __m256i b0 = _mm256_loadu_si256(pb);
+        __m256i b1 = _mm256_loadu_si256(pb + 1);
+        _mm256_storeu_si256(pa, b0);
+        _mm256_storeu_si256(pa + 1, b1);
+        _mm256_storeu_si256(pb, a0);
+        _mm256_storeu_si256(pb + 1, a1);
+    }
+    _mm256_zeroupper();
+    swap_bytes_range(a, b, blocks * 64, length);
+}
+
+static const kernels_t avx2_kernels = {
+    "avx2",
+    &int16_to_float_avx2,
+    &fft_magnitude_avx2,
+    &power_spectrum_avx2,
+    &filterbank_dot_u8_avx2,
+    &log_avx2,
+    &fast_log_avx2,
+    &mean_std_axis0_avx2,
+    &dot_lanes_avx2,
+    &dot_q15_avx2,
+    &dot_q31_avx2,
+    &butterworth_lanes_avx2,
+    &moments_avx2,
+    &swap_bytes_avx2
+};
+#endif // EI_DISPATCH_HAS_AVX2 == 1
+
+#if EI_DISPATCH_HAS_NEON == 1
+/*
+ * NEON kernels: the vector part from ei_dispatch_neon.cpp (see there), the rest
+ * with the scalar code. The FFT magnitudes are calculated in double precision,
+ * those stay scalar.
+ */
+
+static void int16_to_float_neon(const int16_t *input, float *output, size_t length) {
+    size_t vec_length = length - (length % 8);
+    neon_vector_kernels()->int16_to_float(input, output, vec_length);
+    int16_to_float_scalar(input + vec_length, output + vec_length, length - vec_length);
+}
+
+static void filterbank_dot_u8_neon(const float *row, size_t row_size, const uint8_t *filterbank,
+    size_t filters, const int32_t *bins, const float *dequantize, float *output)
+{
+    size_t vec_filters = filters - (filters % 4);
+    neon_vector_kernels()->filterbank_dot_u8(row, row_size, filterbank, filters, vec_filters, bins,
+        dequantize, output);
+    filterbank_dot_u8_filters(row, row_size, filterbank, filters, bins, dequantize, output, vec_filters);
+}
+
+static void log_neon(float *buffer, size_t length) {
+    size_t vec_length = 0;
+    if (neon_vector_kernels()->log) {
+        vec_length = length - (length % 4);
+        neon_vector_kernels()->log(buffer, vec_length);
+    }
+    log_scalar(buffer + vec_length, length - vec_length);
+}
+
+static void fast_log_neon(float *buffer, size_t length) {
+    size_t vec_length = length - (length % 4);
+    neon_vector_kernels()->fast_log(buffer, vec_length);
+    fast_log_scalar(buffer + vec_length, length - vec_length);
+}
+
+static void mean_std_axis0_neon(const float *input, size_t rows, size_t cols, float *mean, float *std) {
+    const size_t vec_cols = cols - (cols % 4);
+
+    neon_vector_kernels()->sum_axis0(input, rows, cols, vec_cols, mean);
+    // no vector division / square root on 32-bit ARM, finish per column
+    for (size_t col = 0; col < vec_cols; col++) {
+        mean[col] = mean[col] / rows;
+    }
+
+    if (std) {
+        neon_vector_kernels()->squared_deviation_axis0(input, rows, cols, vec_cols, mean, std);
+        for (size_t col = 0; col < vec_cols; col++) {
+            std[col] = sqrt(std[col] / rows);
+        }
+    }
+    mean_std_axis0_strips(input, rows, cols, vec_cols, mean, std);
+}
+
+static void dot_lanes_neon(const float *input, size_t length, const float *weights, size_t weights_stride,
+    size_t lanes, float *acc)
+{
+    size_t vec_lanes = lanes - (lanes % 4);
+    neon_vector_kernels()->dot_lanes(input, length, weights, weights_stride, vec_lanes, acc);
+    dot_lanes_range(input, length, weights, weights_stride, vec_lanes, lanes, acc);
+}
+
+static int64_t dot_q15_neon(const int16_t *a, const int16_t *b, size_t length) {
+    size_t vec_length = length - (length % 8);
+    int64_t result = neon_vector_kernels()->dot_q15(a, b, vec_length);
+    return result + dot_q15_scalar(a + vec_length, b + vec_length, length - vec_length);
+}
+
+static int64_t dot_q31_neon(const int32_t *a, const int32_t *b, size_t length) {
+    size_t vec_length = length - (length % 4);
+    uint64_t result = (uint64_t)neon_vector_kernels()->dot_q31(a, b, vec_length);
+    return (int64_t)(result + (uint64_t)dot_q31_scalar(a + vec_length, b + vec_length, length - vec_length));
+}
+
+static void butterworth_lanes_neon(const float *coefs, size_t sections, bool highpass, float *state,
+    const float *src, float *dest, size_t frames, size_t lanes, size_t frame_stride, size_t lane_stride)
+{
+    if (lanes < 2 || !neon_vector_kernels()->butterworth_lanes) {
+        butterworth_lanes_scalar(coefs, sections, highpass, state, src, dest, frames, lanes,
+            frame_stride, lane_stride);
+        return;
+    }
+    neon_vector_kernels()->butterworth_lanes(coefs, sections, highpass, state, src, dest, frames, lanes,
+        frame_stride, lane_stride);
+}
+
+static void moments_neon(const float *input, size_t length, int order, moments_t *output) {
+    size_t blocks = length / EI_DISPATCH_MOMENTS_LANES;
+    float values[6][EI_DISPATCH_MOMENTS_LANES];
+    neon_vector_kernels()->moments(input, blocks, order, values);
+
+    moments_t lanes[EI_DISPATCH_MOMENTS_LANES];
+    for (size_t lane = 0; lane < EI_DISPATCH_MOMENTS_LANES; lane++) {
+        lanes[lane].count = blocks;
+        lanes[lane].mean = values[0][lane];
+        lanes[lane].min = values[1][lane];
+        lanes[lane].max = values[2][lane];
+        lanes[lane].m2 = values[3][lane];
+        lanes[lane].m3 = values[4][lane];
+        lanes[lane].m4 = values[5][lane];
+    }
+
+    moments_finish(lanes, input + (blocks * EI_DISPATCH_MOMENTS_LANES),
+        length - (blocks * EI_DISPATCH_MOMENTS_LANES), order, output);
+}
+
+static void swap_bytes_neon(uint8_t *a, uint8_t *b, size_t length) {
+    size_t vec_length = length - (length % 32);
+    neon_vector_kernels()->swap_bytes(a, b, vec_length);
+    swap_bytes_range(a, b, vec_length, length);
+}
+
+static const kernels_t neon_kernels = {
+    "neon",
+    &int16_to_float_neon,
+    &fft_magnitude_scalar,
+    &power_spectrum_scalar,
+    &filterbank_dot_u8_neon,
+    &log_neon,
+    &fast_log_neon,
+    &mean_std_axis0_neon,
+    &dot_lanes_neon,
+    &dot_q15_neon,
+    &dot_q31_neon,
+    &butterworth_lanes_neon,
+    &moments_neon,
+    &swap_bytes_neon
+};
+#endif // EI_DISPATCH_HAS_NEON == 1
+
+/*
+ * Selection
+ */
+
+typedef struct {
+    const kernels_t *kernels;
+    const char *cpu_features;
+    const char *requested;
+    bool request_honored;
+} selection_t;
+
+static const kernels_t *best_kernels(const char **cpu_features) {
+    *cpu_features = "none";
+
+#if EI_DISPATCH_HAS_AVX2 == 1
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        *cpu_features = "avx2 fma";
+        return &avx2_kernels;
+    }
+#endif
+
+#if EI_DISPATCH_HAS_NEON == 1
+    if (!neon_vector_kernels()) {
+        return &scalar_kernels;
+    }
+#if defined(__arm__) && defined(__linux__)
+    // ei_dispatch_neon.cpp may use VFPv4 (fused multiply-add) as well
+    unsigned long hwcap = getauxval(AT_HWCAP);
+    if (!(hwcap & HWCAP_NEON) || !(hwcap & HWCAP_VFPv4)) {
+        return &scalar_kernels;
+    }
+    *cpu_features = "neon vfpv4";
+#else
+    *cpu_features = "neon";
+#endif
+    return &neon_kernels;
+#endif
+
+    return &scalar_kernels;
+}
+
+static selection_t select_kernels() {
+    selection_t selection;
+    selection.kernels = best_kernels(&selection.cpu_features);
+    selection.requested = NULL;
+    selection.request_honored = false;
+
+#if EI_PORTING_POSIX == 1
+    selection.requested = getenv("EI_DISPATCH");
+    if (selection.requested && selection.requested[0] != '\0') {
+        // only allow going down, never to a variant the CPU can't run
+        if (strcmp(selection.requested, scalar_kernels.name) == 0 ||
+            strcmp(selection.requested, selection.kernels->name) == 0)
+        {
+            if (strcmp(selection.requested, scalar_kernels.name) == 0) {
+                selection.kernels = &scalar_kernels;
+            }
+            selection.request_honored = true;
+        }
+    }
+    else {
+        selection.requested = NULL;
+    }
+#endif
+
+    return selection;
+}
+
+static const selection_t &selection() {
+    static const selection_t s = select_kernels();
+    return s;
+}
+
+} // namespace
+
+const kernels_t &kernels() {
+    return *selection().kernels;
+}
+
+void print_report() {
+    const selection_t &s = selection();
+
+    ei_printf("DSP/NN kernels: %s (CPU features: %s", s.kernels->name, s.cpu_features);
+    if (s.requested && s.request_honored) {
+        ei_printf(", selected by EI_DISPATCH=%s", s.requested);
+    }
+    else if (s.requested) {
+        ei_printf(", EI_DISPATCH=%s is not available", s.requested);
+    }
+    ei_printf(")\n");
+}
+
+} // namespace dispatch
+} // namespace ei
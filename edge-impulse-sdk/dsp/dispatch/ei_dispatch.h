@@ -0,0 +1,121 @@
+/* Edge Impulse inferencing library
+ * Copyright (c) 2021 EdgeImpulse Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef _EIDSP_DISPATCH_H_
+#define _EIDSP_DISPATCH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../numpy_types.h"
+
+namespace ei {
+namespace dispatch {
+
+/**
+ * Hot DSP and NN kernels, bound once to the best implementation for the CPU
+ * we run on. The SIMD variants work on several output elements at a time, but
+ * do the operations for every single element in the same order as the scalar
+ * variant, so they don't change the results (verified bit-exact on x86). Forcing
+ * the scalar variant is a cheap way to rule out the SIMD code while debugging.
+ */
+typedef struct {
+    /** Name of the variant ("scalar", "avx2", "neon") */
+    const char *name;
+
+    /** output[i] = input[i] / 32768 */
+    void (*int16_to_float)(const int16_t *input, float *output, size_t length);
+
+    /** output[i] = |input[i]| */
+    void (*fft_magnitude)(const fft_complex_t *input, float *output, size_t length);
+
+    /** output[i] = |input[i]|^2 / fft_points, like processing::power_spectrum */
+    void (*power_spectrum)(const fft_complex_t *input, float *output, size_t length, uint16_t fft_points);
+
+    /**
+     * Dot product of a row with a transposed, quantized filterbank (row_size x filters):
+     * output[j] = sum_k row[k] * dequantize[filterbank[k * filters + j]], zeros are skipped.
+     * bins (may be NULL) holds the first k and the number of k's of every filter that can be
+     * non-zero (see numpy::filterbank_bins), only those are read.
+     */
+    void (*filterbank_dot_u8)(const float *row, size_t row_size, const uint8_t *filterbank,
+        size_t filters, const int32_t *bins, const float *dequantize, float *output);
+
+    /** buffer[i] = numpy::log(buffer[i]) */
+    void (*log)(float *buffer, size_t length);
+
+    /** buffer[i] = fast_math::log(buffer[i]) */
+    void (*fast_log)(float *buffer, size_t length);
+
+    /** Mean and (optional, may be NULL) standard deviation of every column of a row-major matrix */
+    void (*mean_std_axis0)(const float *input, size_t rows, size_t cols, float *mean, float *std);
+
+    /**
+     * Accumulate `lanes` dot products with a shared input:
+     * acc[l] += sum_i input[i] * weights[l * weights_stride + i], in order of i
+     */
+    void (*dot_lanes)(const float *input, size_t length, const float *weights, size_t weights_stride,
+        size_t lanes, float *acc);
+
+    /** Exact dot product of two int16 vectors, sum_i a[i] * b[i] */
+    int64_t (*dot_q15)(const int16_t *a, const int16_t *b, size_t length);
+
+    /** Dot product of two int32 vectors with 64-bit products, sum_i a[i] * b[i] (wraps like int64 math) */
+    int64_t (*dot_q31)(const int32_t *a, const int32_t *b, size_t length);
+
+    /**
+     * Cascade of Butterworth second order sections (see filters::butterworth_filter) over
+     * several lanes (axes) at once. Sample f of lane l is at src[f * frame_stride + l * lane_stride],
+     * dest has the same layout and can be src. coefs holds A, d1 and d2 of every section,
+     * state holds w1 and w2 of every section and lane: state[(section * 2 + k) * lanes + l].
+     */
+    void (*butterworth_lanes)(const float *coefs, size_t sections, bool highpass, float *state,
+        const float *src, float *dest, size_t frames, size_t lanes, size_t frame_stride, size_t lane_stride);
+
+    /**
+     * Count, mean, min, max and (up to `order`, 2..4) the central moment sums of a buffer in a
+     * single pass. Eight interleaved Welford accumulators (sample i goes to i % 8) are merged
+     * pairwise at the end, the last length % 8 samples are added to the merged accumulator.
+     */
+    void (*moments)(const float *input, size_t length, int order, moments_t *output);
+
+    /** Swap the contents of two buffers of length bytes that don't overlap */
+    void (*swap_bytes)(uint8_t *a, uint8_t *b, size_t length);
+} kernels_t;
+
+/**
+ * @brief Kernels for this CPU. Selected on first use: the best variant the CPU
+ *        supports, unless the EI_DISPATCH environment variable (POSIX targets)
+ *        names another one, e.g. EI_DISPATCH=scalar.
+ */
+const kernels_t &kernels();
+
+/**
+ * @brief Print the selected variant, the CPU features that were found and
+ *        whether the environment overrode the choice
+ */
+void print_report();
+
+} // namespace dispatch
+} // namespace ei
+
+#endif // _EIDSP_DISPATCH_H_
@@ -0,0 +1,429 @@
+/* Edge Impulse inferencing library
+ * Copyright (c) 2021 EdgeImpulse Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * The vector part of the NEON kernels. 32-bit ARM builds compile this file with
+ * -mfpu=neon-vfpv4, the rest of the SDK without, so it must not include any SDK
+ * header besides ei_dispatch_neon.h (see there). The scalar code that finishes
+ * every kernel lives in ei_dispatch.cpp.
+ */
+
+#include <float.h>
+#include <string.h>
+#include "ei_dispatch_neon.h"
+
+#if defined(__aarch64__) || (defined(__arm__) && defined(__ARM_NEON))
+#include <arm_neon.h>
+#define EI_DISPATCH_NEON_BUILT          1
+#else
+#define EI_DISPATCH_NEON_BUILT          0
+#endif
+
+namespace ei {
+namespace dispatch {
+
+#if EI_DISPATCH_NEON_BUILT == 1
+
+namespace {
+
+/*
+ * 4 output elements per vector. Note that 32-bit NEON flushes denormals to zero,
+ * so tiny values can differ from the scalar code there.
+ */
+
+static void int16_to_float_neon(const int16_t *input, float *output, size_t length) {
+    // dividing by a power of two is exact, so multiplying by the inverse is the same
+    const float inverse = 1.0f / 32768.f;
+    for (size_t ix = 0; ix < length; ix += 8) {
+        int16x8_t v = vld1q_s16(input + ix);
+        vst1q_f32(output + ix, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), inverse));
+        vst1q_f32(output + ix + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), inverse));
+    }
+}
+
+static void filterbank_dot_u8_neon(const float *row, size_t row_size, const uint8_t *filterbank,
+    size_t filters, size_t vec_filters, const int32_t *bins, const float *dequantize, float *output)
+{
+    for (size_t j = 0; j < vec_filters; j += 4) {
+        size_t start, end;
+        filterbank_bins_range(bins, row_size, j, j + 4, &start, &end);
+
+        float32x4_t acc = vdupq_n_f32(0.0f);
+        for (size_t k = start; k < end; k++) {
+            const uint8_t *u8 = filterbank + (k * filters) + j;
+            if ((u8[0] | u8[1] | u8[2] | u8[3]) == 0) {
+                continue;
+            }
+            float32x4_t values = vdupq_n_f32(0.0f);
+            values = vld1q_lane_f32(dequantize + u8[0], values, 0);
+            values = vld1q_lane_f32(dequantize + u8[1], values, 1);
+            values = vld1q_lane_f32(dequantize + u8[2], values, 2);
+            values = vld1q_lane_f32(dequantize + u8[3], values, 3);
+            uint32x4_t ix = { u8[0], u8[1], u8[2], u8[3] };
+            float32x4_t product = vmulq_n_f32(values, row[k]);
+            // skip the zero weights like the scalar code (keeps inf / nan rows out)
+            product = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(product),
+                vcgtq_u32(ix, vdupq_n_u32(0))));
+            acc = vaddq_f32(acc, product);
+        }
+        vst1q_f32(output + j, acc);
+    }
+}
+
+#if defined(__aarch64__) || defined(__ARM_FEATURE_FMA)
+static void log_neon(float *buffer, size_t length) {
+    for (size_t ix = 0; ix < length; ix += 4) {
+        int32x4_t g = vreinterpretq_s32_f32(vld1q_f32(buffer + ix));
+        int32x4_t e = vandq_s32(vsubq_s32(g, vdupq_n_s32(0x3f2aaaab)), vdupq_n_s32((int32_t)0xff800000));
+        float32x4_t m = vreinterpretq_f32_s32(vsubq_s32(g, e));
+        float32x4_t i = vmulq_n_f32(vcvtq_f32_s32(e), 1.19209290e-7f);
+        float32x4_t f = vsubq_f32(m, vdupq_n_f32(1.0f));
+        float32x4_t s = vmulq_f32(f, f);
+        // vfmaq_f32(a, b, c) = a + b * c
+        float32x4_t r = vfmaq_f32(vdupq_n_f32(-0.279208571f), vdupq_n_f32(0.230836749f), f);
+        float32x4_t t = vfmaq_f32(vdupq_n_f32(-0.498910338f), vdupq_n_f32(0.331826031f), f);
+        r = vfmaq_f32(t, r, s);
+        r = vfmaq_f32(f, r, s);
+        r = vfmaq_f32(r, i, vdupq_n_f32(0.693147182f));
+        vst1q_f32(buffer + ix, r);
+    }
+}
+#define EI_DISPATCH_NEON_LOG            &log_neon
+#else
+#define EI_DISPATCH_NEON_LOG            NULL
+#endif
+
+static void fast_log_neon(float *buffer, size_t length) {
+    for (size_t ix = 0; ix < length; ix += 4) {
+        int32x4_t g = vreinterpretq_s32_f32(vld1q_f32(buffer + ix));
+        int32x4_t e = vandq_s32(vsubq_s32(g, vdupq_n_s32(0x3f3504f3)), vdupq_n_s32((int32_t)0xff800000));
+        float32x4_t f = vsubq_f32(vreinterpretq_f32_s32(vsubq_s32(g, e)), vdupq_n_f32(1.0f));
+        float32x4_t p = vdupq_n_f32(2.556668716e-01f);
+        p = vaddq_f32(vmulq_f32(p, f), vdupq_n_f32(-3.911231730e-01f));
+        p = vaddq_f32(vmulq_f32(p, f), vdupq_n_f32(4.852140572e-01f));
+        p = vaddq_f32(vmulq_f32(p, f), vdupq_n_f32(-7.205412109e-01f));
+        p = vaddq_f32(vmulq_f32(p, f), vdupq_n_f32(1.442647575e+00f));
+        float32x4_t r = vaddq_f32(vmulq_n_f32(vcvtq_f32_s32(e), 1.19209290e-7f), vmulq_f32(p, f));
+        vst1q_f32(buffer + ix, vmulq_n_f32(r, 0.693147182f));
+    }
+}
+
+static void sum_axis0_neon(const float *input, size_t rows, size_t cols, size_t vec_cols, float *sum) {
+    if (cols <= EI_DISPATCH_AXIS0_REGISTER_COLS) {
+        // sums of two (then one) vectors of columns in registers, walking down the rows
+        size_t col = 0;
+        for (; col + 8 <= vec_cols; col += 8) {
+            float32x4_t sum0 = vdupq_n_f32(0.0f);
+            float32x4_t sum1 = vdupq_n_f32(0.0f);
+            const float *in = input + col;
+            for (size_t row = 0; row < rows; row++, in += cols) {
+                sum0 = vaddq_f32(sum0, vld1q_f32(in));
+                sum1 = vaddq_f32(sum1, vld1q_f32(in + 4));
+            }
+            vst1q_f32(sum + col, sum0);
+            vst1q_f32(sum + col + 4, sum1);
+        }
+        if (col < vec_cols) {
+            float32x4_t sum0 = vdupq_n_f32(0.0f);
+            const float *in = input + col;
+            for (size_t row = 0; row < rows; row++, in += cols) {
+                sum0 = vaddq_f32(sum0, vld1q_f32(in));
+            }
+            vst1q_f32(sum + col, sum0);
+        }
+        return;
+    }
+
+    for (size_t col = 0; col < vec_cols; col += 4) {
+        vst1q_f32(sum + col, vdupq_n_f32(0.0f));
+    }
+    for (size_t row = 0; row < rows; row++) {
+        const float *in = input + (row * cols);
+        for (size_t col = 0; col < vec_cols; col += 4) {
+            vst1q_f32(sum + col, vaddq_f32(vld1q_f32(sum + col), vld1q_f32(in + col)));
+        }
+    }
+}
+
+static void squared_deviation_axis0_neon(const float *input, size_t rows, size_t cols, size_t vec_cols,
+    const float *mean, float *sum)
+{
+    if (cols <= EI_DISPATCH_AXIS0_REGISTER_COLS) {
+        size_t col = 0;
+        for (; col + 8 <= vec_cols; col += 8) {
+            const float32x4_t mean0 = vld1q_f32(mean + col);
+            const float32x4_t mean1 = vld1q_f32(mean + col + 4);
+            float32x4_t sum0 = vdupq_n_f32(0.0f);
+            float32x4_t sum1 = vdupq_n_f32(0.0f);
+            const float *in = input + col;
+            for (size_t row = 0; row < rows; row++, in += cols) {
+                float32x4_t tmp0 = vsubq_f32(vld1q_f32(in), mean0);
+                float32x4_t tmp1 = vsubq_f32(vld1q_f32(in + 4), mean1);
+                sum0 = vaddq_f32(sum0, vmulq_f32(tmp0, tmp0));
+                sum1 = vaddq_f32(sum1, vmulq_f32(tmp1, tmp1));
+            }
+            vst1q_f32(sum + col, sum0);
+            vst1q_f32(sum + col + 4, sum1);
+        }
+        if (col < vec_cols) {
+            const float32x4_t mean0 = vld1q_f32(mean + col);
+            float32x4_t sum0 = vdupq_n_f32(0.0f);
+            const float *in = input + col;
+            for (size_t row = 0; row < rows; row++, in += cols) {
+                float32x4_t tmp0 = vsubq_f32(vld1q_f32(in), mean0);
+                sum0 = vaddq_f32(sum0, vmulq_f32(tmp0, tmp0));
+            }
+            vst1q_f32(sum + col, sum0);
+        }
+        return;
+    }
+
+    for (size_t col = 0; col < vec_cols; col += 4) {
+        vst1q_f32(sum + col, vdupq_n_f32(0.0f));
+    }
+    for (size_t row = 0; row < rows; row++) {
+        const float *in = input + (row * cols);
+        for (size_t col = 0; col < vec_cols; col += 4) {
+            float32x4_t tmp = vsubq_f32(vld1q_f32(in + col), vld1q_f32(mean + col));
+            vst1q_f32(sum + col, vaddq_f32(vld1q_f32(sum + col), vmulq_f32(tmp, tmp)));
+        }
+    }
+}
+
+static void dot_lanes_neon(const float *input, size_t length, const float *weights, size_t weights_stride,
+    size_t vec_lanes, float *acc)
+{
+    for (size_t lane = 0; lane < vec_lanes; lane += 4) {
+        const float *w0 = weights + (lane * weights_stride);
+        const float *w1 = w0 + weights_stride;
+        const float *w2 = w1 + weights_stride;
+        const float *w3 = w2 + weights_stride;
+        float32x4_t total = vld1q_f32(acc + lane);
+        for (size_t ix = 0; ix < length; ix++) {
+            float32x4_t wv = vdupq_n_f32(0.0f);
+            wv = vld1q_lane_f32(w0 + ix, wv, 0);
+            wv = vld1q_lane_f32(w1 + ix, wv, 1);
+            wv = vld1q_lane_f32(w2 + ix, wv, 2);
+            wv = vld1q_lane_f32(w3 + ix, wv, 3);
+            total = vaddq_f32(total, vmulq_n_f32(wv, input[ix]));
+        }
+        vst1q_f32(acc + lane, total);
+    }
+}
+
+static int64_t dot_q15_neon(const int16_t *a, const int16_t *b, size_t length) {
+    int64x2_t total = vdupq_n_s64(0);
+    for (size_t ix = 0; ix < length; ix += 8) {
+        int16x8_t av = vld1q_s16(a + ix);
+        int16x8_t bv = vld1q_s16(b + ix);
+        total = vpadalq_s32(total, vmull_s16(vget_low_s16(av), vget_low_s16(bv)));
+        total = vpadalq_s32(total, vmull_s16(vget_high_s16(av), vget_high_s16(bv)));
+    }
+    return vgetq_lane_s64(total, 0) + vgetq_lane_s64(total, 1);
+}
+
+static int64_t dot_q31_neon(const int32_t *a, const int32_t *b, size_t length) {
+    int64x2_t total = vdupq_n_s64(0);
+    for (size_t ix = 0; ix < length; ix += 4) {
+        int32x4_t av = vld1q_s32(a + ix);
+        int32x4_t bv = vld1q_s32(b + ix);
+        total = vmlal_s32(total, vget_low_s32(av), vget_low_s32(bv));
+        total = vmlal_s32(total, vget_high_s32(av), vget_high_s32(bv));
+    }
+    return (int64_t)((uint64_t)vgetq_lane_s64(total, 0) + (uint64_t)vgetq_lane_s64(total, 1));
+}
+
+#if defined(__aarch64__)
+/**
+ * Four lanes per vector, filtered in blocks of frames one section at a time like the
+ * AVX2 variant, with the output of every section in double precision (two vectors of two doubles)
+ */
+static void butterworth_lanes_neon(const float *coefs, size_t sections, bool highpass, float *state,
+    const float *src, float *dest, size_t frames, size_t lanes, size_t frame_stride, size_t lane_stride)
+{
+    const size_t block_frames = 64;
+    const double sign = highpass ? -2.0 : 2.0;
+    float block[block_frames * 4];
+
+    for (size_t lane = 0; lane < lanes; lane += 4) {
+        const size_t n = lanes - lane < 4 ? lanes - lane : 4;
+
+        for (size_t start = 0; start < frames; start += block_frames) {
+            const size_t count = frames - start < block_frames ? frames - start : block_frames;
+
+            memset(block, 0, sizeof(block));
+            for (size_t f = 0; f < count; f++) {
+                const float *in = src + ((start + f) * frame_stride) + (lane * lane_stride);
+                for (size_t l = 0; l < n; l++) {
+                    block[f * 4 + l] = in[l * lane_stride];
+                }
+            }
+
+            for (size_t s = 0; s < sections; s++) {
+                float tmp[4] = { 0 };
+                float *w1_state = &state[(s * 2) * lanes + lane];
+                float *w2_state = &state[(s * 2 + 1) * lanes + lane];
+                memcpy(tmp, w1_state, n * sizeof(float));
+                float32x4_t w1 = vld1q_f32(tmp);
+                memcpy(tmp, w2_state, n * sizeof(float));
+                float32x4_t w2 = vld1q_f32(tmp);
+
+                const float d1 = coefs[sections + s];
+                const float d2 = coefs[2 * sections + s];
+                const double A = coefs[s];
+
+                for (size_t f = 0; f < count; f++) {
+                    float32x4_t v = vld1q_f32(block + (f * 4));
+                    float32x4_t w0 = vaddq_f32(vaddq_f32(vmulq_n_f32(w1, d1), vmulq_n_f32(w2, d2)), v);
+                    // (w0 +/- 2 * w1) + w2, +/- 2 * w1 is exact
+                    float64x2_t lo = vaddq_f64(vcvt_f64_f32(vget_low_f32(w0)),
+                        vmulq_n_f64(vcvt_f64_f32(vget_low_f32(w1)), sign));
+                    float64x2_t hi = vaddq_f64(vcvt_high_f64_f32(w0),
+                        vmulq_n_f64(vcvt_high_f64_f32(w1), sign));
+                    lo = vmulq_n_f64(vaddq_f64(lo, vcvt_f64_f32(vget_low_f32(w2))), A);
+                    hi = vmulq_n_f64(vaddq_f64(hi, vcvt_high_f64_f32(w2)), A);
+                    vst1q_f32(block + (f * 4), vcvt_high_f32_f64(vcvt_f32_f64(lo), hi));
+                    w2 = w1;
+                    w1 = w0;
+                }
+
+                vst1q_f32(tmp, w1);
+                memcpy(w1_state, tmp, n * sizeof(float));
+                vst1q_f32(tmp, w2);
+                memcpy(w2_state, tmp, n * sizeof(float));
+            }
+
+            for (size_t f = 0; f < count; f++) {
+                float *out = dest + ((start + f) * frame_stride) + (lane * lane_stride);
+                for (size_t l = 0; l < n; l++) {
+                    out[l * lane_stride] = block[f * 4 + l];
+                }
+            }
+        }
+    }
+}
+#define EI_DISPATCH_NEON_BUTTERWORTH    &butterworth_lanes_neon
+#else
+#define EI_DISPATCH_NEON_BUTTERWORTH    NULL
+#endif
+
+/** Eight accumulators in two vectors, see moments_update in ei_dispatch.cpp for the order of operations */
+static void moments_neon(const float *input, size_t blocks, int order, float values[6][EI_DISPATCH_MOMENTS_LANES]) {
+    float32x4_t mean[2], m2[2], m3[2], m4[2], min[2], max[2];
+    for (size_t h = 0; h < 2; h++) {
+        mean[h] = vdupq_n_f32(0.0f);
+        m2[h] = vdupq_n_f32(0.0f);
+        m3[h] = vdupq_n_f32(0.0f);
+        m4[h] = vdupq_n_f32(0.0f);
+        min[h] = vdupq_n_f32(FLT_MAX);
+        max[h] = vdupq_n_f32(-FLT_MAX);
+    }
+
+    for (size_t block = 0; block < blocks; block++) {
+        float n = (float)(block + 1);
+        const float n1 = n - 1.0f;
+        const float n2 = n - 2.0f;
+        const float inv_n = 1.0f / n;
+        const float c4 = n * n - 3.0f * n + 3.0f;
+
+        for (size_t h = 0; h < 2; h++) {
+            float32x4_t v = vld1q_f32(input + (block * EI_DISPATCH_MOMENTS_LANES) + (h * 4));
+            float32x4_t delta = vsubq_f32(v, mean[h]);
+            float32x4_t delta_n = vmulq_n_f32(delta, inv_n);
+            float32x4_t term1 = vmulq_n_f32(vmulq_f32(delta, delta_n), n1);
+
+            mean[h] = vaddq_f32(mean[h], delta_n);
+            if (order >= 4) {
+                float32x4_t delta_n2 = vmulq_f32(delta_n, delta_n);
+                float32x4_t t = vaddq_f32(vmulq_n_f32(vmulq_f32(term1, delta_n2), c4),
+                    vmulq_f32(vmulq_n_f32(delta_n2, 6.0f), m2[h]));
+                m4[h] = vaddq_f32(m4[h], vsubq_f32(t, vmulq_f32(vmulq_n_f32(delta_n, 4.0f), m3[h])));
+            }
+            if (order >= 3) {
+                m3[h] = vaddq_f32(m3[h], vsubq_f32(vmulq_n_f32(vmulq_f32(term1, delta_n), n2),
+                    vmulq_f32(vmulq_n_f32(delta_n, 3.0f), m2[h])));
+            }
+            if (order >= 2) {
+                m2[h] = vaddq_f32(m2[h], term1);
+            }
+            // select like the scalar compares (vminq / vmaxq propagate NaN differently)
+            min[h] = vbslq_f32(vcltq_f32(v, min[h]), v, min[h]);
+            max[h] = vbslq_f32(vcgtq_f32(v, max[h]), v, max[h]);
+        }
+    }
+
+    for (size_t h = 0; h < 2; h++) {
+        vst1q_f32(values[0] + (h * 4), mean[h]);
+        vst1q_f32(values[1] + (h * 4), min[h]);
+        vst1q_f32(values[2] + (h * 4), max[h]);
+        vst1q_f32(values[3] + (h * 4), m2[h]);
+        vst1q_f32(values[4] + (h * 4), m3[h]);
+        vst1q_f32(values[5] + (h * 4), m4[h]);
+    }
+}
+
+static void swap_bytes_neon(uint8_t *a, uint8_t *b, size_t length) {
+    for (size_t offset = 0; offset < length; offset += 32) {
+        uint8_t *pa = a + offset;
+        uint8_t *pb = b + offset;
+        uint8x16_t a0 = vld1q_u8(pa);
+        uint8x16_t a1 = vld1q_u8(pa + 16);
+        uint8x16_t b0 = vld1q_u8(pb);
+        uint8x16_t b1 = vld1q_u8(pb + 16);
+        vst1q_u8(pa, b0);
+        vst1q_u8(pa + 16, b1);
+        vst1q_u8(pb, a0);
+        vst1q_u8(pb + 16, a1);
+    }
+}
+
+static const neon_vector_kernels_t neon_vector = {
+    &int16_to_float_neon,
+    &filterbank_dot_u8_neon,
+    EI_DISPATCH_NEON_LOG,
+    &fast_log_neon,
+    &sum_axis0_neon,
+    &squared_deviation_axis0_neon,
+    &dot_lanes_neon,
+    &dot_q15_neon,
+    &dot_q31_neon,
+    EI_DISPATCH_NEON_BUTTERWORTH,
+    &moments_neon,
+    &swap_bytes_neon
+};
+
+} // namespace
+
+const neon_vector_kernels_t *neon_vector_kernels() {
+    return &neon_vector;
+}
+
+#else
+
+const neon_vector_kernels_t *neon_vector_kernels() {
+    return NULL;
+}
+
+#endif // EI_DISPATCH_NEON_BUILT == 1
+
+} // namespace dispatch
+} // namespace ei
@@ -0,0 +1,142 @@
+/* Edge Impulse inferencing library
+ * Copyright (c) 2021 EdgeImpulse Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _EIDSP_DISPATCH_NEON_H_
+#define _EIDSP_DISPATCH_NEON_H_
+
+/*
+ * Internal to the dispatch layer. 32-bit ARM builds compile ei_dispatch_neon.cpp
+ * with -mfpu=neon-vfpv4, so this header (and that file) only include standard
+ * headers and define static functions: an inline function of a shared SDK header
+ * would get a NEON copy there that the linker can pick for the whole program.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define EI_DISPATCH_MOMENTS_LANES       8
+
+/*
+ * The vector mean_std_axis0 kernels keep the sums of a few vectors of columns in registers
+ * while they walk down the rows, for matrices up to this many columns. Wider matrices add
+ * whole rows into the outputs, so they are read once in memory order.
+ */
+#define EI_DISPATCH_AXIS0_REGISTER_COLS 32
+
+namespace ei {
+namespace dispatch {
+
+/** Range of k's [*start, *end) of filters [first, last) that can be non-zero */
+static inline void filterbank_bins_range(const int32_t *bins, size_t row_size, size_t first, size_t last,
+    size_t *start, size_t *end)
+{
+    if (!bins) {
+        *start = 0;
+        *end = row_size;
+        return;
+    }
+
+    *start = row_size;
+    *end = 0;
+    for (size_t j = first; j < last; j++) {
+        if (bins[j * 2 + 1] == 0) {
+            continue;
+        }
+        size_t bin_start = (size_t)bins[j * 2];
+        size_t bin_end = bin_start + (size_t)bins[j * 2 + 1];
+        if (bin_start < *start) {
+            *start = bin_start;
+        }
+        if (bin_end > *end) {
+            *end = bin_end;
+        }
+    }
+    if (*end > row_size) {
+        *end = row_size;
+    }
+}
+
+/**
+ * The vector part of the NEON kernels (see kernels_t). They only take whole
+ * vectors, the NEON kernels in ei_dispatch.cpp do the rest with the scalar code.
+ */
+typedef struct {
+    /** int16_to_float, length is a multiple of 8 */
+    void (*int16_to_float)(const int16_t *input, float *output, size_t length);
+
+    /** filterbank_dot_u8 of filters [0, vec_filters), vec_filters is a multiple of 4 */
+    void (*filterbank_dot_u8)(const float *row, size_t row_size, const uint8_t *filterbank,
+        size_t filters, size_t vec_filters, const int32_t *bins, const float *dequantize, float *output);
+
+    /** log, length is a multiple of 4. NULL without FMA, where it wouldn't match the scalar code */
+    void (*log)(float *buffer, size_t length);
+
+    /** fast_log, length is a multiple of 4 */
+    void (*fast_log)(float *buffer, size_t length);
+
+    /**
+     * sum[col] = sum_row input[row][col], in order of row, for columns [0, vec_cols),
+     * vec_cols is a multiple of 4
+     */
+    void (*sum_axis0)(const float *input, size_t rows, size_t cols, size_t vec_cols, float *sum);
+
+    /**
+     * sum[col] = sum_row (input[row][col] - mean[col])^2, in order of row, for columns
+     * [0, vec_cols), vec_cols is a multiple of 4
+     */
+    void (*squared_deviation_axis0)(const float *input, size_t rows, size_t cols, size_t vec_cols,
+        const float *mean, float *sum);
+
+    /** dot_lanes of lanes [0, vec_lanes), vec_lanes is a multiple of 4 */
+    void (*dot_lanes)(const float *input, size_t length, const float *weights, size_t weights_stride,
+        size_t vec_lanes, float *acc);
+
+    /** dot_q15, length is a multiple of 8 */
+    int64_t (*dot_q15)(const int16_t *a, const int16_t *b, size_t length);
+
+    /** dot_q31, length is a multiple of 4 */
+    int64_t (*dot_q31)(const int32_t *a, const int32_t *b, size_t length);
+
+    /** butterworth_lanes for lanes >= 2. NULL on 32-bit ARM (no double precision vectors) */
+    void (*butterworth_lanes)(const float *coefs, size_t sections, bool highpass, float *state,
+        const float *src, float *dest, size_t frames, size_t lanes, size_t frame_stride, size_t lane_stride);
+
+    /**
+     * The EI_DISPATCH_MOMENTS_LANES Welford accumulators of moments over blocks * 8 samples:
+     * mean, min, max, m2, m3 and m4 of every accumulator, in that order
+     */
+    void (*moments)(const float *input, size_t blocks, int order, float values[6][EI_DISPATCH_MOMENTS_LANES]);
+
+    /** swap_bytes, length is a multiple of 32 */
+    void (*swap_bytes)(uint8_t *a, uint8_t *b, size_t length);
+} neon_vector_kernels_t;
+
+/**
+ * @brief The vector part of the NEON kernels, NULL if ei_dispatch_neon.cpp was
+ *        built without NEON (32-bit ARM without -mfpu=neon*) or for another CPU
+ */
+const neon_vector_kernels_t *neon_vector_kernels();
+
+} // namespace dispatch
+} // namespace ei
+
+#endif // _EIDSP_DISPATCH_NEON_H_
@@ -0,0 +1,124 @@
+/* Edge Impulse inferencing library
+ * Copyright (c) 2021 EdgeImpulse Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef _EIDSP_FAST_MATH_H_
+#define _EIDSP_FAST_MATH_H_
+
+#include <stdint.h>
+#include <string.h>
+
+namespace ei {
+
+/**
+ * Approximate log / exp for the DSP blocks (enable with EIDSP_USE_FAST_MATH).
+ * Plain multiply-adds only: no fmaf() (a libm call on targets without FMA
+ * instructions) and no contraction, so the dispatch SIMD variants return the
+ * same bits as these functions. Max errors below were measured over all
+ * positive normal floats (log) and over the full non-overflowing range (exp).
+ */
+class fast_math {
+public:
+    /**
+     * Base 2 log, max abs error 3.0e-5. For positive normal floats only,
+     * zero, denormals, negative numbers, inf and nan return garbage.
+     * @param a Input number
+     * @returns log2(a)
+     */
+    __attribute__((always_inline)) static inline float log2(float a)
+    {
+        int32_t g;
+        memcpy(&g, &a, sizeof(g));
+        // a = 2^e * m with m in [sqrt(1/2), sqrt(2))
+        int32_t e = (g - 0x3f3504f3) & (int32_t)0xff800000;
+        g -= e;
+        float m;
+        memcpy(&m, &g, sizeof(m));
+        float f = m - 1.0f;
+
+        // log2(1 + f) = f * P(f), least squares fit on [sqrt(1/2) - 1, sqrt(2) - 1]
+        float p = 2.556668716e-01f;
+        p = p * f + -3.911231730e-01f;
+        p = p * f + 4.852140572e-01f;
+        p = p * f + -7.205412109e-01f;
+        p = p * f + 1.442647575e+00f;
+        return (float)e * 1.19209290e-7f + p * f; // 0x1.0p-23
+    }
+
+    /**
+     * Natural log, max abs error 2.5e-5 (see log2 for the valid inputs)
+     */
+    __attribute__((always_inline)) static inline float log(float a)
+    {
+        return log2(a) * 0.693147182f;
+    }
+
+    /**
+     * Base 10 log, max abs error 1.3e-5 (see log2 for the valid inputs)
+     */
+    __attribute__((always_inline)) static inline float log10(float a)
+    {
+        return log2(a) * 0.301029996f;
+    }
+
+    /**
+     * 2^x, max rel error 2.6e-7. x is clamped to [-126, 127], so the result
+     * never overflows or becomes denormal. Not for nan.
+     * @param x Exponent
+     * @returns 2^x
+     */
+    __attribute__((always_inline)) static inline float exp2(float x)
+    {
+        x = x < -126.0f ? -126.0f : (x > 127.0f ? 127.0f : x);
+
+        // round to nearest by adding 1.5 * 2^23, the integer ends up in the low mantissa bits
+        float t = x + 12582912.0f;
+        float r = x - (t - 12582912.0f); // r in [-0.5, 0.5]
+        int32_t n;
+        memcpy(&n, &t, sizeof(n));
+        int32_t bits = (n - 0x4b400000 + 127) << 23;
+        float scale;
+        memcpy(&scale, &bits, sizeof(scale));
+
+        // 2^r, least squares fit on [-0.5, 0.5]
+        float p = 1.340043224e-03f;
+        p = p * r + 9.676037094e-03f;
+        p = p * r + 5.550327214e-02f;
+        p = p * r + 2.402210736e-01f;
+        p = p * r + 6.931472067e-01f;
+        p = p * r + 1.000000075e+00f;
+        return scale * p;
+    }
+
+    /**
+     * e^x, max rel error 4.0e-6 for x in [-87, 88] (rounding x * log2(e)
+     * dominates), clamped outside of that like exp2
+     */
+    __attribute__((always_inline)) static inline float exp(float x)
+    {
+        return exp2(x * 1.44269504f);
+    }
+};
+
+} // namespace ei
+
+#endif // _EIDSP_FAST_MATH_H_
@@ -0,0 +1,644 @@
+/* Edge Impulse inferencing library
+ * Copyright (c) 2021 EdgeImpulse Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ei_fft.h"
+#include "../config.hpp"
+#include "../memory.hpp"
+#include "../returntypes.hpp"
+#include "../kissfft/kiss_fft.h"
+#include "../kissfft/kiss_fftr.h"
+#include "../kissfft/kiss_fftr_batch.h"
+#include "../kissfft/kiss_fftr_q15.h"
+#include "../../porting/ei_classifier_porting.h"
+#if EIDSP_USE_CMSIS_FIXED
+#include "edge-impulse-sdk/CMSIS/DSP/Include/arm_math.h"
+#endif
+
+namespace ei {
+namespace fft {
+
+/*
+ * kissfft, the state is the kiss_fftr_cfg (real) or kiss_fft_cfg (complex),
+ * real q15 FFTs run on the fixed point build (kiss_fftr_q15_cfg)
+ */
+
+static bool kissfft_supports(size_t n, bool real, format_t format) {
+    if (n == 0) {
+        return false;
+    }
+    switch (format) {
+        case FFT_F32: return real ? (n % 2 == 0) : true;
+        case FFT_Q15: return real && (n % 2 == 0);
+        default: return false;
+    }
+}
+
+static int kissfft_init(plan_t *plan) {
+    size_t kiss_mem_length;
+
+    if (plan->format == FFT_Q15) {
+        plan->state = kiss_fftr_q15_alloc(plan->n, 0, NULL, NULL, &kiss_mem_length);
+    }
+    else if (plan->real) {
+        plan->state = kiss_fftr_alloc(plan->n, 0, NULL, NULL, &kiss_mem_length);
+    }
+    else {
+        plan->state = kiss_fft_alloc(plan->n, 0, NULL, NULL, &kiss_mem_length);
+    }
+    if (!plan->state) {
+        EIDSP_ERR(EIDSP_OUT_OF_MEM);
+    }
+
+    ei_dsp_register_alloc(kiss_mem_length, plan->state);
+    plan->state_size = kiss_mem_length;
+
+    return EIDSP_OK;
+}
+
+static void kissfft_free(plan_t *plan) {
+    ei_dsp_free(plan->state, plan->state_size);
+}
+
+static int kissfft_rfft_f32(const plan_t *plan, const float *input, fft_complex_t *output) {
+    kiss_fftr((kiss_fftr_cfg)plan->state, input, (kiss_fft_cpx*)output);
+    return EIDSP_OK;
+}
+
+static int kissfft_rfft_f32_frames(const plan_t *plan, const float *input, size_t input_stride,
+    fft_complex_t *output, size_t output_stride, size_t frames)
+{
+    if (frames == 1) {
+        return kissfft_rfft_f32(plan, input, output);
+    }
+
+    size_t kiss_fftr_mem_length;
+
+    // transforms KISS_FFTR_BATCH_LANES frames at a time, the output is the same as kiss_fftr
+    kiss_fftr_batch_cfg cfg = kiss_fftr_batch_alloc(plan->n, NULL, NULL, &kiss_fftr_mem_length);
+    if (!cfg) {
+        EIDSP_ERR(EIDSP_OUT_OF_MEM);
+    }
+
+    ei_dsp_register_alloc(kiss_fftr_mem_length, cfg);
+
+    kiss_fftr_batch(cfg, input, input_stride, (kiss_fft_cpx*)output, output_stride, frames);
+
+    ei_dsp_free(cfg, kiss_fftr_mem_length);
+
+    return EIDSP_OK;
+}
+
+static int kissfft_cfft_f32(const plan_t *plan, const fft_complex_t *input, fft_complex_t *output) {
+    kiss_fft((kiss_fft_cfg)plan->state, (const kiss_fft_cpx*)input, (kiss_fft_cpx*)output);
+    return EIDSP_OK;
+}
+
+static int kissfft_rfft_q15(const plan_t *plan, const int16_t *input, fft_complex_i16_t *output) {
+    kiss_fftr_q15((kiss_fftr_q15_cfg)plan->state, input, (int16_t*)output);
+    return EIDSP_OK;
+}
+
+const backend_t kissfft_backend = {
+    "kissfft",
+    &kissfft_supports,
+    &kissfft_init,
+    &kissfft_free,
+    &kissfft_rfft_f32,
+    &kissfft_rfft_f32_frames,
+    &kissfft_cfft_f32,
+    &kissfft_rfft_q15,
+    NULL,
+    NULL,
+    NULL
+};
+
+#if EIDSP_USE_CMSIS_FIXED
+/*
+ * CMSIS-DSP (linked in on every target, it's also the fixed point FFT of numpy).
+ * Its FFTs work in place or modify their input, so the state has a scratch buffer.
+ */
+
+typedef struct {
+    union {
+        arm_rfft_fast_instance_f32 rfft_f32;
+        arm_cfft_instance_f32 cfft_f32;
+        arm_rfft_instance_q15 rfft_q15;
+        arm_cfft_instance_q15 cfft_q15;
+        arm_rfft_instance_q31 rfft_q31;
+        arm_cfft_instance_q31 cfft_q31;
+    } instance;
+    void *scratch;
+} cmsis_state_t;
+
+static bool cmsis_supports(size_t n, bool real, format_t format) {
+    (void)format;
+
+    // all formats have the same sizes
+    if ((n & (n - 1)) != 0 || n > 4096) {
+        return false;
+    }
+    if (real) {
+        return n >= 32;
+    }
+    return n >= 16;
+}
+
+static int cmsis_init(plan_t *plan) {
+    size_t n = plan->n;
+    size_t sample_size = plan->format == FFT_Q15 ? sizeof(q15_t) :
+        plan->format == FFT_Q31 ? sizeof(q31_t) : sizeof(float32_t);
+
+    // real f32: input copy + packed output, real fixed point: input copy + full spectrum,
+    // complex: the in place buffer
+    size_t scratch_samples = !plan->real ? 2 * n :
+        plan->format == FFT_F32 ? 2 * n : 3 * n;
+
+    size_t state_size = sizeof(cmsis_state_t) + scratch_samples * sample_size;
+    cmsis_state_t *state = (cmsis_state_t*)ei_dsp_malloc(state_size);
+    if (!state) {
+        EIDSP_ERR(EIDSP_OUT_OF_MEM);
+    }
+    state->scratch = state + 1;
+
+    arm_status status = ARM_MATH_ARGUMENT_ERROR;
+    switch (plan->format) {
+        case FFT_F32:
+            status = plan->real ?
+                arm_rfft_fast_init_f32(&state->instance.rfft_f32, n) :
+                arm_cfft_init_f32(&state->instance.cfft_f32, n);
+            break;
+        case FFT_Q15:
+            status = plan->real ?
+                arm_rfft_init_q15(&state->instance.rfft_q15, n, 0, 1) :
+                arm_cfft_init_q15(&state->instance.cfft_q15, n);
+            break;
+        case FFT_Q31:
+            status = plan->real ?
+                arm_rfft_init_q31(&state->instance.rfft_q31, n, 0, 1) :
+                arm_cfft_init_q31(&state->instance.cfft_q31, n);
+            break;
+    }
+    if (status != ARM_MATH_SUCCESS) {
+        ei_dsp_free(state, state_size);
+        EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+    }
+
+    plan->state = state;
+    plan->state_size = state_size;
+
+    return EIDSP_OK;
+}
+
+static void cmsis_free(plan_t *plan) {
+    ei_dsp_free(plan->state, plan->state_size);
+}
+
+static int cmsis_rfft_f32(const plan_t *plan, const float *input, fft_complex_t *output) {
+    cmsis_state_t *state = (cmsis_state_t*)plan->state;
+    size_t n = plan->n;
+    float32_t *fft_input = (float32_t*)state->scratch;
+    float32_t *fft_output = fft_input + n;
+
+    memcpy(fft_input, input, n * sizeof(float32_t));
+    arm_rfft_fast_f32(&state->instance.rfft_f32, fft_input, fft_output, 0);
+
+    // the real Nyquist bin is packed into the imaginary part of the DC bin
+    output[0].r = fft_output[0];
+    output[0].i = 0.0f;
+    output[n / 2].r = fft_output[1];
+    output[n / 2].i = 0.0f;
+    memcpy(output + 1, fft_output + 2, ((n / 2) - 1) * sizeof(fft_complex_t));
+
+    return EIDSP_OK;
+}
+
+static int cmsis_cfft_f32(const plan_t *plan, const fft_complex_t *input, fft_complex_t *output) {
+    cmsis_state_t *state = (cmsis_state_t*)plan->state;
+    float32_t *buffer = (float32_t*)state->scratch;
+
+    memcpy(buffer, input, plan->n * sizeof(fft_complex_t));
+    arm_cfft_f32(&state->instance.cfft_f32, buffer, 0, 1);
+    memcpy(output, buffer, plan->n * sizeof(fft_complex_t));
+
+    return EIDSP_OK;
+}
+
+static int cmsis_rfft_q15(const plan_t *plan, const int16_t *input, fft_complex_i16_t *output) {
+    cmsis_state_t *state = (cmsis_state_t*)plan->state;
+    size_t n = plan->n;
+    q15_t *fft_input = (q15_t*)state->scratch;
+    q15_t *fft_output = fft_input + n;
+
+    memcpy(fft_input, input, n * sizeof(q15_t));
+    arm_rfft_q15(&state->instance.rfft_q15, fft_input, fft_output);
+    memcpy(output, fft_output, ((n / 2) + 1) * sizeof(fft_complex_i16_t));
+
+    return EIDSP_OK;
+}
+
+static int cmsis_cfft_q15(const plan_t *plan, const fft_complex_i16_t *input, fft_complex_i16_t *output) {
+    cmsis_state_t *state = (cmsis_state_t*)plan->state;
+    q15_t *buffer = (q15_t*)state->scratch;
+
+    memcpy(buffer, input, plan->n * sizeof(fft_complex_i16_t));
+    arm_cfft_q15(&state->instance.cfft_q15, buffer, 0, 1);
+    memcpy(output, buffer, plan->n * sizeof(fft_complex_i16_t));
+
+    return EIDSP_OK;
+}
+
+static int cmsis_rfft_q31(const plan_t *plan, const int32_t *input, fft_complex_i32_t *output) {
+    cmsis_state_t *state = (cmsis_state_t*)plan->state;
+    size_t n = plan->n;
+    q31_t *fft_input = (q31_t*)state->scratch;
+    q31_t *fft_output = fft_input + n;
+
+    memcpy(fft_input, input, n * sizeof(q31_t));
+    arm_rfft_q31(&state->instance.rfft_q31, fft_input, fft_output);
+    memcpy(output, fft_output, ((n / 2) + 1) * sizeof(fft_complex_i32_t));
+
+    return EIDSP_OK;
+}
+
+static int cmsis_cfft_q31(const plan_t *plan, const fft_complex_i32_t *input, fft_complex_i32_t *output) {
+    cmsis_state_t *state = (cmsis_state_t*)plan->state;
+    q31_t *buffer = (q31_t*)state->scratch;
+
+    memcpy(buffer, input, plan->n * sizeof(fft_complex_i32_t));
+    arm_cfft_q31(&state->instance.cfft_q31, buffer, 0, 1);
+    memcpy(output, buffer, plan->n * sizeof(fft_complex_i32_t));
+
+    return EIDSP_OK;
+}
+
+const backend_t cmsis_backend = {
+    "cmsis",
+    &cmsis_supports,
+    &cmsis_init,
+    &cmsis_free,
+    &cmsis_rfft_f32,
+    NULL,
+    &cmsis_cfft_f32,
+    &cmsis_rfft_q15,
+    &cmsis_cfft_q15,
+    &cmsis_rfft_q31,
+    &cmsis_cfft_q31
+};
+#endif // EIDSP_USE_CMSIS_FIXED
+
+/*
+ * Selection
+ */
+
+namespace {
+
+static const backend_t *const all_backends[] = {
+    &kissfft_backend,
+#if EIDSP_USE_CMSIS_FIXED
+    &cmsis_backend,
+#endif
+    &radix4_backend
+};
+
+typedef struct {
+    const backend_t *backend;
+    const char *requested;
+    bool request_honored;
+} selection_t;
+
+static const backend_t *configured_backend() {
+#if EIDSP_FFT_BACKEND == EIDSP_FFT_BACKEND_RADIX4
+    return &radix4_backend;
+#elif EIDSP_FFT_BACKEND == EIDSP_FFT_BACKEND_CMSIS && EIDSP_USE_CMSIS_FIXED
+    return &cmsis_backend;
+#else
+    return &kissfft_backend;
+#endif
+}
+
+static selection_t select_backend() {
+    selection_t selection;
+    selection.backend = configured_backend();
+    selection.requested = NULL;
+    selection.request_honored = false;
+
+#if EI_PORTING_POSIX == 1
+    selection.requested = getenv("EI_FFT_BACKEND");
+    if (selection.requested && selection.requested[0] != '\0') {
+        const backend_t *requested = find_backend(selection.requested);
+        if (requested) {
+            selection.backend = requested;
+            selection.request_honored = true;
+        }
+    }
+    else {
+        selection.requested = NULL;
+    }
+#endif
+
+    return selection;
+}
+
+static const selection_t &selection() {
+    static const selection_t s = select_backend();
+    return s;
+}
+
+static const backend_t *override_backend = NULL;
+
+/*
+ * Fixed point FFTs on floating point backends
+ */
+
+static size_t convert_input_floats(const plan_t *plan) {
+    return plan->real ? plan->n : 2 * plan->n;
+}
+
+static size_t convert_output_bins(const plan_t *plan) {
+    return plan->real ? (plan->n / 2) + 1 : plan->n;
+}
+
+static bool has_native_format(const backend_t *backend, bool real, format_t format) {
+    switch (format) {
+        case FFT_Q15: return real ? backend->rfft_q15 != NULL : backend->cfft_q15 != NULL;
+        case FFT_Q31: return real ? backend->rfft_q31 != NULL : backend->cfft_q31 != NULL;
+        default: return true;
+    }
+}
+
+static bool can_plan(const backend_t *backend, size_t n, bool real, format_t format) {
+    return backend->supports(n, real, has_native_format(backend, real, format) ? format : FFT_F32);
+}
+
+template<typename T>
+static T saturate_round(double v, double min, double max) {
+    v = round(v);
+    if (v < min) {
+        return (T)min;
+    }
+    if (v > max) {
+        return (T)max;
+    }
+    return (T)v;
+}
+
+// runs the f32 FFT on plan->convert, the fixed point output is the DFT scaled down by n
+static int run_converted(const plan_t *plan) {
+    float *input = plan->convert;
+    fft_complex_t *output = (fft_complex_t*)(plan->convert + convert_input_floats(plan));
+
+    if (plan->real) {
+        return plan->backend->rfft_f32(plan, input, output);
+    }
+    return plan->backend->cfft_f32(plan, (const fft_complex_t*)input, output);
+}
+
+template<typename T, typename C>
+static int fft_converted(const plan_t *plan, const T *input, C *output, double one) {
+    size_t input_floats = convert_input_floats(plan);
+    size_t output_bins = convert_output_bins(plan);
+    float *fft_input = plan->convert;
+    fft_complex_t *fft_output = (fft_complex_t*)(plan->convert + input_floats);
+
+    for (size_t ix = 0; ix < input_floats; ix++) {
+        fft_input[ix] = (float)((double)input[ix] / one);
+    }
+
+    int ret = run_converted(plan);
+    if (ret != EIDSP_OK) {
+        EIDSP_ERR(ret);
+    }
+
+    double scale = one / (double)plan->n;
+    for (size_t ix = 0; ix < output_bins; ix++) {
+        output[ix].r = saturate_round<T>((double)fft_output[ix].r * scale, -one, one - 1.0);
+        output[ix].i = saturate_round<T>((double)fft_output[ix].i * scale, -one, one - 1.0);
+    }
+
+    return EIDSP_OK;
+}
+
+static int check_plan(const plan_t *plan, bool real, format_t format) {
+    if (!plan->backend || plan->real != real || plan->format != format) {
+        EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+    }
+    return EIDSP_OK;
+}
+
+} // namespace
+
+const backend_t *const *backends(size_t *count) {
+    *count = sizeof(all_backends) / sizeof(all_backends[0]);
+    return all_backends;
+}
+
+const backend_t *find_backend(const char *name) {
+    for (size_t ix = 0; ix < sizeof(all_backends) / sizeof(all_backends[0]); ix++) {
+        if (strcmp(all_backends[ix]->name, name) == 0) {
+            return all_backends[ix];
+        }
+    }
+    return NULL;
+}
+
+const backend_t *backend() {
+    if (override_backend) {
+        return override_backend;
+    }
+    return selection().backend;
+}
+
+void set_backend(const backend_t *backend) {
+    override_backend = backend;
+}
+
+int plan_init(plan_t *plan, size_t n, bool real, format_t format, const backend_t *backend) {
+    memset(plan, 0, sizeof(plan_t));
+
+    if (!backend) {
+        backend = fft::backend();
+    }
+
+    if (!can_plan(backend, n, real, format)) {
+#if EIDSP_USE_CMSIS_FIXED
+        if (format != FFT_F32 && can_plan(&cmsis_backend, n, real, format)) {
+            backend = &cmsis_backend;
+        }
+        else
+#endif
+        if (can_plan(&kissfft_backend, n, real, format)) {
+            backend = &kissfft_backend;
+        }
+        else {
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+        }
+    }
+
+    bool native = has_native_format(backend, real, format);
+
+    plan->backend = backend;
+    plan->n = n;
+    plan->real = real;
+    plan->format = native ? format : FFT_F32;
+
+    if (!native) {
+        plan->convert_size = (convert_input_floats(plan) + 2 * convert_output_bins(plan)) * sizeof(float);
+        plan->convert = (float*)ei_dsp_malloc(plan->convert_size);
+        if (!plan->convert) {
+            memset(plan, 0, sizeof(plan_t));
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+    }
+
+    int ret = backend->init(plan);
+    if (ret != EIDSP_OK) {
+        if (plan->convert) {
+            ei_dsp_free(plan->convert, plan->convert_size);
+        }
+        memset(plan, 0, sizeof(plan_t));
+        EIDSP_ERR(ret);
+    }
+
+    plan->format = format;
+
+    return EIDSP_OK;
+}
+
+void plan_free(plan_t *plan) {
+    if (!plan->backend) {
+        return;
+    }
+
+    plan->backend->free(plan);
+    if (plan->convert) {
+        ei_dsp_free(plan->convert, plan->convert_size);
+    }
+    memset(plan, 0, sizeof(plan_t));
+}
+
+int rfft(const plan_t *plan, const float *input, fft_complex_t *output) {
+    int ret = check_plan(plan, true, FFT_F32);
+    if (ret != EIDSP_OK) {
+        EIDSP_ERR(ret);
+    }
+    return plan->backend->rfft_f32(plan, input, output);
+}
+
+int rfft(const plan_t *plan, const int16_t *input, fft_complex_i16_t *output) {
+    int ret = check_plan(plan, true, FFT_Q15);
+    if (ret != EIDSP_OK) {
+        EIDSP_ERR(ret);
+    }
+    if (plan->convert) {
+        return fft_converted(plan, input, output, 32768.0);
+    }
+    return plan->backend->rfft_q15(plan, input, output);
+}
+
+int rfft(const plan_t *plan, const int32_t *input, fft_complex_i32_t *output) {
+    int ret = check_plan(plan, true, FFT_Q31);
+    if (ret != EIDSP_OK) {
+        EIDSP_ERR(ret);
+    }
+    if (plan->convert) {
+        return fft_converted(plan, input, output, 2147483648.0);
+    }
+    return plan->backend->rfft_q31(plan, input, output);
+}
+
+int rfft_frames(const plan_t *plan, const float *input, size_t input_stride,
+    fft_complex_t *output, size_t output_stride, size_t frames)
+{
+    int ret = check_plan(plan, true, FFT_F32);
+    if (ret != EIDSP_OK) {
+        EIDSP_ERR(ret);
+    }
+
+    if (plan->backend->rfft_f32_frames) {
+        return plan->backend->rfft_f32_frames(plan, input, input_stride, output, output_stride, frames);
+    }
+
+    for (size_t ix = 0; ix < frames; ix++) {
+        ret = plan->backend->rfft_f32(plan, input + (ix * input_stride), output + (ix * output_stride));
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(ret);
+        }
+    }
+
+    return EIDSP_OK;
+}
+
+int cfft(const plan_t *plan, const fft_complex_t *input, fft_complex_t *output) {
+    int ret = check_plan(plan, false, FFT_F32);
+    if (ret != EIDSP_OK) {
+        EIDSP_ERR(ret);
+    }
+    return plan->backend->cfft_f32(plan, input, output);
+}
+
+int cfft(const plan_t *plan, const fft_complex_i16_t *input, fft_complex_i16_t *output) {
+    int ret = check_plan(plan, false, FFT_Q15);
+    if (ret != EIDSP_OK) {
+        EIDSP_ERR(ret);
+    }
+    if (plan->convert) {
+        return fft_converted(plan, (const int16_t*)input, output, 32768.0);
+    }
+    return plan->backend->cfft_q15(plan, input, output);
+}
+
+int cfft(const plan_t *plan, const fft_complex_i32_t *input, fft_complex_i32_t *output) {
+    int ret = check_plan(plan, false, FFT_Q31);
+    if (ret != EIDSP_OK) {
+        EIDSP_ERR(ret);
+    }
+    if (plan->convert) {
+        return fft_converted(plan, (const int32_t*)input, output, 2147483648.0);
+    }
+    return plan->backend->cfft_q31(plan, input, output);
+}
+
+void print_report() {
+    const selection_t &s = selection();
+
+    ei_printf("FFT backend: %s (", backend()->name);
+    if (override_backend) {
+        ei_printf("set by the application");
+    }
+    else if (s.requested && s.request_honored) {
+        ei_printf("selected by EI_FFT_BACKEND=%s", s.requested);
+    }
+    else if (s.requested) {
+        ei_printf("EI_FFT_BACKEND=%s is not available", s.requested);
+    }
+    else {
+        ei_printf("default");
+    }
+    ei_printf(")\n");
+}
+
+} // namespace fft
+} // namespace ei
@@ -0,0 +1,170 @@
+/* Edge Impulse inferencing library
+ * Copyright (c) 2021 EdgeImpulse Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef _EIDSP_FFT_H_
+#define _EIDSP_FFT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../numpy_types.h"
+
+namespace ei {
+namespace fft {
+
+/** Sample format of an FFT */
+typedef enum {
+    FFT_F32 = 0,
+    FFT_Q15 = 1,
+    FFT_Q31 = 2
+} format_t;
+
+struct backend_t;
+
+/**
+ * An FFT of one size, kind and format. Create it with plan_init(), run it as
+ * often as needed and release it with plan_free(). A plan can be used by one
+ * thread at a time (it holds the scratch buffers of the backend).
+ */
+typedef struct {
+    const backend_t *backend;
+    size_t n;
+    bool real;
+    format_t format;
+    /** Backend state (twiddles, scratch), owned by the backend */
+    void *state;
+    size_t state_size;
+    /** Conversion buffers when a fixed point FFT runs on a floating point backend */
+    float *convert;
+    size_t convert_size;
+} plan_t;
+
+/**
+ * An FFT implementation. Real FFTs of n points write n / 2 + 1 bins, complex
+ * FFTs write n bins. Fixed point FFTs take Q15 / Q31 input and write the
+ * DFT scaled down by n (so it can't overflow) in the same format.
+ * The fixed point functions may be NULL, then the frontend converts to
+ * floating point and runs the f32 FFT of the backend.
+ */
+struct backend_t {
+    /** Name of the backend ("kissfft", "cmsis", "radix4") */
+    const char *name;
+
+    /** Whether the backend has an FFT of n points of this kind and format */
+    bool (*supports)(size_t n, bool real, format_t format);
+
+    /** Set up plan->state for plan->n / real / format, returns EIDSP_OK */
+    int (*init)(plan_t *plan);
+
+    /** Release plan->state */
+    void (*free)(plan_t *plan);
+
+    int (*rfft_f32)(const plan_t *plan, const float *input, fft_complex_t *output);
+
+    /**
+     * Real FFT of several frames, frame f is read from input + f * input_stride
+     * and written to output + f * output_stride. May be NULL (runs rfft_f32 per frame).
+     */
+    int (*rfft_f32_frames)(const plan_t *plan, const float *input, size_t input_stride,
+        fft_complex_t *output, size_t output_stride, size_t frames);
+
+    int (*cfft_f32)(const plan_t *plan, const fft_complex_t *input, fft_complex_t *output);
+    int (*rfft_q15)(const plan_t *plan, const int16_t *input, fft_complex_i16_t *output);
+    int (*cfft_q15)(const plan_t *plan, const fft_complex_i16_t *input, fft_complex_i16_t *output);
+    int (*rfft_q31)(const plan_t *plan, const int32_t *input, fft_complex_i32_t *output);
+    int (*cfft_q31)(const plan_t *plan, const fft_complex_i32_t *input, fft_complex_i32_t *output);
+};
+
+/** Mixed radix kissfft, any n (real FFTs: even n). Real q15 FFTs run in fixed point, the rest in f32 */
+extern const backend_t kissfft_backend;
+/** CMSIS-DSP, powers of two from 16 (complex) / 32 (real) up to 4096 */
+extern const backend_t cmsis_backend;
+/** Vectorized Stockham radix-4 (SSE / NEON), f32 only, powers of two from 4 (complex) / 8 (real) */
+extern const backend_t radix4_backend;
+
+/**
+ * @brief All backends that are compiled in
+ * @param count Receives the number of backends
+ */
+const backend_t *const *backends(size_t *count);
+
+/**
+ * @brief Find a backend by name, NULL if there's no such backend
+ */
+const backend_t *find_backend(const char *name);
+
+/**
+ * @brief Backend that plans use by default: the one set with set_backend(), else
+ *        the one named by the EI_FFT_BACKEND environment variable (POSIX targets),
+ *        else EIDSP_FFT_BACKEND from dsp/config.hpp
+ */
+const backend_t *backend();
+
+/**
+ * @brief Override the default backend (NULL restores the configured one).
+ *        Call this before running any DSP, plans that exist keep their backend.
+ */
+void set_backend(const backend_t *backend);
+
+/**
+ * @brief Create a plan. If the backend (NULL = backend()) has no FFT of this
+ *        kind, the plan falls back to kissfft (f32) or CMSIS-DSP (fixed point).
+ * @param plan Plan to initialize
+ * @param n Number of points
+ * @param real Real (true) or complex (false) FFT
+ * @param format Sample format
+ * @param backend Backend to use, NULL for the default
+ * @returns EIDSP_OK, EIDSP_PARAMETER_INVALID if no backend supports the FFT
+ */
+int plan_init(plan_t *plan, size_t n, bool real, format_t format, const backend_t *backend = NULL);
+
+/**
+ * @brief Release the memory held by a plan
+ */
+void plan_free(plan_t *plan);
+
+/** Real FFT of plan->n points into plan->n / 2 + 1 bins */
+int rfft(const plan_t *plan, const float *input, fft_complex_t *output);
+int rfft(const plan_t *plan, const int16_t *input, fft_complex_i16_t *output);
+int rfft(const plan_t *plan, const int32_t *input, fft_complex_i32_t *output);
+
+/**
+ * Real FFT of several frames of plan->n points,
+ * see backend_t::rfft_f32_frames for the layout
+ */
+int rfft_frames(const plan_t *plan, const float *input, size_t input_stride,
+    fft_complex_t *output, size_t output_stride, size_t frames);
+
+/** Complex FFT of plan->n points */
+int cfft(const plan_t *plan, const fft_complex_t *input, fft_complex_t *output);
+int cfft(const plan_t *plan, const fft_complex_i16_t *input, fft_complex_i16_t *output);
+int cfft(const plan_t *plan, const fft_complex_i32_t *input, fft_complex_i32_t *output);
+
+/**
+ * @brief Print the default backend and where it was selected
+ */
+void print_report();
+
+} // namespace fft
+} // namespace ei
+
+#endif // _EIDSP_FFT_H_
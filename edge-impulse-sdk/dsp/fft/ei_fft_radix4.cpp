@@ -0,0 +1,162 @@
+/* Edge Impulse inferencing library
+ * Copyright (c) 2021 EdgeImpulse Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <math.h>
+#include <stdint.h>
+#include "ei_fft.h"
+#include "ei_fft_radix4.h"
+#include "../memory.hpp"
+#include "../returntypes.hpp"
+
+#if defined(__arm__) && defined(__linux__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846264338327950288
+#endif // M_PI
+
+/*
+ * The radix4 backend: plans and the backend table. The FFTs themselves are in
+ * ei_fft_radix4_kernels.cpp, the only part 32-bit ARM builds compile with NEON.
+ */
+
+namespace ei {
+namespace fft {
+
+namespace {
+
+static float *carve(uint8_t **ptr, size_t floats) {
+    float *res = (float*)*ptr;
+    size_t bytes = floats * sizeof(float);
+    *ptr += (bytes + RADIX4_ALIGN - 1) & ~(size_t)(RADIX4_ALIGN - 1);
+    return res;
+}
+
+static size_t carve_size(size_t floats) {
+    return (floats * sizeof(float) + RADIX4_ALIGN - 1) & ~(size_t)(RADIX4_ALIGN - 1);
+}
+
+} // namespace
+
+static bool radix4_supports(size_t n, bool real, format_t format) {
+    if (format != FFT_F32 || (n & (n - 1)) != 0) {
+        return false;
+    }
+#if defined(__arm__) && defined(__linux__)
+    // 32-bit ARM CPUs without NEON fall back to kissfft
+    if (radix4_kernels_need_neon() && !(getauxval(AT_HWCAP) & HWCAP_NEON)) {
+        return false;
+    }
+#endif
+    return n >= (real ? 8u : 4u);
+}
+
+static int radix4_init(plan_t *plan) {
+    const size_t m = plan->real ? plan->n / 2 : plan->n;
+    const size_t n1 = m / 4;
+    const size_t super = plan->real ? (m / 2) + 1 : 0;
+
+    size_t state_size = sizeof(radix4_state_t) + RADIX4_ALIGN +
+        2 * carve_size(m) + 6 * carve_size(n1) + 2 * carve_size(super) + 4 * carve_size(m);
+    radix4_state_t *st = (radix4_state_t*)ei_dsp_malloc(state_size);
+    if (!st) {
+        EIDSP_ERR(EIDSP_OUT_OF_MEM);
+    }
+
+    uintptr_t data = (uintptr_t)(st + 1);
+    uint8_t *ptr = (uint8_t*)((data + RADIX4_ALIGN - 1) & ~(uintptr_t)(RADIX4_ALIGN - 1));
+
+    st->m = m;
+    st->tw_re = carve(&ptr, m);
+    st->tw_im = carve(&ptr, m);
+    st->tw1_re = carve(&ptr, n1);
+    st->tw1_im = carve(&ptr, n1);
+    st->tw2_re = carve(&ptr, n1);
+    st->tw2_im = carve(&ptr, n1);
+    st->tw3_re = carve(&ptr, n1);
+    st->tw3_im = carve(&ptr, n1);
+    st->super_re = carve(&ptr, super);
+    st->super_im = carve(&ptr, super);
+    st->a_re = carve(&ptr, m);
+    st->a_im = carve(&ptr, m);
+    st->b_re = carve(&ptr, m);
+    st->b_im = carve(&ptr, m);
+
+    for (size_t j = 0; j < m; j++) {
+        double phase = -2.0 * M_PI * (double)j / (double)m;
+        st->tw_re[j] = (float)cos(phase);
+        st->tw_im[j] = (float)sin(phase);
+    }
+    for (size_t p = 0; p < n1; p++) {
+        st->tw1_re[p] = st->tw_re[p];
+        st->tw1_im[p] = st->tw_im[p];
+        st->tw2_re[p] = st->tw_re[2 * p];
+        st->tw2_im[p] = st->tw_im[2 * p];
+        st->tw3_re[p] = st->tw_re[3 * p];
+        st->tw3_im[p] = st->tw_im[3 * p];
+    }
+    for (size_t k = 0; k < super; k++) {
+        double phase = -M_PI * ((double)k / (double)m + 0.5);
+        st->super_re[k] = (float)cos(phase);
+        st->super_im[k] = (float)sin(phase);
+    }
+
+    plan->state = st;
+    plan->state_size = state_size;
+
+    return EIDSP_OK;
+}
+
+static void radix4_free(plan_t *plan) {
+    ei_dsp_free(plan->state, plan->state_size);
+}
+static int radix4_cfft_f32(const plan_t *plan, const fft_complex_t *input, fft_complex_t *output) {
+    radix4_cfft((const radix4_state_t*)plan->state, (const float*)input, (float*)output);
+
+    return EIDSP_OK;
+}
+
+static int radix4_rfft_f32(const plan_t *plan, const float *input, fft_complex_t *output) {
+    radix4_rfft((const radix4_state_t*)plan->state, input, (float*)output);
+
+    return EIDSP_OK;
+}
+
+const backend_t radix4_backend = {
+    "radix4",
+    &radix4_supports,
+    &radix4_init,
+    &radix4_free,
+    &radix4_rfft_f32,
+    NULL,
+    &radix4_cfft_f32,
+    NULL,
+    NULL,
+    NULL,
+    NULL
+};
+
+} // namespace fft
+} // namespace ei
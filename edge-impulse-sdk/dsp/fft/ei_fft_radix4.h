@@ -0,0 +1,66 @@
+/* Edge Impulse inferencing library
+ * Copyright (c) 2021 EdgeImpulse Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _EIDSP_FFT_RADIX4_H_
+#define _EIDSP_FFT_RADIX4_H_
+
+/*
+ * Internal to the radix4 backend. 32-bit ARM builds compile ei_fft_radix4_kernels.cpp
+ * with -mfpu=neon-vfpv4, so this header (and that file) only include standard headers.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define RADIX4_ALIGN 16
+
+namespace ei {
+namespace fft {
+
+typedef struct {
+    /* points of the complex FFT (n, or n / 2 for real FFTs) */
+    size_t m;
+    /* w^j = exp(-2 pi i j / m), 0 <= j < m */
+    float *tw_re;
+    float *tw_im;
+    /* w^p, w^2p and w^3p of the first stage, 0 <= p < m / 4 */
+    float *tw1_re, *tw1_im, *tw2_re, *tw2_im, *tw3_re, *tw3_im;
+    /* real FFTs: exp(-i pi (k / m + 1 / 2)), 0 <= k <= m / 2 */
+    float *super_re;
+    float *super_im;
+    /* ping-pong buffers */
+    float *a_re, *a_im, *b_re, *b_im;
+} radix4_state_t;
+
+/** Complex FFT of st->m points, input and output are interleaved (re, im) pairs */
+void radix4_cfft(const radix4_state_t *st, const float *input, float *output);
+
+/** Real FFT of 2 * st->m points, output holds st->m + 1 interleaved (re, im) pairs */
+void radix4_rfft(const radix4_state_t *st, const float *input, float *output);
+
+/** True if ei_fft_radix4_kernels.cpp was built with NEON on 32-bit ARM (the CPU needs it then) */
+bool radix4_kernels_need_neon();
+
+} // namespace fft
+} // namespace ei
+
+#endif // _EIDSP_FFT_RADIX4_H_
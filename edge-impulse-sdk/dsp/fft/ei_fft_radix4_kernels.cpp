@@ -0,0 +1,388 @@
+/* Edge Impulse inferencing library
+ * Copyright (c) 2021 EdgeImpulse Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "ei_fft_radix4.h"
+
+/*
+ * Vectorized Stockham radix-4 FFT for powers of two, with one radix-2 stage
+ * when the number of points is not a power of four. The data is kept as
+ * separate real / imaginary arrays, so every vector holds four complex numbers.
+ * Stockham ping-pongs between two buffers and needs no bit reversal; the first
+ * stage runs vectors over the butterflies, the later ones (stride >= 4) over the
+ * stride. Real FFTs of n points run a complex FFT of n / 2 points on the
+ * even / odd samples and split the result (like kiss_fftr).
+ *
+ * The vectors are GCC / clang vector extensions, SSE on x86 and NEON on ARM
+ * (32-bit ARM only with -mfpu=neon*, see the Makefile), other compilers get plain loops.
+ * The plans (twiddles, buffers) are set up in ei_fft_radix4.cpp.
+ */
+
+namespace ei {
+namespace fft {
+
+namespace {
+
+#if defined(__GNUC__)
+typedef float v4f __attribute__((vector_size(16)));
+typedef int32_t v4i __attribute__((vector_size(16)));
+
+static inline v4f v4_set1(float f) {
+    v4f res = { f, f, f, f };
+    return res;
+}
+#else
+struct v4f {
+    float v[4];
+
+    float& operator[](size_t ix) { return v[ix]; }
+    const float& operator[](size_t ix) const { return v[ix]; }
+};
+
+#define V4_OP(op) \
+    static inline v4f operator op(const v4f &a, const v4f &b) { \
+        v4f res; for (size_t l = 0; l < 4; l++) res.v[l] = a.v[l] op b.v[l]; return res; }
+V4_OP(+)
+V4_OP(-)
+V4_OP(*)
+
+static inline v4f v4_set1(float f) {
+    v4f res = { { f, f, f, f } };
+    return res;
+}
+#endif
+
+static inline v4f v4_load(const float *p) {
+    v4f res;
+    memcpy(&res, p, sizeof(res));
+    return res;
+}
+
+static inline void v4_store(float *p, const v4f &v) {
+    memcpy(p, &v, sizeof(v));
+}
+
+/* res[l] = l-th of (a[0..3], b[0..3]) at index I<l> */
+template<int I0, int I1, int I2, int I3>
+static inline v4f v4_shuffle(const v4f &a, const v4f &b) {
+#if defined(__clang__)
+    return __builtin_shufflevector(a, b, I0, I1, I2, I3);
+#elif defined(__GNUC__)
+    const v4i mask = { I0, I1, I2, I3 };
+    return __builtin_shuffle(a, b, mask);
+#else
+    v4f res;
+    res[0] = I0 < 4 ? a[I0] : b[I0 - 4];
+    res[1] = I1 < 4 ? a[I1] : b[I1 - 4];
+    res[2] = I2 < 4 ? a[I2] : b[I2 - 4];
+    res[3] = I3 < 4 ? a[I3] : b[I3 - 4];
+    return res;
+#endif
+}
+
+static inline v4f v4_reverse(const v4f &a) {
+    return v4_shuffle<3, 2, 1, 0>(a, a);
+}
+
+/* transpose the 4x4 matrix with rows r0..r3 */
+static inline void v4_transpose(v4f &r0, v4f &r1, v4f &r2, v4f &r3) {
+    v4f t0 = v4_shuffle<0, 4, 1, 5>(r0, r1);
+    v4f t1 = v4_shuffle<0, 4, 1, 5>(r2, r3);
+    v4f t2 = v4_shuffle<2, 6, 3, 7>(r0, r1);
+    v4f t3 = v4_shuffle<2, 6, 3, 7>(r2, r3);
+    r0 = v4_shuffle<0, 1, 4, 5>(t0, t1);
+    r1 = v4_shuffle<2, 3, 6, 7>(t0, t1);
+    r2 = v4_shuffle<0, 1, 4, 5>(t2, t3);
+    r3 = v4_shuffle<2, 3, 6, 7>(t2, t3);
+}
+
+/* (re, im) of four complex numbers from / to interleaved storage */
+static inline void v4_load_complex(const float *p, v4f &re, v4f &im) {
+    v4f lo = v4_load(p);
+    v4f hi = v4_load(p + 4);
+    re = v4_shuffle<0, 2, 4, 6>(lo, hi);
+    im = v4_shuffle<1, 3, 5, 7>(lo, hi);
+}
+
+static inline void v4_store_complex(float *p, const v4f &re, const v4f &im) {
+    v4_store(p, v4_shuffle<0, 4, 1, 5>(re, im));
+    v4_store(p + 4, v4_shuffle<2, 6, 3, 7>(re, im));
+}
+
+
+
+/*
+ * One radix-4 stage of length l = m / s: for 0 <= p < l / 4 and 0 <= q < s
+ *   y[q + s*4p + s*k] = w^(k p s) * butterfly_k(x[q + s*p + s*k*l/4])
+ */
+static void radix4_stage(const radix4_state_t *st, size_t l, size_t s,
+    const float *x_re, const float *x_im, float *y_re, float *y_im)
+{
+    const size_t n1 = l / 4;
+
+    if (s >= 4) {
+        for (size_t p = 0; p < n1; p++) {
+            const v4f w1r = v4_set1(st->tw_re[p * s]), w1i = v4_set1(st->tw_im[p * s]);
+            const v4f w2r = v4_set1(st->tw_re[2 * p * s]), w2i = v4_set1(st->tw_im[2 * p * s]);
+            const v4f w3r = v4_set1(st->tw_re[3 * p * s]), w3i = v4_set1(st->tw_im[3 * p * s]);
+
+            const size_t in = s * p;
+            const size_t out = s * 4 * p;
+            for (size_t q = 0; q < s; q += 4) {
+                v4f ar = v4_load(x_re + q + in), ai = v4_load(x_im + q + in);
+                v4f br = v4_load(x_re + q + in + s * n1), bi = v4_load(x_im + q + in + s * n1);
+                v4f cr = v4_load(x_re + q + in + s * 2 * n1), ci = v4_load(x_im + q + in + s * 2 * n1);
+                v4f dr = v4_load(x_re + q + in + s * 3 * n1), di = v4_load(x_im + q + in + s * 3 * n1);
+
+                v4f apcr = ar + cr, apci = ai + ci;
+                v4f amcr = ar - cr, amci = ai - ci;
+                v4f bpdr = br + dr, bpdi = bi + di;
+                v4f bmdr = br - dr, bmdi = bi - di;
+
+                v4f y1r = amcr + bmdi, y1i = amci - bmdr;
+                v4f y2r = apcr - bpdr, y2i = apci - bpdi;
+                v4f y3r = amcr - bmdi, y3i = amci + bmdr;
+
+                v4_store(y_re + q + out, apcr + bpdr);
+                v4_store(y_im + q + out, apci + bpdi);
+                v4_store(y_re + q + out + s, y1r * w1r - y1i * w1i);
+                v4_store(y_im + q + out + s, y1r * w1i + y1i * w1r);
+                v4_store(y_re + q + out + 2 * s, y2r * w2r - y2i * w2i);
+                v4_store(y_im + q + out + 2 * s, y2r * w2i + y2i * w2r);
+                v4_store(y_re + q + out + 3 * s, y3r * w3r - y3i * w3i);
+                v4_store(y_im + q + out + 3 * s, y3r * w3i + y3i * w3r);
+            }
+        }
+    }
+    else if (n1 >= 4) {
+        // first stage (s == 1), vectors over p, the four outputs of a butterfly are adjacent
+        for (size_t p = 0; p < n1; p += 4) {
+            v4f ar = v4_load(x_re + p), ai = v4_load(x_im + p);
+            v4f br = v4_load(x_re + p + n1), bi = v4_load(x_im + p + n1);
+            v4f cr = v4_load(x_re + p + 2 * n1), ci = v4_load(x_im + p + 2 * n1);
+            v4f dr = v4_load(x_re + p + 3 * n1), di = v4_load(x_im + p + 3 * n1);
+
+            v4f apcr = ar + cr, apci = ai + ci;
+            v4f amcr = ar - cr, amci = ai - ci;
+            v4f bpdr = br + dr, bpdi = bi + di;
+            v4f bmdr = br - dr, bmdi = bi - di;
+
+            v4f y1r = amcr + bmdi, y1i = amci - bmdr;
+            v4f y2r = apcr - bpdr, y2i = apci - bpdi;
+            v4f y3r = amcr - bmdi, y3i = amci + bmdr;
+
+            v4f w1r = v4_load(st->tw1_re + p), w1i = v4_load(st->tw1_im + p);
+            v4f w2r = v4_load(st->tw2_re + p), w2i = v4_load(st->tw2_im + p);
+            v4f w3r = v4_load(st->tw3_re + p), w3i = v4_load(st->tw3_im + p);
+
+            v4f o0r = apcr + bpdr, o0i = apci + bpdi;
+            v4f o1r = y1r * w1r - y1i * w1i, o1i = y1r * w1i + y1i * w1r;
+            v4f o2r = y2r * w2r - y2i * w2i, o2i = y2r * w2i + y2i * w2r;
+            v4f o3r = y3r * w3r - y3i * w3i, o3i = y3r * w3i + y3i * w3r;
+
+            v4_transpose(o0r, o1r, o2r, o3r);
+            v4_transpose(o0i, o1i, o2i, o3i);
+
+            v4_store(y_re + 4 * p, o0r);
+            v4_store(y_re + 4 * p + 4, o1r);
+            v4_store(y_re + 4 * p + 8, o2r);
+            v4_store(y_re + 4 * p + 12, o3r);
+            v4_store(y_im + 4 * p, o0i);
+            v4_store(y_im + 4 * p + 4, o1i);
+            v4_store(y_im + 4 * p + 8, o2i);
+            v4_store(y_im + 4 * p + 12, o3i);
+        }
+    }
+    else {
+        // small FFTs
+        for (size_t p = 0; p < n1; p++) {
+            const float w1r = st->tw_re[p * s], w1i = st->tw_im[p * s];
+            const float w2r = st->tw_re[2 * p * s], w2i = st->tw_im[2 * p * s];
+            const float w3r = st->tw_re[3 * p * s], w3i = st->tw_im[3 * p * s];
+
+            for (size_t q = 0; q < s; q++) {
+                const size_t in = q + s * p;
+                const size_t out = q + s * 4 * p;
+
+                float apcr = x_re[in] + x_re[in + 2 * s * n1], apci = x_im[in] + x_im[in + 2 * s * n1];
+                float amcr = x_re[in] - x_re[in + 2 * s * n1], amci = x_im[in] - x_im[in + 2 * s * n1];
+                float bpdr = x_re[in + s * n1] + x_re[in + 3 * s * n1], bpdi = x_im[in + s * n1] + x_im[in + 3 * s * n1];
+                float bmdr = x_re[in + s * n1] - x_re[in + 3 * s * n1], bmdi = x_im[in + s * n1] - x_im[in + 3 * s * n1];
+
+                float y1r = amcr + bmdi, y1i = amci - bmdr;
+                float y2r = apcr - bpdr, y2i = apci - bpdi;
+                float y3r = amcr - bmdi, y3i = amci + bmdr;
+
+                y_re[out] = apcr + bpdr;
+                y_im[out] = apci + bpdi;
+                y_re[out + s] = y1r * w1r - y1i * w1i;
+                y_im[out + s] = y1r * w1i + y1i * w1r;
+                y_re[out + 2 * s] = y2r * w2r - y2i * w2i;
+                y_im[out + 2 * s] = y2r * w2i + y2i * w2r;
+                y_re[out + 3 * s] = y3r * w3r - y3i * w3i;
+                y_im[out + 3 * s] = y3r * w3i + y3i * w3r;
+            }
+        }
+    }
+}
+
+/* the last stage when m is not a power of four: l = 2, s = m / 2 */
+static void radix2_stage(size_t s, const float *x_re, const float *x_im, float *y_re, float *y_im) {
+    size_t q = 0;
+    for (; q + 4 <= s; q += 4) {
+        v4f ar = v4_load(x_re + q), ai = v4_load(x_im + q);
+        v4f br = v4_load(x_re + q + s), bi = v4_load(x_im + q + s);
+        v4_store(y_re + q, ar + br);
+        v4_store(y_im + q, ai + bi);
+        v4_store(y_re + q + s, ar - br);
+        v4_store(y_im + q + s, ai - bi);
+    }
+    for (; q < s; q++) {
+        float ar = x_re[q], ai = x_im[q];
+        float br = x_re[q + s], bi = x_im[q + s];
+        y_re[q] = ar + br;
+        y_im[q] = ai + bi;
+        y_re[q + s] = ar - br;
+        y_im[q + s] = ai - bi;
+    }
+}
+
+/* complex FFT of the data in a_re / a_im, returns the buffer that holds the result */
+static void radix4_run(const radix4_state_t *st, const float **res_re, const float **res_im) {
+    float *x_re = st->a_re, *x_im = st->a_im;
+    float *y_re = st->b_re, *y_im = st->b_im;
+
+    size_t l = st->m;
+    size_t s = 1;
+    for (; l >= 4; l /= 4, s *= 4) {
+        radix4_stage(st, l, s, x_re, x_im, y_re, y_im);
+
+        float *t_re = x_re, *t_im = x_im;
+        x_re = y_re; x_im = y_im;
+        y_re = t_re; y_im = t_im;
+    }
+    if (l == 2) {
+        radix2_stage(s, x_re, x_im, y_re, y_im);
+        x_re = y_re; x_im = y_im;
+    }
+
+    *res_re = x_re;
+    *res_im = x_im;
+}
+
+/* split interleaved complex numbers into st->a_re / a_im */
+static void radix4_deinterleave(const radix4_state_t *st, const float *input) {
+    size_t ix = 0;
+    for (; ix + 4 <= st->m; ix += 4) {
+        v4f re, im;
+        v4_load_complex(input + 2 * ix, re, im);
+        v4_store(st->a_re + ix, re);
+        v4_store(st->a_im + ix, im);
+    }
+    for (; ix < st->m; ix++) {
+        st->a_re[ix] = input[2 * ix];
+        st->a_im[ix] = input[2 * ix + 1];
+    }
+}
+
+} // namespace
+
+void radix4_cfft(const radix4_state_t *st, const float *input, float *output) {
+    radix4_deinterleave(st, input);
+
+    const float *z_re, *z_im;
+    radix4_run(st, &z_re, &z_im);
+
+    size_t ix = 0;
+    for (; ix + 4 <= st->m; ix += 4) {
+        v4_store_complex(output + 2 * ix, v4_load(z_re + ix), v4_load(z_im + ix));
+    }
+    for (; ix < st->m; ix++) {
+        output[2 * ix] = z_re[ix];
+        output[2 * ix + 1] = z_im[ix];
+    }
+}
+
+void radix4_rfft(const radix4_state_t *st, const float *input, float *output) {
+    const size_t m = st->m;
+
+    // even samples are the real, odd samples the imaginary parts of an m point FFT
+    radix4_deinterleave(st, input);
+
+    const float *z_re, *z_im;
+    radix4_run(st, &z_re, &z_im);
+
+    output[0] = z_re[0] + z_im[0];
+    output[1] = 0.0f;
+    output[2 * m] = z_re[0] - z_im[0];
+    output[2 * m + 1] = 0.0f;
+
+    // X[k] = (f1k + tw) / 2 and X[m - k] = conj(f1k - tw) / 2, with
+    // f1k = Z[k] + conj(Z[m - k]) and tw = (Z[k] - conj(Z[m - k])) * super[k]
+    const v4f half = v4_set1(0.5f);
+    size_t k = 1;
+    for (; k + 3 <= m / 2; k += 4) {
+        v4f fpk_r = v4_load(z_re + k), fpk_i = v4_load(z_im + k);
+        v4f fpnk_r = v4_reverse(v4_load(z_re + m - k - 3));
+        v4f fpnk_i = v4_reverse(v4_load(z_im + m - k - 3));
+
+        v4f f1k_r = fpk_r + fpnk_r, f1k_i = fpk_i - fpnk_i;
+        v4f f2k_r = fpk_r - fpnk_r, f2k_i = fpk_i + fpnk_i;
+
+        v4f sr = v4_load(st->super_re + k), si = v4_load(st->super_im + k);
+        v4f tw_r = f2k_r * sr - f2k_i * si;
+        v4f tw_i = f2k_r * si + f2k_i * sr;
+
+        v4_store_complex(output + 2 * k, (f1k_r + tw_r) * half, (f1k_i + tw_i) * half);
+        v4_store_complex(output + 2 * (m - k - 3),
+            v4_reverse((f1k_r - tw_r) * half), v4_reverse((tw_i - f1k_i) * half));
+    }
+    for (; k <= m / 2; k++) {
+        float fpk_r = z_re[k], fpk_i = z_im[k];
+        float fpnk_r = z_re[m - k], fpnk_i = -z_im[m - k];
+
+        float f1k_r = fpk_r + fpnk_r, f1k_i = fpk_i + fpnk_i;
+        float f2k_r = fpk_r - fpnk_r, f2k_i = fpk_i - fpnk_i;
+
+        float tw_r = f2k_r * st->super_re[k] - f2k_i * st->super_im[k];
+        float tw_i = f2k_r * st->super_im[k] + f2k_i * st->super_re[k];
+
+        output[2 * k] = (f1k_r + tw_r) * 0.5f;
+        output[2 * k + 1] = (f1k_i + tw_i) * 0.5f;
+        output[2 * (m - k)] = (f1k_r - tw_r) * 0.5f;
+        output[2 * (m - k) + 1] = (tw_i - f1k_i) * 0.5f;
+    }
+}
+
+bool radix4_kernels_need_neon() {
+#if defined(__arm__) && defined(__ARM_NEON)
+    return true;
+#else
+    return false;
+#endif
+}
+
+} // namespace fft
+} // namespace ei
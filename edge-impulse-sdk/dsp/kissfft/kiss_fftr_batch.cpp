@@ -0,0 +1,419 @@
+/*
+ *  Copyright (c) 2003-2010, Mark Borgerding. All rights reserved.
+ *  This file is part of KISS FFT - https://github.com/mborgerding/kissfft
+ *
+ *  SPDX-License-Identifier: BSD-3-Clause
+ *  See COPYING file for more information.
+ */
+
+#include <stdint.h>
+#include "kiss_fftr_batch.h"
+#include "_kiss_fft_guts.h"
+
+/*
+ One scalar per frame. GCC and clang map this on the native vector registers
+ (and split or scalarize it where there are none), other compilers get a plain loop.
+ */
+#if defined(__GNUC__)
+typedef kiss_fft_scalar kf_lanes __attribute__((vector_size(KISS_FFTR_BATCH_LANES * sizeof(kiss_fft_scalar))));
+#else
+struct kf_lanes {
+    kiss_fft_scalar v[KISS_FFTR_BATCH_LANES];
+
+    kiss_fft_scalar& operator[](size_t ix) { return v[ix]; }
+    const kiss_fft_scalar& operator[](size_t ix) const { return v[ix]; }
+};
+
+#define KF_LANES_OP(op) \
+    static inline kf_lanes operator op(const kf_lanes &a, const kf_lanes &b) { \
+        kf_lanes res; for (size_t l = 0; l < KISS_FFTR_BATCH_LANES; l++) res.v[l] = a.v[l] op b.v[l]; return res; } \
+    static inline kf_lanes operator op(const kf_lanes &a, kiss_fft_scalar b) { \
+        kf_lanes res; for (size_t l = 0; l < KISS_FFTR_BATCH_LANES; l++) res.v[l] = a.v[l] op b; return res; } \
+    static inline kf_lanes &operator op##=(kf_lanes &a, const kf_lanes &b) { a = a op b; return a; } \
+    static inline kf_lanes &operator op##=(kf_lanes &a, kiss_fft_scalar b) { a = a op b; return a; }
+KF_LANES_OP(+)
+KF_LANES_OP(-)
+KF_LANES_OP(*)
+static inline kf_lanes operator-(const kf_lanes &a) {
+    kf_lanes res; for (size_t l = 0; l < KISS_FFTR_BATCH_LANES; l++) res.v[l] = -a.v[l]; return res;
+}
+#endif
+
+typedef struct {
+    kf_lanes r;
+    kf_lanes i;
+} kf_cpx_lanes;
+
+#define KF_LANES_ALIGN 16
+
+struct kiss_fftr_batch_state{
+    kiss_fft_cfg substate;
+    kiss_fft_cpx * super_twiddles;
+    kf_cpx_lanes * inbuf;
+    kf_cpx_lanes * tmpbuf;
+};
+
+/* the C_ macros from the guts header work on kf_cpx_lanes too, data operand first, twiddle second */
+
+static void kf_bfly2_batch(
+        kf_cpx_lanes * Fout,
+        const size_t fstride,
+        const kiss_fft_cfg st,
+        int m
+        )
+{
+    kf_cpx_lanes * Fout2;
+    kiss_fft_cpx * tw1 = st->twiddles;
+    kf_cpx_lanes t;
+    Fout2 = Fout + m;
+    do{
+        C_MUL (t,  *Fout2 , *tw1);
+        tw1 += fstride;
+        C_SUB( *Fout2 ,  *Fout , t );
+        C_ADDTO( *Fout ,  t );
+        ++Fout2;
+        ++Fout;
+    }while (--m);
+}
+
+static void kf_bfly4_batch(
+        kf_cpx_lanes * Fout,
+        const size_t fstride,
+        const kiss_fft_cfg st,
+        const size_t m
+        )
+{
+    kiss_fft_cpx *tw1,*tw2,*tw3;
+    kf_cpx_lanes scratch[6];
+    size_t k=m;
+    const size_t m2=2*m;
+    const size_t m3=3*m;
+
+    tw3 = tw2 = tw1 = st->twiddles;
+
+    do {
+        C_MUL(scratch[0],Fout[m] , *tw1 );
+        C_MUL(scratch[1],Fout[m2] , *tw2 );
+        C_MUL(scratch[2],Fout[m3] , *tw3 );
+
+        C_SUB( scratch[5] , *Fout, scratch[1] );
+        C_ADDTO(*Fout, scratch[1]);
+        C_ADD( scratch[3] , scratch[0] , scratch[2] );
+        C_SUB( scratch[4] , scratch[0] , scratch[2] );
+        C_SUB( Fout[m2], *Fout, scratch[3] );
+        tw1 += fstride;
+        tw2 += fstride*2;
+        tw3 += fstride*3;
+        C_ADDTO( *Fout , scratch[3] );
+
+        Fout[m].r = scratch[5].r + scratch[4].i;
+        Fout[m].i = scratch[5].i - scratch[4].r;
+        Fout[m3].r = scratch[5].r - scratch[4].i;
+        Fout[m3].i = scratch[5].i + scratch[4].r;
+        ++Fout;
+    }while(--k);
+}
+
+static void kf_bfly3_batch(
+         kf_cpx_lanes * Fout,
+         const size_t fstride,
+         const kiss_fft_cfg st,
+         size_t m
+         )
+{
+     size_t k=m;
+     const size_t m2 = 2*m;
+     kiss_fft_cpx *tw1,*tw2;
+     kf_cpx_lanes scratch[5];
+     kiss_fft_cpx epi3;
+     epi3 = st->twiddles[fstride*m];
+
+     tw1=tw2=st->twiddles;
+
+     do{
+         C_MUL(scratch[1],Fout[m] , *tw1);
+         C_MUL(scratch[2],Fout[m2] , *tw2);
+
+         C_ADD(scratch[3],scratch[1],scratch[2]);
+         C_SUB(scratch[0],scratch[1],scratch[2]);
+         tw1 += fstride;
+         tw2 += fstride*2;
+
+         Fout[m].r = Fout->r - HALF_OF(scratch[3].r);
+         Fout[m].i = Fout->i - HALF_OF(scratch[3].i);
+
+         C_MULBYSCALAR( scratch[0] , epi3.i );
+
+         C_ADDTO(*Fout,scratch[3]);
+
+         Fout[m2].r = Fout[m].r + scratch[0].i;
+         Fout[m2].i = Fout[m].i - scratch[0].r;
+
+         Fout[m].r -= scratch[0].i;
+         Fout[m].i += scratch[0].r;
+
+         ++Fout;
+     }while(--k);
+}
+
+static void kf_bfly5_batch(
+        kf_cpx_lanes * Fout,
+        const size_t fstride,
+        const kiss_fft_cfg st,
+        int m
+        )
+{
+    kf_cpx_lanes *Fout0,*Fout1,*Fout2,*Fout3,*Fout4;
+    int u;
+    kf_cpx_lanes scratch[13];
+    kiss_fft_cpx * twiddles = st->twiddles;
+    kiss_fft_cpx *tw;
+    kiss_fft_cpx ya,yb;
+    ya = twiddles[fstride*m];
+    yb = twiddles[fstride*2*m];
+
+    Fout0=Fout;
+    Fout1=Fout0+m;
+    Fout2=Fout0+2*m;
+    Fout3=Fout0+3*m;
+    Fout4=Fout0+4*m;
+
+    tw=st->twiddles;
+    for ( u=0; u<m; ++u ) {
+        scratch[0] = *Fout0;
+
+        C_MUL(scratch[1] ,*Fout1, tw[u*fstride]);
+        C_MUL(scratch[2] ,*Fout2, tw[2*u*fstride]);
+        C_MUL(scratch[3] ,*Fout3, tw[3*u*fstride]);
+        C_MUL(scratch[4] ,*Fout4, tw[4*u*fstride]);
+
+        C_ADD( scratch[7],scratch[1],scratch[4]);
+        C_SUB( scratch[10],scratch[1],scratch[4]);
+        C_ADD( scratch[8],scratch[2],scratch[3]);
+        C_SUB( scratch[9],scratch[2],scratch[3]);
+
+        Fout0->r += scratch[7].r + scratch[8].r;
+        Fout0->i += scratch[7].i + scratch[8].i;
+
+        scratch[5].r = scratch[0].r + S_MUL(scratch[7].r,ya.r) + S_MUL(scratch[8].r,yb.r);
+        scratch[5].i = scratch[0].i + S_MUL(scratch[7].i,ya.r) + S_MUL(scratch[8].i,yb.r);
+
+        scratch[6].r =  S_MUL(scratch[10].i,ya.i) + S_MUL(scratch[9].i,yb.i);
+        scratch[6].i = -S_MUL(scratch[10].r,ya.i) - S_MUL(scratch[9].r,yb.i);
+
+        C_SUB(*Fout1,scratch[5],scratch[6]);
+        C_ADD(*Fout4,scratch[5],scratch[6]);
+
+        scratch[11].r = scratch[0].r + S_MUL(scratch[7].r,yb.r) + S_MUL(scratch[8].r,ya.r);
+        scratch[11].i = scratch[0].i + S_MUL(scratch[7].i,yb.r) + S_MUL(scratch[8].i,ya.r);
+        scratch[12].r = - S_MUL(scratch[10].i,yb.i) + S_MUL(scratch[9].i,ya.i);
+        scratch[12].i = S_MUL(scratch[10].r,yb.i) - S_MUL(scratch[9].r,ya.i);
+
+        C_ADD(*Fout2,scratch[11],scratch[12]);
+        C_SUB(*Fout3,scratch[11],scratch[12]);
+
+        ++Fout0;++Fout1;++Fout2;++Fout3;++Fout4;
+    }
+}
+
+/* perform the butterfly for one stage of a mixed radix FFT */
+static void kf_bfly_generic_batch(
+        kf_cpx_lanes * Fout,
+        const size_t fstride,
+        const kiss_fft_cfg st,
+        int m,
+        int p
+        )
+{
+    int u,k,q1,q;
+    kiss_fft_cpx * twiddles = st->twiddles;
+    kf_cpx_lanes t;
+    int Norig = st->nfft;
+
+    // one extra element so the scratch buffer can be aligned for the vector type
+    void * scratch_mem = KISS_FFT_TMP_ALLOC(sizeof(kf_cpx_lanes)*(p + 1));
+    if (!scratch_mem) {
+        return;
+    }
+    kf_cpx_lanes * scratch = (kf_cpx_lanes*)(((uintptr_t)scratch_mem + KF_LANES_ALIGN - 1) & ~(uintptr_t)(KF_LANES_ALIGN - 1));
+
+    for ( u=0; u<m; ++u ) {
+        k=u;
+        for ( q1=0 ; q1<p ; ++q1 ) {
+            scratch[q1] = Fout[ k  ];
+            k += m;
+        }
+
+        k=u;
+        for ( q1=0 ; q1<p ; ++q1 ) {
+            int twidx=0;
+            Fout[ k ] = scratch[0];
+            for (q=1;q<p;++q ) {
+                twidx += fstride * k;
+                if (twidx>=Norig) twidx-=Norig;
+                C_MUL(t,scratch[q] , twiddles[twidx] );
+                C_ADDTO( Fout[ k ] ,t);
+            }
+            k += m;
+        }
+    }
+    KISS_FFT_TMP_FREE(scratch_mem);
+}
+
+static
+void kf_work_batch(
+        kf_cpx_lanes * Fout,
+        const kf_cpx_lanes * f,
+        const size_t fstride,
+        const int * factors,
+        const kiss_fft_cfg st
+        )
+{
+    kf_cpx_lanes * Fout_beg=Fout;
+    const int p=*factors++; /* the radix  */
+    const int m=*factors++; /* stage's fft length/p */
+    const kf_cpx_lanes * Fout_end = Fout + p*m;
+
+    if (m==1) {
+        do{
+            *Fout = *f;
+            f += fstride;
+        }while(++Fout != Fout_end );
+    }else{
+        do{
+            // recursive call:
+            // DFT of size m*p performed by doing
+            // p instances of smaller DFTs of size m,
+            // each one takes a decimated version of the input
+            kf_work_batch( Fout , f, fstride*p, factors,st);
+            f += fstride;
+        }while( (Fout += m) != Fout_end );
+    }
+
+    Fout=Fout_beg;
+
+    // recombine the p smaller DFTs
+    switch (p) {
+        case 2: kf_bfly2_batch(Fout,fstride,st,m); break;
+        case 3: kf_bfly3_batch(Fout,fstride,st,m); break;
+        case 4: kf_bfly4_batch(Fout,fstride,st,m); break;
+        case 5: kf_bfly5_batch(Fout,fstride,st,m); break;
+        default: kf_bfly_generic_batch(Fout,fstride,st,m,p); break;
+    }
+}
+
+kiss_fftr_batch_cfg kiss_fftr_batch_alloc(int nfft, void * mem, size_t * lenmem, size_t * memallocated)
+{
+    int i;
+    kiss_fftr_batch_cfg st = NULL;
+    size_t subsize = 0, memneeded;
+
+    if (nfft & 1) {
+        fprintf(stderr,"Real FFT optimization must be even.\n");
+        return NULL;
+    }
+    nfft >>= 1;
+
+    kiss_fft_alloc (nfft, 0, NULL, &subsize);
+    memneeded = sizeof(struct kiss_fftr_batch_state) + (KF_LANES_ALIGN - 1)
+        + sizeof(kf_cpx_lanes) * nfft * 2
+        + subsize + sizeof(kiss_fft_cpx) * (nfft / 2);
+
+    if (lenmem == NULL) {
+        st = (kiss_fftr_batch_cfg) KISS_FFT_MALLOC (memneeded);
+    } else {
+        if (*lenmem >= memneeded)
+            st = (kiss_fftr_batch_cfg) mem;
+        *lenmem = memneeded;
+    }
+    if (!st)
+        return NULL;
+
+    /* the lane buffers come first, aligned for the vector type */
+    st->inbuf = (kf_cpx_lanes *) (((uintptr_t)(st + 1) + KF_LANES_ALIGN - 1) & ~(uintptr_t)(KF_LANES_ALIGN - 1));
+    st->tmpbuf = st->inbuf + nfft;
+    st->substate = (kiss_fft_cfg) (st->tmpbuf + nfft);
+    st->super_twiddles = (kiss_fft_cpx *) (((char *) st->substate) + subsize);
+    kiss_fft_alloc(nfft, 0, st->substate, &subsize);
+
+    for (i = 0; i < nfft/2; ++i) {
+        double phase =
+            -3.14159265358979323846264338327 * ((double) (i+1) / nfft + .5);
+        kf_cexp (st->super_twiddles+i,phase);
+    }
+
+    if (memallocated != NULL) {
+        *memallocated = memneeded;
+    }
+
+    return st;
+}
+
+void kiss_fftr_batch(kiss_fftr_batch_cfg st, const kiss_fft_scalar *timedata, size_t time_stride,
+                     kiss_fft_cpx *freqdata, size_t freq_stride, size_t frames)
+{
+    int k,ncfft;
+    size_t j,l;
+
+    ncfft = st->substate->nfft;
+
+    for (size_t first = 0; first < frames; first += KISS_FFTR_BATCH_LANES) {
+        size_t lanes = frames - first;
+        if (lanes > KISS_FFTR_BATCH_LANES) {
+            lanes = KISS_FFTR_BATCH_LANES;
+        }
+        const kiss_fft_scalar * in = timedata + first * time_stride;
+        kiss_fft_cpx * out = freqdata + first * freq_stride;
+
+        /* transpose the frames into the lanes, the real input is packed in real,imag pairs */
+        for (j = 0; j < (size_t)ncfft; j++) {
+            for (l = 0; l < KISS_FFTR_BATCH_LANES; l++) {
+                if (l < lanes) {
+                    st->inbuf[j].r[l] = in[l * time_stride + 2 * j];
+                    st->inbuf[j].i[l] = in[l * time_stride + 2 * j + 1];
+                }
+                else {
+                    st->inbuf[j].r[l] = 0;
+                    st->inbuf[j].i[l] = 0;
+                }
+            }
+        }
+
+        /*perform the parallel fft of two real signals packed in real,imag*/
+        kf_work_batch(st->tmpbuf, st->inbuf, 1, st->substate->factors, st->substate);
+
+        /* split the spectra like kiss_fftr, and transpose back to one output per frame */
+        kf_cpx_lanes tdc = st->tmpbuf[0];
+        kf_lanes dc = tdc.r + tdc.i;
+        kf_lanes nyquist = tdc.r - tdc.i;
+        for (l = 0; l < lanes; l++) {
+            out[l * freq_stride].r = dc[l];
+            out[l * freq_stride + ncfft].r = nyquist[l];
+            out[l * freq_stride + ncfft].i = out[l * freq_stride].i = 0;
+        }
+
+        for ( k=1;k <= ncfft/2 ; ++k ) {
+            kf_cpx_lanes fpnk,fpk,f1k,f2k,tw,lo,hi;
+
+            fpk    = st->tmpbuf[k];
+            fpnk.r =   st->tmpbuf[ncfft-k].r;
+            fpnk.i = - st->tmpbuf[ncfft-k].i;
+
+            C_ADD( f1k, fpk , fpnk );
+            C_SUB( f2k, fpk , fpnk );
+            C_MUL( tw , f2k , st->super_twiddles[k-1]);
+
+            lo.r = HALF_OF(f1k.r + tw.r);
+            lo.i = HALF_OF(f1k.i + tw.i);
+            hi.r = HALF_OF(f1k.r - tw.r);
+            hi.i = HALF_OF(tw.i - f1k.i);
+
+            for (l = 0; l < lanes; l++) {
+                out[l * freq_stride + k].r = lo.r[l];
+                out[l * freq_stride + k].i = lo.i[l];
+                out[l * freq_stride + ncfft - k].r = hi.r[l];
+                out[l * freq_stride + ncfft - k].i = hi.i[l];
+            }
+        }
+    }
+}
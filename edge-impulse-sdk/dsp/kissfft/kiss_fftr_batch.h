@@ -0,0 +1,49 @@
+/*
+ *  Copyright (c) 2003-2004, Mark Borgerding. All rights reserved.
+ *  This file is part of KISS FFT - https://github.com/mborgerding/kissfft
+ *
+ *  SPDX-License-Identifier: BSD-3-Clause
+ *  See COPYING file for more information.
+ */
+
+#ifndef KISS_FTR_BATCH_H
+#define KISS_FTR_BATCH_H
+
+#include "kiss_fft.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ Batched version of kiss_fftr: transforms several real frames of the same size at once.
+ The frames are transposed into a structure-of-arrays layout where every vector lane
+ carries one frame, so the butterflies run on full vectors and every twiddle is loaded
+ once per group of frames. The butterflies do exactly the same operations as kiss_fftr,
+ the output is identical.
+ */
+
+/* number of frames that are transformed together */
+#define KISS_FFTR_BATCH_LANES 4
+
+typedef struct kiss_fftr_batch_state *kiss_fftr_batch_cfg;
+
+/*
+ Forward transforms only, nfft must be even.
+ Memory is handled like kiss_fftr_alloc.
+ */
+kiss_fftr_batch_cfg kiss_fftr_batch_alloc(int nfft, void * mem, size_t * lenmem, size_t * memallocated = NULL);
+
+/*
+ frame f (0 <= f < frames) is read from timedata + f * time_stride (nfft scalar points)
+ and its nfft/2+1 complex points are written to freqdata + f * freq_stride
+ */
+void kiss_fftr_batch(kiss_fftr_batch_cfg cfg, const kiss_fft_scalar *timedata, size_t time_stride,
+                     kiss_fft_cpx *freqdata, size_t freq_stride, size_t frames);
+
+#define kiss_fftr_batch_free KISS_FFT_FREE
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,37 @@
+/*
+ *  Copyright (c) 2003-2010, Mark Borgerding. All rights reserved.
+ *  This file is part of KISS FFT - https://github.com/mborgerding/kissfft
+ *
+ *  SPDX-License-Identifier: BSD-3-Clause
+ *  See COPYING file for more information.
+ */
+
+#include "kiss_fftr_q15.h"
+
+/*
+ The fixed point build of kiss_fft.cpp and kiss_fftr.cpp. Every name they define
+ gets a _q15 suffix here, so both builds can be linked into the same program.
+ */
+#define FIXED_POINT 16
+
+#define kiss_fft_cpx kiss_fft_q15_cpx
+#define kiss_fft_state kiss_fft_q15_state
+#define kiss_fft_cfg kiss_fft_q15_cfg
+#define kiss_fft_alloc kiss_fft_q15_alloc
+#define kiss_fft_stride kiss_fft_q15_stride
+#define kiss_fft kiss_fft_q15
+#define kiss_fft_cleanup kiss_fft_q15_cleanup
+#define kiss_fft_next_fast_size kiss_fft_q15_next_fast_size
+#define kiss_fftr_state kiss_fftr_q15_state
+#define kiss_fftr_cfg kiss_fftr_q15_cfg
+#define kiss_fftr_alloc kiss_fftr_q15_alloc
+#define kiss_fftr kiss_fftr_q15_cpx
+#define kiss_fftri kiss_fftri_q15_cpx
+
+#include "kiss_fft.cpp"
+#include "kiss_fftr.cpp"
+
+void kiss_fftr_q15(kiss_fftr_q15_cfg cfg,const int16_t *timedata,int16_t *freqdata)
+{
+    kiss_fftr_q15_cpx(cfg, timedata, (kiss_fft_q15_cpx*)freqdata);
+}
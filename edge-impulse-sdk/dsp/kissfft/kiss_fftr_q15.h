@@ -0,0 +1,39 @@
+/*
+ *  Copyright (c) 2003-2004, Mark Borgerding. All rights reserved.
+ *  This file is part of KISS FFT - https://github.com/mborgerding/kissfft
+ *
+ *  SPDX-License-Identifier: BSD-3-Clause
+ *  See COPYING file for more information.
+ */
+
+#ifndef KISS_FTR_Q15_H
+#define KISS_FTR_Q15_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ kiss_fftr built for 16-bit fixed point (FIXED_POINT=16), next to the floating point
+ build of kiss_fftr.h. The twiddles are q15 and every stage scales down by its radix,
+ so the output is the DFT of the q15 input divided by nfft, in q15.
+ */
+
+typedef struct kiss_fftr_q15_state *kiss_fftr_q15_cfg;
+
+/* see kiss_fftr_alloc, nfft must be even */
+kiss_fftr_q15_cfg kiss_fftr_q15_alloc(int nfft,int inverse_fft,void * mem, size_t * lenmem, size_t * memallocated);
+
+/*
+ input timedata has nfft q15 points
+ output freqdata has nfft/2+1 complex q15 points, as interleaved (r, i) pairs
+*/
+void kiss_fftr_q15(kiss_fftr_q15_cfg cfg,const int16_t *timedata,int16_t *freqdata);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
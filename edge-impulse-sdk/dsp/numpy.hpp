@@ -33,6 +33,8 @@
 #include "memory.hpp"
 #include "dct/fast-dct-fft.h"
 #include "kissfft/kiss_fftr.h"
+#include "dispatch/ei_dispatch.h"
+#include "fft/ei_fft.h"
 #if EIDSP_USE_CMSIS_FIXED
 #include "edge-impulse-sdk/CMSIS/DSP/Include/arm_math.h"
 #endif
@@ -64,26 +66,7 @@ public:
      * @returns EIDSP_OK if OK
      */
     static int roll(float *input_array, size_t input_array_size, int shift) {
-        if (shift < 0) {
-            shift = input_array_size + shift;
-        }
-
-        if (shift == 0) {
-            return EIDSP_OK;
-        }
-
-        // so we need to allocate a buffer of the size of shift...
-        EI_DSP_MATRIX(shift_matrix, 1, shift);
-
-        // we copy from the end of the buffer into the shift buffer
-        memcpy(shift_matrix.buffer, input_array + input_array_size - shift, shift * sizeof(float));
-
-        // now we do a memmove to shift the array
-        memmove(input_array + shift, input_array, (input_array_size - shift) * sizeof(float));
-
-        // and copy the shift buffer back to the beginning of the array
-        memcpy(input_array, shift_matrix.buffer, shift * sizeof(float));
-
+        roll_in_place(input_array, input_array_size, shift);
         return EIDSP_OK;
     }
 
@@ -96,26 +79,7 @@ public:
      * @returns EIDSP_OK if OK
      */
     static int roll(int *input_array, size_t input_array_size, int shift) {
-        if (shift < 0) {
-            shift = input_array_size + shift;
-        }
-
-        if (shift == 0) {
-            return EIDSP_OK;
-        }
-
-        // so we need to allocate a buffer of the size of shift...
-        EI_DSP_MATRIX(shift_matrix, 1, shift);
-
-        // we copy from the end of the buffer into the shift buffer
-        memcpy(shift_matrix.buffer, input_array + input_array_size - shift, shift * sizeof(int));
-
-        // now we do a memmove to shift the array
-        memmove(input_array + shift, input_array, (input_array_size - shift) * sizeof(int));
-
-        // and copy the shift buffer back to the beginning of the array
-        memcpy(input_array, shift_matrix.buffer, shift * sizeof(int));
-
+        roll_in_place(input_array, input_array_size, shift);
         return EIDSP_OK;
     }
 
@@ -128,27 +92,90 @@ public:
      * @returns EIDSP_OK if OK
      */
     static int roll(int16_t *input_array, size_t input_array_size, int shift) {
-        if (shift < 0) {
-            shift = input_array_size + shift;
-        }
+        roll_in_place(input_array, input_array_size, shift);
+        return EIDSP_OK;
+    }
 
-        if (shift == 0) {
-            return EIDSP_OK;
+    /**
+     * Roll without allocating: the elements that wrap around go through a small
+     * buffer on the stack if they fit, otherwise the two parts of the array are
+     * swapped block by block (see rotate_left).
+     * @param array
+     * @param size
+     * @param shift The number of places by which elements are shifted, negative
+     *     rolls to the left. Shifts beyond the size wrap around.
+     */
+    template <typename T>
+    static void roll_in_place(T *array, size_t size, int shift) {
+        if (size == 0) {
+            return;
         }
 
-        // so we need to allocate a buffer of the size of shift...
-        EI_DSP_MATRIX(shift_matrix, 1, shift);
-
-        // we copy from the end of the buffer into the shift buffer
-        memcpy(shift_matrix.buffer, input_array + input_array_size - shift, shift * sizeof(int16_t));
+        long s = shift % (long)size;
+        if (s < 0) {
+            s += size;
+        }
+        if (s == 0) {
+            return;
+        }
 
-        // now we do a memmove to shift the array
-        memmove(input_array + shift, input_array, (input_array_size - shift) * sizeof(int16_t));
+        // rolling right by s moves the first size - s elements to the end
+        rotate_left(array, size, size - (size_t)s);
+    }
 
-        // and copy the shift buffer back to the beginning of the array
-        memcpy(input_array, shift_matrix.buffer, shift * sizeof(int16_t));
+    /**
+     * Rotate an array in place, so the first `count` elements end up at the end
+     * (like std::rotate(array, array + count, array + size)). If the shorter of the
+     * two parts fits in the stack buffer that's a memcpy, memmove, memcpy. Otherwise
+     * the shorter part is swapped with the same number of elements at the edge of
+     * the longer part, which puts those in their final place, and the rest is
+     * rotated the same way (Gries-Mills block swap). Every element moves about once,
+     * the swaps are done by the dispatch swap_bytes kernel.
+     * @param array
+     * @param size Number of elements in the array
+     * @param count Number of elements to move from the start to the end
+     */
+    template <typename T>
+    static void rotate_left(T *array, size_t size, size_t count) {
+        const size_t buffer_elements = 256 / sizeof(T);
+        T buffer[buffer_elements];
+
+        size_t first = 0;
+        size_t middle = count;
+        size_t last = size;
+
+        while (first < middle && middle < last) {
+            size_t a = middle - first;
+            size_t b = last - middle;
+
+            if (a <= buffer_elements) {
+                memcpy(buffer, array + first, a * sizeof(T));
+                memmove(array + first, array + middle, b * sizeof(T));
+                memcpy(array + first + b, buffer, a * sizeof(T));
+                return;
+            }
+            if (b <= buffer_elements) {
+                memcpy(buffer, array + middle, b * sizeof(T));
+                memmove(array + first + b, array + first, a * sizeof(T));
+                memcpy(array + first, buffer, b * sizeof(T));
+                return;
+            }
 
-        return EIDSP_OK;
+            if (a <= b) {
+                // A B1 B2 -> B1 A B2, B1 is done, continue with A B2
+                dispatch::kernels().swap_bytes((uint8_t *)(array + first), (uint8_t *)(array + middle),
+                    a * sizeof(T));
+                first = middle;
+                middle += a;
+            }
+            else {
+                // A1 A2 B -> A1 B A2, A2 is done, continue with A1 B
+                dispatch::kernels().swap_bytes((uint8_t *)(array + middle - b), (uint8_t *)(array + middle),
+                    b * sizeof(T));
+                last = middle;
+                middle -= b;
+            }
+        }
     }
 
     static float sum(float *input_array, size_t input_array_size) {
@@ -288,20 +315,76 @@ public:
      */
     static inline int dot_by_row(int i, float *row, size_t matrix1_cols,
         quantized_matrix_t *matrix2, matrix_t *out_matrix)
+    {
+        return dot_by_row(i, row, matrix1_cols, matrix2, NULL, out_matrix);
+    }
+
+    /**
+     * Multiply two matrices lazily per row in matrix 1 (MxN * NxK matrix), only reading
+     * the rows of every column of matrix 2 that can be non-zero
+     * @param i matrix1 row index
+     * @param row matrix1 row
+     * @param matrix1_cols matrix1 row size
+     * @param matrix2 Pointer to matrix2 (NxK)
+     * @param bins Non-zero rows of every column of matrix2 (Kx2), see filterbank_bins.
+     *     NULL reads all rows.
+     * @param out_matrix Pointer to out matrix (MxK)
+     * @returns EIDSP_OK if OK
+     */
+    static inline int dot_by_row(int i, float *row, size_t matrix1_cols,
+        quantized_matrix_t *matrix2, const matrix_i32_t *bins, matrix_t *out_matrix)
     {
         if (matrix1_cols != matrix2->rows) {
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
         }
 
-        for (uint16_t j = 0; j < matrix2->cols; j++) {
-            float tmp = 0.0;
-            for (uint16_t k = 0; k < matrix1_cols; k++) {
-                uint8_t u8 = matrix2->buffer[k * matrix2->cols + j];
-                if (u8) { // this matrix appears to be very sparsely populated
-                    tmp += row[k] * quantized_values_one_zero[u8];
+        if (bins && (bins->rows != matrix2->cols || bins->cols != 2)) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        // this matrix appears to be very sparsely populated, zeros are skipped
+        dispatch::kernels().filterbank_dot_u8(row, matrix1_cols, matrix2->buffer, matrix2->cols,
+            bins ? bins->buffer : NULL, quantized_values_one_zero, out_matrix->buffer + (i * matrix2->cols));
+
+        return EIDSP_OK;
+    }
+
+    /**
+     * Find the rows that can be non-zero in every column of a quantized matrix, for
+     * dot_by_row. Mel filterbanks are triangles, so (transposed) every column only
+     * has a few non-zero rows next to each other.
+     * @param matrix Quantized matrix (NxK)
+     * @param bins Out matrix (Kx2), first non-zero row and number of rows up to and
+     *     including the last non-zero one for every column (0, 0 if it's all zeros)
+     * @returns EIDSP_OK if OK
+     */
+    static int filterbank_bins(const quantized_matrix_t *matrix, matrix_i32_t *bins) {
+        if (bins->rows != matrix->cols || bins->cols != 2) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        for (size_t col = 0; col < matrix->cols; col++) {
+            bins->buffer[col * 2] = -1;
+            bins->buffer[col * 2 + 1] = 0;
+        }
+
+        for (size_t row = 0; row < matrix->rows; row++) {
+            const uint8_t *values = matrix->buffer + (row * matrix->cols);
+            for (size_t col = 0; col < matrix->cols; col++) {
+                if (values[col] == 0) {
+                    continue;
+                }
+                if (bins->buffer[col * 2] < 0) {
+                    bins->buffer[col * 2] = row;
                 }
+                bins->buffer[col * 2 + 1] = row - bins->buffer[col * 2] + 1;
+            }
+        }
+
+        for (size_t col = 0; col < matrix->cols; col++) {
+            if (bins->buffer[col * 2] < 0) {
+                bins->buffer[col * 2] = 0;
             }
-            out_matrix->buffer[i * matrix2->cols + j] = tmp;
         }
 
         return EIDSP_OK;
@@ -309,7 +392,7 @@ public:
 
     /**
      * Transpose an array in place (from MxN to NxM)
-     * Note: this temporary allocates a copy of the matrix on the heap.
+     * Note: this temporary allocates a copy of the matrix on the heap (not for square matrices or vectors).
      * @param matrix
      * @param rows
      * @param columns
@@ -353,6 +436,15 @@ public:
      * @returns EIDSP_OK if OK
      */
     static int transpose(float *matrix, int rows, int columns) {
+        // a row or column vector has the same layout either way
+        if (rows == 1 || columns == 1) {
+            return EIDSP_OK;
+        }
+        if (rows == columns) {
+            transpose_square(matrix, rows);
+            return EIDSP_OK;
+        }
+
         EI_DSP_MATRIX(temp_matrix, rows, columns);
         if (!temp_matrix.buffer) {
             EIDSP_ERR(EIDSP_OUT_OF_MEM);
@@ -377,20 +469,25 @@ public:
         if (status != ARM_MATH_SUCCESS) {
             return status;
         }
-#else
-        for (int j = 0; j < rows; j++){
-            for (int i = 0; i < columns; i++){
-                temp_matrix.buffer[j * columns + i] = matrix[i * rows + j];
-            }
-        }
-#endif
 
         memcpy(matrix, temp_matrix.buffer, rows * columns * sizeof(float));
+#else
+        transpose_through(matrix, temp_matrix.buffer, columns, rows);
+#endif
 
         return EIDSP_OK;
     }
 
     static int transpose(EIDSP_i16 *matrix, int rows, int columns) {
+        // a row or column vector has the same layout either way
+        if (rows == 1 || columns == 1) {
+            return EIDSP_OK;
+        }
+        if (rows == columns) {
+            transpose_square(matrix, rows);
+            return EIDSP_OK;
+        }
+
         EI_DSP_i16_MATRIX(temp_matrix, rows, columns);
         if (!temp_matrix.buffer) {
             EIDSP_ERR(EIDSP_OUT_OF_MEM);
@@ -411,22 +508,18 @@ public:
         if (status != ARM_MATH_SUCCESS) {
             return status;
         }
-#else
-        for (int j = 0; j < rows; j++){
-            for (int i = 0; i < columns; i++){
-                temp_matrix.buffer[j * columns + i] = matrix[i * rows + j];
-            }
-        }
-#endif
 
         memcpy(matrix, temp_matrix.buffer, rows * columns * sizeof(EIDSP_i16));
+#else
+        transpose_through(matrix, temp_matrix.buffer, columns, rows);
+#endif
 
         return EIDSP_OK;
     }
 
     /**
      * Transpose an array in place (from MxN to NxM)
-     * Note: this temporary allocates a copy of the matrix on the heap.
+     * Note: this temporary allocates a copy of the matrix on the heap (not for square matrices or vectors).
      * @param matrix
      * @param rows
      * @param columns
@@ -455,21 +548,144 @@ public:
      * @returns EIDSP_OK if OK
      */
     static int transpose(uint8_t *matrix, int rows, int columns) {
+        // a row or column vector has the same layout either way
+        if (rows == 1 || columns == 1) {
+            return EIDSP_OK;
+        }
+        if (rows == columns) {
+            transpose_square(matrix, rows);
+            return EIDSP_OK;
+        }
+
         // dequantization function is not used actually...
         EI_DSP_QUANTIZED_MATRIX(temp_matrix, rows, columns, &dequantize_zero_one);
         if (!temp_matrix.buffer) {
             EIDSP_ERR(EIDSP_OUT_OF_MEM);
         }
 
-        for (int j = 0; j < rows; j++){
-            for (int i = 0; i < columns; i++){
-                temp_matrix.buffer[j * columns + i] = matrix[i * rows + j];
+        transpose_through(matrix, temp_matrix.buffer, columns, rows);
+
+        return EIDSP_OK;
+    }
+
+    /**
+     * Copy count elements from a strided source to a strided destination, four
+     * at a time so there's one loop branch per four elements.
+     * @param in Source
+     * @param in_stride Distance (in elements) between source elements
+     * @param out Destination
+     * @param out_stride Distance (in elements) between destination elements
+     * @param count Number of elements
+     */
+    template <typename T>
+    static void copy_strided(const T *in, size_t in_stride, T *out, size_t out_stride, size_t count) {
+        size_t ix = 0;
+        for (; ix + 4 <= count; ix += 4) {
+            T a = in[0];
+            T b = in[in_stride];
+            T c = in[2 * in_stride];
+            T d = in[3 * in_stride];
+            out[0] = a;
+            out[out_stride] = b;
+            out[2 * out_stride] = c;
+            out[3 * out_stride] = d;
+            in += 4 * in_stride;
+            out += 4 * out_stride;
+        }
+        for (; ix < count; ix++) {
+            *out = *in;
+            in += in_stride;
+            out += out_stride;
+        }
+    }
+
+    /**
+     * Transpose a matrix in place through a scratch buffer of the same size.
+     * Thin matrices (3xN axes, Nx13 MFCC frames) are transposed into the scratch
+     * buffer one line of the long side at a time and copied back: with a short
+     * side of at most EIDSP_TRANSPOSE_BLOCK the strided accesses stay in a few
+     * cache lines and tiles don't win anything. Other shapes are copied into the
+     * scratch buffer and transposed back in tiles (see transpose_blocked).
+     * @param matrix Matrix (rows x cols), transposed to cols x rows
+     * @param temp Scratch buffer of rows x cols elements
+     * @param rows Number of rows in the matrix
+     * @param cols Number of columns in the matrix
+     */
+    template <typename T>
+    static void transpose_through(T *matrix, T *temp, size_t rows, size_t cols) {
+        if (rows <= EIDSP_TRANSPOSE_BLOCK) {
+            // read the rows in order
+            for (size_t row = 0; row < rows; row++) {
+                copy_strided(matrix + (row * cols), 1, temp + row, rows, cols);
             }
+            memcpy(matrix, temp, rows * cols * sizeof(T));
+            return;
+        }
+        if (cols <= EIDSP_TRANSPOSE_BLOCK) {
+            // write the rows of the transposed matrix in order
+            for (size_t col = 0; col < cols; col++) {
+                copy_strided(matrix + col, cols, temp + (col * rows), 1, rows);
+            }
+            memcpy(matrix, temp, rows * cols * sizeof(T));
+            return;
         }
 
-        memcpy(matrix, temp_matrix.buffer, rows * columns * sizeof(uint8_t));
+        memcpy(temp, matrix, rows * cols * sizeof(T));
+        transpose_blocked(temp, matrix, rows, cols);
+    }
 
-        return EIDSP_OK;
+    /**
+     * Transpose a matrix into another buffer (from MxN to NxM), in tiles of
+     * EIDSP_TRANSPOSE_BLOCK x EIDSP_TRANSPOSE_BLOCK so the strided writes of a tile
+     * hit the same few cache lines, instead of a new one for every element.
+     * @param input Input matrix (rows x cols)
+     * @param output Output matrix (cols x rows), can't overlap with the input
+     * @param rows Number of rows in the input
+     * @param cols Number of columns in the input
+     */
+    template <typename T>
+    static void transpose_blocked(const T *input, T *output, size_t rows, size_t cols) {
+        for (size_t row_start = 0; row_start < rows; row_start += EIDSP_TRANSPOSE_BLOCK) {
+            size_t row_end = row_start + EIDSP_TRANSPOSE_BLOCK < rows ? row_start + EIDSP_TRANSPOSE_BLOCK : rows;
+
+            for (size_t col_start = 0; col_start < cols; col_start += EIDSP_TRANSPOSE_BLOCK) {
+                size_t col_end = col_start + EIDSP_TRANSPOSE_BLOCK < cols ? col_start + EIDSP_TRANSPOSE_BLOCK : cols;
+
+                for (size_t row = row_start; row < row_end; row++) {
+                    const T *in = input + (row * cols);
+                    for (size_t col = col_start; col < col_end; col++) {
+                        output[(col * rows) + row] = in[col];
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * Transpose a square matrix in place, without a copy. Swaps the tiles above the
+     * diagonal with the ones below (see transpose_blocked).
+     * @param matrix Matrix (n x n)
+     * @param n Number of rows and columns
+     */
+    template <typename T>
+    static void transpose_square(T *matrix, size_t n) {
+        for (size_t row_start = 0; row_start < n; row_start += EIDSP_TRANSPOSE_BLOCK) {
+            size_t row_end = row_start + EIDSP_TRANSPOSE_BLOCK < n ? row_start + EIDSP_TRANSPOSE_BLOCK : n;
+
+            for (size_t col_start = row_start; col_start < n; col_start += EIDSP_TRANSPOSE_BLOCK) {
+                size_t col_end = col_start + EIDSP_TRANSPOSE_BLOCK < n ? col_start + EIDSP_TRANSPOSE_BLOCK : n;
+
+                for (size_t row = row_start; row < row_end; row++) {
+                    // on the diagonal tile only swap the elements above the diagonal
+                    size_t col = col_start == row_start ? row + 1 : col_start;
+                    for (; col < col_end; col++) {
+                        T tmp = matrix[(row * n) + col];
+                        matrix[(row * n) + col] = matrix[(col * n) + row];
+                        matrix[(col * n) + row] = tmp;
+                    }
+                }
+            }
+        }
     }
 
     /**
@@ -576,9 +792,12 @@ public:
      * @param output Output matrix of size (M+pad_before+pad_after x N)
      * @param pad_before Number of items to pad before
      * @param pad_after Number of items to pad after
+     * @param first_row Row of the input that is treated as the first row, rows before
+     *                  it wrap around to the end (used to read ring buffers in order)
      * @returns 0 if OK
      */
-    static int pad_1d_symmetric(matrix_t *input, matrix_t *output, uint16_t pad_before, uint16_t pad_after) {
+    static int pad_1d_symmetric(matrix_t *input, matrix_t *output, uint16_t pad_before, uint16_t pad_after,
+        uint32_t first_row = 0) {
         if (output->cols != input->cols) {
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
         }
@@ -591,12 +810,16 @@ public:
             EIDSP_ERR(EIDSP_INPUT_MATRIX_EMPTY);
         }
 
+        if (first_row >= input->rows) {
+            EIDSP_ERR(EIDSP_OUT_OF_BOUNDS);
+        }
+
         uint32_t pad_before_index = 0;
         bool pad_before_direction_up = true;
 
         for (int32_t ix = pad_before - 1; ix >= 0; ix--) {
             memcpy(output->buffer + (input->cols * ix),
-                input->buffer + (pad_before_index * input->cols),
+                input->buffer + (((pad_before_index + first_row) % input->rows) * input->cols),
                 input->cols * sizeof(float));
 
             if (pad_before_index == 0 && !pad_before_direction_up) {
@@ -614,15 +837,18 @@ public:
         }
 
         memcpy(output->buffer + (input->cols * pad_before),
+            input->buffer + (first_row * input->cols),
+            (input->rows - first_row) * input->cols * sizeof(float));
+        memcpy(output->buffer + (input->cols * (pad_before + input->rows - first_row)),
             input->buffer,
-            input->rows * input->cols * sizeof(float));
+            first_row * input->cols * sizeof(float));
 
         int32_t pad_after_index = input->rows - 1;
         bool pad_after_direction_up = false;
 
         for (int32_t ix = 0; ix < pad_after; ix++) {
             memcpy(output->buffer + (input->cols * (ix + pad_before + input->rows)),
-                input->buffer + (pad_after_index * input->cols),
+                input->buffer + (((pad_after_index + first_row) % input->rows) * input->cols),
                 input->cols * sizeof(float));
 
             if (pad_after_index == 0 && !pad_after_direction_up) {
@@ -1019,21 +1245,12 @@ public:
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
         }
 
-        for (size_t col = 0; col < input_matrix->cols; col++) {
-            // Note - not using CMSIS-DSP here
-            // gathering up the current columnand moving it into sequential memory to use
-            // SIMD to calculate the mean would take more time than the simple loop
-            // so disable this case. The alternative is to use 2 transposes and on a "big" ARM
-            // platform that will take more time
-
-            float sum = 0.0f;
-
-            for (size_t row = 0; row < input_matrix->rows; row++) {
-                sum += input_matrix->buffer[( row * input_matrix->cols ) + col];
-            }
-
-            output_matrix->buffer[col] = sum / input_matrix->rows;
-        }
+        // Note - not using CMSIS-DSP here
+        // gathering up the current column and moving it into sequential memory to use
+        // SIMD to calculate the mean would take more time than the dispatched kernel,
+        // which sums a strip of columns in registers per row (or whole rows, for wide matrices)
+        dispatch::kernels().mean_std_axis0(input_matrix->buffer, input_matrix->rows,
+            input_matrix->cols, output_matrix->buffer, NULL);
 
         return EIDSP_OK;
     }
@@ -1057,25 +1274,14 @@ public:
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
         }
 
-        for (size_t col = 0; col < input_matrix->cols; col++) {
-            float sum = 0.0f;
-
-            for (size_t row = 0; row < input_matrix->rows; row++) {
-                sum += input_matrix->buffer[(row * input_matrix->cols) + col];
-            }
-
-            float mean = sum / input_matrix->rows;
-
-            float std = 0.0f;
-            float tmp;
-            for (size_t row = 0; row < input_matrix->rows; row++) {
-                tmp = input_matrix->buffer[(row * input_matrix->cols) + col] - mean;
-                std += tmp * tmp;
-            }
-
-            output_matrix->buffer[col] = sqrt(std / input_matrix->rows);
+        EI_DSP_MATRIX(mean_matrix, input_matrix->cols, 1);
+        if (!mean_matrix.buffer) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
         }
 
+        dispatch::kernels().mean_std_axis0(input_matrix->buffer, input_matrix->rows,
+            input_matrix->cols, mean_matrix.buffer, output_matrix->buffer);
+
         return EIDSP_OK;
 #endif
     }
@@ -1323,6 +1529,25 @@ public:
         return EIDSP_OK;
     }
 
+    /**
+     * Count, mean, min, max and the central moment sums of a buffer in one pass over the
+     * data, with Welford style accumulators (see dispatch::kernels_t::moments)
+     * @param input Input buffer
+     * @param length Number of elements in the input buffer
+     * @param order Highest central moment that's needed, 1 (only count, mean, min and max) to 4
+     * @param output Output moments, the sums above order are left at 0
+     * @returns 0 if OK
+     */
+    static int moments(const float *input, size_t length, int order, moments_t *output) {
+        if (order < 1 || order > 4) {
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+        }
+
+        dispatch::kernels().moments(input, length, order, output);
+
+        return EIDSP_OK;
+    }
+
     /**
      * Compute the one-dimensional discrete Fourier Transform for real input.
      * This function computes the one-dimensional n-point discrete Fourier Transform (DFT) of
@@ -1400,6 +1625,63 @@ public:
         return EIDSP_OK;
     }
 
+    /**
+     * Compute the one-dimensional real input DFT (like rfft) of several frames at once.
+     * Without CMSIS-DSP the frames share one FFT plan (the kissfft backend transforms
+     * KISS_FFTR_BATCH_LANES frames together), the results are the same as rfft per frame.
+     * @param src Source buffer, frame f starts at src + f * src_stride
+     * @param src_size Size of every source frame
+     * @param src_stride Distance between the starts of two source frames
+     * @param frames Number of frames
+     * @param output Output buffer, frames x output_size
+     * @param output_size Size of the output of one frame, should be n_fft / 2 + 1
+     * @returns 0 if OK
+     */
+    static int rfft_frames(const float *src, size_t src_size, size_t src_stride, size_t frames,
+        float *output, size_t output_size, size_t n_fft)
+    {
+        size_t n_fft_out_features = (n_fft / 2) + 1;
+        if (output_size != n_fft_out_features) {
+            EIDSP_ERR(EIDSP_BUFFER_SIZE_MISMATCH);
+        }
+
+#if EIDSP_USE_CMSIS_DSP
+        for (size_t ix = 0; ix < frames; ix++) {
+            int ret = rfft(src + (ix * src_stride), src_size, output + (ix * output_size), output_size, n_fft);
+            if (ret != EIDSP_OK) {
+                EIDSP_ERR(ret);
+            }
+        }
+#else
+        // frames that are too short are zero padded, frames that are long enough are truncated in place
+        if (src_size < n_fft) {
+            EI_DSP_MATRIX(fft_input, frames, n_fft);
+            if (!fft_input.buffer) {
+                EIDSP_ERR(EIDSP_OUT_OF_MEM);
+            }
+
+            for (size_t ix = 0; ix < frames; ix++) {
+                float *frame = fft_input.buffer + (ix * n_fft);
+                memcpy(frame, src + (ix * src_stride), src_size * sizeof(float));
+                memset(frame + src_size, 0, (n_fft - src_size) * sizeof(float));
+            }
+
+            int ret = software_rfft_frames(fft_input.buffer, n_fft, frames, output, n_fft, n_fft_out_features);
+            if (ret != EIDSP_OK) {
+                EIDSP_ERR(ret);
+            }
+        }
+        else {
+            int ret = software_rfft_frames(src, src_stride, frames, output, n_fft, n_fft_out_features);
+            if (ret != EIDSP_OK) {
+                EIDSP_ERR(ret);
+            }
+        }
+#endif
+
+        return EIDSP_OK;
+    }
+
     /**
      * Compute the one-dimensional discrete Fourier Transform for real input.
      * This function computes the one-dimensional n-point discrete Fourier Transform (DFT) of
@@ -1864,9 +2146,7 @@ public:
 #if EIDSP_USE_CMSIS_FiXED
         arm_q15_to_float((q15_t *)input, output, length);
 #else
-        for (size_t ix = 0; ix < length; ix++) {
-            output[ix] = (float)(input[ix]) / 32768.f;
-        }
+        dispatch::kernels().int16_to_float(input, output, length);
 #endif
         return EIDSP_OK;
     }
@@ -1998,13 +2278,82 @@ public:
      */
     static int log(matrix_t *matrix)
     {
-        for (uint32_t ix = 0; ix < matrix->rows * matrix->cols; ix++) {
-            matrix->buffer[ix] = numpy::log(matrix->buffer[ix]);
-        }
+        dispatch::kernels().log(matrix->buffer, matrix->rows * matrix->cols);
 
         return EIDSP_OK;
     }
 
+    /**
+     * Integer square root
+     * @param x Input number
+     * @returns floor(sqrt(x))
+     */
+    static uint32_t sqrt_u64(uint64_t x)
+    {
+        uint64_t root = 0;
+        uint64_t bit = 1ULL << 62;
+
+        while (bit > x) {
+            bit >>= 2;
+        }
+        while (bit != 0) {
+            if (x >= root + bit) {
+                x -= root + bit;
+                root = (root >> 1) + bit;
+            }
+            else {
+                root >>= 1;
+            }
+            bit >>= 2;
+        }
+        return (uint32_t)root;
+    }
+
+    /**
+     * Base 2 log of an integer in q16 (16 fractional bits), from a 128 entry
+     * table with linear interpolation (max error 2.5e-5)
+     * @param x Input number, > 0
+     * @returns log2(x) * 65536, 0 for x = 0
+     */
+    static int32_t log2_q16(uint64_t x)
+    {
+        // log2(1 + i / 128) in q16
+        static const uint32_t table[129] = {
+            0, 736, 1466, 2190, 2909, 3623, 4331, 5034,
+            5732, 6425, 7112, 7795, 8473, 9146, 9814, 10477,
+            11136, 11791, 12440, 13086, 13727, 14363, 14996, 15624,
+            16248, 16868, 17484, 18096, 18704, 19308, 19909, 20505,
+            21098, 21687, 22272, 22854, 23433, 24007, 24579, 25146,
+            25711, 26272, 26830, 27384, 27936, 28484, 29029, 29571,
+            30109, 30645, 31178, 31707, 32234, 32758, 33279, 33797,
+            34312, 34825, 35334, 35841, 36346, 36847, 37346, 37842,
+            38336, 38827, 39316, 39802, 40286, 40767, 41246, 41722,
+            42196, 42667, 43137, 43603, 44068, 44530, 44990, 45448,
+            45904, 46357, 46809, 47258, 47705, 48150, 48593, 49034,
+            49472, 49909, 50344, 50776, 51207, 51636, 52063, 52488,
+            52911, 53332, 53751, 54169, 54584, 54998, 55410, 55820,
+            56229, 56635, 57040, 57443, 57845, 58245, 58643, 59039,
+            59434, 59827, 60219, 60609, 60997, 61384, 61769, 62152,
+            62534, 62915, 63294, 63671, 64047, 64421, 64794, 65166,
+            65536
+        };
+
+        if (x == 0) {
+            return 0;
+        }
+
+        int32_t leading_zeros = __builtin_clzll(x);
+        int32_t exponent = 63 - leading_zeros;
+        x <<= leading_zeros;
+
+        // 7 bits below the leading one index the table, the next 16 interpolate
+        uint32_t ix = (uint32_t)(x >> 56) & 0x7f;
+        uint32_t frac = (uint32_t)(x >> 40) & 0xffff;
+        uint32_t mantissa = table[ix] + (((table[ix + 1] - table[ix]) * frac + 0x8000) >> 16);
+
+        return (exponent << 16) + (int32_t)mantissa;
+    }
+
     /**
      * @brief      Signed Saturate
      *
@@ -2079,26 +2428,16 @@ private:
             EIDSP_ERR(EIDSP_OUT_OF_MEM);
         }
 
-        size_t kiss_fftr_mem_length;
-
-        // create fftr context
-        kiss_fftr_cfg cfg = kiss_fftr_alloc(n_fft, 0, NULL, NULL, &kiss_fftr_mem_length);
-        if (!cfg) {
+        // execute the rfft operation
+        int ret = software_rfft(fft_input, (fft_complex_t*)fft_output, n_fft, n_fft_out_features);
+        if (ret != EIDSP_OK) {
             ei_dsp_free(fft_output, n_fft_out_features * sizeof(kiss_fft_cpx));
-            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+            EIDSP_ERR(ret);
         }
 
-        ei_dsp_register_alloc(kiss_fftr_mem_length, cfg);
-
-        // execute the rfft operation
-        kiss_fftr(cfg, fft_input, fft_output);
-
         // and write back to the output
-        for (size_t ix = 0; ix < n_fft_out_features; ix++) {
-            output[ix] = sqrt(pow(fft_output[ix].r, 2) + pow(fft_output[ix].i, 2));
-        }
+        dispatch::kernels().fft_magnitude((fft_complex_t*)fft_output, output, n_fft_out_features);
 
-        ei_dsp_free(cfg, kiss_fftr_mem_length);
         ei_dsp_free(fft_output, n_fft_out_features * sizeof(kiss_fft_cpx));
 
         return EIDSP_OK;
@@ -2106,20 +2445,52 @@ private:
 
     static int software_rfft(float *fft_input, fft_complex_t *output, size_t n_fft, size_t n_fft_out_features)
     {
-        // create fftr context
-        size_t kiss_fftr_mem_length;
+        (void)n_fft_out_features;
+
+        fft::plan_t plan;
+        int ret = fft::plan_init(&plan, n_fft, true, fft::FFT_F32);
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(ret);
+        }
+
+        ret = fft::rfft(&plan, fft_input, output);
 
-        kiss_fftr_cfg cfg = kiss_fftr_alloc(n_fft, 0, NULL, NULL, &kiss_fftr_mem_length);
-        if (!cfg) {
+        fft::plan_free(&plan);
+
+        return ret;
+    }
+
+    static int software_rfft_frames(const float *fft_input, size_t input_stride, size_t frames,
+        float *output, size_t n_fft, size_t n_fft_out_features)
+    {
+        size_t fft_output_size = frames * n_fft_out_features * sizeof(kiss_fft_cpx);
+        kiss_fft_cpx *fft_output = (kiss_fft_cpx*)ei_dsp_malloc(fft_output_size);
+        if (!fft_output) {
             EIDSP_ERR(EIDSP_OUT_OF_MEM);
         }
 
-        ei_dsp_register_alloc(kiss_fftr_mem_length, cfg);
+        fft::plan_t plan;
+        int ret = fft::plan_init(&plan, n_fft, true, fft::FFT_F32);
+        if (ret != EIDSP_OK) {
+            ei_dsp_free(fft_output, fft_output_size);
+            EIDSP_ERR(ret);
+        }
 
-        // execute the rfft operation
-        kiss_fftr(cfg, fft_input, (kiss_fft_cpx*)output);
+        // execute the rfft operation over all frames
+        ret = fft::rfft_frames(&plan, fft_input, input_stride, (fft_complex_t*)fft_output,
+            n_fft_out_features, frames);
 
-        ei_dsp_free(cfg, kiss_fftr_mem_length);
+        fft::plan_free(&plan);
+
+        if (ret != EIDSP_OK) {
+            ei_dsp_free(fft_output, fft_output_size);
+            EIDSP_ERR(ret);
+        }
+
+        // and write back to the output
+        dispatch::kernels().fft_magnitude((fft_complex_t*)fft_output, output, frames * n_fft_out_features);
+
+        ei_dsp_free(fft_output, fft_output_size);
 
         return EIDSP_OK;
     }
@@ -2482,6 +2853,7 @@ private:
             *pOut = 0;
         }
     }
+
 };
 
 } // namespace ei
@@ -59,6 +59,21 @@ typedef struct {
     int32_t r;
     int32_t i;
 } fft_complex_i32_t;
+
+/**
+ * Single pass statistics of a buffer (see numpy::moments).
+ * m2, m3 and m4 are the sums of the 2nd, 3rd and 4th power of the deviations
+ * from the mean, divide them by count for the central moments.
+ */
+typedef struct {
+    size_t count;
+    float mean;
+    float min;
+    float max;
+    float m2;
+    float m3;
+    float m4;
+} moments_t;
 /**
  * A matrix structure that allocates a matrix on the **heap**.
  * Freeing happens by calling `delete` on the object or letting the object go out of scope.
@@ -25,6 +25,7 @@
 
 #include <vector>
 #include <stdint.h>
+#include <stdlib.h>
 #include "processing.hpp"
 
 namespace ei {
@@ -36,13 +37,26 @@ typedef enum {
     filter_highpass = 2
 } filter_t;
 
-class feature {
+/**
+ * Everything spectral_analysis() needs that only depends on the configuration of the
+ * block: the spectral power edges, the filter coefficients and the scratch buffers.
+ * Build it once per configuration (and sampling frequency) and reuse it for every
+ * window. The scratch buffers make a plan usable by one thread at a time.
+ */
+class spectral_analysis_plan {
 public:
+    spectral_analysis_plan() : edges(NULL), edge_count(0), scratch(NULL) { }
+
+    ~spectral_analysis_plan() {
+        release();
+    }
+
+    spectral_analysis_plan(const spectral_analysis_plan&) = delete;
+    spectral_analysis_plan& operator=(const spectral_analysis_plan&) = delete;
+
     /**
-     * Calculate the spectral features over a signal.
-     * @param out_features Output matrix. Use `calculate_spectral_buffer_size` to calculate
-     *  the size required. Needs as many rows as `raw_data`.
-     * @param input_matrix Signal, with one row per axis
+     * @brief Set up the plan
+     * @param axes Number of axes of the signal
      * @param sampling_freq Sampling frequency of the signal
      * @param filter_type Filter type
      * @param filter_cutoff Filter cutoff frequency
@@ -50,12 +64,12 @@ public:
      * @param fft_length Length of the FFT signal
      * @param fft_peaks Number of FFT peaks to find
      * @param fft_peaks_threshold Minimum threshold
-     * @param edges_matrix Spectral power edges
+     * @param edges Spectral power edges
+     * @param edge_count Number of spectral power edges
      * @returns 0 if OK
      */
-    static int spectral_analysis(
-        matrix_t *out_features,
-        matrix_t *input_matrix,
+    int init(
+        size_t axes,
         float sampling_freq,
         filter_t filter_type,
         float filter_cutoff,
@@ -63,26 +77,184 @@ public:
         uint16_t fft_length,
         uint8_t fft_peaks,
         float fft_peaks_threshold,
-        matrix_t *edges_matrix_in
-    ) {
-        if (out_features->rows != input_matrix->rows) {
-            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        const float *edges,
+        size_t edge_count)
+    {
+        release();
+
+        this->axes = axes;
+        this->sampling_freq = sampling_freq;
+        this->filter_type = filter_type;
+        this->fft_length = fft_length;
+        this->fft_peaks = fft_peaks;
+        this->fft_peaks_threshold = fft_peaks_threshold;
+        this->edge_count = edge_count;
+
+        if (filter_type != filter_none) {
+            int ret = filter.init(filter_type == filter_highpass, filter_order, sampling_freq, filter_cutoff, axes);
+            if (ret != EIDSP_OK) {
+                EIDSP_ERR(ret);
+            }
         }
 
-        if (out_features->cols != calculate_spectral_buffer_size(true, fft_peaks, edges_matrix_in->rows)) {
+        const size_t bins = fft_length / 2 + 1;
+        const size_t edges_out = edge_count > 0 ? edge_count - 1 : 0;
+
+        // edges, mean, rms, FFT, peaks, periodogram (power and frequencies), power per edge
+        scratch_size = edge_count + (2 * axes) + bins + (fft_peaks * 2) + (2 * bins) + edges_out;
+        scratch = (float*)ei_calloc(scratch_size, sizeof(float));
+        if (!scratch) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        float *ptr = scratch;
+        this->edges = ptr;
+        ptr += edge_count;
+        mean_buffer = ptr;
+        ptr += axes;
+        rms_buffer = ptr;
+        ptr += axes;
+        fft_buffer = ptr;
+        ptr += bins;
+        peaks_buffer = ptr;
+        ptr += fft_peaks * 2;
+        period_fft_buffer = ptr;
+        ptr += bins;
+        period_freq_buffer = ptr;
+        ptr += bins;
+        edges_out_buffer = ptr;
+
+        memcpy(this->edges, edges, edge_count * sizeof(float));
+
+        return EIDSP_OK;
+    }
+
+    /**
+     * @brief Set up the plan from the block configuration strings
+     * @param filter_type "low", "high", anything else for no filter
+     * @param spectral_power_edges Comma separated spectral power edges (e.g. "0.1, 0.5, 1.0")
+     * @returns 0 if OK
+     */
+    int init(
+        size_t axes,
+        float sampling_freq,
+        const char *filter_type,
+        float filter_cutoff,
+        uint8_t filter_order,
+        uint16_t fft_length,
+        uint8_t fft_peaks,
+        float fft_peaks_threshold,
+        const char *spectral_power_edges)
+    {
+        filter_t type;
+        if (strcmp(filter_type, "low") == 0) {
+            type = filter_lowpass;
+        }
+        else if (strcmp(filter_type, "high") == 0) {
+            type = filter_highpass;
+        }
+        else {
+            type = filter_none;
+        }
+
+        size_t count = 1;
+        for (const char *c = spectral_power_edges; *c != '\0'; c++) {
+            if (*c == ',') {
+                count++;
+            }
+        }
+
+        EI_DSP_MATRIX(edges_matrix, count, 1);
+        if (!edges_matrix.buffer) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        // atof stops at the next delimiter
+        const char *spectral_ptr = spectral_power_edges;
+        for (size_t ix = 0; ix < count; ix++) {
+            edges_matrix.buffer[ix] = atof(spectral_ptr);
+            spectral_ptr = strchr(spectral_ptr, ',');
+            if (spectral_ptr) {
+                spectral_ptr++;
+            }
+        }
+
+        return init(axes, sampling_freq, type, filter_cutoff, filter_order, fft_length,
+            fft_peaks, fft_peaks_threshold, edges_matrix.buffer, count);
+    }
+
+    size_t get_edge_count() const {
+        return edge_count;
+    }
+
+    size_t get_axes() const {
+        return axes;
+    }
+
+private:
+    friend class feature;
+
+    void release() {
+        if (scratch) {
+            ei_free(scratch);
+            scratch = NULL;
+        }
+        edges = NULL;
+        edge_count = 0;
+    }
+
+    size_t axes;
+    float sampling_freq;
+    filter_t filter_type;
+    filters::butterworth_filter filter;
+    uint16_t fft_length;
+    uint8_t fft_peaks;
+    float fft_peaks_threshold;
+    float *edges;
+    size_t edge_count;
+
+    float *scratch;
+    size_t scratch_size;
+    float *mean_buffer;
+    float *rms_buffer;
+    float *fft_buffer;
+    float *peaks_buffer;
+    float *period_fft_buffer;
+    float *period_freq_buffer;
+    float *edges_out_buffer;
+};
+
+class feature {
+public:
+    /**
+     * Calculate the spectral features over a signal.
+     * @param out_features Output matrix. Use `calculate_spectral_buffer_size` to calculate
+     *  the size required. Needs as many rows as `raw_data`.
+     * @param input_matrix Signal, with one row per axis, modified in place
+     * @param plan Plan for the block configuration
+     * @returns 0 if OK
+     */
+    static int spectral_analysis(
+        matrix_t *out_features,
+        matrix_t *input_matrix,
+        spectral_analysis_plan *plan
+    ) {
+        if (out_features->rows != input_matrix->rows || input_matrix->rows != plan->axes) {
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
         }
 
-        if (edges_matrix_in->cols != 1) {
+        if (out_features->cols != calculate_spectral_buffer_size(true, plan->fft_peaks, plan->edge_count)) {
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
         }
 
         int ret;
 
-        size_t axes = input_matrix->rows;
+        const size_t axes = input_matrix->rows;
+        const float sampling_freq = plan->sampling_freq;
+        const uint16_t fft_length = plan->fft_length;
 
         // calculate the mean
-        EI_DSP_MATRIX(mean_matrix, axes, 1);
+        EI_DSP_MATRIX_B(mean_matrix, axes, 1, plan->mean_buffer);
         ret = numpy::mean(input_matrix, &mean_matrix);
         if (ret != EIDSP_OK) {
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
@@ -94,31 +266,25 @@ public:
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
         }
 
-        // apply filter
-        if (filter_type == filter_lowpass) {
-            ret = spectral::processing::butterworth_lowpass_filter(
-                input_matrix, sampling_freq, filter_cutoff, filter_order);
-            if (ret != EIDSP_OK) {
-                EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
-            }
-        }
-        else if (filter_type == filter_highpass) {
-            ret = spectral::processing::butterworth_highpass_filter(
-                input_matrix, sampling_freq, filter_cutoff, filter_order);
-            if (ret != EIDSP_OK) {
-                EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
-            }
+        // apply filter, on all axes at once
+        if (plan->filter_type != filter_none) {
+            plan->filter.apply_rows(input_matrix);
         }
 
         // calculate RMS
-        EI_DSP_MATRIX(rms_matrix, axes, 1);
+        EI_DSP_MATRIX_B(rms_matrix, axes, 1, plan->rms_buffer);
         ret = numpy::rms(input_matrix, &rms_matrix);
         if (ret != EIDSP_OK) {
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
         }
 
-        // find peaks in FFT
-        EI_DSP_MATRIX(peaks_matrix, axes, fft_peaks * 2);
+        EI_DSP_MATRIX_B(edges_matrix_in, plan->edge_count, 1, plan->edges);
+        EI_DSP_MATRIX_B(fft_matrix, 1, fft_length / 2 + 1, plan->fft_buffer);
+        EI_DSP_MATRIX_B(peaks_matrix, plan->fft_peaks, 2, plan->peaks_buffer);
+        EI_DSP_MATRIX_B(period_fft_matrix, 1, fft_length / 2 + 1, plan->period_fft_buffer);
+        EI_DSP_MATRIX_B(period_freq_matrix, 1, fft_length / 2 + 1, plan->period_freq_buffer);
+        EI_DSP_MATRIX_B(edges_matrix_out, plan->edge_count > 0 ? plan->edge_count - 1 : 0, 1,
+            plan->edges_out_buffer);
 
         for (size_t row = 0; row < input_matrix->rows; row++) {
             // per axis code
@@ -127,7 +293,6 @@ public:
             EI_DSP_MATRIX_B(axis_matrix, 1, input_matrix->cols, input_matrix->buffer + (row * input_matrix->cols));
 
             // calculate FFT
-            EI_DSP_MATRIX(fft_matrix, 1, fft_length / 2 + 1);
             ret = numpy::rfft(axis_matrix.buffer, axis_matrix.cols, fft_matrix.buffer, fft_matrix.cols, fft_length);
             if (ret != EIDSP_OK) {
                 EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
@@ -137,27 +302,23 @@ public:
             numpy::scale(&fft_matrix, (2.0f / static_cast<float>(fft_length)));
 
             // we're now using the FFT matrix to calculate peaks etc.
-            EI_DSP_MATRIX(peaks_matrix, fft_peaks, 2);
             ret = spectral::processing::find_fft_peaks(&fft_matrix, &peaks_matrix,
-                sampling_freq, fft_peaks_threshold, fft_length);
+                sampling_freq, plan->fft_peaks_threshold, fft_length);
             if (ret != EIDSP_OK) {
                 EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
             }
 
             // calculate periodogram for spectral power buckets
-            EI_DSP_MATRIX(period_fft_matrix, 1, fft_length / 2 + 1);
-            EI_DSP_MATRIX(period_freq_matrix, 1, fft_length / 2 + 1);
             ret = spectral::processing::periodogram(&axis_matrix,
                 &period_fft_matrix, &period_freq_matrix, sampling_freq, fft_length);
             if (ret != EIDSP_OK) {
                 EIDSP_ERR(ret);
             }
 
-            EI_DSP_MATRIX(edges_matrix_out, edges_matrix_in->rows - 1, 1);
             ret = spectral::processing::spectral_power_edges(
                 &period_fft_matrix,
                 &period_freq_matrix,
-                edges_matrix_in,
+                &edges_matrix_in,
                 &edges_matrix_out,
                 sampling_freq);
             if (ret != EIDSP_OK) {
@@ -181,6 +342,47 @@ public:
         return EIDSP_OK;
     }
 
+    /**
+     * Calculate the spectral features over a signal.
+     * @param out_features Output matrix. Use `calculate_spectral_buffer_size` to calculate
+     *  the size required. Needs as many rows as `raw_data`.
+     * @param input_matrix Signal, with one row per axis
+     * @param sampling_freq Sampling frequency of the signal
+     * @param filter_type Filter type
+     * @param filter_cutoff Filter cutoff frequency
+     * @param filter_order Filter order
+     * @param fft_length Length of the FFT signal
+     * @param fft_peaks Number of FFT peaks to find
+     * @param fft_peaks_threshold Minimum threshold
+     * @param edges_matrix Spectral power edges
+     * @returns 0 if OK
+     */
+    static int spectral_analysis(
+        matrix_t *out_features,
+        matrix_t *input_matrix,
+        float sampling_freq,
+        filter_t filter_type,
+        float filter_cutoff,
+        uint8_t filter_order,
+        uint16_t fft_length,
+        uint8_t fft_peaks,
+        float fft_peaks_threshold,
+        matrix_t *edges_matrix_in
+    ) {
+        if (edges_matrix_in->cols != 1) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        spectral_analysis_plan plan;
+        int ret = plan.init(input_matrix->rows, sampling_freq, filter_type, filter_cutoff, filter_order,
+            fft_length, fft_peaks, fft_peaks_threshold, edges_matrix_in->buffer, edges_matrix_in->rows);
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(ret);
+        }
+
+        return spectral_analysis(out_features, input_matrix, &plan);
+    }
+
     static int spectral_analysis(
         matrix_i32_t *out_features,
         matrix_i16_t *input_matrix,
@@ -33,6 +33,136 @@
 namespace ei {
 namespace spectral {
 namespace filters {
+    /**
+     * Butterworth filter as a cascade of second order sections. The coefficients are
+     * calculated once by init(), after that the filter can run over any number of signals.
+     * All axes of a signal are filtered together, one axis per SIMD lane.
+     */
+    class butterworth_filter {
+    public:
+        butterworth_filter() : n_steps(0), axes(0), highpass(false), coefs(NULL), state(NULL) { }
+
+        ~butterworth_filter() {
+            if (coefs) {
+                ei_free(coefs);
+            }
+        }
+
+        butterworth_filter(const butterworth_filter&) = delete;
+        butterworth_filter& operator=(const butterworth_filter&) = delete;
+
+        /**
+         * @brief Calculate the filter coefficients
+         * @param highpass Highpass filter instead of a lowpass filter
+         * @param filter_order Even filter order (between 2..8)
+         * @param sampling_freq Sample frequency of the signal
+         * @param cutoff_freq Cut-off frequency of the signal
+         * @param axes Number of axes in the signals
+         * @returns EIDSP_OK, or EIDSP_OUT_OF_MEM
+         */
+        int init(bool highpass, int filter_order, float sampling_freq, float cutoff_freq, size_t axes = 1) {
+            if (coefs) {
+                ei_free(coefs);
+                coefs = NULL;
+                state = NULL;
+            }
+
+            this->highpass = highpass;
+            this->axes = axes;
+            n_steps = filter_order / 2;
+            if (n_steps <= 0) {
+                n_steps = 0;
+                return EIDSP_OK;
+            }
+
+            // A, d1, d2, and the w1, w2 state of every section and axis
+            coefs = (float*)ei_calloc(n_steps * (3 + (2 * axes)), sizeof(float));
+            if (!coefs) {
+                n_steps = 0;
+                EIDSP_ERR(EIDSP_OUT_OF_MEM);
+            }
+            state = coefs + (3 * n_steps);
+
+            float a = tan(M_PI * cutoff_freq / sampling_freq);
+            float a2 = pow(a, 2);
+            float *A = coefs;
+            float *d1 = coefs + n_steps;
+            float *d2 = coefs + (2 * n_steps);
+
+            for (int ix = 0; ix < n_steps; ix++) {
+                float r = sin(M_PI * ((2.0 * ix) + 1.0) / (2.0 * filter_order));
+                float s = a2 + (2.0 * a * r) + 1.0;
+                A[ix] = highpass ? 1.0f / s : a2 / s;
+                d1[ix] = 2.0 * (1 - a2) / s;
+                d2[ix] = -(a2 - (2.0 * a * r) + 1.0) / s;
+            }
+
+            return EIDSP_OK;
+        }
+
+        /**
+         * @brief Clear the filter state
+         */
+        void reset() {
+            if (state) {
+                memset(state, 0, n_steps * 2 * axes * sizeof(float));
+            }
+        }
+
+        /**
+         * @brief Filter frames of all axes, continuing from the state that the previous
+         *        call left (streaming), call reset() to start a new signal
+         * @param src Source, sample f of axis a is at src[f * frame_stride + a * axis_stride]
+         * @param dest Destination with the same layout (can be the same as src)
+         * @param frames Number of samples per axis
+         * @param frame_stride Distance between the samples of an axis
+         * @param axis_stride Distance between the axes
+         */
+        void process(const float *src, float *dest, size_t frames, size_t frame_stride, size_t axis_stride) {
+            if (n_steps == 0) {
+                for (size_t f = 0; f < frames; f++) {
+                    for (size_t a = 0; a < axes; a++) {
+                        dest[f * frame_stride + a * axis_stride] = src[f * frame_stride + a * axis_stride];
+                    }
+                }
+                return;
+            }
+
+            dispatch::kernels().butterworth_lanes(coefs, n_steps, highpass, state, src, dest,
+                frames, axes, frame_stride, axis_stride);
+        }
+
+        /**
+         * @brief Filter a signal with interleaved axes, starting from a zero state
+         * @param src Source array
+         * @param dest Destination array (can be the same as src)
+         * @param size Size of both source and destination arrays (all axes)
+         */
+        void apply(const float *src, float *dest, size_t size) {
+            reset();
+            process(src, dest, size / axes, axes, 1);
+        }
+
+        /**
+         * @brief Filter a matrix with one row per axis in place, starting from a zero state
+         */
+        void apply_rows(matrix_t *matrix) {
+            reset();
+            process(matrix->buffer, matrix->buffer, matrix->cols, 1, matrix->cols);
+        }
+
+        size_t get_axes() const {
+            return axes;
+        }
+
+    private:
+        int n_steps;
+        size_t axes;
+        bool highpass;
+        float *coefs;
+        float *state;
+    };
+
     /**
      * The Butterworth filter has maximally flat frequency response in the passband.
      * @param filter_order Even filter order (between 2..8)
@@ -42,7 +172,7 @@ namespace filters {
      * @param dest Destination array
      * @param size Size of both source and destination arrays
      */
-    static void butterworth_lowpass(
+    __attribute__((unused)) static void butterworth_lowpass(
         int filter_order,
         float sampling_freq,
         float cutoff_freq,
@@ -50,43 +180,11 @@ namespace filters {
         float *dest,
         size_t size)
     {
-        int n_steps = filter_order / 2;
-        float a = tan(M_PI * cutoff_freq / sampling_freq);
-        float a2 = pow(a, 2);
-        float *A = (float*)ei_calloc(n_steps, sizeof(float));
-        float *d1 = (float*)ei_calloc(n_steps, sizeof(float));
-        float *d2 = (float*)ei_calloc(n_steps, sizeof(float));
-        float *w0 = (float*)ei_calloc(n_steps, sizeof(float));
-        float *w1 = (float*)ei_calloc(n_steps, sizeof(float));
-        float *w2 = (float*)ei_calloc(n_steps, sizeof(float));
-
-        // Calculate the filter parameters
-        for(int ix = 0; ix < n_steps; ix++) {
-            float r = sin(M_PI * ((2.0 * ix) + 1.0) / (2.0 * filter_order));
-            sampling_freq = a2 + (2.0 * a * r) + 1.0;
-            A[ix] = a2 / sampling_freq;
-            d1[ix] = 2.0 * (1 - a2) / sampling_freq;
-            d2[ix] = -(a2 - (2.0 * a * r) + 1.0) / sampling_freq;
+        butterworth_filter filter;
+        if (filter.init(false, filter_order, sampling_freq, cutoff_freq) != EIDSP_OK) {
+            return;
         }
-
-        // Apply the filter
-        for (size_t sx = 0; sx < size; sx++) {
-            dest[sx] = src[sx];
-
-            for (int i = 0; i < n_steps; i++) {
-                w0[i] = d1[i] * w1[i] + d2[i] * w2[i] + dest[sx];
-                dest[sx] = A[i] * (w0[i] + (2.0 * w1[i]) + w2[i]);
-                w2[i] = w1[i];
-                w1[i] = w0[i];
-            }
-        }
-
-        ei_free(A);
-        ei_free(d1);
-        ei_free(d2);
-        ei_free(w0);
-        ei_free(w1);
-        ei_free(w2);
+        filter.apply(src, dest, size);
     }
 
     /**
@@ -98,7 +196,7 @@ namespace filters {
      * @param dest Destination array
      * @param size Size of both source and destination arrays
      */
-    static void butterworth_highpass(
+    __attribute__((unused)) static void butterworth_highpass(
         int filter_order,
         float sampling_freq,
         float cutoff_freq,
@@ -106,43 +204,11 @@ namespace filters {
         float *dest,
         size_t size)
     {
-        int n_steps = filter_order / 2;
-        float a = tan(M_PI * cutoff_freq / sampling_freq);
-        float a2 = pow(a, 2);
-        float *A = (float*)ei_calloc(n_steps, sizeof(float));
-        float *d1 = (float*)ei_calloc(n_steps, sizeof(float));
-        float *d2 = (float*)ei_calloc(n_steps, sizeof(float));
-        float *w0 = (float*)ei_calloc(n_steps, sizeof(float));
-        float *w1 = (float*)ei_calloc(n_steps, sizeof(float));
-        float *w2 = (float*)ei_calloc(n_steps, sizeof(float));
-
-        // Calculate the filter parameters
-        for (int ix = 0; ix < n_steps; ix++) {
-            float r = sin(M_PI * ((2.0 * ix) + 1.0) / (2.0 * filter_order));
-            sampling_freq = a2 + (2.0 * a * r) + 1.0;
-            A[ix] = 1.0f / sampling_freq;
-            d1[ix] = 2.0 * (1 - a2) / sampling_freq;
-            d2[ix] = -(a2 - (2.0 * a * r) + 1.0) / sampling_freq;
+        butterworth_filter filter;
+        if (filter.init(true, filter_order, sampling_freq, cutoff_freq) != EIDSP_OK) {
+            return;
         }
-
-        // Apply the filter
-        for (size_t sx = 0; sx < size; sx++) {
-            dest[sx] = src[sx];
-
-            for (int i = 0; i < n_steps; i++) {
-                w0[i] = d1[i] * w1[i] + d2[i] * w2[i] + dest[sx];
-                dest[sx] = A[i] * (w0[i] - (2.0 * w1[i]) + w2[i]);
-                w2[i] = w1[i];
-                w1[i] = w0[i];
-            }
-        }
-
-        ei_free(A);
-        ei_free(d1);
-        ei_free(d2);
-        ei_free(w0);
-        ei_free(w1);
-        ei_free(w2);
+        filter.apply(src, dest, size);
     }
 
 } // namespace filters
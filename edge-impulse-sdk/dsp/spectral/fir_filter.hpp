@@ -22,7 +22,9 @@
 #pragma once
 #include <vector>
 #include <cmath>
+#include <string.h>
 #include "filters.hpp" //for M_PI
+#include "../dispatch/ei_dispatch.h"
 #include <limits>
 
 /**
@@ -99,15 +101,21 @@ public:
      * For example, 4 to go from sample rate of 40k to 10k.  LOWPASS CUTOFF MUST MATCH THIS
      * If you don't filter the high frequencies, they WILL alias into the passband
      * So in the above example, you would want to cutoff at 5K (so you have some buffer)
+     * Only decimate() drops samples, apply_filter() keeps the sample rate
+     * @param axes Number of interleaved axes in the signals, each axis is filtered on its own
      */
     fir_filter(
         float sampling_frequency,
         uint8_t filter_size,
         float lowpass_cutoff,
         float highpass_cutoff = 0,
-        int decimation_ratio = 1) :  taps(filter_size) , history(filter_size, 0)
+        int decimation_ratio = 1,
+        int axes = 1) :  taps(filter_size), reversed_taps(filter_size, 0),
+            delay_line(axes * (filter_size - 1 + block_size), 0)
     {
         this->filter_size = filter_size;
+        this->decimation_ratio = decimation_ratio < 1 ? 1 : decimation_ratio;
+        this->axes = axes;
         std::vector<float> f_taps(filter_size, 0);
         if( highpass_cutoff == 0 && lowpass_cutoff == 0 ) 
         {
@@ -139,58 +147,45 @@ public:
         {
             taps[i] = f_taps[i] * 32767;
         }
+        // the delay line holds the oldest sample first
+        for (int i = 0; i < filter_size; i++)
+        {
+            reversed_taps[i] = taps[filter_size - 1 - i];
+        }
     }
 
 /**
  * @brief Apply the filter to the input data.  You can do this blockwise, as the object preserves memory of old samples
  * Call reset if there's a gap in the data
  * 
- * @param src Source array
+ * @param src Source array, with the axes interleaved
  * @param dest Output array (can be the same as source for in place)
- * @param size Number of samples to process
+ * @param size Number of samples to process (of all axes together)
  */
     void apply_filter(
         const input_t *src,
         input_t *dest,
         size_t size)
     {
-        for (size_t i = 0; i < size; i++)
-        {
-            history[write_index] = src[i];
-            int read_index = write_index;
-            //minus one b/c of the sign bit
-            int shift = (sizeof(input_t) * 8) - 1;
-            //stuff a 1 into one less than we're going to shift to effectively round
-            //this is essentially resetting the accumulator back to zero otherwise
-            acc_t accumulator = 1 << (shift - 1);
-            for (auto tap : taps)
-            {
-                accumulator += static_cast<acc_t>(tap) * history[read_index];
-                //wrap the read index
-                read_index = read_index == 0 ? filter_size - 1 : read_index - 1;
-            }
-            //wrap the write index
-            write_index++;
-            if (write_index == filter_size)
-            {
-                write_index = 0;
-            }
+        filter_blocks(src, dest, size / axes, 1);
+    }
 
-            accumulator >>= shift;
-            //saturate if overflow
-            if (accumulator > std::numeric_limits<input_t>::max())
-            {
-                dest[i] = std::numeric_limits<input_t>::max();
-            }
-            else if (accumulator < std::numeric_limits<input_t>::min())
-            {
-                dest[i] = std::numeric_limits<input_t>::min();
-            }
-            else
-            {
-                dest[i] = accumulator;
-            }
-        }
+/**
+ * @brief Filter and downsample by decimation_ratio. Only the samples that are kept
+ * are calculated. The position in the decimation pattern carries over to the next call,
+ * so the signal can be fed in blocks of any size
+ * 
+ * @param src Source array, with the axes interleaved
+ * @param dest Output array (can be the same as source for in place)
+ * @param size Number of samples to process (of all axes together)
+ * @return Number of samples written to dest (of all axes together)
+ */
+    size_t decimate(
+        const input_t *src,
+        input_t *dest,
+        size_t size)
+    {
+        return filter_blocks(src, dest, size / axes, decimation_ratio) * axes;
     }
 
     /**
@@ -200,14 +195,117 @@ public:
      */
     void reset()
     {
-        std::fill(history.begin(), history.end(), 0);
+        std::fill(delay_line.begin(), delay_line.end(), 0);
+        decimation_phase = 0;
     }
 
 private:
+    // samples per axis that are added to the delay lines at a time
+    static const size_t block_size = 64;
+
+    static int64_t dot(const ei::dispatch::kernels_t &kernels, const int16_t *a, const int16_t *b, size_t length)
+    {
+        return kernels.dot_q15(a, b, length);
+    }
+
+    static int64_t dot(const ei::dispatch::kernels_t &kernels, const int32_t *a, const int32_t *b, size_t length)
+    {
+        return kernels.dot_q31(a, b, length);
+    }
+
+    template <class T>
+    static acc_t dot(const ei::dispatch::kernels_t &kernels, const T *a, const T *b, size_t length)
+    {
+        acc_t total = 0;
+        for (size_t i = 0; i < length; i++)
+        {
+            total += static_cast<acc_t>(a[i]) * b[i];
+        }
+        return total;
+    }
+
+    /**
+     * @brief Filter frames (one sample per axis), keeping every step-th output
+     * @return Number of output frames
+     */
+    size_t filter_blocks(const input_t *src, input_t *dest, size_t frames, int step)
+    {
+        const size_t history_size = filter_size - 1;
+        const size_t line_size = history_size + block_size;
+        //minus one b/c of the sign bit
+        const int shift = (sizeof(input_t) * 8) - 1;
+        const ei::dispatch::kernels_t &kernels = ei::dispatch::kernels();
+        size_t phase = step > 1 ? decimation_phase : 0;
+        size_t out_frames = 0;
+
+        for (size_t start = 0; start < frames; start += block_size)
+        {
+            size_t count = frames - start < block_size ? frames - start : block_size;
+
+            // read the whole block before writing, so filtering in place works
+            for (int axis = 0; axis < axes; axis++)
+            {
+                input_t *line = delay_line.data() + (axis * line_size) + history_size;
+                for (size_t i = 0; i < count; i++)
+                {
+                    line[i] = src[(start + i) * axes + axis];
+                }
+            }
+
+            size_t block_out_frames = 0;
+            for (int axis = 0; axis < axes; axis++)
+            {
+                input_t *line = delay_line.data() + (axis * line_size);
+                block_out_frames = 0;
+                for (size_t i = phase; i < count; i += step)
+                {
+                    //stuff a 1 into one less than we're going to shift to effectively round
+                    acc_t accumulator = 1 << (shift - 1);
+                    accumulator += static_cast<acc_t>(dot(kernels, reversed_taps.data(), line + i, filter_size));
+
+                    accumulator >>= shift;
+                    //saturate if overflow
+                    input_t *out = &dest[(out_frames + block_out_frames) * axes + axis];
+                    if (accumulator > std::numeric_limits<input_t>::max())
+                    {
+                        *out = std::numeric_limits<input_t>::max();
+                    }
+                    else if (accumulator < std::numeric_limits<input_t>::min())
+                    {
+                        *out = std::numeric_limits<input_t>::min();
+                    }
+                    else
+                    {
+                        *out = accumulator;
+                    }
+                    block_out_frames++;
+                }
+
+                // keep the newest samples as history for the next block
+                memmove(line, line + count, history_size * sizeof(input_t));
+            }
+
+            // position of the next kept sample, relative to the next block
+            phase = phase + (block_out_frames * step) - count;
+            out_frames += block_out_frames;
+        }
+
+        if (step > 1)
+        {
+            decimation_phase = phase;
+        }
+
+        return out_frames;
+    }
+
     std::vector<input_t> taps;
-    std::vector<input_t> history;
-    int write_index = 0;
+    std::vector<input_t> reversed_taps;
+    // per axis: the last filter_size - 1 samples, then room for a block of new ones
+    std::vector<input_t> delay_line;
     int filter_size;
+    int decimation_ratio;
+    int axes;
+    size_t decimation_phase = 0;
 
     friend class AccelerometerQuantizedTestCase;
 };
\ No newline at end of file
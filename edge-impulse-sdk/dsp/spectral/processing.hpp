@@ -112,21 +112,19 @@ namespace processing {
      * @param filter_order
      * @returns 0 when successful
      */
-    static int butterworth_lowpass_filter(
+    __attribute__((unused)) static int butterworth_lowpass_filter(
         matrix_t *matrix,
         float sampling_frequency,
         float filter_cutoff,
         uint8_t filter_order)
     {
-        for (size_t row = 0; row < matrix->rows; row++) {
-            filters::butterworth_lowpass(
-                filter_order,
-                sampling_frequency,
-                filter_cutoff,
-                matrix->buffer + (row * matrix->cols),
-                matrix->buffer + (row * matrix->cols),
-                matrix->cols);
+        // all rows (axes) are filtered together
+        filters::butterworth_filter filter;
+        int ret = filter.init(false, filter_order, sampling_frequency, filter_cutoff, matrix->rows);
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(ret);
         }
+        filter.apply_rows(matrix);
 
         return EIDSP_OK;
     }
@@ -141,21 +139,19 @@ namespace processing {
      * @param filter_order
      * @returns 0 when successful
      */
-    static int butterworth_highpass_filter(
+    __attribute__((unused)) static int butterworth_highpass_filter(
         matrix_t *matrix,
         float sampling_frequency,
         float filter_cutoff,
         uint8_t filter_order)
     {
-        for (size_t row = 0; row < matrix->rows; row++) {
-            filters::butterworth_highpass(
-                filter_order,
-                sampling_frequency,
-                filter_cutoff,
-                matrix->buffer + (row * matrix->cols),
-                matrix->buffer + (row * matrix->cols),
-                matrix->cols);
+        // all rows (axes) are filtered together
+        filters::butterworth_filter filter;
+        int ret = filter.init(true, filter_order, sampling_frequency, filter_cutoff, matrix->rows);
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(ret);
         }
+        filter.apply_rows(matrix);
 
         return EIDSP_OK;
     }
@@ -207,7 +203,7 @@ namespace processing {
      * @param peaks_found Out parameter with the number of peaks found
      * @returns 0 if OK
      */
-    static int find_peak_indexes(
+    __attribute__((unused)) static int find_peak_indexes(
         matrix_t *input_matrix,
         matrix_t *output_matrix,
         float threshold,
@@ -263,7 +259,7 @@ namespace processing {
         return EIDSP_OK;
     }
 
-    static int find_peak_indexes(
+    __attribute__((unused)) static int find_peak_indexes(
         matrix_i16_t *input_matrix,
         matrix_i16_t *output_matrix,
         int16_t threshold,
@@ -306,7 +302,7 @@ namespace processing {
         return EIDSP_OK;
     }
 
-    static int find_peak_indexes(
+    __attribute__((unused)) static int find_peak_indexes(
         matrix_i32_t *input_matrix,
         matrix_i32_t *output_matrix,
         int16_t threshold,
@@ -350,19 +346,50 @@ namespace processing {
     }
 
     /**
-     * Find peaks in FFT
+     * Add a peak to the `k` highest peaks found so far, kept in a (k x 2) buffer of
+     * frequency and amplitude. Sorted by amplitude, highest first, peaks with the
+     * same amplitude stay in the order they were found in.
+     * @param out Buffer of k rows
+     * @param k Number of peaks to keep
+     * @param count Number of rows in use, updated
+     */
+    template <typename T>
+    static void insert_top_peak(T *out, size_t k, size_t *count, T freq, T amplitude)
+    {
+        size_t pos = *count;
+        while (pos > 0 && out[(pos - 1) * 2 + 1] < amplitude) {
+            if (pos < k) {
+                out[pos * 2 + 0] = out[(pos - 1) * 2 + 0];
+                out[pos * 2 + 1] = out[(pos - 1) * 2 + 1];
+            }
+            pos--;
+        }
+        if (pos < k) {
+            out[pos * 2 + 0] = freq;
+            out[pos * 2 + 1] = amplitude;
+        }
+        if (*count < k) {
+            (*count)++;
+        }
+    }
+
+    /**
+     * Single pass over a spectrum that finds the peaks (like find_peak_indexes with a
+     * threshold of 0) and keeps the highest ones in the output matrix, without allocating.
      * @param fft_matrix Matrix of FFT numbers (1xN)
-     * @param output_matrix Matrix for the output (Mx2), one row per output you want and two colums per row
-     * @param sampling_freq How often we sample (in Hz)
-     * @param threshold Minimum threshold (default: 0.1)
-     * @returns
+     * @param output_matrix Matrix for the output (Mx2), frequency and amplitude per row,
+     *      rows that no peak was found for are zero
+     * @param max_candidates Only the first max_candidates peaks in the spectrum are considered
+     * @param amplitude_threshold Peaks below this amplitude are kept with frequency and amplitude 0
+     * @param freq Function that returns the frequency of an FFT bin
      */
-    static int find_fft_peaks(
-        matrix_t *fft_matrix,
-        matrix_t *output_matrix,
-        float sampling_freq,
-        float threshold,
-        uint16_t fft_length)
+    template <typename matrix_type_t, typename T, typename freq_fn_t>
+    static int find_top_fft_peaks(
+        matrix_type_t *fft_matrix,
+        matrix_type_t *output_matrix,
+        size_t max_candidates,
+        T amplitude_threshold,
+        freq_fn_t freq)
     {
         if (fft_matrix->rows != 1) {
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
@@ -372,79 +399,89 @@ namespace processing {
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
         }
 
-        int ret;
-
-        int N = static_cast<int>(fft_length);
-        float T = 1.0f / sampling_freq;
-
-        EI_DSP_MATRIX(freq_space, 1, fft_matrix->cols);
-        ret = numpy::linspace(0.0f, 1.0f / (2.0f * T), floor(N / 2), freq_space.buffer);
-        if (ret != EIDSP_OK) {
-            EIDSP_ERR(ret);
-        }
-
-        EI_DSP_MATRIX(peaks_matrix, output_matrix->rows * 10, 1);
-
-        uint16_t peak_count;
-        ret = find_peak_indexes(fft_matrix, &peaks_matrix, 0.0f, &peak_count);
-        if (ret != EIDSP_OK) {
-            EIDSP_ERR(ret);
-        }
-
-        // turn this into C++ vector and sort it based on amplitude
-        std::vector<freq_peak_t> peaks;
-        for (uint8_t ix = 0; ix < peak_count; ix++) {
-            freq_peak_t d;
+        const size_t k = output_matrix->rows;
+        const size_t in_size = fft_matrix->cols;
+        const T *in = fft_matrix->buffer;
+        T *out = output_matrix->buffer;
+        size_t count = 0;
+        size_t candidates = 0;
+
+        if (in_size >= 3 && max_candidates > 0) {
+            T prev = in[0];
+
+            for (size_t ix = 1; ix < in_size - 1; ix++) {
+                // first make sure it's actually a peak...
+                if (in[ix] > prev && in[ix] > in[ix + 1]) {
+                    // (the height is calculated in T, like find_peak_indexes)
+                    T height = ((in[ix] - prev) + (in[ix] - in[ix + 1]));
+                    if (height > 0) {
+                        T amplitude = in[ix];
+                        if (amplitude < amplitude_threshold) {
+                            insert_top_peak<T>(out, k, &count, 0, 0);
+                        }
+                        else {
+                            insert_top_peak<T>(out, k, &count, freq(ix), amplitude);
+                        }
+                        candidates++;
+                        if (candidates == max_candidates) break;
+                    }
+                }
 
-            d.freq = freq_space.buffer[static_cast<uint32_t>(peaks_matrix.buffer[ix])];
-            d.amplitude = fft_matrix->buffer[static_cast<uint32_t>(peaks_matrix.buffer[ix])];
-            // printf("freq %f : %f amp: %f\r\n", peaks_matrix.buffer[ix], d.freq, d.amplitude);
-            if (d.amplitude < threshold) {
-                d.freq = 0.0f;
-                d.amplitude = 0.0f;
+                prev = in[ix];
             }
-            peaks.push_back(d);
         }
-        sort(peaks.begin(), peaks.end(),
-            [](const freq_peak_t & a, const freq_peak_t & b) -> bool
-        {
-            return a.amplitude > b.amplitude;
-        });
 
         // fill with zeros at the end (if needed)
-        for (size_t ix = peaks.size(); ix < output_matrix->rows; ix++) {
-            freq_peak_t d;
-            d.freq = 0;
-            d.amplitude = 0;
-            peaks.push_back(d);
-        }
-
-        for (size_t row = 0; row < output_matrix->rows; row++) {
-            // col 0 is freq, col 1 is ampl
-            output_matrix->buffer[row * output_matrix->cols + 0] = peaks[row].freq;
-            output_matrix->buffer[row * output_matrix->cols + 1] = peaks[row].amplitude;
+        for (size_t row = count; row < k; row++) {
+            out[row * 2 + 0] = 0;
+            out[row * 2 + 1] = 0;
         }
 
         return EIDSP_OK;
     }
 
-    __attribute__((unused)) static int find_fft_peaks(
-        matrix_i16_t *fft_matrix,
-        matrix_i16_t *output_matrix,
+    /**
+     * Find peaks in FFT
+     * @param fft_matrix Matrix of FFT numbers (1xN)
+     * @param output_matrix Matrix for the output (Mx2), one row per output you want and two colums per row
+     * @param sampling_freq How often we sample (in Hz)
+     * @param threshold Minimum threshold (default: 0.1)
+     * @returns
+     */
+    static int find_fft_peaks(
+        matrix_t *fft_matrix,
+        matrix_t *output_matrix,
         float sampling_freq,
         float threshold,
         uint16_t fft_length)
     {
-        if (fft_matrix->rows != 1) {
-            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
-        }
+        int N = static_cast<int>(fft_length);
+        float T = 1.0f / sampling_freq;
 
-        if (output_matrix->cols != 2) {
-            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        // bin frequencies, like numpy::linspace(0.0f, 1.0f / (2.0f * T), floor(N / 2))
+        const uint32_t number = static_cast<uint32_t>(floor(N / 2));
+        if (number < 1) {
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
         }
+        const float stop = 1.0f / (2.0f * T);
+        const float step = number > 1 ? (stop - 0.0f) / (number - 1) : 0.0f;
 
-        int ret;
+        return find_top_fft_peaks(fft_matrix, output_matrix, output_matrix->rows * 10, threshold,
+            [number, stop, step](size_t ix) -> float {
+                if (ix + 1 < number) {
+                    return 0.0f + static_cast<uint32_t>(ix) * step;
+                }
+                return ix + 1 == number && number > 1 ? stop : 0.0f;
+            });
+    }
 
+    __attribute__((unused)) static int find_fft_peaks(
+        matrix_i16_t *fft_matrix,
+        matrix_i16_t *output_matrix,
+        float sampling_freq,
+        float threshold,
+        uint16_t fft_length)
+    {
         int N = static_cast<int>(fft_length);
         float T = 1.0f / sampling_freq;
 
@@ -452,63 +489,28 @@ namespace processing {
         float stop = (((1.0f / (2.0f * T)))/N);
         numpy::float_to_int16(&stop, &stop_point, 1);
 
-        EI_DSP_i16_MATRIX(freq_space, 1, fft_matrix->cols);
-        ret = numpy::linspace(0, stop_point, (N >> 1), freq_space.buffer);
-        if (ret != EIDSP_OK) {
-            EIDSP_ERR(ret);
-        }
-
-        EI_DSP_i16_MATRIX(peaks_matrix, output_matrix->rows * 4, 1);
-
-        uint16_t peak_count;
-        ret = find_peak_indexes(fft_matrix, &peaks_matrix, 0, &peak_count);
-        if (ret != EIDSP_OK) {
-            EIDSP_ERR(ret);
+        // bin frequencies, like numpy::linspace(0, stop_point, (N >> 1))
+        const uint32_t number = N >> 1;
+        if (number < 1) {
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
         }
+        const EIDSP_i16 step = number > 1 ? (stop_point - 0) / (number - 1) : 0;
 
         EIDSP_i16 i16_threshold;
         threshold /= fft_length;
         numpy::float_to_int16(&threshold, &i16_threshold, 1);
 
-        // turn this into C++ vector and sort it based on amplitude
-        std::vector<freq_peak_i16_t> peaks;
-        for (uint8_t ix = 0; ix < peak_count; ix++) {
-            freq_peak_i16_t d;
-            // @todo: something somewhere does not go OK... and these numbers are dependent on
-            // the FFT length I think... But they are an OK approximation for now.            
-            d.freq = freq_space.buffer[static_cast<uint32_t>(peaks_matrix.buffer[ix])];
-            d.amplitude = fft_matrix->buffer[peaks_matrix.buffer[ix]];
-
-            if (d.amplitude < i16_threshold) {
-                d.freq = 0.0f;
-                d.amplitude = 0.0f;
-            }
-            peaks.push_back(d);
-        }
-        sort(peaks.begin(), peaks.end(),
-            [](const freq_peak_i16_t & a, const freq_peak_i16_t & b) -> bool
-        {
-            return a.amplitude > b.amplitude;
-        });
-
-        // fill with zeros at the end (if needed)
-        for (size_t ix = peaks.size(); ix < output_matrix->rows; ix++) {
-            freq_peak_i16_t d;
-            d.freq = 0;
-            d.amplitude = 0;
-            peaks.push_back(d);
-        }
-
-        for (size_t row = 0; row < output_matrix->rows; row++) {
-            // col 0 is freq, col 1 is ampl
-            output_matrix->buffer[row * output_matrix->cols + 0] = (peaks[row].freq);
-            output_matrix->buffer[row * output_matrix->cols + 1] = (peaks[row].amplitude);
-        }
-
-        return EIDSP_OK;
+        // @todo: something somewhere does not go OK... and these numbers are dependent on
+        // the FFT length I think... But they are an OK approximation for now.
+        return find_top_fft_peaks(fft_matrix, output_matrix, output_matrix->rows * 4, i16_threshold,
+            [number, stop_point, step](size_t ix) -> EIDSP_i16 {
+                if (ix + 1 < number) {
+                    return 0 + static_cast<uint32_t>(ix) * step;
+                }
+                return ix + 1 == number && number > 1 ? stop_point : 0;
+            });
     }
 
-
     static int find_fft_peaks(
         matrix_i32_t *fft_matrix,
         matrix_i32_t *output_matrix,
@@ -516,16 +518,6 @@ namespace processing {
         float threshold,
         uint16_t fft_length)
     {
-        if (fft_matrix->rows != 1) {
-            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
-        }
-
-        if (output_matrix->cols != 2) {
-            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
-        }
-
-        int ret;
-
         int N = static_cast<int>(fft_length);
         float T = 1.0f / sampling_freq;
 
@@ -533,60 +525,26 @@ namespace processing {
         float stop = (((1.0f / (2.0f * T)))/N);
         numpy::float_to_int32(&stop, &stop_point, 1);
 
-        EI_DSP_i32_MATRIX(freq_space, 1, fft_matrix->cols);
-        ret = numpy::linspace(0, stop_point, (N >> 1), freq_space.buffer);
-        if (ret != EIDSP_OK) {
-            EIDSP_ERR(ret);
-        }
-
-        EI_DSP_i32_MATRIX(peaks_matrix, output_matrix->rows * 4, 1);
-
-        uint16_t peak_count;
-        ret = find_peak_indexes(fft_matrix, &peaks_matrix, 0, &peak_count);
-        if (ret != EIDSP_OK) {
-            EIDSP_ERR(ret);
+        // bin frequencies, like numpy::linspace(0, stop_point, (N >> 1))
+        const uint32_t number = N >> 1;
+        if (number < 1) {
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
         }
+        const EIDSP_i32 step = number > 1 ? (stop_point - 0) / (number - 1) : 0;
 
         EIDSP_i32 i32_threshold;
         threshold /= fft_length;
         numpy::float_to_int32(&threshold, &i32_threshold, 1);
 
-        // turn this into C++ vector and sort it based on amplitude
-        std::vector<freq_peak_i32_t> peaks;
-        for (uint8_t ix = 0; ix < peak_count; ix++) {
-            freq_peak_i32_t d;
-            // @todo: something somewhere does not go OK... and these numbers are dependent on
-            // the FFT length I think... But they are an OK approximation for now.
-            d.freq = freq_space.buffer[static_cast<uint32_t>(peaks_matrix.buffer[ix])];
-            d.amplitude = fft_matrix->buffer[peaks_matrix.buffer[ix]];
-
-            if (d.amplitude < i32_threshold) {
-                d.freq = 0.0f;
-                d.amplitude = 0.0f;
-            }
-            peaks.push_back(d);
-        }
-        sort(peaks.begin(), peaks.end(),
-            [](const freq_peak_i32_t & a, const freq_peak_i32_t & b) -> bool
-        {
-            return a.amplitude > b.amplitude;
-        });
-
-        // fill with zeros at the end (if needed)
-        for (size_t ix = peaks.size(); ix < output_matrix->rows; ix++) {
-            freq_peak_i32_t d;
-            d.freq = 0;
-            d.amplitude = 0;
-            peaks.push_back(d);
-        }
-
-        for (size_t row = 0; row < output_matrix->rows; row++) {
-            // col 0 is freq, col 1 is ampl
-            output_matrix->buffer[row * output_matrix->cols + 0] = (peaks[row].freq);
-            output_matrix->buffer[row * output_matrix->cols + 1] = (peaks[row].amplitude);
-        }
-
-        return EIDSP_OK;
+        // @todo: something somewhere does not go OK... and these numbers are dependent on
+        // the FFT length I think... But they are an OK approximation for now.
+        return find_top_fft_peaks(fft_matrix, output_matrix, output_matrix->rows * 4, i32_threshold,
+            [number, stop_point, step](size_t ix) -> EIDSP_i32 {
+                if (ix + 1 < number) {
+                    return 0 + static_cast<uint32_t>(ix) * step;
+                }
+                return ix + 1 == number && number > 1 ? stop_point : 0;
+            });
     }
 
     /**
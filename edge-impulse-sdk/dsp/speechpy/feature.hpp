@@ -29,9 +29,81 @@
 #include "processing.hpp"
 #include "../memory.hpp"
 
+#ifndef M_PI
+#define M_PI 3.14159265358979323846264338327950288
+#endif // M_PI
+
 namespace ei {
 namespace speechpy {
 
+/**
+ * Everything the fixed point MFCC (`feature::mfcc` on an int16 signal) needs that only
+ * depends on the configuration of the block: the sparse q15 filterbank, the q15 DCT table
+ * and the q15 FFT plan. Build it once per configuration (and sampling frequency) and reuse
+ * it for every window. The FFT plan makes a plan usable by one thread at a time.
+ */
+class mfcc_i16_plan {
+public:
+    mfcc_i16_plan() : sampling_frequency(0), num_cepstral(0), num_filters(0), fft_length(0), tables(NULL) {
+        memset(&fft_plan, 0, sizeof(fft_plan));
+    }
+
+    ~mfcc_i16_plan() {
+        release();
+    }
+
+    mfcc_i16_plan(const mfcc_i16_plan&) = delete;
+    mfcc_i16_plan& operator=(const mfcc_i16_plan&) = delete;
+
+    /**
+     * @brief Set up the plan
+     * @param sampling_frequency Sampling frequency of the signal
+     * @param num_cepstral Number of cepstral coefficients
+     * @param num_filters Number of filters in the filterbank
+     * @param fft_length Number of FFT points
+     * @param low_frequency Lowest band edge of mel filters in Hz, 0 for 300 Hz
+     * @param high_frequency Highest band edge of mel filters in Hz, 0 for samplerate/2
+     * @returns 0 if OK
+     */
+    int init(uint32_t sampling_frequency, uint8_t num_cepstral, uint16_t num_filters,
+        uint16_t fft_length, uint32_t low_frequency, uint32_t high_frequency);
+
+    uint32_t get_sampling_frequency() const {
+        return sampling_frequency;
+    }
+
+    uint8_t get_num_cepstral() const {
+        return num_cepstral;
+    }
+
+private:
+    friend class feature;
+
+    void release() {
+        if (tables) {
+            ei_free(tables);
+            tables = NULL;
+        }
+        fft::plan_free(&fft_plan);
+        num_cepstral = 0;
+        num_filters = 0;
+    }
+
+    uint32_t sampling_frequency;
+    uint8_t num_cepstral;
+    uint16_t num_filters;
+    uint16_t fft_length;
+    // one allocation for the three tables below
+    EIDSP_i32 *tables;
+    // first bin and number of bins of every filter (num_filters x 2)
+    EIDSP_i32 *filter_bins;
+    // q15 weights of all filters after each other
+    EIDSP_i32 *filter_weights;
+    // q15 DCT type 2 (ortho), num_cepstral x num_filters
+    EIDSP_i16 *dct_table;
+    fft::plan_t fft_plan;
+};
+
 class feature {
 public:
     /**
@@ -187,6 +259,8 @@ public:
      *     In Hz, default is 0.
      * @param high_frequency (int): highest band edge of mel filters.
      *     In Hz, default is samplerate/2
+     * @param cached_spectra Power spectra of the signal from `power_spectra` with the
+     *     same framing parameters, or NULL to frame and FFT the signal here
      * @EIDSP_OK if OK
      */
     static int mfe(matrix_t *out_features, matrix_t *out_energies,
@@ -194,7 +268,8 @@ public:
         uint32_t sampling_frequency,
         float frame_length, float frame_stride, uint16_t num_filters,
         uint16_t fft_length, uint32_t low_frequency, uint32_t high_frequency,
-        uint16_t version
+        uint16_t version,
+        const matrix_t *cached_spectra = NULL
         )
     {
         int ret = 0;
@@ -207,22 +282,34 @@ public:
             low_frequency = 300;
         }
 
+        uint16_t coefficients = fft_length / 2 + 1;
+
         stack_frames_info_t stack_frame_info = { 0 };
         stack_frame_info.signal = signal;
 
-        ret = processing::stack_frames(
-            &stack_frame_info,
-            sampling_frequency,
-            frame_length,
-            frame_stride,
-            false,
-            version
-        );
-        if (ret != 0) {
-            EIDSP_ERR(ret);
+        size_t frame_count;
+        if (cached_spectra) {
+            if (cached_spectra->cols != coefficients) {
+                EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+            }
+            frame_count = cached_spectra->rows;
+        }
+        else {
+            ret = processing::stack_frames(
+                &stack_frame_info,
+                sampling_frequency,
+                frame_length,
+                frame_stride,
+                false,
+                version
+            );
+            if (ret != 0) {
+                EIDSP_ERR(ret);
+            }
+            frame_count = stack_frame_info.frame_ixs->size();
         }
 
-        if (stack_frame_info.frame_ixs->size() != out_features->rows) {
+        if (frame_count != out_features->rows) {
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
         }
 
@@ -230,7 +317,7 @@ public:
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
         }
 
-        if (stack_frame_info.frame_ixs->size() != out_energies->rows || out_energies->cols != 1) {
+        if (frame_count != out_energies->rows || out_energies->cols != 1) {
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
         }
 
@@ -238,8 +325,6 @@ public:
             *(out_features->buffer + i) = 0;
         }
 
-        uint16_t coefficients = fft_length / 2 + 1;
-
         // calculate the filterbanks first... preferably I would want to do the matrix multiplications
         // whenever they happen, but OK...
 #if EIDSP_QUANTIZE_FILTERBANK
@@ -256,47 +341,45 @@ public:
         if (ret != 0) {
             EIDSP_ERR(ret);
         }
-        for (size_t ix = 0; ix < stack_frame_info.frame_ixs->size(); ix++) {
-            size_t power_spectrum_frame_size = (fft_length / 2 + 1);
 
-            EI_DSP_MATRIX(power_spectrum_frame, 1, power_spectrum_frame_size);
-            if (!power_spectrum_frame.buffer) {
-                EIDSP_ERR(EIDSP_OUT_OF_MEM);
-            }
+#if EIDSP_QUANTIZE_FILTERBANK
+        // the non-zero bins of every filter, so the dot products below skip the rest
+        EI_DSP_i32_MATRIX(filter_bins, num_filters, 2);
+        ret = numpy::filterbank_bins(&filterbanks, &filter_bins);
+        if (ret != 0) {
+            EIDSP_ERR(ret);
+        }
+#endif
 
-            // get signal data from the audio file
-            EI_DSP_MATRIX(signal_frame, 1, stack_frame_info.frame_length);
+        size_t power_spectrum_frame_size = coefficients;
 
-            // don't read outside of the audio buffer... we'll automatically zero pad then
-            size_t signal_offset = stack_frame_info.frame_ixs->at(ix);
-            size_t signal_length = stack_frame_info.frame_length;
-            if (signal_offset + signal_length > stack_frame_info.signal->total_length) {
-                signal_length = signal_length -
-                    (stack_frame_info.signal->total_length - (signal_offset + signal_length));
-            }
-
-            ret = stack_frame_info.signal->get_data(
-                signal_offset,
-                signal_length,
-                signal_frame.buffer
-            );
-            if (ret != 0) {
-                EIDSP_ERR(ret);
-            }
+        const size_t block_frames = cached_spectra ? 1 : EIDSP_FFT_BATCH_FRAMES;
+        EI_DSP_MATRIX(power_spectrum_block, block_frames, power_spectrum_frame_size);
+        if (!power_spectrum_block.buffer) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
 
-            ret = processing::power_spectrum(
-                signal_frame.buffer,
-                stack_frame_info.frame_length,
-                power_spectrum_frame.buffer,
-                power_spectrum_frame_size,
-                fft_length
-            );
+        for (size_t ix = 0; ix < frame_count; ix++) {
+            float *power_spectrum;
 
-            if (ret != 0) {
-                EIDSP_ERR(ret);
+            if (cached_spectra) {
+                power_spectrum = cached_spectra->buffer + (ix * coefficients);
+            }
+            else {
+                // the frames are read and transformed a block at a time
+                size_t block_ix = ix % block_frames;
+                if (block_ix == 0) {
+                    size_t frames = frame_count - ix < block_frames ? frame_count - ix : block_frames;
+                    ret = frames_power_spectra(&stack_frame_info, ix, frames,
+                        power_spectrum_block.buffer, fft_length);
+                    if (ret != 0) {
+                        EIDSP_ERR(ret);
+                    }
+                }
+                power_spectrum = power_spectrum_block.buffer + (block_ix * coefficients);
             }
 
-            float energy = numpy::sum(power_spectrum_frame.buffer, power_spectrum_frame_size);
+            float energy = numpy::sum(power_spectrum, power_spectrum_frame_size);
             if (energy == 0) {
                 energy = FLT_EPSILON;
             }
@@ -306,9 +389,12 @@ public:
             // calculate the out_features directly here
             ret = numpy::dot_by_row(
                 ix,
-                power_spectrum_frame.buffer,
+                power_spectrum,
                 power_spectrum_frame_size,
                 &filterbanks,
+#if EIDSP_QUANTIZE_FILTERBANK
+                &filter_bins,
+#endif
                 out_features
             );
 
@@ -323,19 +409,19 @@ public:
     }
 
     /**
-     * Compute spectrogram from a sensor signal.
-     * @param out_features Use `calculate_mfe_buffer_size` to allocate the right matrix.
+     * Frame the signal and calculate the power spectrum of every frame, this is the
+     * part that MFCC, MFE and spectrogram blocks with the same framing parameters share.
+     * @param out_spectra Use `calculate_mfe_buffer_size` with `fft_length / 2 + 1` filters
+     *     to allocate the right matrix.
      * @param signal: audio signal structure with functions to retrieve data from a signal
      * @param sampling_frequency (int): the sampling frequency of the signal
      *     we are working with.
      * @param frame_length (float): the length of each frame in seconds.
-     *     Default is 0.020s
      * @param frame_stride (float): the step between successive frames in seconds.
-     *     Default is 0.02s (means no overlap)
-     * @param fft_length (int): number of FFT points. Default is 512.
+     * @param fft_length (int): number of FFT points.
      * @EIDSP_OK if OK
      */
-    static int spectrogram(matrix_t *out_features,
+    static int power_spectra(matrix_t *out_spectra,
         signal_t *signal, uint32_t sampling_frequency,
         float frame_length, float frame_stride, uint16_t fft_length,
         uint16_t version
@@ -358,49 +444,61 @@ public:
             EIDSP_ERR(ret);
         }
 
-        if (stack_frame_info.frame_ixs->size() != out_features->rows) {
+        if (stack_frame_info.frame_ixs->size() != out_spectra->rows) {
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
         }
 
         uint16_t coefficients = fft_length / 2 + 1;
 
-        if (coefficients != out_features->cols) {
+        if (coefficients != out_spectra->cols) {
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
         }
 
-        for (uint32_t i = 0; i < out_features->rows * out_features->cols; i++) {
-            *(out_features->buffer + i) = 0;
-        }
-
-        for (size_t ix = 0; ix < stack_frame_info.frame_ixs->size(); ix++) {
-            // get signal data from the audio file
-            EI_DSP_MATRIX(signal_frame, 1, stack_frame_info.frame_length);
-
-            // don't read outside of the audio buffer... we'll automatically zero pad then
-            size_t signal_offset = stack_frame_info.frame_ixs->at(ix);
-            size_t signal_length = stack_frame_info.frame_length;
-            if (signal_offset + signal_length > stack_frame_info.signal->total_length) {
-                signal_length = signal_length -
-                    (stack_frame_info.signal->total_length - (signal_offset + signal_length));
-            }
-
-            ret = stack_frame_info.signal->get_data(
-                signal_offset,
-                signal_length,
-                signal_frame.buffer
-            );
+        const size_t frame_count = stack_frame_info.frame_ixs->size();
+        for (size_t ix = 0; ix < frame_count; ix += EIDSP_FFT_BATCH_FRAMES) {
+            size_t frames = frame_count - ix < EIDSP_FFT_BATCH_FRAMES ? frame_count - ix : EIDSP_FFT_BATCH_FRAMES;
+            ret = frames_power_spectra(&stack_frame_info, ix, frames,
+                out_spectra->buffer + (ix * coefficients), fft_length);
             if (ret != 0) {
                 EIDSP_ERR(ret);
             }
+        }
 
-            ret = processing::power_spectrum(
-                signal_frame.buffer,
-                stack_frame_info.frame_length,
-                out_features->buffer + (ix * coefficients),
-                coefficients,
-                fft_length
-            );
+        return EIDSP_OK;
+    }
 
+    /**
+     * Compute spectrogram from a sensor signal.
+     * @param out_features Use `calculate_mfe_buffer_size` to allocate the right matrix.
+     * @param signal: audio signal structure with functions to retrieve data from a signal
+     * @param sampling_frequency (int): the sampling frequency of the signal
+     *     we are working with.
+     * @param frame_length (float): the length of each frame in seconds.
+     *     Default is 0.020s
+     * @param frame_stride (float): the step between successive frames in seconds.
+     *     Default is 0.02s (means no overlap)
+     * @param fft_length (int): number of FFT points. Default is 512.
+     * @param cached_spectra Power spectra of the signal from `power_spectra` with the
+     *     same framing parameters, or NULL to frame and FFT the signal here
+     * @EIDSP_OK if OK
+     */
+    static int spectrogram(matrix_t *out_features,
+        signal_t *signal, uint32_t sampling_frequency,
+        float frame_length, float frame_stride, uint16_t fft_length,
+        uint16_t version,
+        const matrix_t *cached_spectra = NULL
+        )
+    {
+        if (cached_spectra) {
+            if (cached_spectra->rows != out_features->rows || cached_spectra->cols != out_features->cols) {
+                EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+            }
+            memcpy(out_features->buffer, cached_spectra->buffer,
+                out_features->rows * out_features->cols * sizeof(float));
+        }
+        else {
+            int ret = power_spectra(out_features, signal, sampling_frequency,
+                frame_length, frame_stride, fft_length, version);
             if (ret != 0) {
                 EIDSP_ERR(ret);
             }
@@ -461,13 +559,15 @@ public:
      *     In Hz, default is samplerate/2
      * @param dc_elimination Whether the first dc component should
      *     be eliminated or not.
+     * @param cached_spectra Power spectra of the signal from `power_spectra` with the
+     *     same framing parameters, or NULL to frame and FFT the signal here
      * @returns 0 if OK
      */
     static int mfcc(matrix_t *out_features, signal_t *signal,
         uint32_t sampling_frequency, float frame_length, float frame_stride,
         uint8_t num_cepstral, uint16_t num_filters, uint16_t fft_length,
         uint32_t low_frequency, uint32_t high_frequency, bool dc_elimination,
-        uint16_t version)
+        uint16_t version, const matrix_t *cached_spectra = NULL)
     {
         if (out_features->cols != num_cepstral) {
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
@@ -501,17 +601,14 @@ public:
 
         ret = mfe(&features_matrix, &energy_matrix, signal,
             sampling_frequency, frame_length, frame_stride, num_filters, fft_length,
-            low_frequency, high_frequency, version);
+            low_frequency, high_frequency, version, cached_spectra);
         if (ret != EIDSP_OK) {
             EIDSP_ERR(ret);
         }
 
         // ok... now we need to calculate the MFCC from this...
         // first do log() over all features...
-        ret = numpy::log(&features_matrix);
-        if (ret != EIDSP_OK) {
-            EIDSP_ERR(ret);
-        }
+        functions::log(features_matrix.buffer, features_matrix.rows * features_matrix.cols);
 
         // now do DST type 2
         ret = numpy::dct2(&features_matrix, DCT_NORMALIZATION_ORTHO);
@@ -522,7 +619,7 @@ public:
         // replace first cepstral coefficient with log of frame energy for DC elimination
         if (dc_elimination) {
             for (size_t row = 0; row < features_matrix.rows; row++) {
-                features_matrix.buffer[row * features_matrix.cols] = numpy::log(energy_matrix.buffer[row]);
+                features_matrix.buffer[row * features_matrix.cols] = functions::log(energy_matrix.buffer[row]);
             }
         }
 
@@ -536,6 +633,121 @@ public:
         return EIDSP_OK;
     }
 
+    /**
+     * Compute MFCC features from an int16 audio signal, in fixed point. The int16
+     * counterpart of `mfcc` on a preemphasized signal:
+     *  - preemphasis on the int16 samples, the history wraps around to the end
+     *    of the signal like `processing::preemphasis`,
+     *  - every frame is normalized to the full q15 range (block floating point)
+     *    before the q15 FFT, the exponent is added back after the log,
+     *  - the mel energies of the power spectrum are accumulated in 64 bits with
+     *    q15 filter weights (only the bins a filter covers),
+     *  - log through `numpy::log2_q16`, DCT type 2 (ortho) with a q15 cosine table.
+     * This overload sets up a temporary `mfcc_i16_plan` (filterbank, DCT table and FFT,
+     * built with floating point math) on every call. To build them once, keep a plan
+     * for the block and use the overload below.
+     * @param out_features q15 output, use `calculate_mfcc_buffer_size` to allocate the right matrix.
+     * @param signal: int16 audio signal (q15), e.g. straight from the microphone
+     * @param sampling_frequency (int): the sampling frequency of the signal
+     *     we are working with.
+     * @param frame_length (float): the length of each frame in seconds.
+     * @param frame_stride (float): the step between successive frames in seconds.
+     * @param num_cepstral (int): Number of cepstral coefficients.
+     * @param num_filters (int): the number of filters in the filterbank.
+     * @param fft_length (int): number of FFT points.
+     * @param low_frequency (int): lowest band edge of mel filters.
+     *     In Hz, default is 0.
+     * @param high_frequency (int): highest band edge of mel filters.
+     *     In Hz, default is samplerate/2
+     * @param dc_elimination Whether the first dc component should
+     *     be eliminated or not.
+     * @param pre_shift (int): The preemphasis shift step.
+     * @param pre_cof (float): The preemphasis coefficient. 0 equals to no filtering.
+     * @returns 0 if OK
+     */
+    static int mfcc(matrix_i32_t *out_features, signal_i16_t *signal,
+        uint32_t sampling_frequency, float frame_length, float frame_stride,
+        uint8_t num_cepstral, uint16_t num_filters, uint16_t fft_length,
+        uint32_t low_frequency, uint32_t high_frequency, bool dc_elimination,
+        uint16_t version, int pre_shift, float pre_cof)
+    {
+        if (out_features->cols != num_cepstral || num_cepstral > num_filters) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        mfcc_i16_plan plan;
+        int ret = plan.init(sampling_frequency, num_cepstral, num_filters, fft_length,
+            low_frequency, high_frequency);
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(ret);
+        }
+
+        return mfcc(out_features, signal, &plan, frame_length, frame_stride,
+            dc_elimination, version, pre_shift, pre_cof);
+    }
+
+    /**
+     * Compute MFCC features from an int16 audio signal, in fixed point, with the
+     * filterbank, DCT table and FFT plan of `plan` (see `mfcc` above).
+     * @param out_features q15 output, use `calculate_mfcc_buffer_size` to allocate the right matrix.
+     * @param signal: int16 audio signal (q15), e.g. straight from the microphone
+     * @param plan Plan for the sampling frequency and the MFCC parameters of the block
+     * @param frame_length (float): the length of each frame in seconds.
+     * @param frame_stride (float): the step between successive frames in seconds.
+     * @param dc_elimination Whether the first dc component should
+     *     be eliminated or not.
+     * @param pre_shift (int): The preemphasis shift step.
+     * @param pre_cof (float): The preemphasis coefficient. 0 equals to no filtering.
+     * @returns 0 if OK
+     */
+    static int mfcc(matrix_i32_t *out_features, signal_i16_t *signal,
+        const mfcc_i16_plan *plan, float frame_length, float frame_stride,
+        bool dc_elimination, uint16_t version, int pre_shift, float pre_cof)
+    {
+        if (!plan->tables) {
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+        }
+
+        if (out_features->cols != plan->num_cepstral) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        const uint32_t sampling_frequency = plan->sampling_frequency;
+
+        int32_t frame_count = processing::calculate_no_of_stack_frames(
+            signal->total_length, sampling_frequency, frame_length, frame_stride, false, version);
+        if (frame_count <= 0 || out_features->rows != static_cast<uint32_t>(frame_count)) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        // framing like processing::stack_frames
+        size_t frame_sample_length;
+        size_t frame_stride_samples;
+        if (version == 1) {
+            frame_sample_length = static_cast<size_t>(round(static_cast<float>(sampling_frequency) * frame_length));
+            frame_stride_samples = static_cast<size_t>(round(static_cast<float>(sampling_frequency) * frame_stride));
+        }
+        else {
+            frame_sample_length = static_cast<size_t>(ceil(static_cast<float>(sampling_frequency) * frame_length));
+            frame_stride_samples = static_cast<size_t>(ceil(static_cast<float>(sampling_frequency) * frame_stride));
+        }
+
+        // the FFT only sees the start of a frame
+        const size_t frame_read_length = frame_sample_length < plan->fft_length ? frame_sample_length : plan->fft_length;
+
+        if (pre_shift < 1 || static_cast<size_t>(pre_shift) > signal->total_length) {
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+        }
+
+        int ret = mfcc_frames_i16(out_features, signal, frame_stride_samples, frame_read_length,
+            plan, dc_elimination, pre_shift, pre_cof);
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(ret);
+        }
+
+        return EIDSP_OK;
+    }
+
     /**
      * Calculate the buffer size for MFCC
      * @param signal_length: Length of the signal.
@@ -564,8 +776,312 @@ public:
         size_matrix.cols = cols;
         return size_matrix;
     }
+
+private:
+    friend class mfcc_i16_plan;
+
+    /**
+     * Read a block of frames of a stacked signal (zero padded past the end of the signal)
+     * and calculate their power spectra in one batch.
+     * @param info Framing of the signal, from `processing::stack_frames`
+     * @param first_frame Index of the first frame
+     * @param frame_count Number of frames
+     * @param out_power_spectra Output buffer of frame_count x `fft_length / 2 + 1` elements
+     * @param fft_length (int): number of FFT points.
+     * @EIDSP_OK if OK
+     */
+    static int frames_power_spectra(stack_frames_info_t *info, size_t first_frame, size_t frame_count,
+        float *out_power_spectra, uint16_t fft_length)
+    {
+        // get signal data from the audio file
+        EI_DSP_MATRIX(signal_frames, frame_count, info->frame_length);
+
+        for (size_t ix = 0; ix < frame_count; ix++) {
+            // don't read outside of the audio buffer... we'll automatically zero pad then
+            size_t signal_offset = info->frame_ixs->at(first_frame + ix);
+            size_t signal_length = info->frame_length;
+            if (signal_offset + signal_length > info->signal->total_length) {
+                signal_length = signal_length -
+                    (info->signal->total_length - (signal_offset + signal_length));
+            }
+
+            int ret = info->signal->get_data(
+                signal_offset,
+                signal_length,
+                signal_frames.buffer + (ix * info->frame_length)
+            );
+            if (ret != 0) {
+                EIDSP_ERR(ret);
+            }
+        }
+
+        int ret = processing::power_spectrum_frames(
+            signal_frames.buffer,
+            frame_count,
+            info->frame_length,
+            out_power_spectra,
+            fft_length / 2 + 1,
+            fft_length
+        );
+        if (ret != 0) {
+            EIDSP_ERR(ret);
+        }
+
+        return EIDSP_OK;
+    }
+
+    /**
+     * Build the mel filterbank (see `filterbanks`) in sparse q15 form for the fixed point MFCC
+     * @param filter_bins Matrix of num_filters x 2, first bin and number of bins of every filter
+     * @param filter_weights Weights of all filters after each other, q15
+     * @EIDSP_OK if OK
+     */
+    static int filterbanks_q15(matrix_i32_t *filter_bins, matrix_i32_t *filter_weights,
+        uint16_t num_filters, uint16_t coefficients, uint32_t sampling_frequency,
+        uint32_t low_frequency, uint32_t high_frequency)
+    {
+#if EIDSP_QUANTIZE_FILTERBANK
+        EI_DSP_QUANTIZED_MATRIX(filterbanks, num_filters, coefficients, &numpy::dequantize_zero_one);
+#else
+        EI_DSP_MATRIX(filterbanks, num_filters, coefficients);
+#endif
+
+        int ret = feature::filterbanks(
+            &filterbanks, num_filters, coefficients, sampling_frequency, low_frequency, high_frequency);
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(ret);
+        }
+
+        size_t weight_ix = 0;
+        for (size_t filter_ix = 0; filter_ix < num_filters; filter_ix++) {
+            int32_t first = -1;
+            int32_t last = -1;
+            for (size_t ix = 0; ix < coefficients; ix++) {
+                if (filterbanks.buffer[filter_ix * coefficients + ix] != 0) {
+                    if (first < 0) {
+                        first = ix;
+                    }
+                    last = ix;
+                }
+            }
+
+            filter_bins->buffer[filter_ix * 2] = first < 0 ? 0 : first;
+            filter_bins->buffer[filter_ix * 2 + 1] = first < 0 ? 0 : last - first + 1;
+
+            for (int32_t ix = first; first >= 0 && ix <= last; ix++) {
+                if (weight_ix >= filter_weights->cols) {
+                    EIDSP_ERR(EIDSP_BUFFER_SIZE_MISMATCH);
+                }
+#if EIDSP_QUANTIZE_FILTERBANK
+                float weight = numpy::dequantize_zero_one(filterbanks.buffer[filter_ix * coefficients + ix]);
+#else
+                float weight = filterbanks.buffer[filter_ix * coefficients + ix];
+#endif
+                filter_weights->buffer[weight_ix++] = static_cast<EIDSP_i32>(round(weight * 32768.0f));
+            }
+        }
+
+        return EIDSP_OK;
+    }
+
+    /**
+     * Frame loop of the fixed point MFCC, see `mfcc` (int16 signal)
+     */
+    static int mfcc_frames_i16(matrix_i32_t *out_features, signal_i16_t *signal,
+        size_t frame_stride, size_t frame_read_length, const mfcc_i16_plan *plan,
+        bool dc_elimination, int pre_shift, float pre_cof)
+    {
+        const size_t fft_length = plan->fft_length;
+        const size_t coefficients = fft_length / 2 + 1;
+        const size_t num_filters = plan->num_filters;
+        const size_t num_cepstral = out_features->cols;
+        const size_t shift = static_cast<size_t>(pre_shift);
+        const int32_t pre_cof_q15 = static_cast<int32_t>(round(pre_cof * 32768.0f));
+
+        // log2(FLT_EPSILON), the float version replaces zero energies by FLT_EPSILON
+        const int32_t log2_epsilon_q16 = -23 * 65536;
+        // ln(2) in q30
+        const int64_t ln2_q30 = 744261118;
+
+        // preemphasis history followed by the frame
+        EI_DSP_i16_MATRIX(samples, 1, shift + frame_read_length);
+        EI_DSP_i32_MATRIX(preemphasized, 1, frame_read_length);
+        EI_DSP_i16_MATRIX(fft_input, 1, fft_length);
+        EI_DSP_i16_MATRIX(fft_output, 1, coefficients * 2);
+        EI_DSP_i32_MATRIX(power_spectrum_matrix, 1, coefficients);
+        EI_DSP_i32_MATRIX(log_mel, 1, num_filters);
+
+        uint32_t *power_spectrum = (uint32_t*)power_spectrum_matrix.buffer;
+        const int32_t log2_fft_length_q16 = numpy::log2_q16(fft_length);
+
+        memset(fft_input.buffer, 0, fft_length * sizeof(EIDSP_i16));
+
+        for (size_t frame_ix = 0; frame_ix < out_features->rows; frame_ix++) {
+            const size_t offset = frame_ix * frame_stride;
+
+            // the samples before the first frame wrap around to the end of the signal
+            int ret;
+            if (offset >= shift) {
+                ret = signal->get_data(offset - shift, shift + frame_read_length, samples.buffer);
+            }
+            else {
+                ret = signal->get_data(signal->total_length - (shift - offset), shift - offset, samples.buffer);
+                if (ret == 0) {
+                    ret = signal->get_data(0, offset + frame_read_length, samples.buffer + (shift - offset));
+                }
+            }
+            if (ret != 0) {
+                EIDSP_ERR(ret);
+            }
+
+            // preemphasis in q30, exact (the result uses up to 31 bits)
+            int32_t max_abs = 0;
+            for (size_t ix = 0; ix < frame_read_length; ix++) {
+                int32_t y = (samples.buffer[shift + ix] * 32768) - (pre_cof_q15 * samples.buffer[ix]);
+                preemphasized.buffer[ix] = y;
+                int32_t a = y < 0 ? -y : y;
+                if (a > max_abs) {
+                    max_abs = a;
+                }
+            }
+
+            // normalize the frame to the q15 range (block floating point), the FFT input
+            // is the preemphasized signal * 2^exponent
+            int32_t right_shift = 0;
+            while ((max_abs >> right_shift) > 32767) {
+                right_shift++;
+            }
+            const int32_t exponent = 15 - right_shift;
+            for (size_t ix = 0; ix < frame_read_length; ix++) {
+                int32_t y = right_shift == 0 ?
+                    preemphasized.buffer[ix] :
+                    (int32_t)(((int64_t)preemphasized.buffer[ix] + (1 << (right_shift - 1))) >> right_shift);
+                fft_input.buffer[ix] = (EIDSP_i16)(y > 32767 ? 32767 : y);
+            }
+
+            // q15 output = DFT / fft_length
+            ret = fft::rfft(&plan->fft_plan, fft_input.buffer, (fft_complex_i16_t*)fft_output.buffer);
+            if (ret != EIDSP_OK) {
+                EIDSP_ERR(ret);
+            }
+
+            uint64_t energy = 0;
+            for (size_t ix = 0; ix < coefficients; ix++) {
+                int32_t re = fft_output.buffer[ix * 2];
+                int32_t im = fft_output.buffer[ix * 2 + 1];
+                power_spectrum[ix] = (uint32_t)(re * re) + (uint32_t)(im * im);
+                energy += power_spectrum[ix];
+            }
+
+            // the float power spectrum is |X|^2 * fft_length / 2^(30 + 2 * exponent),
+            // the filter weights add another 2^15
+            const int32_t log2_scale_q16 = log2_fft_length_q16 - ((30 + 2 * exponent) << 16);
+
+            const EIDSP_i32 *weights = plan->filter_weights;
+            for (size_t filter_ix = 0; filter_ix < num_filters; filter_ix++) {
+                const size_t first = plan->filter_bins[filter_ix * 2];
+                const size_t bins = plan->filter_bins[filter_ix * 2 + 1];
+                uint64_t mel = 0;
+                for (size_t ix = 0; ix < bins; ix++) {
+                    mel += (uint64_t)power_spectrum[first + ix] * (uint32_t)weights[ix];
+                }
+                weights += bins;
+
+                int32_t log2_mel = mel == 0 ?
+                    log2_epsilon_q16 :
+                    numpy::log2_q16(mel) + log2_scale_q16 - (15 << 16);
+                log_mel.buffer[filter_ix] = (EIDSP_i32)(((int64_t)log2_mel * ln2_q30 + (1 << 29)) >> 30);
+            }
+
+            // DCT, q16 log * q15 cosine >> 16 = q15
+            EIDSP_i32 *out = out_features->buffer + (frame_ix * num_cepstral);
+            for (size_t k = dc_elimination ? 1 : 0; k < num_cepstral; k++) {
+                const EIDSP_i16 *c = plan->dct_table + (k * num_filters);
+                int64_t acc = 0;
+                for (size_t n = 0; n < num_filters; n++) {
+                    acc += (int64_t)log_mel.buffer[n] * c[n];
+                }
+                out[k] = (EIDSP_i32)((acc + (1 << 15)) >> 16);
+            }
+
+            // replace first cepstral coefficient with log of frame energy for DC elimination
+            if (dc_elimination) {
+                int32_t log2_energy = energy == 0 ?
+                    log2_epsilon_q16 :
+                    numpy::log2_q16(energy) + log2_scale_q16;
+                int64_t log_energy_q16 = ((int64_t)log2_energy * ln2_q30 + (1 << 29)) >> 30;
+                out[0] = (EIDSP_i32)((log_energy_q16 + 1) >> 1);
+            }
+        }
+
+        return EIDSP_OK;
+    }
 };
 
+inline int mfcc_i16_plan::init(uint32_t sampling_frequency, uint8_t num_cepstral, uint16_t num_filters,
+    uint16_t fft_length, uint32_t low_frequency, uint32_t high_frequency)
+{
+    release();
+
+    if (num_cepstral > num_filters) {
+        EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+    }
+
+    if (high_frequency == 0) {
+        high_frequency = sampling_frequency / 2;
+    }
+
+    if (low_frequency == 0) {
+        low_frequency = 300;
+    }
+
+    const uint16_t coefficients = fft_length / 2 + 1;
+
+    // filter i spans bins freq_index[i]..freq_index[i + 2], so 2 * coefficients + num_filters
+    // weights are enough, the int16 DCT table goes in the int32s after the weights
+    const size_t weight_count = 2 * coefficients + num_filters;
+    const size_t dct_count = static_cast<size_t>(num_cepstral) * num_filters;
+    tables = (EIDSP_i32*)ei_calloc((num_filters * 2) + weight_count + ((dct_count + 1) / 2), sizeof(EIDSP_i32));
+    if (!tables) {
+        EIDSP_ERR(EIDSP_OUT_OF_MEM);
+    }
+    filter_bins = tables;
+    filter_weights = filter_bins + (num_filters * 2);
+    dct_table = (EIDSP_i16*)(filter_weights + weight_count);
+
+    matrix_i32_t filter_bins_matrix(num_filters, 2, filter_bins);
+    matrix_i32_t filter_weights_matrix(1, weight_count, filter_weights);
+    int ret = feature::filterbanks_q15(&filter_bins_matrix, &filter_weights_matrix, num_filters,
+        coefficients, sampling_frequency, low_frequency, high_frequency);
+    if (ret != EIDSP_OK) {
+        release();
+        EIDSP_ERR(ret);
+    }
+
+    // DCT type 2 with orthogonal normalization
+    for (size_t k = 0; k < num_cepstral; k++) {
+        double scale = k == 0 ? sqrt(1.0 / num_filters) : sqrt(2.0 / num_filters);
+        for (size_t n = 0; n < num_filters; n++) {
+            double c = scale * cos(M_PI * k * (2 * n + 1) / (2.0 * num_filters));
+            // c is 1.0 with a single filter, which is just outside of q15
+            dct_table[k * num_filters + n] = (EIDSP_i16)fmin(round(c * 32768.0), 32767.0);
+        }
+    }
+
+    ret = fft::plan_init(&fft_plan, fft_length, true, fft::FFT_Q15);
+    if (ret != EIDSP_OK) {
+        release();
+        EIDSP_ERR(ret);
+    }
+
+    this->sampling_frequency = sampling_frequency;
+    this->num_cepstral = num_cepstral;
+    this->num_filters = num_filters;
+    this->fft_length = fft_length;
+
+    return EIDSP_OK;
+}
+
 } // namespace speechpy
 } // namespace ei
 
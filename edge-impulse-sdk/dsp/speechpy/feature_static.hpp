@@ -0,0 +1,387 @@
+/* Edge Impulse inferencing library
+ * Copyright (c) 2021 EdgeImpulse Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef _EIDSP_SPEECHPY_FEATURE_STATIC_H_
+#define _EIDSP_SPEECHPY_FEATURE_STATIC_H_
+
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+#include "feature.hpp"
+#include "processing.hpp"
+#include "../numpy.hpp"
+#include "../kissfft/kiss_fftr.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846264338327950288
+#endif // M_PI
+
+namespace ei {
+namespace speechpy {
+
+/**
+ * Compile-time versions of the framing math in `processing::stack_frames`, so the
+ * frame size, the stride and the number of frames can be used as template arguments.
+ * All arguments are positive, so truncation stands in for floor().
+ */
+namespace static_framing {
+    constexpr int ceil_positive(float x) {
+        return static_cast<float>(static_cast<int>(x)) < x ? static_cast<int>(x) + 1 : static_cast<int>(x);
+    }
+
+    constexpr int round_positive(float x) {
+        return x - static_cast<float>(static_cast<int>(x)) >= 0.5f ? static_cast<int>(x) + 1 : static_cast<int>(x);
+    }
+
+    /**
+     * Number of samples in one frame
+     */
+    constexpr int frame_length(uint32_t sampling_frequency, float frame_length, uint16_t version) {
+        return version == 1 ?
+            round_positive(static_cast<float>(sampling_frequency) * frame_length) :
+            ceil_positive(static_cast<float>(sampling_frequency) * frame_length);
+    }
+
+    /**
+     * Number of samples between the start of two frames
+     */
+    constexpr int frame_stride(uint32_t sampling_frequency, float frame_stride, uint16_t version) {
+        return version == 1 ?
+            round_positive(static_cast<float>(sampling_frequency) * frame_stride) :
+            ceil_positive(static_cast<float>(sampling_frequency) * frame_stride);
+    }
+
+    /**
+     * Number of strides that fit in a signal after its first `reach` samples,
+     * 0 when the signal is shorter than that (or the stride is empty)
+     */
+    constexpr int strides_after(size_t signal_length, int reach, int stride) {
+        return stride <= 0 || (reach > 0 && signal_length < static_cast<size_t>(reach)) ? 0 :
+            static_cast<int>(
+                static_cast<float>(signal_length - static_cast<size_t>(reach)) /
+                static_cast<float>(stride));
+    }
+
+    /**
+     * Number of frames in a signal (without zero padding)
+     */
+    constexpr int frame_count(size_t signal_length, uint32_t sampling_frequency,
+        float frame_length, float frame_stride, uint16_t version)
+    {
+        return strides_after(signal_length,
+            version == 1 ?
+                static_framing::frame_length(sampling_frequency, frame_length, version) :
+                static_framing::frame_length(sampling_frequency, frame_length, version) -
+                    static_framing::frame_stride(sampling_frequency, frame_stride, version),
+            static_framing::frame_stride(sampling_frequency, frame_stride, version));
+    }
+} // namespace static_framing
+
+/**
+ * MFCC pipeline specialized on the framing, FFT size and filterbank of one block.
+ * Produces the same output as `feature::mfcc` (with DC elimination) on a
+ * preemphasized signal, but:
+ *  - only the samples that end up in the FFT are read and preemphasized,
+ *  - the filterbank, the FFT configurations and the DCT twiddles are built once
+ *    (on first use) and kept for the lifetime of the program,
+ *  - every frame runs from power spectrum to cepstrum on fixed-size stack buffers,
+ *    so nothing is allocated per inference and all loop bounds are constants,
+ *  - the filterbank dot product only visits the bins a filter covers.
+ *
+ * Use the `static_framing` helpers to derive the framing arguments from a block config,
+ * and check `mfcc_static_supported` before using a pipeline that is derived from a
+ * config that is not known in advance.
+ * Requires EIDSP_QUANTIZE_FILTERBANK, the tables are built with the quantized filterbank.
+ */
+template<uint32_t Frequency, size_t SignalLength, size_t FrameLength, size_t FrameStride,
+    size_t FrameCount, uint16_t FftLength, uint16_t NumFilters, uint16_t NumCepstral,
+    uint32_t LowFrequency, uint32_t HighFrequency>
+class mfcc_static {
+public:
+    static const size_t coefficients = FftLength / 2 + 1;
+    static const size_t frame_read_length = FrameLength < FftLength ? FrameLength : FftLength;
+    static const size_t dct_coefficients = NumFilters / 2 + 1;
+    static const uint32_t low_frequency = LowFrequency == 0 ? 300 : LowFrequency;
+    static const uint32_t high_frequency = HighFrequency == 0 ? Frequency / 2 : HighFrequency;
+
+    static_assert(FrameCount > 0, "signal is shorter than one frame");
+    static_assert((FrameCount - 1) * FrameStride + FrameLength <= SignalLength,
+        "frames have to lie within the signal");
+    static_assert(FftLength % 2 == 0 && NumFilters % 2 == 0,
+        "the real FFT needs an even number of points");
+    static_assert(NumCepstral > 0 && NumCepstral <= NumFilters,
+        "number of cepstral coefficients out of range");
+
+    /**
+     * Whether a preemphasis shift is supported, the shift has to fit in a
+     * frame and may not reach past the previous frame.
+     */
+    static bool supports_pre_shift(int pre_shift) {
+        return pre_shift >= 1 &&
+            static_cast<size_t>(pre_shift) <= frame_read_length &&
+            static_cast<size_t>(pre_shift) <= FrameStride;
+    }
+
+    /**
+     * Calculate the MFCC features (before cepstral normalization) of a signal
+     * @param out_features Matrix of FrameCount x NumCepstral
+     * @param signal Raw audio signal of SignalLength samples
+     * @param pre_shift Preemphasis shift, see `supports_pre_shift`
+     * @param pre_cof Preemphasis coefficient
+     * @returns EIDSP_OK if OK
+     */
+    static int mfcc(matrix_t *out_features, signal_t *signal, int pre_shift, float pre_cof)
+    {
+        const tables_t &t = tables();
+        const dispatch::kernels_t &kernels = dispatch::kernels();
+        if (t.status != EIDSP_OK) {
+            EIDSP_ERR(t.status);
+        }
+#if !EIDSP_USE_CMSIS_DSP
+        const plans_t &p = plans();
+        if (!p.fft_cfg || !p.dct_cfg) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+#endif
+
+        if (signal->total_length != SignalLength) {
+            EIDSP_ERR(EIDSP_SIGNAL_SIZE_MISMATCH);
+        }
+
+        if (out_features->rows != FrameCount || out_features->cols != NumCepstral) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        if (!supports_pre_shift(pre_shift)) {
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+        }
+
+        const size_t shift = static_cast<size_t>(pre_shift);
+
+        // preemphasis history followed by the frame, zero padded to the FFT size
+        float frame[frame_read_length + FftLength];
+        fft_complex_t fft_output[coefficients];
+        float power_spectrum[coefficients];
+        float mel[NumFilters];
+        float dct_input[NumFilters];
+        fft_complex_t dct_output[dct_coefficients];
+
+        for (size_t frame_ix = 0; frame_ix < FrameCount; frame_ix++) {
+            const size_t offset = frame_ix * FrameStride;
+
+            // the samples before the first frame wrap around to the end of the signal
+            int ret;
+            if (offset >= shift) {
+                ret = signal->get_data(offset - shift, shift + frame_read_length, frame);
+            }
+            else {
+                ret = signal->get_data(SignalLength - (shift - offset), shift - offset, frame);
+                if (ret == 0) {
+                    ret = signal->get_data(0, offset + frame_read_length, frame + (shift - offset));
+                }
+            }
+            if (ret != 0) {
+                EIDSP_ERR(ret);
+            }
+
+            // preemphasize in place, back to front so the history is read before it's overwritten
+            for (size_t ix = frame_read_length; ix-- > 0; ) {
+                frame[shift + ix] = frame[shift + ix] - (pre_cof * frame[ix]);
+            }
+            float *fft_input = frame + shift;
+            memset(fft_input + frame_read_length, 0, (FftLength - frame_read_length) * sizeof(float));
+
+#if EIDSP_USE_CMSIS_DSP
+            (void)fft_output;
+            ret = processing::power_spectrum(fft_input, frame_read_length, power_spectrum, coefficients, FftLength);
+            if (ret != EIDSP_OK) {
+                EIDSP_ERR(ret);
+            }
+#else
+            kiss_fftr(p.fft_cfg, fft_input, (kiss_fft_cpx*)fft_output);
+            kernels.power_spectrum(fft_output, power_spectrum, coefficients, FftLength);
+#endif
+
+            float energy = numpy::sum(power_spectrum, coefficients);
+            if (energy == 0) {
+                energy = FLT_EPSILON;
+            }
+
+            // log mel energies
+            for (size_t filter_ix = 0; filter_ix < NumFilters; filter_ix++) {
+                float tmp = 0.0f;
+                for (size_t ix = t.filter_start[filter_ix]; ix < t.filter_end[filter_ix]; ix++) {
+                    uint8_t u8 = t.filterbank[ix * NumFilters + filter_ix];
+                    if (u8) {
+                        tmp += power_spectrum[ix] * quantized_values_one_zero[u8];
+                    }
+                }
+                if (tmp == 0) {
+                    tmp = FLT_EPSILON;
+                }
+                mel[filter_ix] = tmp;
+            }
+            functions::log(mel, NumFilters);
+
+            // DCT type 2 through a real FFT, see ei::dct::transform
+            for (size_t ix = 0; ix < NumFilters / 2; ix++) {
+                dct_input[ix] = mel[ix * 2];
+                dct_input[NumFilters - 1 - ix] = mel[ix * 2 + 1];
+            }
+#if EIDSP_USE_CMSIS_DSP
+            ret = numpy::rfft(dct_input, NumFilters, dct_output, dct_coefficients, NumFilters);
+            if (ret != EIDSP_OK) {
+                EIDSP_ERR(ret);
+            }
+#else
+            kiss_fftr(p.dct_cfg, dct_input, (kiss_fft_cpx*)dct_output);
+#endif
+
+            // the first coefficient is replaced by the log of the frame energy (DC elimination)
+            float *out = out_features->buffer + (frame_ix * NumCepstral);
+            out[0] = functions::log(energy);
+            for (size_t ix = 1; ix < NumCepstral; ix++) {
+                float v = ix < dct_coefficients ?
+                    dct_output[ix].r * t.dct_cos[ix] + dct_output[ix].i * t.dct_sin[ix] :
+                    mel[ix];
+                out[ix] = (v * 2) * t.dct_scale;
+            }
+        }
+
+        return EIDSP_OK;
+    }
+
+private:
+    struct tables_t {
+        int status;
+        // transposed (coefficients x filters), like the filterbank in feature::mfe
+        uint8_t filterbank[coefficients * NumFilters];
+        uint16_t filter_start[NumFilters];
+        uint16_t filter_end[NumFilters];
+        float dct_cos[dct_coefficients];
+        float dct_sin[dct_coefficients];
+        float dct_scale;
+
+        tables_t() {
+            status = init();
+        }
+
+        int init() {
+            quantized_matrix_t filterbanks(NumFilters, coefficients, &numpy::dequantize_zero_one, filterbank);
+            int ret = feature::filterbanks(&filterbanks, NumFilters, coefficients, Frequency,
+                low_frequency, high_frequency, true);
+            if (ret != EIDSP_OK) {
+                return ret;
+            }
+
+            for (size_t filter_ix = 0; filter_ix < NumFilters; filter_ix++) {
+                filter_start[filter_ix] = 0;
+                filter_end[filter_ix] = 0;
+                for (size_t ix = 0; ix < coefficients; ix++) {
+                    if (filterbank[ix * NumFilters + filter_ix] == 0) {
+                        continue;
+                    }
+                    if (filter_end[filter_ix] == 0) {
+                        filter_start[filter_ix] = ix;
+                    }
+                    filter_end[filter_ix] = ix + 1;
+                }
+            }
+
+            const size_t len = NumFilters;
+            for (size_t ix = 0; ix < dct_coefficients; ix++) {
+                float temp = ix * M_PI / (len * 2);
+                dct_cos[ix] = cos(temp);
+                dct_sin[ix] = sin(temp);
+            }
+            // orthogonal normalization, the first coefficient is never used
+            dct_scale = sqrt(1.0f / static_cast<float>(2 * len));
+
+            return EIDSP_OK;
+        }
+    };
+
+    static const tables_t &tables() {
+        static tables_t t;
+        return t;
+    }
+
+#if !EIDSP_USE_CMSIS_DSP
+    // kissfft configs carry scratch buffers, so unlike the tables they can't be shared by threads
+    struct plans_t {
+        kiss_fftr_cfg fft_cfg;
+        kiss_fftr_cfg dct_cfg;
+
+        plans_t() {
+            size_t mem_length;
+            fft_cfg = kiss_fftr_alloc(FftLength, 0, NULL, NULL, &mem_length);
+            dct_cfg = kiss_fftr_alloc(NumFilters, 0, NULL, NULL, &mem_length);
+        }
+
+        ~plans_t() {
+            if (fft_cfg) {
+                kiss_fftr_free(fft_cfg);
+            }
+            if (dct_cfg) {
+                kiss_fftr_free(dct_cfg);
+            }
+        }
+    };
+
+    static const plans_t &plans() {
+#if EI_PORTING_POSIX == 1
+        // per thread, so impulses can run on several threads at once (see ei_classifier_async.h)
+        static thread_local plans_t p;
+#else
+        static plans_t p;
+#endif
+        return p;
+    }
+#endif // !EIDSP_USE_CMSIS_DSP
+};
+
+/**
+ * Whether an `mfcc_static` pipeline can be built, i.e. whether it passes the
+ * static_asserts of the class. Only looks at the template arguments, so it
+ * does not instantiate the pipeline and can pick the runtime MFCC instead.
+ */
+template<typename Pipeline>
+struct mfcc_static_supported : std::false_type { };
+
+template<uint32_t Frequency, size_t SignalLength, size_t FrameLength, size_t FrameStride,
+    size_t FrameCount, uint16_t FftLength, uint16_t NumFilters, uint16_t NumCepstral,
+    uint32_t LowFrequency, uint32_t HighFrequency>
+struct mfcc_static_supported<mfcc_static<Frequency, SignalLength, FrameLength, FrameStride,
+    FrameCount, FftLength, NumFilters, NumCepstral, LowFrequency, HighFrequency> >
+    : std::integral_constant<bool, (
+        FrameCount > 0 &&
+        (FrameCount - 1) * FrameStride + FrameLength <= SignalLength &&
+        FftLength % 2 == 0 && NumFilters % 2 == 0 &&
+        NumCepstral > 0 && NumCepstral <= NumFilters)> { };
+
+} // namespace speechpy
+} // namespace ei
+
+#endif // _EIDSP_SPEECHPY_FEATURE_STATIC_H_
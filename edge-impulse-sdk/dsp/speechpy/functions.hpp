@@ -25,6 +25,7 @@
 
 #include <math.h>
 #include "../numpy.hpp"
+#include "../fast_math.hpp"
 #include "../returntypes.hpp"
 
 namespace ei {
@@ -39,7 +40,11 @@ public:
      * @returns The mel scale values(or a single mel).
      */
     static float frequency_to_mel(float f) {
+#if EIDSP_USE_FAST_MATH == 1
+        return 1127.0 * fast_math::log(1 + f / 700.0f);
+#else
         return 1127.0 * numpy::log(1 + f / 700.0f);
+#endif
     }
 
     /**
@@ -49,7 +54,40 @@ public:
      * @returns The frequency values(or a single frequency) in Hz.
      */
     static float mel_to_frequency(float mel) {
+#if EIDSP_USE_FAST_MATH == 1
+        return 700.0f * (fast_math::exp(mel / 1127.0f) - 1.0f);
+#else
         return 700.0f * (exp(mel / 1127.0f) - 1.0f);
+#endif
+    }
+
+    /**
+     * Natural log of the (mel) energies, numpy::log or, with
+     * EIDSP_USE_FAST_MATH, fast_math::log
+     *
+     * @param a Energy, > 0
+     * @returns log(a)
+     */
+    static float log(float a) {
+#if EIDSP_USE_FAST_MATH == 1
+        return fast_math::log(a);
+#else
+        return numpy::log(a);
+#endif
+    }
+
+    /**
+     * In-place natural log of a buffer of energies, see log(float)
+     *
+     * @param buffer Energies, > 0
+     * @param length Number of elements
+     */
+    static void log(float *buffer, size_t length) {
+#if EIDSP_USE_FAST_MATH == 1
+        dispatch::kernels().fast_log(buffer, length);
+#else
+        dispatch::kernels().log(buffer, length);
+#endif
     }
 
     /**
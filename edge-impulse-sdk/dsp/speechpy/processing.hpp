@@ -317,7 +317,7 @@ namespace processing {
      * @param fft_points (int): The length of FFT. If fft_length is greater than frame_len, the frames will be zero-padded.
      * @returns EIDSP_OK if OK
      */
-    static int power_spectrum(float *frame, size_t frame_size, float *out_buffer, size_t out_buffer_size, uint16_t fft_points)
+    static int power_spectrum(const float *frame, size_t frame_size, float *out_buffer, size_t out_buffer_size, uint16_t fft_points)
     {
         if (out_buffer_size != static_cast<size_t>(fft_points / 2 + 1)) {
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
@@ -337,25 +337,71 @@ namespace processing {
     }
 
     /**
-     * This function performs local cepstral mean and
-     * variance normalization on a sliding window. The code assumes that
-     * there is one observation per row.
-     * @param features_matrix input feature matrix, will be modified in place
+     * Power spectra of several frames at once, see power_spectrum
+     * @param frames Frames, frame_count x frame_size
+     * @param frame_count Number of frames
+     * @param frame_size Size of a frame
+     * @param out_buffer Out buffer, frame_count x out_buffer_size
+     * @param out_buffer_size Size of the power spectrum of one frame, should be fft_points / 2 + 1
+     * @param fft_points (int): The length of FFT. If fft_length is greater than frame_len, the frames will be zero-padded.
+     * @returns EIDSP_OK if OK
+     */
+    static int power_spectrum_frames(const float *frames, size_t frame_count, size_t frame_size,
+        float *out_buffer, size_t out_buffer_size, uint16_t fft_points)
+    {
+        if (out_buffer_size != static_cast<size_t>(fft_points / 2 + 1)) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        // a single frame doesn't fill the lanes of the batched FFT
+        if (frame_count == 1) {
+            return power_spectrum(frames, frame_size, out_buffer, out_buffer_size, fft_points);
+        }
+
+        int r = numpy::rfft_frames(frames, frame_size, frame_size, frame_count,
+            out_buffer, out_buffer_size, fft_points);
+        if (r != EIDSP_OK) {
+            return r;
+        }
+
+        for (size_t ix = 0; ix < frame_count * out_buffer_size; ix++) {
+            out_buffer[ix] = (1.0 / static_cast<float>(fft_points)) *
+                (out_buffer[ix] * out_buffer[ix]);
+        }
+
+        return EIDSP_OK;
+    }
+
+    /**
+     * Performs local cepstral mean and variance normalization on a sliding window,
+     * like cmvnw below, but reads the features as a ring buffer (starting at `first_row`)
+     * and writes the normalized features in order to `out_matrix`. The features are
+     * linearized while padding, so no extra copy of the ring is needed.
+     * @param features_matrix input feature matrix (ring buffer of rows)
+     * @param first_row Oldest row in the ring buffer
+     * @param out_matrix Output matrix, same size as features_matrix (may be features_matrix if first_row is 0)
      * @param win_size The size of sliding window for local normalization.
-     *   Default=301 which is around 3s if 100 Hz rate is
-     *   considered(== 10ms frame stide)
      * @param variance_normalization If the variance normilization should
      *   be performed or not.
      * @param scale Scale output to 0..1
      * @returns 0 if OK
      */
-    static int cmvnw(matrix_t *features_matrix, uint16_t win_size = 301, bool variance_normalization = false,
-        bool scale = false)
+    static int cmvnw(matrix_t *features_matrix, uint32_t first_row, matrix_t *out_matrix,
+        uint16_t win_size, bool variance_normalization, bool scale)
     {
         uint16_t pad_size = (win_size - 1) / 2;
 
         int ret;
         float *features_buffer_ptr;
+        float *vec_pad_ptr;
+
+        if (out_matrix->rows * out_matrix->cols != features_matrix->rows * features_matrix->cols) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        if (out_matrix == features_matrix && first_row != 0) {
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+        }
 
         // mean & variance normalization
         EI_DSP_MATRIX(vec_pad, features_matrix->rows + (pad_size * 2), features_matrix->cols);
@@ -363,7 +409,7 @@ namespace processing {
             EIDSP_ERR(EIDSP_OUT_OF_MEM);
         }
 
-        ret = numpy::pad_1d_symmetric(features_matrix, &vec_pad, pad_size, pad_size);
+        ret = numpy::pad_1d_symmetric(features_matrix, &vec_pad, pad_size, pad_size, first_row);
         if (ret != EIDSP_OK) {
             EIDSP_ERR(ret);
         }
@@ -385,6 +431,7 @@ namespace processing {
                 EIDSP_ERR(EIDSP_OUT_OF_MEM);
             }
 
+#if EIDSP_USE_CMSIS_DSP
             ret = numpy::mean_axis0(&window, &mean_matrix);
             if (ret != EIDSP_OK) {
                 EIDSP_ERR(ret);
@@ -395,25 +442,37 @@ namespace processing {
                 if (ret != EIDSP_OK) {
                     EIDSP_ERR(ret);
                 }
+            }
+#else
+            // mean and standard deviation in one pass over the window
+            dispatch::kernels().mean_std_axis0(window.buffer, window.rows, window.cols,
+                mean_matrix.buffer, variance_normalization ? window_variance.buffer : NULL);
+#endif
 
-                features_buffer_ptr = &features_matrix->buffer[ix * vec_pad.cols];
+            if (variance_normalization == true) {
+
+                features_buffer_ptr = &out_matrix->buffer[ix * vec_pad.cols];
+                vec_pad_ptr = &vec_pad.buffer[(ix + pad_size) * vec_pad.cols];
                 for (size_t col = 0; col < vec_pad.cols; col++) {
-                    *(features_buffer_ptr) = (*(features_buffer_ptr)-mean_matrix.buffer[col]) /
+                    *(features_buffer_ptr) = (*(vec_pad_ptr)-mean_matrix.buffer[col]) /
                                              (window_variance.buffer[col] + FLT_EPSILON);
                     features_buffer_ptr++;
+                    vec_pad_ptr++;
                 }
             }
             else {
-                features_buffer_ptr = &features_matrix->buffer[ix * vec_pad.cols];
+                features_buffer_ptr = &out_matrix->buffer[ix * vec_pad.cols];
+                vec_pad_ptr = &vec_pad.buffer[(ix + pad_size) * vec_pad.cols];
                 for (size_t col = 0; col < vec_pad.cols; col++) {
-                    *(features_buffer_ptr) = *(features_buffer_ptr)-mean_matrix.buffer[col];
+                    *(features_buffer_ptr) = *(vec_pad_ptr)-mean_matrix.buffer[col];
                     features_buffer_ptr++;
+                    vec_pad_ptr++;
                 }
             }
         }
 
         if (scale) {
-            ret = numpy::normalize(features_matrix);
+            ret = numpy::normalize(out_matrix);
             if (ret != EIDSP_OK) {
                 EIDSP_ERR(ret);
             }
@@ -421,6 +480,117 @@ namespace processing {
 
         return EIDSP_OK;
     }
+
+    /**
+     * This function performs local cepstral mean and
+     * variance normalization on a sliding window. The code assumes that
+     * there is one observation per row.
+     * @param features_matrix input feature matrix, will be modified in place
+     * @param win_size The size of sliding window for local normalization.
+     *   Default=301 which is around 3s if 100 Hz rate is
+     *   considered(== 10ms frame stide)
+     * @param variance_normalization If the variance normilization should
+     *   be performed or not.
+     * @param scale Scale output to 0..1
+     * @returns 0 if OK
+     */
+    static int cmvnw(matrix_t *features_matrix, uint16_t win_size = 301, bool variance_normalization = false,
+        bool scale = false)
+    {
+        return cmvnw(features_matrix, 0, features_matrix, win_size, variance_normalization, scale);
+    }
+
+    /**
+     * Row of the features that row `row` of the padded window of the fixed point `cmvnw`
+     * reads, past the edges the features are mirrored (edge included)
+     */
+    static size_t cmvnw_window_row(int32_t row, size_t rows)
+    {
+        const int32_t period = 2 * static_cast<int32_t>(rows);
+        row = ((row % period) + period) % period;
+        return row < static_cast<int32_t>(rows) ? row : period - 1 - row;
+    }
+
+    /**
+     * Fixed point version of `cmvnw` (without scaling) for q15 features in an i32
+     * matrix, the window is padded symmetrically like `numpy::pad_1d_symmetric`.
+     * @param features_matrix input feature matrix, will be modified in place
+     * @param win_size The size of sliding window for local normalization.
+     * @param variance_normalization If the variance normilization should
+     *   be performed or not.
+     * @returns 0 if OK
+     */
+    static int cmvnw(matrix_i32_t *features_matrix, uint16_t win_size = 301, bool variance_normalization = false)
+    {
+        const size_t rows = features_matrix->rows;
+        const size_t cols = features_matrix->cols;
+        const int32_t pad_size = (win_size - 1) / 2;
+
+        if (rows == 0) {
+            EIDSP_ERR(EIDSP_INPUT_MATRIX_EMPTY);
+        }
+
+        // the rows are normalized in place, so every window reads from a copy
+        EI_DSP_i32_MATRIX(input, rows, cols);
+        if (!input.buffer) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+        memcpy(input.buffer, features_matrix->buffer, rows * cols * sizeof(EIDSP_i32));
+
+        // sum and sum of squares of the window in every column, updated when the window
+        // slides down a row (exact, so the same as summing every window)
+        const size_t sums_size = cols * 2 * sizeof(int64_t);
+        int64_t *sums = (int64_t*)ei_dsp_calloc(sums_size, 1);
+        if (!sums) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+        int64_t *square_sums = sums + cols;
+
+        for (int32_t wx = 0; wx < win_size; wx++) {
+            const EIDSP_i32 *row = input.buffer + (cmvnw_window_row(wx - pad_size, rows) * cols);
+            for (size_t col = 0; col < cols; col++) {
+                sums[col] += row[col];
+                square_sums[col] += (int64_t)row[col] * row[col];
+            }
+        }
+
+        for (size_t ix = 0; ix < rows; ix++) {
+            for (size_t col = 0; col < cols; col++) {
+                const int64_t sum = sums[col];
+                // round to nearest
+                int64_t mean = (sum + (sum >= 0 ? win_size / 2 : -(win_size / 2))) / win_size;
+
+                int64_t value = input.buffer[ix * cols + col] - mean;
+
+                if (variance_normalization) {
+                    // sum of (x - mean)^2 over the window
+                    uint64_t var = (uint64_t)(square_sums[col] - (2 * mean * sum) + (win_size * mean * mean));
+                    // q30 variance, q15 standard deviation
+                    int64_t std = numpy::sqrt_u64(var / win_size);
+                    if (std == 0) {
+                        std = 1;
+                    }
+                    value = (value * 32768) / std;
+                }
+
+                features_matrix->buffer[ix * cols + col] = (EIDSP_i32)value;
+            }
+
+            if (ix + 1 < rows) {
+                const int32_t first = static_cast<int32_t>(ix) - pad_size;
+                const EIDSP_i32 *removed = input.buffer + (cmvnw_window_row(first, rows) * cols);
+                const EIDSP_i32 *added = input.buffer + (cmvnw_window_row(first + win_size, rows) * cols);
+                for (size_t col = 0; col < cols; col++) {
+                    sums[col] += added[col] - removed[col];
+                    square_sums[col] += ((int64_t)added[col] * added[col]) - ((int64_t)removed[col] * removed[col]);
+                }
+            }
+        }
+
+        ei_dsp_free(sums, sums_size);
+
+        return EIDSP_OK;
+    }
 };
 
 } // namespace speechpy
@@ -25,6 +25,7 @@
 
 #include "../config.hpp"
 #include "feature.hpp"
+#include "feature_static.hpp"
 #include "functions.hpp"
 #include "processing.hpp"
 
@@ -48,7 +48,8 @@ typedef enum {
     EI_IMPULSE_OUTPUT_TENSOR_WAS_NULL = -14,
     EI_IMPULSE_SCORE_TENSOR_WAS_NULL = -15,
     EI_IMPULSE_LABEL_TENSOR_WAS_NULL = -16,
-    EI_IMPULSE_TENSORRT_INIT_FAILED = -17
+    EI_IMPULSE_TENSORRT_INIT_FAILED = -17,
+    EI_IMPULSE_MODEL_LOAD_FAILED = -18
 } EI_IMPULSE_ERROR;
 
 /**
@@ -1009,6 +1009,7 @@ limitations under the License.
 
 #include "edge-impulse-sdk/tensorflow/lite/kernels/internal/reference/conv.h"
 
+#include "edge-impulse-sdk/dsp/dispatch/ei_dispatch.h"
 #include "edge-impulse-sdk/tensorflow/lite/c/builtin_op_data.h"
 #include "edge-impulse-sdk/tensorflow/lite/c/common.h"
 #include "edge-impulse-sdk/tensorflow/lite/kernels/internal/common.h"
@@ -1231,24 +1232,93 @@ void EvalFloat(TfLiteContext* context, TfLiteNode* node,
   float output_activation_min, output_activation_max;
   CalculateActivationRange(params->activation, &output_activation_min,
                            &output_activation_max);
-  // TODO(b/154032858): Investigate removing extra copies.
-  ConvParams op_params;
-  op_params.padding_type = RuntimePaddingType(params->padding);
-  op_params.padding_values.width = data.padding.width;
-  op_params.padding_values.height = data.padding.height;
-  op_params.stride_width = params->stride_width;
-  op_params.stride_height = params->stride_height;
-  op_params.dilation_width_factor = params->dilation_width_factor;
-  op_params.dilation_height_factor = params->dilation_height_factor;
-  op_params.float_activation_min = output_activation_min;
-  op_params.float_activation_max = output_activation_max;
 
-  reference_ops::Conv(op_params, GetTensorShape(input),
-                      GetTensorData<float>(input), GetTensorShape(filter),
-                      GetTensorData<float>(filter), GetTensorShape(bias),
-                      GetTensorData<float>(bias), GetTensorShape(output),
-                      GetTensorData<float>(output), GetTensorShape(im2col),
-                      GetTensorData<float>(im2col));
+  // Same math as reference_ops::Conv, the output channels of a pixel are
+  // accumulated together (in the output buffer) by the dispatched dot product
+  // kernel. Every channel still sums over filter_y, filter_x, in_channel in
+  // that order and skips the taps outside of the input.
+  const int stride_width = params->stride_width;
+  const int stride_height = params->stride_height;
+  const int dilation_width_factor = params->dilation_width_factor;
+  const int dilation_height_factor = params->dilation_height_factor;
+  const int pad_width = data.padding.width;
+  const int pad_height = data.padding.height;
+
+  const RuntimeShape input_shape = GetTensorShape(input);
+  const RuntimeShape filter_shape = GetTensorShape(filter);
+  const RuntimeShape output_shape = GetTensorShape(output);
+  const int batches = MatchingDim(input_shape, 0, output_shape, 0);
+  const int input_depth = MatchingDim(input_shape, 3, filter_shape, 3);
+  const int output_depth = MatchingDim(filter_shape, 0, output_shape, 3);
+  const int input_height = input_shape.Dims(1);
+  const int input_width = input_shape.Dims(2);
+  const int filter_height = filter_shape.Dims(1);
+  const int filter_width = filter_shape.Dims(2);
+  const int output_height = output_shape.Dims(1);
+  const int output_width = output_shape.Dims(2);
+  const int filter_stride = filter_height * filter_width * input_depth;
+
+  const float* input_data = GetTensorData<float>(input);
+  const float* filter_data = GetTensorData<float>(filter);
+  const float* bias_data = GetTensorData<float>(bias);
+  float* output_data = GetTensorData<float>(output);
+  const ei::dispatch::kernels_t& kernels = ei::dispatch::kernels();
+
+  for (int batch = 0; batch < batches; ++batch) {
+    for (int out_y = 0; out_y < output_height; ++out_y) {
+      for (int out_x = 0; out_x < output_width; ++out_x) {
+        const int in_x_origin = (out_x * stride_width) - pad_width;
+        const int in_y_origin = (out_y * stride_height) - pad_height;
+        float* total =
+            output_data + Offset(output_shape, batch, out_y, out_x, 0);
+        for (int out_channel = 0; out_channel < output_depth; ++out_channel) {
+          total[out_channel] = 0.f;
+        }
+        for (int filter_y = 0; filter_y < filter_height; ++filter_y) {
+          const int in_y = in_y_origin + dilation_height_factor * filter_y;
+          if ((in_y < 0) || (in_y >= input_height)) {
+            continue;
+          }
+          if (dilation_width_factor == 1) {
+            // the taps inside the input are one contiguous run of pixels
+            const int filter_x_start = std::max(0, -in_x_origin);
+            const int filter_x_end =
+                std::min(filter_width, input_width - in_x_origin);
+            if (filter_x_start < filter_x_end) {
+              kernels.dot_lanes(
+                  input_data + Offset(input_shape, batch, in_y,
+                                      in_x_origin + filter_x_start, 0),
+                  (filter_x_end - filter_x_start) * input_depth,
+                  filter_data +
+                      Offset(filter_shape, 0, filter_y, filter_x_start, 0),
+                  filter_stride, output_depth, total);
+            }
+            continue;
+          }
+          for (int filter_x = 0; filter_x < filter_width; ++filter_x) {
+            const int in_x = in_x_origin + dilation_width_factor * filter_x;
+            if ((in_x < 0) || (in_x >= input_width)) {
+              continue;
+            }
+            kernels.dot_lanes(
+                input_data + Offset(input_shape, batch, in_y, in_x, 0),
+                input_depth,
+                filter_data + Offset(filter_shape, 0, filter_y, filter_x, 0),
+                filter_stride, output_depth, total);
+          }
+        }
+        for (int out_channel = 0; out_channel < output_depth; ++out_channel) {
+          float bias_value = 0.0f;
+          if (bias_data) {
+            bias_value = bias_data[out_channel];
+          }
+          total[out_channel] = ActivationFunctionWithMinMax(
+              total[out_channel] + bias_value, output_activation_min,
+              output_activation_max);
+        }
+      }
+    }
+  }
 }
 
 TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
@@ -670,6 +670,7 @@ limitations under the License.
 
 #include "edge-impulse-sdk/tensorflow/lite/kernels/internal/reference/fully_connected.h"
 
+#include "edge-impulse-sdk/dsp/dispatch/ei_dispatch.h"
 #include "edge-impulse-sdk/tensorflow/lite/c/builtin_op_data.h"
 #include "edge-impulse-sdk/tensorflow/lite/c/common.h"
 #include "edge-impulse-sdk/tensorflow/lite/kernels/internal/common.h"
@@ -825,14 +826,42 @@ TfLiteStatus EvalFloat(TfLiteContext* context, TfLiteNode* node,
   float output_activation_min, output_activation_max;
   CalculateActivationRange(activation, &output_activation_min,
                            &output_activation_max);
-  tflite::FullyConnectedParams op_params;
-  op_params.float_activation_min = output_activation_min;
-  op_params.float_activation_max = output_activation_max;
-  tflite::reference_ops::FullyConnected(
-      op_params, GetTensorShape(input), GetTensorData<float>(input),
-      GetTensorShape(filter), GetTensorData<float>(filter),
-      GetTensorShape(bias), GetTensorData<float>(bias), GetTensorShape(output),
-      GetTensorData<float>(output));
+
+  // Same math as reference_ops::FullyConnected, but all output channels of a
+  // batch are accumulated together (in the output buffer) by the dispatched
+  // dot product kernel.
+  const RuntimeShape output_shape = GetTensorShape(output);
+  const RuntimeShape weights_shape = GetTensorShape(filter);
+  const int output_dims_count = output_shape.DimensionsCount();
+  const int weights_dims_count = weights_shape.DimensionsCount();
+  const int batches = FlatSizeSkipDim(output_shape, output_dims_count - 1);
+  const int output_depth = MatchingDim(weights_shape, weights_dims_count - 2,
+                                       output_shape, output_dims_count - 1);
+  const int accum_depth = weights_shape.Dims(weights_dims_count - 1);
+
+  const float* input_data = GetTensorData<float>(input);
+  const float* weights_data = GetTensorData<float>(filter);
+  const float* bias_data = GetTensorData<float>(bias);
+  float* output_data = GetTensorData<float>(output);
+  const ei::dispatch::kernels_t& kernels = ei::dispatch::kernels();
+
+  for (int b = 0; b < batches; ++b) {
+    float* total = output_data + output_depth * b;
+    for (int out_c = 0; out_c < output_depth; ++out_c) {
+      total[out_c] = 0.f;
+    }
+    kernels.dot_lanes(input_data + b * accum_depth, accum_depth, weights_data,
+                      accum_depth, output_depth, total);
+    for (int out_c = 0; out_c < output_depth; ++out_c) {
+      float bias_value = 0.0f;
+      if (bias_data) {
+        bias_value = bias_data[out_c];
+      }
+      total[out_c] = ActivationFunctionWithMinMax(
+          total[out_c] + bias_value, output_activation_min,
+          output_activation_max);
+    }
+  }
   return kTfLiteOk;
 }
 
@@ -35,9 +35,13 @@ ei_model_dsp_t ei_dsp_blocks[ei_dsp_blocks_size] = {
     }
 };
 
-const size_t ei_dsp_blocks_i16_size = 0;
+const size_t ei_dsp_blocks_i16_size = 1;
 ei_model_dsp_i16_t ei_dsp_blocks_i16[ei_dsp_blocks_i16_size] = {
-
+    { // DSP block 3
+        650,
+        &extract_mfcc_features,
+        (void*)&ei_dsp_config_3
+    }
 };
 
 #endif // _EI_CLASSIFIER_DSP_BLOCKS_H_
\ No newline at end of file
@@ -55,7 +55,7 @@
 #define EI_CLASSIFIER_LABEL_COUNT                3
 #define EI_CLASSIFIER_HAS_ANOMALY                0
 #define EI_CLASSIFIER_FREQUENCY                  44100
-#define EI_CLASSIFIER_USE_QUANTIZED_DSP_BLOCK    0
+#define EI_CLASSIFIER_USE_QUANTIZED_DSP_BLOCK    1
 
 
 #define EI_CLASSIFIER_OBJECT_DETECTION           0
@@ -71,7 +71,9 @@
 #define EI_CLASSIFIER_TFLITE_OUTPUT_SCALE        0
 #define EI_CLASSIFIER_TFLITE_OUTPUT_ZEROPOINT    0
 #define EI_CLASSIFIER_INFERENCING_ENGINE         EI_CLASSIFIER_TFLITE
+#ifndef EI_CLASSIFIER_COMPILED
 #define EI_CLASSIFIER_COMPILED                   0
+#endif // EI_CLASSIFIER_COMPILED
 #define EI_CLASSIFIER_HAS_TFLITE_OPS_RESOLVER    1
 
 #define EI_CLASSIFIER_SENSOR                     EI_CLASSIFIER_SENSOR_MICROPHONE
@@ -178,7 +180,7 @@ typedef struct {
     float pre_cof;
 } ei_dsp_config_audio_syntiant_t;
 
-ei_dsp_config_mfcc_t ei_dsp_config_3 = {
+constexpr ei_dsp_config_mfcc_t ei_dsp_config_3_static = {
     2,
     1,
     13,
@@ -193,4 +195,8 @@ ei_dsp_config_mfcc_t ei_dsp_config_3 = {
     1
 };
 
+ei_dsp_config_mfcc_t ei_dsp_config_3 = ei_dsp_config_3_static;
+
+#define EI_DSP_MFCC_STATIC_CONFIG                ei_dsp_config_3_static
+
 #endif // _EI_CLASSIFIER_MODEL_METADATA_H_
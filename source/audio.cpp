@@ -39,7 +39,16 @@ int microphone_audio_signal_get_data(size_t, size_t, float *);
 #define SLICE_LENGTH_MS      250        // 4 inferences per second
 #define SLICE_LENGTH_VALUES  (EI_CLASSIFIER_RAW_SAMPLE_COUNT / (1000 / SLICE_LENGTH_MS))
 #define DOUT    26
-int counter = 0;
+
+// A siren is anything the model is sure isn't traffic, both siren labels vote as
+// SIREN_READING. The signal goes up once 4 of the last 5 slices (~1 second) are a
+// siren, and comes down when fewer than 2 of them are.
+#define TRAFFIC_LABEL           2
+#define SIREN_READING           0
+#define SIREN_WINDOW            5
+#define SIREN_MIN_READINGS_ON   4
+#define SIREN_MIN_READINGS_KEEP 2
+static ei_classifier_smoother<SIREN_WINDOW> siren_smoother(SIREN_MIN_READINGS_ON, SIREN_MIN_READINGS_KEEP);
 
 static bool use_debug = false; // Set this to true to see e.g. features generated from the raw signal and log WAV files
 static bool use_maf = false; // Set this (can be done from command line) to enable the moving average filter
@@ -202,17 +211,13 @@ void classify_current_buffer() {
         }
     }
     printf("\n");
-    //printf("counter: %d\n",counter);
-    if(result.classification[2].value < .1){
-        ++counter;
-        if(counter >= 4){
-            counter = 4;
-            printf("Signal Sent!\n");
-            gpioWrite(DOUT,1);
-        }
-    }else{
-        --counter;
-        if(counter < 0){counter = 0;}
+
+    int reading = result.classification[TRAFFIC_LABEL].value < .1 ? SIREN_READING : TRAFFIC_LABEL;
+    if (siren_smoother.update(reading) == SIREN_READING) {
+        printf("Signal Sent!\n");
+        gpioWrite(DOUT,1);
+    }
+    else {
         gpioWrite(DOUT,0);
     }
 }
@@ -239,6 +244,9 @@ int main(int argc, char **argv)
 
     card = argv[1];
 
+    ei::dispatch::print_report();
+    ei::fft::print_report();
+
     if (init_alsa(use_debug) != 0) {
         exit(1);
     }
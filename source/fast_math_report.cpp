@@ -0,0 +1,393 @@
+/* Edge Impulse Linux SDK
+ * Copyright (c) 2021 EdgeImpulse Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * Accuracy report for EIDSP_USE_FAST_MATH (approximate log / exp in the MFCC
+ * and MFE blocks).
+ *
+ * The flag is a build flag, so the report is built twice: once without it, which
+ * saves the results, and once with it (USE_FAST_MATH=1), which compares against
+ * them. For every recording it classifies one window and times the DSP blocks,
+ * and the comparison prints the top label of both builds, the largest score
+ * difference and the DSP speedup.
+ *
+ * Recordings are 16-bit mono WAV files at the model frequency, every full window
+ * in a file is a recording. Without files a set of synthetic signals is used.
+ * Pass the same files to both builds.
+ *
+ * Usage: fast-math-report --save results.txt [file.wav ...]     (built without fast math)
+ *        fast-math-report --compare results.txt [file.wav ...]  (built with USE_FAST_MATH=1)
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include "edge-impulse-sdk/classifier/ei_run_classifier.h"
+
+#define SAMPLES EI_CLASSIFIER_RAW_SAMPLE_COUNT
+
+typedef struct {
+    std::string name;
+    std::vector<int16_t> samples;
+} recording_t;
+
+typedef struct {
+    std::string name;
+    size_t top;
+    float scores[EI_CLASSIFIER_LABEL_COUNT];
+    double dsp_us;
+} outcome_t;
+
+static const int16_t *current_samples;
+
+static int get_data(size_t offset, size_t length, float *out_ptr) {
+    return numpy::int16_to_float(current_samples + offset, out_ptr, length);
+}
+
+static uint32_t noise_state = 1;
+
+/**
+ * Uniform noise in [-1, 1)
+ */
+static float noise() {
+    noise_state = noise_state * 1664525 + 1013904223;
+    return (float)(int32_t)noise_state / 2147483648.f;
+}
+
+static int16_t to_int16(float v) {
+    int32_t q = (int32_t)lrintf(v * 32768.f);
+    return (int16_t)(q > 32767 ? 32767 : (q < -32768 ? -32768 : q));
+}
+
+/**
+ * Siren at `siren_db` dBFS plus white noise at `noise_db` dBFS (below -200: off).
+ * A wail sweeps between 600 and 1400 Hz twice a second, a hi-lo siren switches
+ * between 950 and 700 Hz every half second.
+ */
+static recording_t siren(const char *name, bool hi_lo, float siren_db, float noise_db) {
+    const float siren_amplitude = siren_db < -200.f ? 0.f : powf(10.f, siren_db / 20.f);
+    const float noise_amplitude = noise_db < -200.f ? 0.f : powf(10.f, noise_db / 20.f);
+    recording_t r = { name, std::vector<int16_t>(SAMPLES) };
+    double phase = 0;
+    for (size_t ix = 0; ix < SAMPLES; ix++) {
+        double t = (double)ix / EI_CLASSIFIER_FREQUENCY;
+        double frequency = hi_lo ? (fmod(t, 1.0) < 0.5 ? 950.0 : 700.0)
+                                 : 1000.0 + 400.0 * sin(2 * M_PI * 2.0 * t);
+        phase += 2 * M_PI * frequency / EI_CLASSIFIER_FREQUENCY;
+        r.samples[ix] = to_int16(siren_amplitude * (float)sin(phase) + noise_amplitude * noise());
+    }
+    return r;
+}
+
+/**
+ * Low rumble like traffic: white noise at `db` dBFS through a one-pole low-pass
+ * at about 200 Hz
+ */
+static recording_t rumble(const char *name, float db) {
+    const float amplitude = powf(10.f, db / 20.f);
+    const float alpha = 1.f - expf(-2.f * (float)M_PI * 200.f / EI_CLASSIFIER_FREQUENCY);
+    // gain that brings the filtered noise back to the power of the white noise
+    const float gain = sqrtf((2.f - alpha) / alpha);
+    recording_t r = { name, std::vector<int16_t>(SAMPLES) };
+    float y = 0;
+    for (size_t ix = 0; ix < SAMPLES; ix++) {
+        y += alpha * (noise() - y);
+        r.samples[ix] = to_int16(amplitude * gain * y);
+    }
+    return r;
+}
+
+static uint32_t read_u32(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t read_u16(const uint8_t *p) {
+    return p[0] | (p[1] << 8);
+}
+
+/**
+ * Read a 16-bit mono PCM WAV file, every full model window becomes a recording
+ * @returns false if the file can't be read or has another format
+ */
+static bool load_wav(const char *path, std::vector<recording_t> *recordings) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        printf("Failed to open '%s'\n", path);
+        return false;
+    }
+    std::vector<uint8_t> file;
+    uint8_t chunk[4096];
+    size_t read;
+    while ((read = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+        file.insert(file.end(), chunk, chunk + read);
+    }
+    fclose(f);
+
+    if (file.size() < 12 || memcmp(file.data(), "RIFF", 4) != 0 || memcmp(file.data() + 8, "WAVE", 4) != 0) {
+        printf("'%s' is not a WAV file\n", path);
+        return false;
+    }
+
+    bool format_ok = false;
+    size_t offset = 12;
+    while (offset + 8 <= file.size()) {
+        const uint8_t *header = file.data() + offset;
+        size_t size = read_u32(header + 4);
+        const uint8_t *body = header + 8;
+        if (size > file.size() - offset - 8) {
+            size = file.size() - offset - 8;
+        }
+
+        if (memcmp(header, "fmt ", 4) == 0 && size >= 16) {
+            format_ok = read_u16(body) == 1 && read_u16(body + 2) == 1 &&
+                read_u32(body + 4) == EI_CLASSIFIER_FREQUENCY && read_u16(body + 14) == 16;
+            if (!format_ok) {
+                printf("'%s' should be 16-bit mono PCM at %d Hz\n", path, EI_CLASSIFIER_FREQUENCY);
+                return false;
+            }
+        }
+        else if (memcmp(header, "data", 4) == 0 && format_ok) {
+            size_t sample_count = size / 2;
+            if (sample_count < SAMPLES) {
+                printf("'%s' is shorter than one window (%d samples)\n", path, SAMPLES);
+                return false;
+            }
+            for (size_t start = 0; start + SAMPLES <= sample_count; start += SAMPLES) {
+                char name[256];
+                const char *base = strrchr(path, '/');
+                snprintf(name, sizeof(name), "%s@%.1fs", base ? base + 1 : path,
+                    (float)start / EI_CLASSIFIER_FREQUENCY);
+                recording_t r = { name, std::vector<int16_t>(SAMPLES) };
+                for (size_t ix = 0; ix < SAMPLES; ix++) {
+                    r.samples[ix] = (int16_t)read_u16(body + (start + ix) * 2);
+                }
+                recordings->push_back(r);
+            }
+            return true;
+        }
+
+        offset += 8 + size + (size & 1);
+    }
+
+    printf("'%s' has no audio data\n", path);
+    return false;
+}
+
+/**
+ * Classify one recording, and time the DSP blocks over a few runs
+ */
+static bool run(const recording_t *recording, outcome_t *outcome) {
+    current_samples = recording->samples.data();
+
+    signal_t signal;
+    signal.total_length = SAMPLES;
+    signal.get_data = &get_data;
+
+    ei_impulse_result_t result = { 0 };
+    EI_IMPULSE_ERROR res = run_classifier(&signal, &result, false);
+    if (res != EI_IMPULSE_OK) {
+        printf("%s: classification failed (%d)\n", recording->name.c_str(), res);
+        return false;
+    }
+
+    outcome->name = recording->name;
+    outcome->top = 0;
+    for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
+        outcome->scores[ix] = result.classification[ix].value;
+        if (outcome->scores[ix] > outcome->scores[outcome->top]) {
+            outcome->top = ix;
+        }
+    }
+
+    const int runs = 50;
+    uint64_t start_us = ei_read_timer_us();
+    for (int run = 0; run < runs; run++) {
+        for (size_t ix = 0; ix < ei_dsp_blocks_size; ix++) {
+            const ei_model_dsp_t *block = &ei_dsp_blocks[ix];
+            matrix_t features(1, block->n_output_features);
+            if (block->extract_fn(&signal, &features, block->config, EI_CLASSIFIER_FREQUENCY) != EIDSP_OK) {
+                printf("%s: DSP block %d failed\n", recording->name.c_str(), (int)ix);
+                return false;
+            }
+        }
+    }
+    outcome->dsp_us = (double)(ei_read_timer_us() - start_us) / runs;
+
+    return true;
+}
+
+/**
+ * Results file: one line per recording, name <tab> top label index <tab> scores <tab> DSP time
+ */
+static bool save(const char *path, const std::vector<outcome_t> &outcomes) {
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        printf("Failed to open '%s' for writing\n", path);
+        return false;
+    }
+    for (const outcome_t &o : outcomes) {
+        fprintf(f, "%s\t%d\t", o.name.c_str(), (int)o.top);
+        for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
+            fprintf(f, "%.9g ", o.scores[ix]);
+        }
+        fprintf(f, "\t%.1f\n", o.dsp_us);
+    }
+    fclose(f);
+    return true;
+}
+
+static bool load(const char *path, std::vector<outcome_t> *outcomes) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        printf("Failed to open '%s'\n", path);
+        return false;
+    }
+    char line[1024];
+    while (fgets(line, sizeof(line), f)) {
+        char *name = strtok(line, "\t");
+        char *top = strtok(NULL, "\t");
+        char *scores = strtok(NULL, "\t");
+        char *dsp_us = strtok(NULL, "\t\n");
+        if (!name || !top || !scores || !dsp_us) {
+            continue;
+        }
+        outcome_t o;
+        o.name = name;
+        o.top = (size_t)atoi(top);
+        char *p = scores;
+        for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
+            o.scores[ix] = strtof(p, &p);
+        }
+        o.dsp_us = atof(dsp_us);
+        outcomes->push_back(o);
+    }
+    fclose(f);
+    return true;
+}
+
+static bool compare(const std::vector<outcome_t> &exact, const std::vector<outcome_t> &fast) {
+    if (exact.size() != fast.size()) {
+        printf("The results file has %d recordings, this run %d. Pass the same files to both builds.\n",
+            (int)exact.size(), (int)fast.size());
+        return false;
+    }
+
+    printf("%-32s %-10s %-10s %10s %9s %9s %8s\n", "recording", "exact", "fast math",
+        "max diff", "exact us", "fast us", "speedup");
+
+    size_t same_labels = 0;
+    float max_diff = 0;
+    double exact_us = 0;
+    double fast_us = 0;
+    for (size_t ix = 0; ix < fast.size(); ix++) {
+        if (exact[ix].name != fast[ix].name) {
+            printf("Recording %d is '%s' in the results file, '%s' in this run\n", (int)ix,
+                exact[ix].name.c_str(), fast[ix].name.c_str());
+            return false;
+        }
+
+        float diff = 0;
+        for (size_t l = 0; l < EI_CLASSIFIER_LABEL_COUNT; l++) {
+            float d = fabsf(exact[ix].scores[l] - fast[ix].scores[l]);
+            diff = d > diff ? d : diff;
+        }
+        max_diff = diff > max_diff ? diff : max_diff;
+        same_labels += exact[ix].top == fast[ix].top;
+        exact_us += exact[ix].dsp_us;
+        fast_us += fast[ix].dsp_us;
+
+        printf("%-32s %-10s %-10s %10.2e %9.0f %9.0f %7.2fx\n", fast[ix].name.c_str(),
+            ei_classifier_inferencing_categories[exact[ix].top],
+            ei_classifier_inferencing_categories[fast[ix].top],
+            diff, exact[ix].dsp_us, fast[ix].dsp_us, exact[ix].dsp_us / fast[ix].dsp_us);
+    }
+
+    printf("\nSame top label: %d / %d, largest score difference: %.2e, DSP speedup: %.2fx\n",
+        (int)same_labels, (int)fast.size(), max_diff, exact_us / fast_us);
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3 || (strcmp(argv[1], "--save") != 0 && strcmp(argv[1], "--compare") != 0)) {
+        printf("Usage: %s --save|--compare results.txt [file.wav ...]\n", argv[0]);
+        return 1;
+    }
+    bool save_results = strcmp(argv[1], "--save") == 0;
+
+#if EIDSP_USE_FAST_MATH == 1
+    if (save_results) {
+        printf("This build has EIDSP_USE_FAST_MATH on, save the results from a build without it\n");
+        return 1;
+    }
+#else
+    if (!save_results) {
+        printf("This build has EIDSP_USE_FAST_MATH off, compare from a build with USE_FAST_MATH=1\n");
+        return 1;
+    }
+#endif
+
+    std::vector<recording_t> recordings;
+    for (int ix = 3; ix < argc; ix++) {
+        if (!load_wav(argv[ix], &recordings)) {
+            return 1;
+        }
+    }
+    if (argc == 3) {
+        recordings.push_back(siren("wail -6 dBFS", false, -6.f, -300.f));
+        recordings.push_back(siren("wail -30 dBFS", false, -30.f, -300.f));
+        recordings.push_back(siren("wail -12 dBFS, noise -30", false, -12.f, -30.f));
+        recordings.push_back(siren("wail -40 dBFS, noise -50", false, -40.f, -50.f));
+        recordings.push_back(siren("hi-lo -12 dBFS", true, -12.f, -300.f));
+        recordings.push_back(siren("hi-lo -24 dBFS, noise -30", true, -24.f, -30.f));
+        recordings.push_back(rumble("rumble -20 dBFS", -20.f));
+        recordings.push_back(rumble("rumble -40 dBFS", -40.f));
+        recordings.push_back(siren("noise -20 dBFS", false, -300.f, -20.f));
+        recordings.push_back(siren("noise -60 dBFS", false, -300.f, -60.f));
+    }
+
+    std::vector<outcome_t> outcomes;
+    for (const recording_t &recording : recordings) {
+        outcome_t outcome;
+        if (!run(&recording, &outcome)) {
+            return 1;
+        }
+        outcomes.push_back(outcome);
+    }
+
+    if (save_results) {
+        if (!save(argv[2], outcomes)) {
+            return 1;
+        }
+        printf("Saved the results of %d recordings to '%s'\n", (int)outcomes.size(), argv[2]);
+        return 0;
+    }
+
+    std::vector<outcome_t> exact;
+    if (!load(argv[2], &exact)) {
+        return 1;
+    }
+    return compare(exact, outcomes) ? 0 : 1;
+}
@@ -0,0 +1,196 @@
+/* Edge Impulse Linux SDK
+ * Copyright (c) 2021 EdgeImpulse Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * Micro-benchmark for the FFT backends (edge-impulse-sdk/dsp/fft/ei_fft.h).
+ *
+ * Times the real and complex f32 FFTs and the real Q15 FFT of every backend
+ * that is compiled in, for the sizes the DSP blocks use (64 - 4096 points),
+ * and prints the largest difference to kissfft relative to the largest output.
+ * A '-' means the backend has no FFT of that size, so a plan would fall back.
+ *
+ * Usage: fft-benchmark [milliseconds per measurement, default 100]
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+#include "edge-impulse-sdk/dsp/fft/ei_fft.h"
+#include "edge-impulse-sdk/dsp/returntypes.hpp"
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+
+using namespace ei;
+
+typedef struct {
+    const fft::backend_t *backend;
+    size_t n;
+    bool real;
+    fft::format_t format;
+    const std::vector<float> *input;
+    const std::vector<int16_t> *input_q15;
+    std::vector<float> output;
+} measurement_t;
+
+static void run_once(const fft::plan_t *plan, measurement_t *m) {
+    if (m->format == fft::FFT_Q15) {
+        fft::rfft(plan, m->input_q15->data(), (fft_complex_i16_t*)m->output.data());
+    }
+    else if (m->real) {
+        fft::rfft(plan, m->input->data(), (fft_complex_t*)m->output.data());
+    }
+    else {
+        fft::cfft(plan, (const fft_complex_t*)m->input->data(), (fft_complex_t*)m->output.data());
+    }
+}
+
+/**
+ * Time one FFT, returns microseconds per transform or a negative value if
+ * the backend has no FFT of this kind
+ */
+static double measure(measurement_t *m, uint64_t budget_ms) {
+    if (!m->backend->supports(m->n, m->real, m->format) &&
+        !(m->format == fft::FFT_Q15 && m->backend->supports(m->n, m->real, fft::FFT_F32))) {
+        return -1.0;
+    }
+
+    fft::plan_t plan;
+    if (fft::plan_init(&plan, m->n, m->real, m->format, m->backend) != EIDSP_OK) {
+        return -1.0;
+    }
+
+    size_t bins = m->real ? (m->n / 2) + 1 : m->n;
+    m->output.assign(2 * bins, 0.0f);
+
+    // warm up, then double the iterations until the budget is used
+    run_once(&plan, m);
+
+    uint64_t iterations = 1;
+    uint64_t elapsed = 0;
+    while (true) {
+        uint64_t start = ei_read_timer_us();
+        for (uint64_t ix = 0; ix < iterations; ix++) {
+            run_once(&plan, m);
+        }
+        elapsed = ei_read_timer_us() - start;
+        if (elapsed >= budget_ms * 1000 / 4) {
+            break;
+        }
+        iterations *= 2;
+    }
+
+    if (m->format == fft::FFT_Q15) {
+        // widen the Q15 output, so it compares like the float output
+        const int16_t *q15 = (const int16_t*)m->output.data();
+        std::vector<float> widened(2 * bins);
+        for (size_t ix = 0; ix < 2 * bins; ix++) {
+            widened[ix] = q15[ix];
+        }
+        m->output = widened;
+    }
+
+    fft::plan_free(&plan);
+
+    return (double)elapsed / (double)iterations;
+}
+
+static double relative_difference(const std::vector<float> &a, const std::vector<float> &b) {
+    double max_diff = 0.0;
+    double max_value = 0.0;
+    for (size_t ix = 0; ix < a.size(); ix++) {
+        max_diff = fmax(max_diff, fabs((double)a[ix] - (double)b[ix]));
+        max_value = fmax(max_value, fabs((double)b[ix]));
+    }
+    return max_value > 0.0 ? max_diff / max_value : max_diff;
+}
+
+int main(int argc, char **argv) {
+    uint64_t budget_ms = argc > 1 ? strtoull(argv[1], NULL, 10) : 100;
+
+    size_t backend_count;
+    const fft::backend_t *const *backends = fft::backends(&backend_count);
+
+    const struct {
+        const char *name;
+        bool real;
+        fft::format_t format;
+    } kinds[] = {
+        { "rfft f32", true, fft::FFT_F32 },
+        { "cfft f32", false, fft::FFT_F32 },
+        { "rfft q15", true, fft::FFT_Q15 },
+    };
+
+    printf("%-9s %5s", "fft", "n");
+    for (size_t b = 0; b < backend_count; b++) {
+        printf(" %20s", backends[b]->name);
+    }
+    printf("\n%-15s", "");
+    for (size_t b = 0; b < backend_count; b++) {
+        printf(" %20s", "us (rel. diff)");
+    }
+    printf("\n");
+
+    srand(42);
+
+    for (size_t k = 0; k < sizeof(kinds) / sizeof(kinds[0]); k++) {
+        for (size_t n = 64; n <= 4096; n *= 2) {
+            std::vector<float> input(2 * n);
+            std::vector<int16_t> input_q15(2 * n);
+            for (size_t ix = 0; ix < input.size(); ix++) {
+                input[ix] = ((float)rand() / (float)RAND_MAX) * 2.0f - 1.0f;
+                input_q15[ix] = (int16_t)lrintf(input[ix] * 16384.0f);
+            }
+
+            printf("%-9s %5d", kinds[k].name, (int)n);
+
+            std::vector<float> reference;
+            for (size_t b = 0; b < backend_count; b++) {
+                measurement_t m;
+                m.backend = backends[b];
+                m.n = n;
+                m.real = kinds[k].real;
+                m.format = kinds[k].format;
+                m.input = &input;
+                m.input_q15 = &input_q15;
+
+                double us = measure(&m, budget_ms);
+                if (us < 0) {
+                    printf(" %20s", "-");
+                    continue;
+                }
+
+                // the first backend (kissfft) is the reference
+                if (reference.empty()) {
+                    reference = m.output;
+                    printf(" %20.2f", us);
+                }
+                else {
+                    printf(" %11.2f (%6.1e)", us, relative_difference(m.output, reference));
+                }
+            }
+            printf("\n");
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,182 @@
+/* Edge Impulse Linux SDK
+ * Copyright (c) 2021 EdgeImpulse Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * Accuracy report for the fixed point (int16) MFCC pipeline.
+ *
+ * Runs the MFCC block of the model on a set of synthetic int16 signals through
+ * both the float path (int16 -> float, extract_mfcc_features) and the int16 path
+ * (extract_mfcc_features on the int16 samples), and prints the SNR of the int16
+ * features against the float features, the largest difference, the time per
+ * extraction, and the top label of both paths.
+ *
+ * Usage: mfcc-i16-report
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+#include "edge-impulse-sdk/classifier/ei_run_classifier.h"
+
+#if !defined(EI_CLASSIFIER_USE_QUANTIZED_DSP_BLOCK) || EI_CLASSIFIER_USE_QUANTIZED_DSP_BLOCK != 1
+#error "The int16 DSP path is not enabled for this model (EI_CLASSIFIER_USE_QUANTIZED_DSP_BLOCK)"
+#endif
+
+#define SAMPLES EI_CLASSIFIER_RAW_SAMPLE_COUNT
+
+static std::vector<int16_t> samples(SAMPLES);
+
+static int float_get_data(size_t offset, size_t length, float *out_ptr) {
+    return numpy::int16_to_float(samples.data() + offset, out_ptr, length);
+}
+
+static int i16_get_data(size_t offset, size_t length, int16_t *out_ptr) {
+    memcpy(out_ptr, samples.data() + offset, length * sizeof(int16_t));
+    return 0;
+}
+
+static uint32_t noise_state = 1;
+
+/**
+ * Uniform noise in [-1, 1)
+ */
+static float noise() {
+    noise_state = noise_state * 1664525 + 1013904223;
+    return (float)(int32_t)noise_state / 2147483648.f;
+}
+
+/**
+ * Siren sweep between 600 and 1400 Hz (two sweeps per second) at `siren_db`
+ * dBFS plus white noise at `noise_db` dBFS (below -200: off)
+ */
+static void generate(float siren_db, float noise_db) {
+    const float siren_amplitude = siren_db < -200.f ? 0.f : powf(10.f, siren_db / 20.f);
+    const float noise_amplitude = noise_db < -200.f ? 0.f : powf(10.f, noise_db / 20.f);
+    double phase = 0;
+    for (size_t ix = 0; ix < SAMPLES; ix++) {
+        double t = (double)ix / EI_CLASSIFIER_FREQUENCY;
+        double frequency = 1000.0 + 400.0 * sin(2 * M_PI * 2.0 * t);
+        phase += 2 * M_PI * frequency / EI_CLASSIFIER_FREQUENCY;
+        float v = siren_amplitude * (float)sin(phase) + noise_amplitude * noise();
+        int32_t q = (int32_t)lrintf(v * 32768.f);
+        samples[ix] = (int16_t)(q > 32767 ? 32767 : (q < -32768 ? -32768 : q));
+    }
+}
+
+static const char *top_label(const ei_impulse_result_t *result) {
+    size_t top = 0;
+    for (size_t ix = 1; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
+        if (result->classification[ix].value > result->classification[top].value) {
+            top = ix;
+        }
+    }
+    return result->classification[top].label;
+}
+
+static void report(const char *name) {
+    const ei_model_dsp_t *block = &ei_dsp_blocks[0];
+    const ei_model_dsp_i16_t *block_i16 = &ei_dsp_blocks_i16[0];
+
+    signal_t signal;
+    signal.total_length = SAMPLES;
+    signal.get_data = &float_get_data;
+
+    signal_i16_t signal_i16;
+    signal_i16.total_length = SAMPLES;
+    signal_i16.get_data = &i16_get_data;
+
+    matrix_t features(1, block->n_output_features);
+    matrix_i32_t features_i16(1, block_i16->n_output_features);
+
+    const int runs = 10;
+    uint64_t start_us = ei_read_timer_us();
+    for (int ix = 0; ix < runs; ix++) {
+        features.rows = 1;
+        features.cols = block->n_output_features;
+        if (block->extract_fn(&signal, &features, block->config, EI_CLASSIFIER_FREQUENCY) != EIDSP_OK) {
+            printf("%-28s float extraction failed\n", name);
+            return;
+        }
+    }
+    uint64_t float_us = (ei_read_timer_us() - start_us) / runs;
+
+    start_us = ei_read_timer_us();
+    for (int ix = 0; ix < runs; ix++) {
+        features_i16.rows = 1;
+        features_i16.cols = block_i16->n_output_features;
+        if (block_i16->extract_fn(&signal_i16, &features_i16, block_i16->config, EI_CLASSIFIER_FREQUENCY) != EIDSP_OK) {
+            printf("%-28s int16 extraction failed\n", name);
+            return;
+        }
+    }
+    uint64_t i16_us = (ei_read_timer_us() - start_us) / runs;
+
+    double signal_power = 0;
+    double noise_power = 0;
+    double max_diff = 0;
+    for (size_t ix = 0; ix < features.cols; ix++) {
+        double reference = features.buffer[ix];
+        double diff = (double)features_i16.buffer[ix] / 32768.0 - reference;
+        signal_power += reference * reference;
+        noise_power += diff * diff;
+        max_diff = fabs(diff) > max_diff ? fabs(diff) : max_diff;
+    }
+    double snr = noise_power > 0 ? 10 * log10(signal_power / noise_power) : INFINITY;
+
+    ei_impulse_result_t result = { 0 };
+    ei_impulse_result_t result_i16 = { 0 };
+    EI_IMPULSE_ERROR res = run_classifier(&signal, &result, false);
+    EI_IMPULSE_ERROR res_i16 = run_classifier_i16(&signal_i16, &result_i16, false);
+    if (res != EI_IMPULSE_OK || res_i16 != EI_IMPULSE_OK) {
+        printf("%-28s classification failed (%d, %d)\n", name, res, res_i16);
+        return;
+    }
+
+    printf("%-28s %7.1f %9.4f %8llu %8llu   %-10s %-10s\n", name, snr, max_diff,
+        (unsigned long long)float_us, (unsigned long long)i16_us,
+        top_label(&result), top_label(&result_i16));
+}
+
+int main(int argc, char **argv) {
+    ei::dispatch::print_report();
+    ei::fft::print_report();
+
+    printf("\n%-28s %7s %9s %8s %8s   %-10s %-10s\n", "signal", "SNR dB", "max diff",
+        "float us", "int16 us", "float", "int16");
+
+    generate(-6.f, -300.f);
+    report("siren -6 dBFS");
+    generate(-30.f, -300.f);
+    report("siren -30 dBFS");
+    generate(-12.f, -30.f);
+    report("siren -12 dBFS, noise -30");
+    generate(-40.f, -50.f);
+    report("siren -40 dBFS, noise -50");
+    generate(-300.f, -20.f);
+    report("noise -20 dBFS");
+    generate(-300.f, -60.f);
+    report("noise -60 dBFS");
+
+    return 0;
+}
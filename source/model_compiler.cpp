@@ -0,0 +1,893 @@
+/* Edge Impulse Linux SDK
+ * Copyright (c) 2021 EdgeImpulse Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * Ahead-of-time compiler for TensorFlow Lite models.
+ *
+ * Loads a .tflite file (or the model that is built into this application),
+ * lets the TFLite Micro interpreter plan the tensor arena once on the host, and
+ * writes out trained_model_compiled.h / trained_model_compiled.cpp. The
+ * generated code provides the trained_model_init / _input / _output / _invoke /
+ * _reset functions that ei_run_classifier.h uses when EI_CLASSIFIER_COMPILED is
+ * set, so the target no longer parses the flatbuffer, resolves ops or runs
+ * AllocateTensors.
+ *
+ * The generated code stores kernel parameter structs as raw bytes, so it must be
+ * built for a target with the same struct layout as the host it was generated
+ * on (e.g. generate on the Pi itself, or on another 64-bit little-endian Linux
+ * host for aarch64).
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <vector>
+#include <string>
+#include "edge-impulse-sdk/classifier/ei_aligned_malloc.h"
+#include "edge-impulse-sdk/tensorflow/lite/c/builtin_op_data.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/all_ops_resolver.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/kernels/micro_ops.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/micro_error_reporter.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/micro_interpreter.h"
+#include "edge-impulse-sdk/tensorflow/lite/schema/schema_generated.h"
+#include "edge-impulse-sdk/tensorflow/lite/version.h"
+#include "tflite-model/tflite-trained.h"
+
+namespace tflite {
+namespace ops {
+namespace micro {
+TfLiteRegistration* Register_TFLite_Detection_PostProcess();
+}  // namespace micro
+}  // namespace ops
+}  // namespace tflite
+
+#define ARENA_ALIGNMENT          16
+#define MAX_ARENA_SIZE           (256 * 1024 * 1024)
+
+typedef TfLiteRegistration* (*register_fn_t)();
+
+typedef struct {
+    tflite::BuiltinOperator code;
+    const char *name;
+    register_fn_t fn;
+} builtin_kernel_t;
+
+#define BUILTIN_KERNEL(op) { tflite::BuiltinOperator_##op, #op, tflite::ops::micro::Register_##op }
+
+// Kernels that the generated code can reference directly (see micro_ops.h)
+static const builtin_kernel_t builtin_kernels[] = {
+    BUILTIN_KERNEL(ABS), BUILTIN_KERNEL(ADD), BUILTIN_KERNEL(ARG_MAX), BUILTIN_KERNEL(ARG_MIN),
+    BUILTIN_KERNEL(AVERAGE_POOL_2D), BUILTIN_KERNEL(CEIL), BUILTIN_KERNEL(CONV_2D),
+    BUILTIN_KERNEL(CONCATENATION), BUILTIN_KERNEL(COS), BUILTIN_KERNEL(DEPTHWISE_CONV_2D),
+    BUILTIN_KERNEL(DEQUANTIZE), BUILTIN_KERNEL(EQUAL), BUILTIN_KERNEL(FLOOR),
+    BUILTIN_KERNEL(FULLY_CONNECTED), BUILTIN_KERNEL(GREATER), BUILTIN_KERNEL(GREATER_EQUAL),
+    BUILTIN_KERNEL(LESS), BUILTIN_KERNEL(LESS_EQUAL), BUILTIN_KERNEL(LOG), BUILTIN_KERNEL(LOGICAL_AND),
+    BUILTIN_KERNEL(LOGICAL_NOT), BUILTIN_KERNEL(LOGICAL_OR), BUILTIN_KERNEL(LOGISTIC),
+    BUILTIN_KERNEL(MAXIMUM), BUILTIN_KERNEL(MAX_POOL_2D), BUILTIN_KERNEL(MEAN), BUILTIN_KERNEL(MINIMUM),
+    BUILTIN_KERNEL(MUL), BUILTIN_KERNEL(NEG), BUILTIN_KERNEL(NOT_EQUAL), BUILTIN_KERNEL(PACK),
+    BUILTIN_KERNEL(PAD), BUILTIN_KERNEL(PADV2), BUILTIN_KERNEL(PRELU), BUILTIN_KERNEL(QUANTIZE),
+    BUILTIN_KERNEL(RELU), BUILTIN_KERNEL(RELU6), BUILTIN_KERNEL(RESHAPE),
+    BUILTIN_KERNEL(RESIZE_NEAREST_NEIGHBOR), BUILTIN_KERNEL(ROUND), BUILTIN_KERNEL(RSQRT),
+    BUILTIN_KERNEL(SIN), BUILTIN_KERNEL(SOFTMAX), BUILTIN_KERNEL(SPLIT), BUILTIN_KERNEL(SQRT),
+    BUILTIN_KERNEL(SQUARE), BUILTIN_KERNEL(STRIDED_SLICE), BUILTIN_KERNEL(SUB), BUILTIN_KERNEL(SVDF),
+    BUILTIN_KERNEL(UNPACK), BUILTIN_KERNEL(L2_NORMALIZATION), BUILTIN_KERNEL(TANH),
+};
+
+typedef struct {
+    tflite::BuiltinOperator code;
+    const char *type_name;
+    size_t size;
+} builtin_params_t;
+
+#define BUILTIN_PARAMS(op, type) { tflite::BuiltinOperator_##op, #type, sizeof(type) }
+
+// Parameter structs that ParseOpData produces for the kernels above
+static const builtin_params_t builtin_params[] = {
+    BUILTIN_PARAMS(ADD, TfLiteAddParams),
+    BUILTIN_PARAMS(ARG_MAX, TfLiteArgMaxParams),
+    BUILTIN_PARAMS(ARG_MIN, TfLiteArgMinParams),
+    BUILTIN_PARAMS(AVERAGE_POOL_2D, TfLitePoolParams),
+    BUILTIN_PARAMS(CONCATENATION, TfLiteConcatenationParams),
+    BUILTIN_PARAMS(CONV_2D, TfLiteConvParams),
+    BUILTIN_PARAMS(DEPTHWISE_CONV_2D, TfLiteDepthwiseConvParams),
+    BUILTIN_PARAMS(FULLY_CONNECTED, TfLiteFullyConnectedParams),
+    BUILTIN_PARAMS(L2_NORMALIZATION, TfLiteL2NormParams),
+    BUILTIN_PARAMS(MAX_POOL_2D, TfLitePoolParams),
+    BUILTIN_PARAMS(MEAN, TfLiteReducerParams),
+    BUILTIN_PARAMS(MUL, TfLiteMulParams),
+    BUILTIN_PARAMS(PACK, TfLitePackParams),
+    BUILTIN_PARAMS(RESHAPE, TfLiteReshapeParams),
+    BUILTIN_PARAMS(RESIZE_NEAREST_NEIGHBOR, TfLiteResizeNearestNeighborParams),
+    BUILTIN_PARAMS(SOFTMAX, TfLiteSoftmaxParams),
+    BUILTIN_PARAMS(SPLIT, TfLiteSplitParams),
+    BUILTIN_PARAMS(STRIDED_SLICE, TfLiteStridedSliceParams),
+    BUILTIN_PARAMS(SUB, TfLiteSubParams),
+    BUILTIN_PARAMS(SVDF, TfLiteSVDFParams),
+    BUILTIN_PARAMS(UNPACK, TfLiteUnpackParams),
+};
+
+#define DETECTION_POSTPROCESS_NAME "TFLite_Detection_PostProcess"
+
+typedef struct {
+    std::string name;      // e.g. CONV_2D, used for the enum and Register_ call
+    std::string register_fn;
+    const TfLiteRegistration *registration;
+} used_op_t;
+
+static const char *generated_header =
+    "/* Generated by Edge Impulse\n"
+    "*\n"
+    "* Permission is hereby granted, free of charge, to any person obtaining a copy\n"
+    "* of this software and associated documentation files (the \"Software\"), to deal\n"
+    "* in the Software without restriction, including without limitation the rights\n"
+    "* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell\n"
+    "* copies of the Software, and to permit persons to whom the Software is\n"
+    "* furnished to do so, subject to the following conditions:\n"
+    "*\n"
+    "* The above copyright notice and this permission notice shall be included in\n"
+    "* all copies or substantial portions of the Software.\n"
+    "*\n"
+    "* THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR\n"
+    "* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,\n"
+    "* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE\n"
+    "* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER\n"
+    "* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,\n"
+    "* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE\n"
+    "* SOFTWARE.\n"
+    "*/\n"
+    "\n"
+    "// Generated by source/model_compiler.cpp, do not edit\n"
+    "\n";
+
+// Kernel memory that init/prepare ask for, measured per node on the host
+static size_t measured_persistent_bytes = 0;
+static size_t measured_scratch_bytes = 0;
+static int measured_scratch_count = 0;
+static std::vector<void *> measured_buffers;
+
+/**
+ * Interpreter that exposes the context it planned, so the generator can read
+ * the final tensor layout
+ */
+class planning_interpreter : public tflite::MicroInterpreter {
+public:
+    using tflite::MicroInterpreter::MicroInterpreter;
+
+    const TfLiteContext &planned_context() const {
+        return context();
+    }
+};
+
+static TfLiteStatus measure_allocate_persistent_buffer(TfLiteContext *ctx, size_t bytes, void **ptr) {
+    *ptr = ei_aligned_malloc(ARENA_ALIGNMENT, bytes > 0 ? bytes : 1);
+    if (!*ptr) {
+        return kTfLiteError;
+    }
+    measured_buffers.push_back(*ptr);
+    measured_persistent_bytes += align_up(bytes, ARENA_ALIGNMENT);
+    return kTfLiteOk;
+}
+
+static TfLiteStatus measure_request_scratch_buffer(TfLiteContext *ctx, size_t bytes, int *buffer_idx) {
+    *buffer_idx = measured_scratch_count++;
+    measured_scratch_bytes += align_up(bytes, ARENA_ALIGNMENT);
+    return kTfLiteOk;
+}
+
+/**
+ * Run init/prepare of every kernel again against a copy of the planned
+ * context, to find out how much persistent and scratch memory the generated
+ * code needs to reserve next to the activations.
+ */
+static bool measure_kernel_memory(const tflite::MicroInterpreter &interpreter, const TfLiteContext &planned) {
+    TfLiteContext ctx = planned;
+    ctx.AllocatePersistentBuffer = measure_allocate_persistent_buffer;
+    ctx.RequestScratchBufferInArena = measure_request_scratch_buffer;
+    ctx.GetScratchBuffer = nullptr;
+
+    for (size_t ix = 0; ix < interpreter.operators_size(); ix++) {
+        tflite::NodeAndRegistration nr = interpreter.node_and_registration(ix);
+        TfLiteNode node = nr.node;
+        const TfLiteRegistration *registration = nr.registration;
+
+        if (registration->init) {
+            const char *init_data;
+            size_t init_data_size;
+            if (registration->builtin_code == tflite::BuiltinOperator_CUSTOM) {
+                init_data = reinterpret_cast<const char *>(node.custom_initial_data);
+                init_data_size = node.custom_initial_data_size;
+            }
+            else {
+                init_data = reinterpret_cast<const char *>(node.builtin_data);
+                init_data_size = 0;
+            }
+            node.user_data = registration->init(&ctx, init_data, init_data_size);
+        }
+        if (registration->prepare && registration->prepare(&ctx, &node) != kTfLiteOk) {
+            fprintf(stderr, "Failed to prepare node %d\n", (int)ix);
+            return false;
+        }
+        if (registration->free) {
+            registration->free(&ctx, node.user_data);
+        }
+    }
+
+    for (void *ptr : measured_buffers) {
+        ei_aligned_free(ptr);
+    }
+    measured_buffers.clear();
+    return true;
+}
+
+static bool read_file(const char *path, std::vector<uint8_t> &buffer) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "Failed to open %s\n", path);
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size <= 0) {
+        fprintf(stderr, "%s is empty\n", path);
+        fclose(file);
+        return false;
+    }
+    buffer.resize(size);
+    bool ok = fread(buffer.data(), 1, size, file) == (size_t)size;
+    fclose(file);
+    if (!ok) {
+        fprintf(stderr, "Failed to read %s\n", path);
+    }
+    return ok;
+}
+
+static const char *tflite_type_name(TfLiteType type) {
+    switch (type) {
+        case kTfLiteNoType: return "kTfLiteNoType";
+        case kTfLiteFloat32: return "kTfLiteFloat32";
+        case kTfLiteInt32: return "kTfLiteInt32";
+        case kTfLiteUInt8: return "kTfLiteUInt8";
+        case kTfLiteInt64: return "kTfLiteInt64";
+        case kTfLiteString: return "kTfLiteString";
+        case kTfLiteBool: return "kTfLiteBool";
+        case kTfLiteInt16: return "kTfLiteInt16";
+        case kTfLiteComplex64: return "kTfLiteComplex64";
+        case kTfLiteInt8: return "kTfLiteInt8";
+        case kTfLiteFloat16: return "kTfLiteFloat16";
+        case kTfLiteFloat64: return "kTfLiteFloat64";
+    }
+    return nullptr;
+}
+
+static void write_bytes(FILE *f, const void *data, size_t bytes) {
+    const uint8_t *p = static_cast<const uint8_t *>(data);
+    for (size_t ix = 0; ix < bytes; ix++) {
+        if (ix % 16 == 0) {
+            fprintf(f, "\n    ");
+        }
+        fprintf(f, "0x%02x,", p[ix]);
+    }
+    fprintf(f, "\n");
+}
+
+static void write_float(FILE *f, float value) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.9g", value);
+    // make sure the literal parses as a float, e.g. 0 => 0.0f
+    fprintf(f, "%s%sf", buffer, strpbrk(buffer, ".e") ? "" : ".0");
+}
+
+static void write_int_array(FILE *f, const char *name, const TfLiteIntArray *arr, bool is_const) {
+    fprintf(f, "%sTfArray<%d, int> %s = { %d, {", is_const ? "const " : "",
+        arr->size > 0 ? arr->size : 1, name, arr->size);
+    for (int ix = 0; ix < arr->size; ix++) {
+        fprintf(f, "%s %d", ix > 0 ? "," : "", arr->data[ix]);
+    }
+    fprintf(f, " } };\n");
+}
+
+static const builtin_params_t *find_builtin_params(int32_t code) {
+    for (const builtin_params_t &p : builtin_params) {
+        if (p.code == code) {
+            return &p;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * Map a registration from the resolver back onto the kernel function that
+ * produced it, so the generated code can reference the kernel directly.
+ */
+static bool resolve_kernel(const TfLiteRegistration *registration, used_op_t *op) {
+    if (registration->builtin_code == tflite::BuiltinOperator_CUSTOM) {
+        if (registration->custom_name && strcmp(registration->custom_name, DETECTION_POSTPROCESS_NAME) == 0) {
+            op->name = "DETECTION_POSTPROCESS";
+            op->register_fn = "tflite::ops::micro::Register_TFLite_Detection_PostProcess";
+            op->registration = registration;
+            return true;
+        }
+        fprintf(stderr, "Custom op '%s' is not supported by the model compiler\n",
+            registration->custom_name ? registration->custom_name : "(unnamed)");
+        return false;
+    }
+
+    for (const builtin_kernel_t &k : builtin_kernels) {
+        if (k.code != registration->builtin_code) {
+            continue;
+        }
+        if (k.fn()->invoke != registration->invoke) {
+            fprintf(stderr, "Op %s is resolved to a different kernel than Register_%s\n", k.name, k.name);
+            return false;
+        }
+        op->name = k.name;
+        op->register_fn = std::string("tflite::ops::micro::Register_") + k.name;
+        op->registration = registration;
+        return true;
+    }
+
+    fprintf(stderr, "Op %s is not supported by the model compiler\n",
+        tflite::EnumNameBuiltinOperator((tflite::BuiltinOperator)registration->builtin_code));
+    return false;
+}
+
+static bool write_header(const char *path) {
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "Failed to open %s for writing\n", path);
+        return false;
+    }
+    fputs(generated_header, f);
+    fputs(
+        "#ifndef trained_model_GEN_H\n"
+        "#define trained_model_GEN_H\n"
+        "\n"
+        "#include \"edge-impulse-sdk/tensorflow/lite/c/common.h\"\n"
+        "\n"
+        "// Sets up the model with the required tensor arena\n"
+        "TfLiteStatus trained_model_init(void *(*alloc_fnc)(size_t, size_t));\n"
+        "\n"
+        "// Returns input / output tensors\n"
+        "TfLiteTensor *trained_model_input(int index);\n"
+        "TfLiteTensor *trained_model_output(int index);\n"
+        "\n"
+        "// Runs inference on the model\n"
+        "TfLiteStatus trained_model_invoke();\n"
+        "\n"
+        "// Frees memory allocated by trained_model_init\n"
+        "TfLiteStatus trained_model_reset(void (*free_fnc)(void *ptr));\n"
+        "\n"
+        "#endif // trained_model_GEN_H\n", f);
+    fclose(f);
+    return true;
+}
+
+static bool write_source(const char *path, const tflite::MicroInterpreter &interpreter,
+    const TfLiteContext &ctx, const uint8_t *arena)
+{
+    size_t tensor_count = interpreter.tensors_size();
+    size_t node_count = interpreter.operators_size();
+
+    // resolve every node to a directly referenced kernel first, so we fail
+    // before writing anything
+    std::vector<used_op_t> used_ops;
+    std::vector<size_t> node_ops(node_count);
+    for (size_t ix = 0; ix < node_count; ix++) {
+        const TfLiteRegistration *registration = interpreter.node_and_registration(ix).registration;
+        used_op_t op;
+        if (!resolve_kernel(registration, &op)) {
+            return false;
+        }
+        size_t op_ix = 0;
+        for (; op_ix < used_ops.size(); op_ix++) {
+            if (used_ops[op_ix].name == op.name) break;
+        }
+        if (op_ix == used_ops.size()) {
+            used_ops.push_back(op);
+        }
+        node_ops[ix] = op_ix;
+
+        const TfLiteNode &node = interpreter.node_and_registration(ix).node;
+        if (node.builtin_data && !find_builtin_params(registration->builtin_code)) {
+            fprintf(stderr, "Parameters of op %s are not supported by the model compiler\n", op.name.c_str());
+            return false;
+        }
+    }
+
+    // arena layout: planned activations first, kernel memory behind it
+    size_t head_size = 0;
+    for (size_t ix = 0; ix < tensor_count; ix++) {
+        const TfLiteTensor &t = ctx.tensors[ix];
+        if (!tflite_type_name(t.type)) {
+            fprintf(stderr, "Tensor %d has an unsupported type (%d)\n", (int)ix, t.type);
+            return false;
+        }
+        if (t.allocation_type != kTfLiteMmapRo && t.data.raw) {
+            size_t end = (size_t)((const uint8_t *)t.data.raw - arena) + t.bytes;
+            if (end > head_size) {
+                head_size = end;
+            }
+        }
+    }
+    head_size = align_up(head_size, ARENA_ALIGNMENT);
+    size_t arena_size = head_size + measured_persistent_bytes + measured_scratch_bytes;
+
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "Failed to open %s for writing\n", path);
+        return false;
+    }
+
+    fputs(generated_header, f);
+    fputs(
+        "#include \"trained_model_compiled.h\"\n"
+        "#include <stdarg.h>\n"
+        "#include <string.h>\n"
+        "#include \"edge-impulse-sdk/tensorflow/lite/c/builtin_op_data.h\"\n"
+        "#include \"edge-impulse-sdk/tensorflow/lite/micro/kernels/micro_ops.h\"\n"
+        "#include \"edge-impulse-sdk/tensorflow/lite/micro/micro_error_reporter.h\"\n"
+        "\n", f);
+
+    bool has_detection_postprocess = false;
+    for (const used_op_t &op : used_ops) {
+        has_detection_postprocess |= op.name == "DETECTION_POSTPROCESS";
+    }
+    if (has_detection_postprocess) {
+        fputs(
+            "namespace tflite {\n"
+            "namespace ops {\n"
+            "namespace micro {\n"
+            "TfLiteRegistration *Register_TFLite_Detection_PostProcess();\n"
+            "}  // namespace micro\n"
+            "}  // namespace ops\n"
+            "}  // namespace tflite\n"
+            "\n", f);
+    }
+
+    fputs(
+        "#ifndef EI_CLASSIFIER_ALLOCATION_STATIC\n"
+        "#define EI_CLASSIFIER_ALLOCATION_STATIC 0\n"
+        "#endif\n"
+        "\n"
+        "namespace {\n"
+        "\n", f);
+    fprintf(f, "constexpr size_t kTensorArenaSize = %d;\n", (int)arena_size);
+    fprintf(f, "constexpr size_t kTensorArenaHeadSize = %d;\n", (int)head_size);
+    fprintf(f, "constexpr int kTensorCount = %d;\n", (int)tensor_count);
+    fprintf(f, "constexpr int kNodeCount = %d;\n", (int)node_count);
+    fprintf(f, "constexpr int kMaxScratchBuffers = %d;\n", measured_scratch_count > 0 ? measured_scratch_count : 1);
+    fprintf(f, "constexpr int kInputCount = %d;\n", (int)interpreter.inputs_size());
+    fprintf(f, "constexpr int kOutputCount = %d;\n", (int)interpreter.outputs_size());
+    fputs(
+        "\n"
+        "template <int SZ, class T> struct TfArray {\n"
+        "    int sz; T elem[SZ];\n"
+        "};\n"
+        "\n"
+        "enum used_operators_e {\n", f);
+    for (const used_op_t &op : used_ops) {
+        fprintf(f, "    OP_%s,\n", op.name.c_str());
+    }
+    fputs(
+        "    OP_LAST\n"
+        "};\n"
+        "\n"
+        "typedef struct {\n"
+        "    TfLiteAllocationType allocation_type;\n"
+        "    TfLiteType type;\n"
+        "    const void *data;       // constant data, or nullptr for tensors in the arena\n"
+        "    size_t arena_offset;\n"
+        "    TfLiteIntArray *dims;\n"
+        "    size_t bytes;\n"
+        "    TfLiteQuantizationParams params;\n"
+        "    const TfLiteAffineQuantization *quantization;\n"
+        "    bool is_variable;\n"
+        "} tensor_info_t;\n"
+        "\n"
+        "typedef struct {\n"
+        "    used_operators_e used_op_index;\n"
+        "    TfLiteIntArray *inputs;\n"
+        "    TfLiteIntArray *outputs;\n"
+        "    const void *builtin_data;\n"
+        "    const void *custom_initial_data;\n"
+        "    int custom_initial_data_size;\n"
+        "} node_info_t;\n"
+        "\n"
+        "#if EI_CLASSIFIER_ALLOCATION_STATIC == 1\n"
+        "alignas(16) uint8_t tensor_arena_static[kTensorArenaSize];\n"
+        "#endif\n"
+        "uint8_t *tensor_arena = nullptr;\n"
+        "size_t tensor_arena_tail = 0;\n"
+        "void *scratch_buffers[kMaxScratchBuffers];\n"
+        "int scratch_buffer_count = 0;\n"
+        "\n"
+        "TfLiteContext ctx;\n"
+        "TfLiteTensor tensors[kTensorCount];\n"
+        "TfLiteNode nodes[kNodeCount];\n"
+        "TfLiteRegistration registrations[OP_LAST];\n"
+        "bool registrations_resolved = false;\n"
+        "tflite::MicroErrorReporter micro_error_reporter;\n"
+        "\n", f);
+
+    // tensors: constant data, shapes and quantization parameters
+    for (size_t ix = 0; ix < tensor_count; ix++) {
+        const TfLiteTensor &t = ctx.tensors[ix];
+        if (t.allocation_type == kTfLiteMmapRo && t.data.raw) {
+            fprintf(f, "alignas(16) const uint8_t tensor_data%d[%d] = {", (int)ix, (int)t.bytes);
+            write_bytes(f, t.data.raw, t.bytes);
+            fprintf(f, "};\n");
+        }
+        char name[64];
+        snprintf(name, sizeof(name), "tensor_dimension%d", (int)ix);
+        // kernels (e.g. RESHAPE) may rewrite dims during prepare, so not const
+        write_int_array(f, name, t.dims, false);
+
+        if (t.quantization.type == kTfLiteAffineQuantization && t.quantization.params) {
+            const TfLiteAffineQuantization *q =
+                static_cast<const TfLiteAffineQuantization *>(t.quantization.params);
+            fprintf(f, "const TfArray<%d, float> quant%d_scale = { %d, {", q->scale->size, (int)ix, q->scale->size);
+            for (int s = 0; s < q->scale->size; s++) {
+                fprintf(f, "%s ", s > 0 ? "," : "");
+                write_float(f, q->scale->data[s]);
+            }
+            fprintf(f, " } };\n");
+            snprintf(name, sizeof(name), "quant%d_zero", (int)ix);
+            write_int_array(f, name, q->zero_point, true);
+            fprintf(f, "const TfLiteAffineQuantization quant%d = { (TfLiteFloatArray*)&quant%d_scale, "
+                "(TfLiteIntArray*)&quant%d_zero, %d };\n",
+                (int)ix, (int)ix, (int)ix, (int)q->quantized_dimension);
+        }
+    }
+    fprintf(f, "\nconst tensor_info_t tensor_data[kTensorCount] = {\n");
+    for (size_t ix = 0; ix < tensor_count; ix++) {
+        const TfLiteTensor &t = ctx.tensors[ix];
+        bool is_const = t.allocation_type == kTfLiteMmapRo && t.data.raw;
+        size_t offset = (!is_const && t.data.raw) ? (size_t)((const uint8_t *)t.data.raw - arena) : 0;
+        char data[32], quant[32];
+        snprintf(data, sizeof(data), is_const ? "tensor_data%d" : "nullptr", (int)ix);
+        snprintf(quant, sizeof(quant),
+            t.quantization.type == kTfLiteAffineQuantization && t.quantization.params ? "&quant%d" : "nullptr",
+            (int)ix);
+        fprintf(f, "    { %s, %s, %s, %d, (TfLiteIntArray*)&tensor_dimension%d, %d, { ",
+            is_const ? "kTfLiteMmapRo" : "kTfLiteArenaRw",
+            tflite_type_name(t.type), data, (int)offset, (int)ix, (int)t.bytes);
+        write_float(f, t.params.scale);
+        fprintf(f, ", %d }, %s, %s },\n", (int)t.params.zero_point, quant, t.is_variable ? "true" : "false");
+    }
+    fprintf(f, "};\n\n");
+
+    // nodes: tensor indices and parsed op parameters
+    for (size_t ix = 0; ix < node_count; ix++) {
+        tflite::NodeAndRegistration nr = interpreter.node_and_registration(ix);
+        char name[64];
+        snprintf(name, sizeof(name), "inputs%d", (int)ix);
+        write_int_array(f, name, nr.node.inputs, false);
+        snprintf(name, sizeof(name), "outputs%d", (int)ix);
+        write_int_array(f, name, nr.node.outputs, false);
+        if (nr.node.builtin_data) {
+            const builtin_params_t *p = find_builtin_params(nr.registration->builtin_code);
+            fprintf(f, "static_assert(sizeof(%s) == %d, \"%s layout differs from the host this was generated on\");\n",
+                p->type_name, (int)p->size, p->type_name);
+            fprintf(f, "alignas(%s) const uint8_t node_data%d[%d] = {", p->type_name, (int)ix, (int)p->size);
+            write_bytes(f, nr.node.builtin_data, p->size);
+            fprintf(f, "};\n");
+        }
+        if (nr.node.custom_initial_data && nr.node.custom_initial_data_size > 0) {
+            fprintf(f, "alignas(16) const uint8_t node_custom_data%d[%d] = {", (int)ix, nr.node.custom_initial_data_size);
+            write_bytes(f, nr.node.custom_initial_data, nr.node.custom_initial_data_size);
+            fprintf(f, "};\n");
+        }
+    }
+    fprintf(f, "\nconst node_info_t node_data[kNodeCount] = {\n");
+    for (size_t ix = 0; ix < node_count; ix++) {
+        tflite::NodeAndRegistration nr = interpreter.node_and_registration(ix);
+        bool has_custom = nr.node.custom_initial_data && nr.node.custom_initial_data_size > 0;
+        fprintf(f, "    { OP_%s, (TfLiteIntArray*)&inputs%d, (TfLiteIntArray*)&outputs%d, ",
+            used_ops[node_ops[ix]].name.c_str(), (int)ix, (int)ix);
+        if (nr.node.builtin_data) {
+            fprintf(f, "node_data%d, ", (int)ix);
+        }
+        else {
+            fprintf(f, "nullptr, ");
+        }
+        if (has_custom) {
+            fprintf(f, "node_custom_data%d, %d },\n", (int)ix, nr.node.custom_initial_data_size);
+        }
+        else {
+            fprintf(f, "nullptr, 0 },\n");
+        }
+    }
+    fprintf(f, "};\n\n");
+
+    fprintf(f, "const int input_tensors[kInputCount] = {");
+    for (size_t ix = 0; ix < interpreter.inputs_size(); ix++) {
+        fprintf(f, "%s %d", ix > 0 ? "," : "", (int)interpreter.inputs().Get(ix));
+    }
+    fprintf(f, " };\nconst int output_tensors[kOutputCount] = {");
+    for (size_t ix = 0; ix < interpreter.outputs_size(); ix++) {
+        fprintf(f, "%s %d", ix > 0 ? "," : "", (int)interpreter.outputs().Get(ix));
+    }
+    fprintf(f, " };\n\n");
+
+    fputs(
+        "void resolve_registrations() {\n"
+        "    if (registrations_resolved) {\n"
+        "        return;\n"
+        "    }\n", f);
+    for (const used_op_t &op : used_ops) {
+        fprintf(f, "    registrations[OP_%s] = *%s();\n", op.name.c_str(), op.register_fn.c_str());
+    }
+    fputs(
+        "    registrations_resolved = true;\n"
+        "}\n"
+        "\n"
+        "// Kernel memory is bump allocated from the arena, behind the planned activations\n"
+        "void *allocate_from_tail(size_t bytes) {\n"
+        "    size_t aligned = (bytes + 15) & ~((size_t)15);\n"
+        "    if (tensor_arena_tail + aligned > kTensorArenaSize) {\n"
+        "        return nullptr;\n"
+        "    }\n"
+        "    void *ptr = tensor_arena + tensor_arena_tail;\n"
+        "    tensor_arena_tail += aligned;\n"
+        "    return ptr;\n"
+        "}\n"
+        "\n"
+        "TfLiteStatus AllocatePersistentBuffer(struct TfLiteContext *ctx, size_t bytes, void **ptr) {\n"
+        "    *ptr = allocate_from_tail(bytes);\n"
+        "    if (*ptr == nullptr) {\n"
+        "        ctx->ReportError(ctx, \"Failed to allocate %d bytes of persistent memory\", (int)bytes);\n"
+        "        return kTfLiteError;\n"
+        "    }\n"
+        "    return kTfLiteOk;\n"
+        "}\n"
+        "\n"
+        "TfLiteStatus RequestScratchBufferInArena(struct TfLiteContext *ctx, size_t bytes, int *buffer_idx) {\n"
+        "    if (scratch_buffer_count >= kMaxScratchBuffers) {\n"
+        "        ctx->ReportError(ctx, \"Too many scratch buffers requested\");\n"
+        "        return kTfLiteError;\n"
+        "    }\n"
+        "    void *ptr = allocate_from_tail(bytes);\n"
+        "    if (ptr == nullptr) {\n"
+        "        ctx->ReportError(ctx, \"Failed to allocate %d bytes of scratch memory\", (int)bytes);\n"
+        "        return kTfLiteError;\n"
+        "    }\n"
+        "    scratch_buffers[scratch_buffer_count] = ptr;\n"
+        "    *buffer_idx = scratch_buffer_count++;\n"
+        "    return kTfLiteOk;\n"
+        "}\n"
+        "\n"
+        "void *GetScratchBuffer(struct TfLiteContext *ctx, int buffer_idx) {\n"
+        "    if (buffer_idx < 0 || buffer_idx >= scratch_buffer_count) {\n"
+        "        return nullptr;\n"
+        "    }\n"
+        "    return scratch_buffers[buffer_idx];\n"
+        "}\n"
+        "\n"
+        "void ReportError(struct TfLiteContext *ctx, const char *format, ...) {\n"
+        "    va_list args;\n"
+        "    va_start(args, format);\n"
+        "    micro_error_reporter.Report(format, args);\n"
+        "    va_end(args);\n"
+        "}\n"
+        "\n"
+        "} // namespace\n"
+        "\n"
+        "TfLiteStatus trained_model_init(void *(*alloc_fnc)(size_t, size_t)) {\n"
+        "#if EI_CLASSIFIER_ALLOCATION_STATIC == 1\n"
+        "    tensor_arena = tensor_arena_static;\n"
+        "#else\n"
+        "    tensor_arena = (uint8_t *)alloc_fnc(16, kTensorArenaSize);\n"
+        "    if (!tensor_arena) {\n"
+        "        return kTfLiteError;\n"
+        "    }\n"
+        "#endif\n"
+        "    tensor_arena_tail = kTensorArenaHeadSize;\n"
+        "    scratch_buffer_count = 0;\n"
+        "    resolve_registrations();\n"
+        "\n"
+        "    memset(&ctx, 0, sizeof(ctx));\n"
+        "    ctx.tensors_size = kTensorCount;\n"
+        "    ctx.tensors = tensors;\n"
+        "    ctx.ReportError = &ReportError;\n"
+        "    ctx.AllocatePersistentBuffer = &AllocatePersistentBuffer;\n"
+        "    ctx.RequestScratchBufferInArena = nullptr;\n"
+        "    ctx.GetScratchBuffer = nullptr;\n"
+        "\n"
+        "    for (int i = 0; i < kTensorCount; i++) {\n"
+        "        const tensor_info_t &info = tensor_data[i];\n"
+        "        TfLiteTensor &t = tensors[i];\n"
+        "        memset(&t, 0, sizeof(t));\n"
+        "        t.type = info.type;\n"
+        "        t.allocation_type = info.allocation_type;\n"
+        "        t.bytes = info.bytes;\n"
+        "        t.dims = info.dims;\n"
+        "        t.params = info.params;\n"
+        "        t.is_variable = info.is_variable;\n"
+        "        if (info.data) {\n"
+        "            t.data.data = const_cast<void *>(info.data);\n"
+        "        }\n"
+        "        else if (info.bytes > 0) {\n"
+        "            t.data.data = tensor_arena + info.arena_offset;\n"
+        "        }\n"
+        "        if (info.quantization) {\n"
+        "            t.quantization.type = kTfLiteAffineQuantization;\n"
+        "            t.quantization.params = const_cast<TfLiteAffineQuantization *>(info.quantization);\n"
+        "        }\n"
+        "        if (info.is_variable) {\n"
+        "            memset(t.data.data, 0, t.bytes);\n"
+        "        }\n"
+        "    }\n"
+        "\n"
+        "    for (int i = 0; i < kNodeCount; i++) {\n"
+        "        const node_info_t &info = node_data[i];\n"
+        "        TfLiteNode &node = nodes[i];\n"
+        "        memset(&node, 0, sizeof(node));\n"
+        "        node.inputs = info.inputs;\n"
+        "        node.outputs = info.outputs;\n"
+        "        node.builtin_data = const_cast<void *>(info.builtin_data);\n"
+        "        node.custom_initial_data = info.custom_initial_data;\n"
+        "        node.custom_initial_data_size = info.custom_initial_data_size;\n"
+        "\n"
+        "        const TfLiteRegistration &registration = registrations[info.used_op_index];\n"
+        "        if (registration.init) {\n"
+        "            const char *init_data = info.custom_initial_data ?\n"
+        "                (const char *)info.custom_initial_data : (const char *)info.builtin_data;\n"
+        "            node.user_data = registration.init(&ctx, init_data, info.custom_initial_data_size);\n"
+        "        }\n"
+        "    }\n"
+        "\n"
+        "    ctx.RequestScratchBufferInArena = &RequestScratchBufferInArena;\n"
+        "    for (int i = 0; i < kNodeCount; i++) {\n"
+        "        const TfLiteRegistration &registration = registrations[node_data[i].used_op_index];\n"
+        "        if (registration.prepare) {\n"
+        "            TfLiteStatus status = registration.prepare(&ctx, &nodes[i]);\n"
+        "            if (status != kTfLiteOk) {\n"
+        "                return status;\n"
+        "            }\n"
+        "        }\n"
+        "    }\n"
+        "\n"
+        "    ctx.AllocatePersistentBuffer = nullptr;\n"
+        "    ctx.RequestScratchBufferInArena = nullptr;\n"
+        "    ctx.GetScratchBuffer = &GetScratchBuffer;\n"
+        "    return kTfLiteOk;\n"
+        "}\n"
+        "\n"
+        "TfLiteTensor *trained_model_input(int index) {\n"
+        "    if (index < 0 || index >= kInputCount) {\n"
+        "        return nullptr;\n"
+        "    }\n"
+        "    return &tensors[input_tensors[index]];\n"
+        "}\n"
+        "\n"
+        "TfLiteTensor *trained_model_output(int index) {\n"
+        "    if (index < 0 || index >= kOutputCount) {\n"
+        "        return nullptr;\n"
+        "    }\n"
+        "    return &tensors[output_tensors[index]];\n"
+        "}\n"
+        "\n"
+        "TfLiteStatus trained_model_invoke() {\n"
+        "    for (int i = 0; i < kNodeCount; i++) {\n"
+        "        const TfLiteRegistration &registration = registrations[node_data[i].used_op_index];\n"
+        "        TfLiteStatus status = registration.invoke(&ctx, &nodes[i]);\n"
+        "        if (status != kTfLiteOk) {\n"
+        "            return status;\n"
+        "        }\n"
+        "    }\n"
+        "    return kTfLiteOk;\n"
+        "}\n"
+        "\n"
+        "TfLiteStatus trained_model_reset(void (*free_fnc)(void *ptr)) {\n"
+        "    for (int i = 0; i < kNodeCount; i++) {\n"
+        "        const TfLiteRegistration &registration = registrations[node_data[i].used_op_index];\n"
+        "        if (registration.free) {\n"
+        "            registration.free(&ctx, nodes[i].user_data);\n"
+        "        }\n"
+        "    }\n"
+        "#if EI_CLASSIFIER_ALLOCATION_STATIC == 0\n"
+        "    if (tensor_arena) {\n"
+        "        free_fnc(tensor_arena);\n"
+        "    }\n"
+        "#endif\n"
+        "    tensor_arena = nullptr;\n"
+        "    return kTfLiteOk;\n"
+        "}\n", f);
+
+    fclose(f);
+
+    printf("Arena: %d bytes (activations %d, kernel memory %d)\n", (int)arena_size, (int)head_size,
+        (int)(measured_persistent_bytes + measured_scratch_bytes));
+    printf("Tensors: %d, nodes: %d, kernels:", (int)tensor_count, (int)node_count);
+    for (const used_op_t &op : used_ops) {
+        printf(" %s", op.name.c_str());
+    }
+    printf("\n");
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1 && (strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0)) {
+        printf("Usage: %s [model.tflite] [output-directory]\n", argv[0]);
+        printf("    Without a model file the model built into this application is compiled.\n");
+        printf("    The output directory defaults to tflite-model.\n");
+        return 0;
+    }
+
+    std::vector<uint8_t> model_buffer;
+    const uint8_t *model_data = trained_tflite;
+    if (argc > 1 && strcmp(argv[1], "-") != 0) {
+        if (!read_file(argv[1], model_buffer)) {
+            return 1;
+        }
+        model_data = model_buffer.data();
+    }
+    std::string out_dir = argc > 2 ? argv[2] : "tflite-model";
+
+    const tflite::Model *model = tflite::GetModel(model_data);
+    if (model->version() != TFLITE_SCHEMA_VERSION) {
+        fprintf(stderr, "Model provided is schema version %d not equal to supported version %d\n",
+            (int)model->version(), TFLITE_SCHEMA_VERSION);
+        return 1;
+    }
+    if (model->subgraphs()->size() != 1) {
+        fprintf(stderr, "Only models with a single subgraph are supported\n");
+        return 1;
+    }
+
+    tflite::MicroErrorReporter micro_error_reporter;
+    tflite::AllOpsResolver resolver;
+    resolver.AddCustom(DETECTION_POSTPROCESS_NAME, tflite::ops::micro::Register_TFLite_Detection_PostProcess());
+
+    // let the interpreter plan the arena, growing it until the model fits
+    for (size_t arena_size = 64 * 1024; arena_size <= MAX_ARENA_SIZE; arena_size *= 2) {
+        uint8_t *arena = (uint8_t *)ei_aligned_malloc(ARENA_ALIGNMENT, arena_size);
+        if (!arena) {
+            fprintf(stderr, "Failed to allocate %d bytes for the tensor arena\n", (int)arena_size);
+            return 1;
+        }
+
+        bool done = false;
+        bool ok = false;
+        {
+            planning_interpreter interpreter(model, resolver, arena, arena_size, &micro_error_reporter);
+            if (interpreter.AllocateTensors() == kTfLiteOk) {
+                done = true;
+                ok = measure_kernel_memory(interpreter, interpreter.planned_context()) &&
+                    write_header((out_dir + "/trained_model_compiled.h").c_str()) &&
+                    write_source((out_dir + "/trained_model_compiled.cpp").c_str(), interpreter,
+                        interpreter.planned_context(), arena);
+            }
+        }
+
+        ei_aligned_free(arena);
+        if (done) {
+            return ok ? 0 : 1;
+        }
+    }
+
+    fprintf(stderr, "Model does not fit in a %d byte tensor arena\n", MAX_ARENA_SIZE);
+    return 1;
+}
@@ -0,0 +1,258 @@
+/* Edge Impulse Linux SDK
+ * Copyright (c) 2021 EdgeImpulse Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * Micro-benchmark for the matrix layout kernels in edge-impulse-sdk/dsp/numpy.hpp.
+ *
+ * Times numpy::transpose and numpy::mean_axis0 / std_axis0 against the element
+ * by element loops they replaced, on the shapes the DSP blocks use: 3xN (one row
+ * per axis of a motion window) and Nx13 (MFCC frames), plus square matrices
+ * (transposed in place). numpy::roll is timed against the version that copied the
+ * wrapped elements into a heap buffer, on int16 audio buffers (one second at 16 and
+ * 44.1 kHz, rolled by one slice as the continuous audio loop does) and on the short
+ * float buffers of the classifier smoother. The last column says whether both give
+ * the same output, they're meant to be bit-exact.
+ *
+ * Usage: numpy-benchmark [milliseconds per measurement, default 100]
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include "edge-impulse-sdk/dsp/numpy.hpp"
+#include "edge-impulse-sdk/dsp/returntypes.hpp"
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+
+using namespace ei;
+
+typedef void (*kernel_fn)(float *matrix, size_t rows, size_t cols, float *output);
+
+/** The old numpy::transpose: element by element into a heap copy */
+static void transpose_reference(float *matrix, size_t rows, size_t cols, float *output) {
+    (void)output;
+    matrix_t temp(cols, rows);
+    for (size_t j = 0; j < cols; j++) {
+        for (size_t i = 0; i < rows; i++) {
+            temp.buffer[j * rows + i] = matrix[i * cols + j];
+        }
+    }
+    memcpy(matrix, temp.buffer, rows * cols * sizeof(float));
+}
+
+static void transpose_numpy(float *matrix, size_t rows, size_t cols, float *output) {
+    (void)output;
+    numpy::transpose(matrix, (int)cols, (int)rows);
+}
+
+/** The old numpy::std_axis0: one column at a time */
+static void std_axis0_reference(float *matrix, size_t rows, size_t cols, float *output) {
+    for (size_t col = 0; col < cols; col++) {
+        float sum = 0.0f;
+        for (size_t row = 0; row < rows; row++) {
+            sum += matrix[(row * cols) + col];
+        }
+        float mean = sum / rows;
+
+        float std = 0.0f;
+        for (size_t row = 0; row < rows; row++) {
+            float tmp = matrix[(row * cols) + col] - mean;
+            std += tmp * tmp;
+        }
+        output[col] = sqrt(std / rows);
+    }
+}
+
+/** The old numpy::roll: the elements that wrap around go through a heap buffer */
+template <typename T>
+static void roll_reference(T *input_array, size_t input_array_size, int shift) {
+    if (shift < 0) {
+        shift = input_array_size + shift;
+    }
+    if (shift == 0) {
+        return;
+    }
+
+    T *shift_buffer = (T *)calloc(shift, sizeof(T));
+    memcpy(shift_buffer, input_array + input_array_size - shift, shift * sizeof(T));
+    memmove(input_array + shift, input_array, (input_array_size - shift) * sizeof(T));
+    memcpy(input_array, shift_buffer, shift * sizeof(T));
+    free(shift_buffer);
+}
+
+static void std_axis0_numpy(float *matrix, size_t rows, size_t cols, float *output) {
+    matrix_t input(rows, cols, matrix);
+    matrix_t out(cols, 1, output);
+    numpy::std_axis0(&input, &out);
+}
+
+/** Microseconds per call of fn, over a number of calls */
+template <typename Fn>
+static double time_calls(Fn fn, uint64_t iterations) {
+    uint64_t start = ei_read_timer_us();
+    for (uint64_t ix = 0; ix < iterations; ix++) {
+        fn();
+    }
+    return (double)(ei_read_timer_us() - start) / (double)iterations;
+}
+
+/**
+ * Time the old and the new version of a kernel, in microseconds per call. They
+ * take turns over a few rounds and the best round of each counts, so neither
+ * gets an advantage from running first (or second) on a cold or busy core.
+ * The transposes run on the same buffer over and over, that's fine as every
+ * call does the same amount of work.
+ */
+template <typename OldFn, typename NewFn>
+static void measure(OldFn old_fn, NewFn new_fn, uint64_t budget_ms, double *old_us, double *new_us) {
+    const int rounds = 5;
+
+    // enough calls of the old version for a round to take a share of the budget
+    old_fn();
+    new_fn();
+    uint64_t iterations = 1;
+    while ((time_calls(old_fn, iterations) * (double)iterations) < (double)(budget_ms * 1000 / (rounds * 2))) {
+        iterations *= 2;
+    }
+
+    *old_us = 1e30;
+    *new_us = 1e30;
+    for (int round = 0; round < rounds; round++) {
+        double o = time_calls(old_fn, iterations);
+        double n = time_calls(new_fn, iterations);
+        *old_us = o < *old_us ? o : *old_us;
+        *new_us = n < *new_us ? n : *new_us;
+    }
+}
+
+/** Time the old and new roll on a buffer of size elements and print a row */
+template <typename T>
+static void benchmark_roll(const char *name, size_t size, int shift, uint64_t budget_ms) {
+    std::vector<T> input(size);
+    for (size_t ix = 0; ix < size; ix++) {
+        input[ix] = (T)(rand() % 2000 - 1000);
+    }
+
+    std::vector<T> buffer = input;
+    double old_us, new_us;
+    measure([&]() { roll_reference(buffer.data(), buffer.size(), shift); },
+        [&]() { numpy::roll(buffer.data(), buffer.size(), shift); },
+        budget_ms, &old_us, &new_us);
+
+    std::vector<T> a = input, b = input;
+    roll_reference(a.data(), a.size(), shift);
+    numpy::roll(b.data(), b.size(), shift);
+    bool same = memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0;
+
+    char shape[32];
+    snprintf(shape, sizeof(shape), "%d,%d", (int)size, shift);
+    printf("%-9s %13s %12.2f %12.2f %7.2fx %5s\n", name, shape, old_us, new_us,
+        old_us / new_us, same ? "yes" : "NO");
+}
+
+/** Run both kernels once on the same input and compare the results */
+static bool same_output(kernel_fn reference, kernel_fn fn, const std::vector<float> &input,
+    size_t rows, size_t cols, bool in_place)
+{
+    std::vector<float> a = input, b = input;
+    std::vector<float> out_a(cols, 0.0f), out_b(cols, 0.0f);
+    reference(a.data(), rows, cols, out_a.data());
+    fn(b.data(), rows, cols, out_b.data());
+
+    if (in_place) {
+        return memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0;
+    }
+    return memcmp(out_a.data(), out_b.data(), out_a.size() * sizeof(float)) == 0;
+}
+
+int main(int argc, char **argv) {
+    uint64_t budget_ms = argc > 1 ? strtoull(argv[1], NULL, 10) : 100;
+
+    const struct {
+        const char *name;
+        kernel_fn reference;
+        kernel_fn fn;
+        bool in_place;
+    } kernels[] = {
+        { "transpose", &transpose_reference, &transpose_numpy, true },
+        { "std_axis0", &std_axis0_reference, &std_axis0_numpy, false },
+    };
+
+    const struct {
+        size_t rows;
+        size_t cols;
+    } shapes[] = {
+        { 3, 125 }, { 3, 1000 }, { 3, 10000 }, { 3, 100000 },
+        { 99, 13 }, { 1000, 13 }, { 10000, 13 }, { 100000, 13 },
+        { 64, 64 }, { 512, 512 }, { 1024, 1024 },
+    };
+
+    printf("%-9s %13s %12s %12s %8s %5s\n", "kernel", "shape", "old (us)", "new (us)", "speedup", "same");
+
+    srand(42);
+
+    for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+        for (size_t s = 0; s < sizeof(shapes) / sizeof(shapes[0]); s++) {
+            size_t rows = shapes[s].rows;
+            size_t cols = shapes[s].cols;
+
+            std::vector<float> input(rows * cols);
+            for (size_t ix = 0; ix < input.size(); ix++) {
+                input[ix] = ((float)rand() / (float)RAND_MAX) * 2.0f - 1.0f;
+            }
+            std::vector<float> matrix = input;
+            std::vector<float> output(cols, 0.0f);
+
+            kernel_fn reference = kernels[k].reference;
+            kernel_fn fn = kernels[k].fn;
+            double old_us, new_us;
+            measure([&]() { reference(matrix.data(), rows, cols, output.data()); },
+                [&]() { fn(matrix.data(), rows, cols, output.data()); },
+                budget_ms, &old_us, &new_us);
+            bool same = same_output(kernels[k].reference, kernels[k].fn, input, rows, cols,
+                kernels[k].in_place);
+
+            char shape[32];
+            snprintf(shape, sizeof(shape), "%dx%d", (int)rows, (int)cols);
+            printf("%-9s %13s %12.2f %12.2f %7.2fx %5s\n", kernels[k].name, shape, old_us, new_us,
+                old_us / new_us, same ? "yes" : "NO");
+        }
+    }
+
+    const struct {
+        size_t size;
+        int shift;
+    } rolls[] = {
+        { 16000, -4000 }, { 16000, -1 }, { 16000, 1 },
+        { 44100, -11025 }, { 44100, -4410 }, { 44100, -1 }, { 44100, 22050 },
+    };
+
+    for (size_t r = 0; r < sizeof(rolls) / sizeof(rolls[0]); r++) {
+        benchmark_roll<int16_t>("roll_i16", rolls[r].size, rolls[r].shift, budget_ms);
+    }
+    benchmark_roll<float>("roll_f32", 10, -1, budget_ms);
+    benchmark_roll<float>("roll_f32", 16000, -4000, budget_ms);
+
+    return 0;
+}